@@ -0,0 +1,14 @@
+#version 300 es
+
+precision mediump float;
+
+in vec2 fragUV;
+in vec4 fragColor;
+
+uniform sampler2D uTexture;
+
+out vec4 outColor;
+
+void main() {
+   outColor = texture(uTexture, fragUV) * fragColor;
+}
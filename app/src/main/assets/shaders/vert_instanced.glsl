@@ -0,0 +1,30 @@
+#version 300 es
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec2 inUV;
+// per instance attributes, see TMInstance
+layout (location = 2) in vec2 inInstancePosition;
+layout (location = 3) in vec2 inInstanceScale;
+layout (location = 4) in float inInstanceRotation;
+layout (location = 5) in vec4 inInstanceColor;
+layout (location = 6) in vec4 inInstanceUVRect;
+
+out vec2 fragUV;
+out vec4 fragColor;
+
+uniform mat4 uProj;
+uniform mat4 uView;
+
+void main() {
+   // world = translate * rotateZ * scale, same as TMMat4RotateZ
+   float c = cos(inInstanceRotation);
+   float s = sin(inInstanceRotation);
+   mat4 world = mat4(
+      c * inInstanceScale.x, -s * inInstanceScale.x, 0.0, 0.0,
+      s * inInstanceScale.y,  c * inInstanceScale.y, 0.0, 0.0,
+      0.0, 0.0, 1.0, 0.0,
+      inInstancePosition.x, inInstancePosition.y, 0.0, 1.0);
+   fragUV = mix(inInstanceUVRect.xy, inInstanceUVRect.zw, inUV);
+   fragColor = inInstanceColor;
+   gl_Position = uProj * uView * world * vec4(inPosition, 1.0);
+}
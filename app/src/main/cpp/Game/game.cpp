@@ -7,13 +7,39 @@
 
 #include <time.h>
 #include <stdlib.h>
-
-static void UpdateProjectionsMatrices(GameState *state) {
+#include <math.h>
+#include <assert.h>
+
+// manuel: the hits throw a short shower of sparks that falls with gravity
+static const TMParticleEmitterDesc gSparksDesc = {
+        2000.0f, 150, 0.08f,
+        0.0f, 3.14159265f,
+        400.0f, 1400.0f,
+        0.3f, 0.8f,
+        12.0f, 28.0f, 0.3f,
+        TMVec2{0, -1500},
+        TMVec4{1.0f, 0.9f, 0.5f, 1.0f},
+        TMVec4{1.0f, 0.3f, 0.0f, 0.0f}
+};
+
+// manuel: the balls leave a slow glow that shrinks and fades behind them
+static const TMParticleEmitterDesc gTrailDesc = {
+        600.0f, 0, 0.0f,
+        0.0f, 3.14159265f,
+        20.0f, 60.0f,
+        0.4f, 0.7f,
+        40.0f, 80.0f, 0.1f,
+        TMVec2{0, 0},
+        TMVec4{1.0f, 1.0f, 0.8f, 0.6f},
+        TMVec4{1.0f, 0.5f, 0.1f, 0.0f}
+};
+
+static void UpdateProjectionsMatrices(GameFrame *frame) {
     // manuel: create the projection and view matrix
-    int width = TMRendererGetWidth(state->renderer);
-    int height = TMRendererGetHeight(state->renderer);
-    state->orthographic = TMMat4Ortho(-width/2, width/2, -height/2, height/2, 0, 100);
-    state->perspective = TMMat4Perspective(60.0f, (float)width/(float)height, 0.01f, 100.0f);
+    int width = frame->width;
+    int height = frame->height;
+    frame->orthographic = TMMat4Ortho(-width/2, width/2, -height/2, height/2, 0, 100);
+    frame->perspective = TMMat4Perspective(60.0f, (float)width/(float)height, 0.01f, 100.0f);
 }
 
 static void UpdateViewMatrix(GameState *state) {
@@ -21,195 +47,580 @@ static void UpdateViewMatrix(GameState *state) {
     TMVec3 target{0, 0, 0};
     TMVec3 up{0, 1, 0};
     state->view = TMMat4LookAt(position, target, up);
-    TMRendererShaderUpdate(state->shader, "uView", state->view);
+    TMRendererShaderUpdate(state->shader, state->uView, state->view);
+    TMRendererShaderUpdate(state->instancedShader, state->uInstancedView, state->view);
 }
 
-static void InitializeEntities(GameState *state) {
-    // manuel: init player1
-    state->player1Size.x = 400;
-    state->player1Size.y = 100;
-    state->player1Position.x = -200;
-    state->player1Position.y = 800;
-    // manuel: init player2
-    state->player2Size.x = 400;
-    state->player2Size.y = 100;
-    state->player2Position.x = 400;
-    state->player2Position.y = -800;
-    // manuel: init ball
-    state->ballPosition.x = 0;
-    state->ballPosition.y = 0;
-    state->ballVelocity.x = rand() / 2.0f;
-    state->ballVelocity.y = rand();
-    TMVec2Normalize(&state->ballVelocity);
-    state->ballVelocity = state->ballVelocity * 40;
-    state->ballSize.x = 200;
-    state->ballSize.y = 200;
-}
-
-static void CollisionDetectionAndResolution(GameState *state, int width, int height) {
-    TMVec2 halfBallSize = state->ballSize*0.5f;
-    TMVec2 halfPlayerSize = state->player1Size*0.5f;
-    TMVec2 player1 = state->player1Position;
-    TMVec2 player2 = state->player2Position;
-    TMVec2 ball = state->ballPosition;
-    if(ball.x - halfBallSize.x <= player1.x + halfPlayerSize.x &&
-       ball.x + halfBallSize.x >= player1.x - halfPlayerSize.x &&
-       ball.y - halfBallSize.y <= player1.y + halfPlayerSize.y &&
-       ball.y + halfBallSize.y >= player1.y - halfPlayerSize.y) {
-        if(state->ballVelocity.y > 0.0f) {
-            state->ballVelocity.y = -state->ballVelocity.y;
+// manuel: white dot that fades to the border, the particles tint it
+static TMTexture CreateParticleTexture(TMRenderer *renderer) {
+    const int size = 32;
+    unsigned char pixels[size * size * 4];
+    for(int y = 0; y < size; ++y) {
+        for(int x = 0; x < size; ++x) {
+            float dx = ((float)x + 0.5f) / (float)size * 2.0f - 1.0f;
+            float dy = ((float)y + 0.5f) / (float)size * 2.0f - 1.0f;
+            float alpha = 1.0f - sqrtf(dx * dx + dy * dy);
+            if(alpha < 0.0f) alpha = 0.0f;
+            unsigned char *pixel = pixels + (y * size + x) * 4;
+            pixel[0] = 255;
+            pixel[1] = 255;
+            pixel[2] = 255;
+            pixel[3] = (unsigned char)(alpha * alpha * 255.0f);
         }
     }
-    if(ball.x - halfBallSize.x <= player2.x + halfPlayerSize.x &&
-       ball.x + halfBallSize.x >= player2.x - halfPlayerSize.x &&
-       ball.y - halfBallSize.y <= player2.y + halfPlayerSize.y &&
-       ball.y + halfBallSize.y >= player2.y - halfPlayerSize.y) {
-        if(state->ballVelocity.y < 0.0f) {
-            state->ballVelocity.y = -state->ballVelocity.y;
-        }    }
-    if(state->ballPosition.x <= -width/2) {
-        state->ballPosition.x = (-width/2) + 1;
-        state->ballVelocity.x = -state->ballVelocity.x;
+    return TMRendererTextureCreate(renderer, pixels, size, size);
+}
+
+static TMEntity CreatePaddle(TMEntityStore *entities, unsigned int sprite, TMVec2 position) {
+    TMEntity paddle = TMEntityCreate(entities, TM_COMPONENT_POSITION | TM_COMPONENT_SIZE |
+                                               TM_COMPONENT_SPRITE | TM_COMPONENT_COLLIDER);
+    int i = TMEntityGetIndex(entities, paddle);
+    entities->positions[i] = position;
+    entities->previousPositions[i] = position;
+    entities->sizes[i] = TMVec2{400, 100};
+    entities->sprites[i] = TMEntitySprite{sprite, 1};
+    entities->colliders[i] = TMEntityCollider{entities->sizes[i] * 0.5f, TM_COLLIDER_STATIC};
+    return paddle;
+}
+
+static TMEntity CreateBall(TMEntityStore *entities) {
+    TMEntity ball = TMEntityCreate(entities, TM_COMPONENT_POSITION | TM_COMPONENT_VELOCITY | TM_COMPONENT_SIZE |
+                                             TM_COMPONENT_SPRITE | TM_COMPONENT_COLLIDER);
+    int i = TMEntityGetIndex(entities, ball);
+    TMVec2 velocity{rand() / 2.0f, (float)rand()};
+    TMVec2Normalize(&velocity);
+    // manuel: pixels per second
+    entities->velocities[i] = velocity * 2400;
+    entities->sizes[i] = TMVec2{200, 200};
+    entities->sprites[i] = TMEntitySprite{GAME_SPRITE_DONUT, 1};
+    entities->colliders[i] = TMEntityCollider{entities->sizes[i] * 0.5f, 0};
+    return ball;
+}
+
+static void InitializeEntities(GameState *state) {
+    state->entities = TMEntityStoreCreate(GAME_MAX_ENTITIES);
+    state->broadphase = TMSpatialHashCreate(GAME_BROADPHASE_CELL_SIZE, GAME_MAX_ENTITIES);
+    state->staticBroadphase = TMSpatialHashCreate(GAME_BROADPHASE_CELL_SIZE, GAME_MAX_ENTITIES);
+    state->frameArena = TMFrameArenaCreate(GAME_FRAME_ARENA_SIZE);
+    state->impacts = (unsigned char *)malloc(sizeof(unsigned char) * GAME_MAX_ENTITIES);
+    state->hitsCount = 0;
+    state->player1 = CreatePaddle(state->entities, GAME_SPRITE_PADDLE_1, TMVec2{-200, 800});
+    state->player2 = CreatePaddle(state->entities, GAME_SPRITE_PADDLE_2, TMVec2{400, -800});
+    for(int i = 0; i < GAME_BALLS_COUNT; ++i) {
+        CreateBall(state->entities);
+    }
+}
+
+static bool IsMovingCollider(TMEntityStore *entities, unsigned int i) {
+    unsigned int moving = TM_COMPONENT_VELOCITY | TM_COMPONENT_COLLIDER;
+    return (entities->masks[i] & moving) == moving && !(entities->colliders[i].flags & TM_COLLIDER_STATIC);
+}
+
+static bool IsStaticCollider(TMEntityStore *entities, unsigned int i) {
+    return (entities->masks[i] & TM_COMPONENT_COLLIDER) && (entities->colliders[i].flags & TM_COLLIDER_STATIC);
+}
+
+// manuel: every entity with a size goes in, the colliders must fit inside the size,
+// the static colliders also go in their own broadphase, so a crowd of balls
+// never hides a paddle from the sweeps
+static void BuildBroadphase(GameState *state) {
+    TMEntityStore *entities = state->entities;
+    unsigned int bounded = TM_COMPONENT_POSITION | TM_COMPONENT_SIZE;
+    TMSpatialHashClear(state->broadphase);
+    TMSpatialHashClear(state->staticBroadphase);
+    for(unsigned int i = 0; i < entities->count; ++i) {
+        if((entities->masks[i] & bounded) != bounded) continue;
+        TMAABB box = TMAABBFromCenter(entities->positions[i], entities->sizes[i] * 0.5f);
+        TMSpatialHashInsert(state->broadphase, i, box);
+        if(IsStaticCollider(entities, i)) {
+            TMSpatialHashInsert(state->staticBroadphase, i, box);
+        }
     }
-    if(state->ballPosition.x >= width/2) {
-        state->ballPosition.x = (width/2) - 1;
-        state->ballVelocity.x = -state->ballVelocity.x;
+    TMSpatialHashBuild(state->broadphase);
+    TMSpatialHashBuild(state->staticBroadphase);
+}
+
+struct GameCollisionJob {
+    GameState *state;
+    // the borders are walls just outside the screen
+    TMAABB walls[4];
+    float halfWidth;
+    float halfHeight;
+    float dt;
+};
+
+// manuel: moving colliders sweep from where they are to where their velocity takes them
+// and bounce off the static colliders and the screen borders at the exact time of impact,
+// so a fast ball can't go through a paddle even with a long step. Every moving collider
+// only writes its own position and velocity, so ranges of them run in parallel
+static void CollideRange(void *data, unsigned int begin, unsigned int end) {
+    GameCollisionJob *job = (GameCollisionJob *)data;
+    TMEntityStore *entities = job->state->entities;
+    TMVec2 *positions = entities->positions;
+    TMVec2 *velocities = entities->velocities;
+    float halfWidth = job->halfWidth;
+    float halfHeight = job->halfHeight;
+    float dt = job->dt;
+
+    TMAABB targets[GAME_MAX_COLLISION_TARGETS];
+    unsigned int candidates[GAME_MAX_COLLISION_TARGETS];
+    for(unsigned int w = 0; w < 4; ++w) {
+        targets[w] = job->walls[w];
     }
-    if(state->ballPosition.y <= -height/2) {
-        state->ballPosition.y = (-height/2) + 1;
-        state->ballVelocity.y = -state->ballVelocity.y;
+
+    for(unsigned int i = begin; i < end; ++i) {
+        if(!IsMovingCollider(entities, i)) continue;
+        TMVec2 halfSize = entities->colliders[i].halfSize;
+        // anything the box can reach this step, whatever it bounces off
+        float reach = sqrtf(velocities[i].x * velocities[i].x + velocities[i].y * velocities[i].y) * dt;
+        TMAABB area = TMAABBFromCenter(positions[i], TMVec2{halfSize.x + reach, halfSize.y + reach});
+        unsigned int candidatesCount = TMSpatialHashQueryRect(job->state->staticBroadphase, area, candidates,
+                                                              GAME_MAX_COLLISION_TARGETS);
+        if(candidatesCount > GAME_MAX_COLLISION_TARGETS) candidatesCount = GAME_MAX_COLLISION_TARGETS;
+        unsigned int targetsCount = 4;
+        for(unsigned int c = 0; c < candidatesCount; ++c) {
+            unsigned int j = candidates[c];
+            if(targetsCount == GAME_MAX_COLLISION_TARGETS) break;
+            targets[targetsCount++] = TMAABBFromCenter(positions[j], entities->colliders[j].halfSize);
+        }
+        job->state->impacts[i] = (unsigned char)TMSweptAABBBounce(positions + i, velocities + i, halfSize, dt,
+                                                                   targets, targetsCount, GAME_MAX_IMPACTS);
+
+        // manuel: the sweep never enters the walls, but the screen can shrink under a ball
+        if(positions[i].x < -halfWidth || positions[i].x > halfWidth) {
+            positions[i].x = positions[i].x < 0 ? -halfWidth + 1 : halfWidth - 1;
+            velocities[i].x = positions[i].x < 0 ? fabsf(velocities[i].x) : -fabsf(velocities[i].x);
+        }
+        if(positions[i].y < -halfHeight || positions[i].y > halfHeight) {
+            positions[i].y = positions[i].y < 0 ? -halfHeight + 1 : halfHeight - 1;
+            velocities[i].y = positions[i].y < 0 ? fabsf(velocities[i].y) : -fabsf(velocities[i].y);
+        }
     }
-    if(state->ballPosition.y >= height/2) {
-        state->ballPosition.y = (height/2) - 1;
-        state->ballVelocity.y = -state->ballVelocity.y;
+}
+
+static void CollisionDetectionAndResolution(GameState *state, int width, int height, float dt) {
+    GameCollisionJob job;
+    job.state = state;
+    job.halfWidth = width * 0.5f;
+    job.halfHeight = height * 0.5f;
+    job.dt = dt;
+    float halfWidth = job.halfWidth;
+    float halfHeight = job.halfHeight;
+    float thickness = GAME_BROADPHASE_CELL_SIZE;
+    job.walls[0] = TMAABB{TMVec2{-halfWidth - thickness, -halfHeight}, TMVec2{-halfWidth, halfHeight}};
+    job.walls[1] = TMAABB{TMVec2{halfWidth, -halfHeight}, TMVec2{halfWidth + thickness, halfHeight}};
+    job.walls[2] = TMAABB{TMVec2{-halfWidth, -halfHeight - thickness}, TMVec2{halfWidth, -halfHeight}};
+    job.walls[3] = TMAABB{TMVec2{-halfWidth, halfHeight}, TMVec2{halfWidth, halfHeight + thickness}};
+    TMJobSystemParallelFor(state->jobs, state->entities->count, GAME_COLLISION_BATCH_SIZE, CollideRange, &job);
+
+    // manuel: the hits of the step throw sparks in the next frame
+    TMEntityStore *entities = state->entities;
+    for(unsigned int i = 0; i < entities->count; ++i) {
+        if(state->hitsCount == GAME_FRAME_MAX_SPARKS) break;
+        if(IsMovingCollider(entities, i) && state->impacts[i]) {
+            state->hits[state->hitsCount++] = entities->positions[i];
+        }
     }
 }
 
-void GameInitialize(GameState *state, android_app *pApp, AAssetManager *assetManager) {
-    state->renderer = TMRendererCreate(pApp, assetManager);
+void GameInitializeSimulation(GameState *state) {
+    state->width = 0;
+    state->height = 0;
+    state->angle = 0.0f;
+    state->previousAngle = 0.0f;
+
+    // manuel: the main thread plus one worker per big core
+    state->jobs = TMJobSystemCreate(0);
+
+    // manuel: Initializes random number generator
+    time_t t;
+    srand((unsigned) time(&t));
+
+    InitializeEntities(state);
+    BuildBroadphase(state);
+}
+
+void GameInitializeRenderer(GameState *state, TMRenderer *renderer) {
+    state->renderer = renderer;
 
     state->shader = TMRendererShaderCreate(state->renderer,
                                            "shaders/vert.glsl",
                                            "shaders/frag.glsl");
+    state->shaderUniforms.shader = state->shader;
+    state->shaderUniforms.proj = TMRendererShaderGetUniform(state->shader, "uProj");
+    state->shaderUniforms.world = TMRendererShaderGetUniform(state->shader, "uWorld");
+    state->shaderUniforms.texture = TMRendererShaderGetUniform(state->shader, "uTexture");
+    state->uView = TMRendererShaderGetUniform(state->shader, "uView");
 
     state->buffer = TMRendererBufferCreate(state->renderer,
                                            vertices, ARRAY_LENGTH(vertices),
                                            indices, ARRAY_LENGTH(indices));
     state->cubeBuffer = TMRendererBufferCreate(state->renderer, cubeVertices, ARRAY_LENGTH(cubeVertices));
+    state->spriteBatch = TMSpriteBatchCreate(state->renderer, 1024);
+    state->renderQueue = TMRenderQueueCreate(256);
+
+
+    // manuel: the small sprites share one atlas page so they batch together
+    state->atlas = TMTextureAtlasCreate(state->renderer, 512, 512, 4);
+    int donut = TMTextureAtlasAdd(state->atlas, "images/donut.png");
+    int paddle1 = TMTextureAtlasAdd(state->atlas, "images/paddle_1.png");
+    int paddle2 = TMTextureAtlasAdd(state->atlas, "images/paddle_2.png");
+    TMTextureAtlasBuild(state->atlas);
+    state->donutRegion = TMTextureAtlasGetRegion(state->atlas, donut);
+    state->paddle1Region = TMTextureAtlasGetRegion(state->atlas, paddle1);
+    state->paddle2Region = TMTextureAtlasGetRegion(state->atlas, paddle2);
+
+    // manuel: the big textures stream in, they show white until they are uploaded.
+    // back.png and moon.png stay in the apk as the fallback of the .ktx2 files
+    state->textureLoader = TMTextureLoaderCreate(state->renderer, state->jobs);
+    state->backgroundTexture = TMTextureLoaderLoad(state->textureLoader, "images/back.ktx2");
+    state->moonTexture = TMTextureLoaderLoad(state->textureLoader, "images/moon.ktx2");
+
+    // manuel: the scene is drawn at a scaled resolution and stretched to the window,
+    // the scale goes down to 50% when we miss 60 fps
+    state->sceneFramebuffer = TMRendererFramebufferCreate(state->renderer, 1, 1);
+    TMDynamicResolutionInitialize(&state->resolution, 1.0f / 60.0f, 0.5f, 1.0f);
+
+    // manuel: all the particles in one instanced draw of the quad
+    state->instancedShader = TMRendererShaderCreate(state->renderer,
+                                                    "shaders/vert_instanced.glsl",
+                                                    "shaders/frag_instanced.glsl");
+    state->uInstancedProj = TMRendererShaderGetUniform(state->instancedShader, "uProj");
+    state->uInstancedView = TMRendererShaderGetUniform(state->instancedShader, "uView");
+    state->uInstancedTexture = TMRendererShaderGetUniform(state->instancedShader, "uTexture");
+    state->particleTexture = CreateParticleTexture(state->renderer);
+    state->particles = TMParticleSystemCreate(state->renderer, GAME_MAX_PARTICLES);
+    state->trailsCount = 0;
 
-
-    state->donutTexture = TMRendererTextureCreate(state->renderer, "images/donut.png");
-    state->backgroundTexture = TMRendererTextureCreate(state->renderer, "images/back.png");
-    state->paddle1Texture = TMRendererTextureCreate(state->renderer, "images/paddle_1.png");
-    state->paddle2Texture = TMRendererTextureCreate(state->renderer, "images/paddle_2.png");
-    state->moonTexture = TMRendererTextureCreate(state->renderer, "images/moon.png");
-
-    UpdateProjectionsMatrices(state);
     UpdateViewMatrix(state);
     TMRendererFaceCulling(false, 0);
+}
 
-    // manuel: Initializes random number generator
-    time_t t;
-    srand((unsigned) time(&t));
-
-    InitializeEntities(state);
+void GameShutdownRenderer(GameState *state, TMRenderer *renderer) {
+    // the trail emitters go with the system
+    TMParticleSystemDestroy(renderer, state->particles);
+    state->trailsCount = 0;
+    TMRendererTextureDestroy(renderer, state->particleTexture);
+    TMRendererShaderDestroy(renderer, state->instancedShader);
+    TMTextureLoaderDestroy(state->textureLoader);
+    TMRendererFramebufferDestroy(renderer, state->sceneFramebuffer);
+    TMRendererTextureDestroy(renderer, state->moonTexture);
+    TMRendererTextureDestroy(renderer, state->backgroundTexture);
+    TMTextureAtlasDestroy(renderer, state->atlas);
+    TMRenderQueueDestroy(state->renderQueue);
+    TMSpriteBatchDestroy(renderer, state->spriteBatch);
+    TMRendererBufferDestroy(renderer, state->cubeBuffer);
+    TMRendererBufferDestroy(renderer, state->buffer);
+    TMRendererShaderDestroy(renderer, state->shader);
+    state->renderer = NULL;
+}
 
+void GameInitialize(GameState *state, android_app *pApp, AAssetManager *assetManager) {
+    GameInitializeSimulation(state);
+    // manuel: the scene has its own depth buffer, the window only needs color
+    GameInitializeRenderer(state, TMRendererCreate(pApp, assetManager, 0));
+    state->surfacePending = false;
+    state->surfaceRetries = 0;
+    TMRendererUpdateRenderArea(state->renderer);
+    state->width = TMRendererGetWidth(state->renderer);
+    state->height = TMRendererGetHeight(state->renderer);
 }
 
 void GameUpdate(GameState *state, TMInput *input, float dt) {
-    int width = TMRendererGetWidth(state->renderer);
-    int height = TMRendererGetHeight(state->renderer);
+    int width = state->width;
+    int height = state->height;
 
     TMVec2 currMotion0 = TMInputGetCurrentMotionByIndex(input, 0);
     TMVec2 currMotion1 = TMInputGetCurrentMotionByIndex(input, 0);
 
-    state->player1Position.x = currMotion0.x - TMVec2{ width*0.5f, height*0.5f }.x;
-    state->player2Position.x = currMotion1.x - TMVec2{ width*0.5f, height*0.5f }.x;
+    TMEntityStore *entities = state->entities;
+    int player1 = TMEntityGetIndex(entities, state->player1);
+    int player2 = TMEntityGetIndex(entities, state->player2);
+    entities->positions[player1].x = currMotion0.x - TMVec2{ width*0.5f, height*0.5f }.x;
+    entities->positions[player2].x = currMotion1.x - TMVec2{ width*0.5f, height*0.5f }.x;
+
+    state->previousAngle = state->angle;
+
+    // manuel: the broadphase has everything where it is at the start of the step,
+    // the colliders are moved by the sweep and the rest just integrates
+    BuildBroadphase(state);
+    TMEntityStoreIntegrate(entities, dt, TM_COMPONENT_COLLIDER);
+    CollisionDetectionAndResolution(state, width, height, dt);
+
+    state->angle += 1.2f * dt;
+}
+
+static void FramePushSprite(GameFrame *frame, TMAtlasRegion region, unsigned int layer,
+                            TMVec2 position, TMVec2 size, float rotation) {
+    bool fits = frame->spritesCount < GAME_FRAME_MAX_SPRITES;
+    if(!fits) TM_LOG_INFO("ERROR: more than %d sprites in the frame\n", GAME_FRAME_MAX_SPRITES);
+    assert(fits);
+    if(!fits) return;
+    GameSprite *sprite = frame->sprites + frame->spritesCount++;
+    sprite->texture = region.texture;
+    sprite->layer = layer;
+    sprite->position = position;
+    sprite->size = size;
+    sprite->rotation = rotation;
+    sprite->uvRect = region.uvRect;
+}
+
+static void FramePushEffect(GameFrame *frame, unsigned int type, TMVec2 position) {
+    bool fits = frame->effectsCount < GAME_FRAME_MAX_EFFECTS;
+    if(!fits) TM_LOG_INFO("ERROR: more than %d effects in the frame\n", GAME_FRAME_MAX_EFFECTS);
+    assert(fits);
+    if(!fits) return;
+    GameEffect *effect = frame->effects + frame->effectsCount++;
+    effect->type = type;
+    effect->position = position;
+}
 
-    CollisionDetectionAndResolution(state, width, height);
+static void FramePushMesh(GameFrame *frame, TMBuffer buffer, TMTexture texture, TMMat4 world, float depth) {
+    if(frame->meshesCount == GAME_FRAME_MAX_MESHES) return;
+    GameMesh *mesh = frame->meshes + frame->meshesCount++;
+    mesh->buffer = buffer;
+    mesh->texture = texture;
+    mesh->world = world;
+    mesh->depth = depth;
+}
 
-    state->ballPosition = state->ballPosition + state->ballVelocity;
+static TMAtlasRegion SpriteRegion(GameState *state, unsigned int sprite) {
+    switch(sprite) {
+        case GAME_SPRITE_PADDLE_1: return state->paddle1Region;
+        case GAME_SPRITE_PADDLE_2: return state->paddle2Region;
+        default: return state->donutRegion;
+    }
 }
 
-void GameRender(GameState *state) {
+static void FramePushEntities(GameState *state, GameFrame *frame, TMArena *arena, float alpha, float angle) {
+    TMEntityStore *entities = state->entities;
+    unsigned int drawable = TM_COMPONENT_POSITION | TM_COMPONENT_SIZE | TM_COMPONENT_SPRITE;
+    // manuel: only what the broadphase finds on screen, with some margin for the
+    // interpolation and the border clamping after the broadphase was built
+    float halfWidth = frame->width * 0.5f + GAME_BROADPHASE_CELL_SIZE;
+    float halfHeight = frame->height * 0.5f + GAME_BROADPHASE_CELL_SIZE;
+    TMAABB viewport{TMVec2{-halfWidth, -halfHeight}, TMVec2{halfWidth, halfHeight}};
+    unsigned int trailsCount = 0;
+    unsigned int maxVisible = entities->count;
+    unsigned int *visible = TM_ARENA_PUSH_ARRAY(arena, unsigned int, maxVisible);
+    unsigned int visibleCount = TMSpatialHashQueryRect(state->broadphase, viewport, visible, maxVisible);
+    if(visibleCount > maxVisible) visibleCount = maxVisible;
+    for(unsigned int v = 0; v < visibleCount; ++v) {
+        unsigned int i = visible[v];
+        unsigned int mask = entities->masks[i];
+        if((mask & drawable) != drawable) continue;
+        // manuel: moving entities are blended between the last two steps and spin, the
+        // paddles follow the finger and are drawn where they are so they don't lag behind it
+        TMVec2 position = entities->positions[i];
+        float rotation = 0;
+        if(mask & TM_COMPONENT_VELOCITY) {
+            position = TMVec2Lerp(entities->previousPositions[i], position, alpha);
+            rotation = angle;
+            if(trailsCount < GAME_MAX_TRAILS) {
+                FramePushEffect(frame, GAME_EFFECT_TRAIL, position);
+                trailsCount++;
+            }
+        }
+        TMEntitySprite sprite = entities->sprites[i];
+        FramePushSprite(frame, SpriteRegion(state, sprite.id), sprite.layer, position, entities->sizes[i], rotation);
+    }
+}
 
-    if(TMRendererUpdateRenderArea(state->renderer)) {
-        UpdateProjectionsMatrices(state);
+void GameBuildFrame(GameState *state, GameFrame *frame, float alpha) {
+    TMArena *arena = TMFrameArenaBegin(state->frameArena);
+    frame->width = state->width;
+    frame->height = state->height;
+    frame->spritesCount = 0;
+    frame->meshesCount = 0;
+    frame->effectsCount = 0;
+    UpdateProjectionsMatrices(frame);
+
+    float width = (float)state->width;
+    float height = (float)state->height;
+
+    float angle = state->previousAngle + (state->angle - state->previousAngle) * alpha;
+
+    // manuel: the background, then the sprite of every entity
+    TMAtlasRegion background{state->backgroundTexture, TMVec4{0, 0, 1, 1}};
+    FramePushSprite(frame, background, 0, TMVec2{0, 0}, TMVec2{width, height}, 0);
+    FramePushEntities(state, frame, arena, alpha, angle);
+    for(unsigned int i = 0; i < state->hitsCount; ++i) {
+        FramePushEffect(frame, GAME_EFFECT_SPARKS, state->hits[i]);
     }
+    state->hitsCount = 0;
 
-    TMRendererClear(0.1f, 0.5f, 0.1f, 1.0f, TM_COLOR_BUFFER_BIT|TM_DEPTH_BUFFER_BIT);
+    // manuel: the 3d cube, the camera is at z = 10 and the far plane at 100
+    TMMat4 trans = TMMat4Translate(2, 4, 0);
+    TMMat4 rotat = TMMat4RotateY(angle) * TMMat4RotateX(angle);
+    FramePushMesh(frame, state->cubeBuffer, state->moonTexture, trans * rotat, 10.0f / 100.0f);
+}
+
+// manuel: every frame is drawn once, so every hit gets its sparks once. The trails keep
+// their emitter while the frames keep sending them in the same order
+static void UpdateParticles(GameState *state, GameFrame *frame, float dt) {
+    unsigned int trailsCount = 0;
+    for(unsigned int i = 0; i < frame->effectsCount; ++i) {
+        GameEffect *effect = frame->effects + i;
+        if(effect->type == GAME_EFFECT_SPARKS) {
+            TMParticleEmitterCreate(state->particles, &gSparksDesc, effect->position);
+        } else if(effect->type == GAME_EFFECT_TRAIL && trailsCount < GAME_MAX_TRAILS) {
+            if(trailsCount == state->trailsCount) {
+                state->trails[state->trailsCount++] = TMParticleEmitterCreate(state->particles, &gTrailDesc,
+                                                                              effect->position);
+            } else {
+                TMParticleEmitterSetPosition(state->trails[trailsCount], effect->position);
+            }
+            trailsCount++;
+        }
+    }
+    while(state->trailsCount > trailsCount) {
+        TMParticleEmitterDestroy(state->particles, state->trails[--state->trailsCount]);
+    }
+    TMParticleSystemUpdate(state->particles, dt);
+}
+
+void GameRenderFrame(GameState *state, GameFrame *frame) {
+    TMTextureLoaderUpdate(state->textureLoader, GAME_TEXTURE_UPLOAD_BUDGET);
+
+    float frameTime = TMRendererGetFrameTime(state->renderer);
+    TMDynamicResolutionUpdate(&state->resolution, frameTime);
+    // manuel: the particles run at the display rate, a long hitch should not throw them off screen
+    UpdateParticles(state, frame, frameTime < 0.1f ? frameTime : 0.1f);
+    int sceneWidth, sceneHeight;
+    TMDynamicResolutionGetSize(&state->resolution,
+                               TMRendererGetWidth(state->renderer), TMRendererGetHeight(state->renderer),
+                               &sceneWidth, &sceneHeight);
+    TMRendererFramebufferResize(state->sceneFramebuffer, sceneWidth, sceneHeight);
+
+    // manuel: the scene depth is never read after the pass, don't write it back
+    TMRenderPass scenePass{};
+    scenePass.framebuffer = state->sceneFramebuffer;
+    scenePass.colorLoad = TM_LOAD_ACTION_CLEAR;
+    scenePass.colorStore = TM_STORE_ACTION_STORE;
+    scenePass.depthLoad = TM_LOAD_ACTION_CLEAR;
+    scenePass.depthStore = TM_STORE_ACTION_DONT_CARE;
+    scenePass.clearColor[0] = 0.1f;
+    scenePass.clearColor[1] = 0.5f;
+    scenePass.clearColor[2] = 0.1f;
+    scenePass.clearColor[3] = 1.0f;
+    scenePass.clearDepth = 1.0f;
+    TMRendererBeginPass(state->renderer, &scenePass);
 
     // manuel: set the shader
     TMRendererBindShader(state->shader);
-    TMRendererShaderUpdate(state->shader, "uProj", state->orthographic);
-
-    // manuel: render the background
-    int width = TMRendererGetWidth(state->renderer);
-    int height = TMRendererGetHeight(state->renderer);
-    static float angle = 0.0f;
-
-    TMMat4 scale = TMMat4Identity();
-    TMMat4 trans = TMMat4Identity();
-    TMMat4 rotat = TMMat4Identity();
-    TMMat4 world = TMMat4Identity();
-
-    scale = TMMat4Scale(width, height, 1);
-    world = scale;
-    TMRendererShaderUpdate(state->shader, "uWorld", world);
-    // manuel: set the background texture
-    TMRendererTextureBind(state->backgroundTexture, state->shader, "uTexture", 0);
-    // manuel: draw the background
-    TMRendererDrawBufferElements(state->buffer);
-    // manuel: draw player one
-    scale = TMMat4Scale(state->player1Size.x, state->player1Size.y, 1);
-    trans = TMMat4Translate(state->player1Position.x, state->player1Position.y, 0);
-    world = trans * scale;
-    TMRendererShaderUpdate(state->shader, "uWorld", world);
-    TMRendererTextureBind(state->paddle1Texture, state->shader, "uTexture", 0);
-    TMRendererDrawBufferElements(state->buffer);
-    // manuel: draw player two
-    scale = TMMat4Scale(state->player2Size.x, state->player2Size.y, 1);
-    trans = TMMat4Translate(state->player2Position.x, state->player2Position.y, 0);
-    world = trans * scale;
-    TMRendererShaderUpdate(state->shader, "uWorld", world);
-    TMRendererTextureBind(state->paddle2Texture, state->shader, "uTexture", 0);
-    TMRendererDrawBufferElements(state->buffer);
-    // manuel: draw donut
-    scale = TMMat4Scale(state->ballSize.x, state->ballSize.y, 1);
-    trans = TMMat4Translate(state->ballPosition.x, state->ballPosition.y, 0);
-    rotat = TMMat4RotateZ(angle);
-    world = trans *  rotat * scale;
-    TMRendererShaderUpdate(state->shader, "uWorld", world);
-    TMRendererTextureBind(state->donutTexture, state->shader, "uTexture", 0);
-    TMRendererDrawBufferElements(state->buffer);
-
-
-    // manuel: draw the 3d cube
-    TMRendererShaderUpdate(state->shader, "uProj", state->perspective);
-    TMRendererDepthTestEnable();
-
-    trans = TMMat4Translate(2, 4, 0);
-    rotat = TMMat4RotateY(angle) * TMMat4RotateX(angle);
-    world = trans * rotat;
-    TMRendererShaderUpdate(state->shader, "uWorld", world);
-    TMRendererTextureBind(state->moonTexture, state->shader, "uTexture", 0);
-    TMRendererDrawBufferArray(state->cubeBuffer);
 
+    // manuel: draw all the sprites in one batch
+    TMSpriteBatchBegin(state->spriteBatch, &state->shaderUniforms, frame->orthographic);
+    for(unsigned int i = 0; i < frame->spritesCount; ++i) {
+        GameSprite *sprite = frame->sprites + i;
+        TMSpriteBatchPush(state->spriteBatch, &state->shaderUniforms, sprite->texture, sprite->layer,
+                          sprite->position, sprite->size, sprite->rotation, sprite->uvRect);
+    }
+    TMSpriteBatchEnd(state->spriteBatch);
+
+    // manuel: the particles on top of the sprites
+    TMRendererBindShader(state->instancedShader);
+    TMRendererShaderUpdate(state->instancedShader, state->uInstancedProj, frame->orthographic);
+    TMRendererTextureBind(state->particleTexture, state->instancedShader, state->uInstancedTexture, 0);
+    TMParticleSystemDraw(state->particles, state->buffer);
+
+    // manuel: queue the 3d geometry, the queue sorts it and submits it
+    TMRenderQueueClear(state->renderQueue);
+    for(unsigned int i = 0; i < frame->meshesCount; ++i) {
+        GameMesh *mesh = frame->meshes + i;
+        uint64_t key = TMRenderQueueMakeKey(0, false, state->shader, mesh->texture, mesh->depth);
+        TMRenderQueuePush(state->renderQueue, key, mesh->buffer, &state->shaderUniforms, mesh->texture,
+                          frame->perspective, mesh->world, TM_RENDER_COMMAND_DEPTH_TEST);
+    }
+    TMRenderQueueSubmit(state->renderQueue);
     TMRendererDepthTestDisable();
+    TMRendererEndPass(state->renderer);
+
+    // manuel: the blit covers the whole window, its old contents are never loaded
+    TMRenderPass windowPass{};
+    windowPass.framebuffer = NULL;
+    windowPass.colorLoad = TM_LOAD_ACTION_DONT_CARE;
+    windowPass.colorStore = TM_STORE_ACTION_STORE;
+    windowPass.depthLoad = TM_LOAD_ACTION_DONT_CARE;
+    windowPass.depthStore = TM_STORE_ACTION_DONT_CARE;
+    TMRendererBeginPass(state->renderer, &windowPass);
+    TMRendererFramebufferBlit(state->renderer, state->sceneFramebuffer);
+    TMRendererEndPass(state->renderer);
+}
+
+// manuel: the context is gone with every GL object in it, build them all again
+static void ReloadRenderer(GameState *state) {
+    TMRenderer *renderer = state->renderer;
+    android_app *pApp = TMRendererGetApp(renderer);
+    AAssetManager *assetManager = TMRendererGetAssetManager(renderer);
+    GameShutdownRenderer(state, renderer);
+    TMRendererDestroy(renderer);
+    GameInitializeRenderer(state, TMRendererCreate(pApp, assetManager, 0));
+}
 
-    angle += 0.02f;
+// manuel: a surface can fail for other reasons than a lost context, try it again on the
+// next frames and build the whole renderer again when it keeps failing
+static void CreateSurface(GameState *state, android_app *pApp) {
+    if(TMRendererSurfaceCreate(state->renderer, pApp)) {
+        state->surfacePending = false;
+        state->surfaceRetries = 0;
+        return;
+    }
+    if(TMRendererIsContextLost(state->renderer) || state->surfaceRetries >= GAME_SURFACE_MAX_RETRIES) {
+        ReloadRenderer(state);
+        state->surfacePending = !TMRendererHasSurface(state->renderer);
+        state->surfaceRetries = 0;
+        return;
+    }
+    TM_LOG_INFO("WARNING: window surface not created, trying again next frame\n");
+    state->surfacePending = true;
+    state->surfaceRetries++;
+}
+
+void GameWindowCreated(GameState *state, android_app *pApp) {
+    CreateSurface(state, pApp);
+}
+
+void GameWindowDestroyed(GameState *state) {
+    state->surfacePending = false;
+    state->surfaceRetries = 0;
+    TMRendererSurfaceDestroy(state->renderer);
+}
+
+void GameRender(GameState *state, float alpha) {
+    if(!TMRendererHasSurface(state->renderer) && state->surfacePending) {
+        CreateSurface(state, TMRendererGetApp(state->renderer));
+    }
+    if(!TMRendererHasSurface(state->renderer)) return;
+
+    TMRendererUpdateRenderArea(state->renderer);
+    state->width = TMRendererGetWidth(state->renderer);
+    state->height = TMRendererGetHeight(state->renderer);
+
+    static GameFrame frame;
+    GameBuildFrame(state, &frame, alpha);
+    GameRenderFrame(state, &frame);
 
     TMRendererPresent(state->renderer);
+    if(TMRendererIsContextLost(state->renderer)) {
+        ReloadRenderer(state);
+    }
 }
 
 void GameShutdown(GameState *state) {
-    TMRendererTextureDestroy(state->renderer, state->moonTexture);
-    TMRendererTextureDestroy(state->renderer, state->donutTexture);
-    TMRendererTextureDestroy(state->renderer, state->backgroundTexture);
-    TMRendererTextureDestroy(state->renderer, state->paddle1Texture);
-    TMRendererTextureDestroy(state->renderer, state->paddle2Texture);
-    TMRendererBufferDestroy(state->renderer, state->cubeBuffer);
-    TMRendererBufferDestroy(state->renderer, state->buffer);
-    TMRendererShaderDestroy(state->renderer, state->shader);
-    TMRendererDestroy(state->renderer);
-}
\ No newline at end of file
+    TMRenderer *renderer = state->renderer;
+    GameShutdownRenderer(state, renderer);
+    TMRendererDestroy(renderer);
+    GameShutdownSimulation(state);
+}
+
+void GameShutdownSimulation(GameState *state) {
+    free(state->impacts);
+    TMFrameArenaDestroy(state->frameArena);
+    TMSpatialHashDestroy(state->staticBroadphase);
+    TMSpatialHashDestroy(state->broadphase);
+    TMEntityStoreDestroy(state->entities);
+    state->entities = NULL;
+    TMJobSystemDestroy(state->jobs);
+    state->jobs = NULL;
+}
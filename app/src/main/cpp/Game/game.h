@@ -8,44 +8,176 @@
 #include <android/log.h>
 #include "../TMEngine//tm_renderer.h"
 #include "../TMEngine/tm_input.h"
+#include "../TMEngine/tm_sprite_batch.h"
+#include "../TMEngine/tm_render_queue.h"
+#include "../TMEngine/tm_texture_atlas.h"
+#include "../TMEngine/tm_texture_loader.h"
+#include "../TMEngine/tm_dynamic_resolution.h"
+#include "../TMEngine/tm_entity.h"
+#include "../TMEngine/tm_collision.h"
+#include "../TMEngine/tm_job_system.h"
+#include "../TMEngine/tm_particle_system.h"
+#include "../TMEngine/utils/tm_arena.h"
 
 
 #define ARRAY_LENGTH(array) (sizeof(array)/sizeof(array[0]))
 #define TM_LOG_INFO(...) ((void)__android_log_print(ANDROID_LOG_INFO, "App2", __VA_ARGS__))
 
+#define GAME_FRAME_MAX_MESHES 16
+// bytes of texture data uploaded per frame while textures are streaming in
+#define GAME_TEXTURE_UPLOAD_BUDGET (256 * 1024)
+// the simulation runs at a fixed rate, independent of the display refresh rate
+#define GAME_SIMULATION_STEP (1.0f / 60.0f)
+#define GAME_SIMULATION_MAX_STEPS 5
+// frames a window surface is tried again before the whole renderer is built again
+#define GAME_SURFACE_MAX_RETRIES 3
+#define GAME_MAX_ENTITIES 4096
+// every entity can be on screen at once, plus the background
+#define GAME_FRAME_MAX_SPRITES (GAME_MAX_ENTITIES + 1)
+#define GAME_BALLS_COUNT 1
+// about the size of a ball
+#define GAME_BROADPHASE_CELL_SIZE 256.0f
+// the screen borders plus the static colliders a ball can reach in one step
+#define GAME_MAX_COLLISION_TARGETS 64
+#define GAME_MAX_IMPACTS 8
+// moving colliders per collision job
+#define GAME_COLLISION_BATCH_SIZE 256
+// the sparks of the hits plus the trails of the balls
+#define GAME_MAX_PARTICLES 32768
+// each kind of effect has its own budget, many balls can't starve the sparks.
+// Hits past the budget in one frame throw no sparks, balls past it leave no trail
+#define GAME_FRAME_MAX_SPARKS 32
+#define GAME_MAX_TRAILS 8
+#define GAME_FRAME_MAX_EFFECTS (GAME_FRAME_MAX_SPARKS + GAME_MAX_TRAILS)
+// transient data of the game thread, per frame
+#define GAME_FRAME_ARENA_SIZE (64 * 1024)
+
+// sprite ids of the entities
+#define GAME_SPRITE_DONUT 0
+#define GAME_SPRITE_PADDLE_1 1
+#define GAME_SPRITE_PADDLE_2 2
+
+// effects the render side turns into particles
+#define GAME_EFFECT_SPARKS 0
+#define GAME_EFFECT_TRAIL 1
+
 struct android_app;
 struct AAssetManager;
 
+struct GameSprite {
+    TMTexture texture;
+    unsigned int layer;
+    TMVec2 position;
+    TMVec2 size;
+    float rotation;
+    TMVec4 uvRect;
+};
+
+struct GameEffect {
+    unsigned int type;
+    TMVec2 position;
+};
+
+struct GameMesh {
+    TMBuffer buffer;
+    TMTexture texture;
+    TMMat4 world;
+    float depth;
+};
+
+// everything the render side needs to draw one frame, built by GameBuildFrame
+// and only read by GameRenderFrame, so it can be drawn on another thread
+struct GameFrame {
+    int width;
+    int height;
+    TMMat4 orthographic;
+    TMMat4 perspective;
+    GameSprite sprites[GAME_FRAME_MAX_SPRITES];
+    unsigned int spritesCount;
+    GameMesh meshes[GAME_FRAME_MAX_MESHES];
+    unsigned int meshesCount;
+    GameEffect effects[GAME_FRAME_MAX_EFFECTS];
+    unsigned int effectsCount;
+};
+
 struct GameState {
     TMRenderer *renderer;
-    TMShader *shader;
+    TMJobSystem *jobs;
+    TMShader shader;
+    // proj, world and texture of shader, set by the sprite batch and the render queue
+    TMShaderUniforms shaderUniforms;
+    TMUniform uView;
 
-    TMBuffer *buffer;
-    TMBuffer *cubeBuffer;
+    TMBuffer buffer;
+    TMBuffer cubeBuffer;
+    TMSpriteBatch *spriteBatch;
+    TMRenderQueue *renderQueue;
 
-    TMTexture *donutTexture;
-    TMTexture *backgroundTexture;
-    TMTexture *paddle1Texture;
-    TMTexture *paddle2Texture;
-    TMTexture *moonTexture;
+    TMTextureAtlas *atlas;
+    TMAtlasRegion donutRegion;
+    TMAtlasRegion paddle1Region;
+    TMAtlasRegion paddle2Region;
+    TMTextureLoader *textureLoader;
+    TMFramebuffer *sceneFramebuffer;
+    TMDynamicResolution resolution;
+    TMTexture backgroundTexture;
+    TMTexture moonTexture;
+
+    // manuel: the particles only look good, they live on the render side
+    TMShader instancedShader;
+    TMUniform uInstancedProj;
+    TMUniform uInstancedView;
+    TMUniform uInstancedTexture;
+    TMTexture particleTexture;
+    TMParticleSystem *particles;
+    TMParticleEmitter *trails[GAME_MAX_TRAILS];
+    unsigned int trailsCount;
 
-    TMMat4 perspective;
-    TMMat4 orthographic;
     TMMat4 view;
 
-    TMVec2 player1Position;
-    TMVec2 player1Size;
-    TMVec2 player2Position;
-    TMVec2 player2Size;
-    TMVec2 ballPosition;
-    TMVec2 ballVelocity;
-    TMVec2 ballSize;
+    int width;
+    int height;
+    float angle;
+    // the window surface failed without a context loss, GameRender tries again
+    bool surfacePending;
+    unsigned int surfaceRetries;
 
+    // manuel: the paddles and the balls
+    TMEntityStore *entities;
+    TMEntity player1;
+    TMEntity player2;
+    // the entities by their size, rebuilt every step, ids are dense indices
+    TMSpatialHash *broadphase;
+    TMSpatialHash *staticBroadphase;
+    // temporary arrays of the frame being built
+    TMFrameArena *frameArena;
+    // impacts of every moving collider in the last step, written by the collision jobs
+    unsigned char *impacts;
+    // where the balls hit something since the last frame was built
+    TMVec2 hits[GAME_FRAME_MAX_SPARKS];
+    unsigned int hitsCount;
+
+    // angle at the start of the last step, rendering blends from it to the current one
+    float previousAngle;
 };
 
+// single threaded: GameInitialize creates the renderer, GameRender builds and draws the frame
 void GameInitialize(GameState *state, android_app *pApp, AAssetManager *assetManager);
+// advances the simulation one fixed step of dt seconds
 void GameUpdate(GameState *state, TMInput *input, float dt);
-void GameRender(GameState *state);
+// alpha blends between the last two simulation steps, see TMClock
+void GameRender(GameState *state, float alpha);
 void GameShutdown(GameState *state);
+// window loss only drops the EGL surface, the context, the GPU resources and the game state stay
+void GameWindowCreated(GameState *state, android_app *pApp);
+void GameWindowDestroyed(GameState *state);
+
+// render thread: the simulation and the GPU resources are initialized separately
+void GameInitializeSimulation(GameState *state);
+void GameShutdownSimulation(GameState *state);
+void GameInitializeRenderer(GameState *state, TMRenderer *renderer);
+void GameShutdownRenderer(GameState *state, TMRenderer *renderer);
+void GameBuildFrame(GameState *state, GameFrame *frame, float alpha);
+void GameRenderFrame(GameState *state, GameFrame *frame);
 
 #endif //MY_APPLICATION_GAME_H
@@ -0,0 +1,59 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_clock.h"
+
+#include <time.h>
+
+static double GetTime() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1000000000.0;
+}
+
+void TMClockInitialize(TMClock *clock, double stepTime, int maxSteps) {
+    clock->stepTime = stepTime;
+    clock->maxSteps = maxSteps > 0 ? maxSteps : 1;
+    TMClockReset(clock);
+}
+
+void TMClockReset(TMClock *clock) {
+    clock->accumulator = 0.0;
+    clock->lastTime = 0.0;
+    clock->alpha = 0.0f;
+    clock->started = false;
+}
+
+int TMClockAdvance(TMClock *clock, double frameTime) {
+    if(frameTime > 0.0) clock->accumulator += frameTime;
+
+    int steps = (int)(clock->accumulator / clock->stepTime);
+    if(steps > clock->maxSteps) {
+        // manuel: too far behind, drop the time we can't simulate
+        steps = clock->maxSteps;
+        clock->accumulator = clock->stepTime * steps;
+    }
+    clock->accumulator -= clock->stepTime * steps;
+    if(clock->accumulator < 0.0) clock->accumulator = 0.0;
+
+    clock->alpha = (float)(clock->accumulator / clock->stepTime);
+    if(clock->alpha > 1.0f) clock->alpha = 1.0f;
+    return steps;
+}
+
+int TMClockTick(TMClock *clock) {
+    double now = GetTime();
+    double frameTime = clock->started ? now - clock->lastTime : 0.0;
+    clock->lastTime = now;
+    clock->started = true;
+    return TMClockAdvance(clock, frameTime);
+}
+
+float TMClockGetAlpha(TMClock *clock) {
+    return clock->alpha;
+}
+
+float TMClockGetStepTime(TMClock *clock) {
+    return (float)clock->stepTime;
+}
@@ -0,0 +1,33 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_CLOCK_H
+#define MY_APPLICATION_TM_CLOCK_H
+
+// Fixed timestep clock. The real time between frames goes into an accumulator and
+// the simulation runs as many steps of exactly stepTime as fit in it, so the game
+// runs at the same speed at 30, 60, 90 or 120 Hz. The time left over is returned
+// as alpha (0..1) to blend between the previous and the current simulation state.
+// After a hitch at most maxSteps run and the rest of the time is dropped, the game
+// slows down for a frame instead of spiraling.
+struct TMClock {
+    double stepTime;
+    double accumulator;
+    double lastTime;
+    int maxSteps;
+    float alpha;
+    bool started;
+};
+
+void TMClockInitialize(TMClock *clock, double stepTime, int maxSteps);
+// forget the time that passed, call it after a pause so the first frame does not catch up
+void TMClockReset(TMClock *clock);
+// adds frameTime seconds and returns the number of steps to simulate
+int TMClockAdvance(TMClock *clock, double frameTime);
+// Advance with the time since the last Tick, the first Tick returns 0 steps
+int TMClockTick(TMClock *clock);
+float TMClockGetAlpha(TMClock *clock);
+float TMClockGetStepTime(TMClock *clock);
+
+#endif //MY_APPLICATION_TM_CLOCK_H
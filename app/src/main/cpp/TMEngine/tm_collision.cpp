@@ -0,0 +1,320 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_collision.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+struct TMSpatialHashItem {
+    unsigned int id;
+    TMAABB box;
+    int cellMinX, cellMinY;
+    int cellMaxX, cellMaxY;
+};
+
+// one per cell covered by an item, grouped by bucket after Build
+struct TMSpatialHashEntry {
+    int cellX, cellY;
+    unsigned int item;
+};
+
+struct TMSpatialHash {
+    float cellSize;
+    float invCellSize;
+
+    TMSpatialHashItem *items;
+    unsigned int itemsCount;
+    unsigned int itemsCapacity;
+
+    TMSpatialHashEntry *entries;
+    unsigned int entriesCount;
+    unsigned int entriesCapacity;
+
+    // bucket b owns entries [bucketStarts[b], bucketStarts[b + 1])
+    unsigned int *bucketStarts;
+    unsigned int bucketsCount;
+};
+
+TMAABB TMAABBFromCenter(TMVec2 center, TMVec2 halfSize) {
+    return TMAABB{
+        TMVec2{center.x - halfSize.x, center.y - halfSize.y},
+        TMVec2{center.x + halfSize.x, center.y + halfSize.y}
+    };
+}
+
+bool TMAABBOverlap(TMAABB a, TMAABB b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y;
+}
+
+// slab of one axis: the times the center enters and leaves [min, max]
+static bool SweepAxis(float position, float delta, float min, float max, float *enter, float *exit) {
+    if(delta == 0.0f) {
+        *enter = -INFINITY;
+        *exit = INFINITY;
+        return position >= min && position <= max;
+    }
+    float t0 = (min - position) / delta;
+    float t1 = (max - position) / delta;
+    *enter = t0 < t1 ? t0 : t1;
+    *exit = t0 < t1 ? t1 : t0;
+    return true;
+}
+
+// how deep box is inside target and the normal of the face it is closest to leaving
+// through, the axis of least penetration. Boxes that only touch do not penetrate
+static bool Penetration(TMAABB box, TMAABB target, TMVec2 *normal, float *depth) {
+    float left = box.max.x - target.min.x;
+    float right = target.max.x - box.min.x;
+    float down = box.max.y - target.min.y;
+    float up = target.max.y - box.min.y;
+    if(left <= 0.0f || right <= 0.0f || down <= 0.0f || up <= 0.0f) return false;
+    *normal = TMVec2{-1.0f, 0.0f};
+    *depth = left;
+    if(right < *depth) {
+        *normal = TMVec2{1.0f, 0.0f};
+        *depth = right;
+    }
+    if(down < *depth) {
+        *normal = TMVec2{0.0f, -1.0f};
+        *depth = down;
+    }
+    if(up < *depth) {
+        *normal = TMVec2{0.0f, 1.0f};
+        *depth = up;
+    }
+    return true;
+}
+
+bool TMSweptAABB(TMAABB box, TMVec2 displacement, TMAABB target, float *time, TMVec2 *normal) {
+    // manuel: already inside, it hits now unless it is on its way out of the nearest face
+    float depth;
+    if(Penetration(box, target, normal, &depth)) {
+        *time = 0.0f;
+        return displacement.x * normal->x + displacement.y * normal->y < 0.0f;
+    }
+
+    // manuel: grow the target by the box and sweep the center of the box as a point
+    TMVec2 halfSize{(box.max.x - box.min.x) * 0.5f, (box.max.y - box.min.y) * 0.5f};
+    TMVec2 center{box.min.x + halfSize.x, box.min.y + halfSize.y};
+    TMAABB expanded{TMVec2{target.min.x - halfSize.x, target.min.y - halfSize.y},
+                    TMVec2{target.max.x + halfSize.x, target.max.y + halfSize.y}};
+
+    float enterX, exitX, enterY, exitY;
+    if(!SweepAxis(center.x, displacement.x, expanded.min.x, expanded.max.x, &enterX, &exitX)) return false;
+    if(!SweepAxis(center.y, displacement.y, expanded.min.y, expanded.max.y, &enterY, &exitY)) return false;
+    float enter = enterX > enterY ? enterX : enterY;
+    float exit = exitX < exitY ? exitX : exitY;
+    if(enter > exit || enter < 0.0f || enter > 1.0f) return false;
+
+    *time = enter;
+    if(enterX > enterY) {
+        *normal = TMVec2{displacement.x > 0.0f ? -1.0f : 1.0f, 0.0f};
+    } else {
+        *normal = TMVec2{0.0f, displacement.y > 0.0f ? -1.0f : 1.0f};
+    }
+    return true;
+}
+
+int TMSweptAABBBounce(TMVec2 *position, TMVec2 *velocity, TMVec2 halfSize, float dt,
+                      const TMAABB *targets, unsigned int targetsCount, unsigned int maxImpacts) {
+    int impacts = 0;
+    // manuel: something moved into the box (a paddle under the finger, a screen that
+    // shrank), push it out of the nearest face first so the sweep starts from outside
+    for(unsigned int i = 0; i < targetsCount && (unsigned int)impacts < maxImpacts; ++i) {
+        TMVec2 normal;
+        float depth;
+        if(!Penetration(TMAABBFromCenter(*position, halfSize), targets[i], &normal, &depth)) continue;
+        position->x += normal.x * depth;
+        position->y += normal.y * depth;
+        if(normal.x * velocity->x < 0.0f) velocity->x = -velocity->x;
+        if(normal.y * velocity->y < 0.0f) velocity->y = -velocity->y;
+        impacts++;
+    }
+    if((unsigned int)impacts >= maxImpacts) return impacts;
+
+    float remaining = dt;
+    while(remaining > 0.0f) {
+        TMVec2 displacement{velocity->x * remaining, velocity->y * remaining};
+        TMAABB box = TMAABBFromCenter(*position, halfSize);
+        float firstTime = 2.0f;
+        TMVec2 firstNormal{0, 0};
+        for(unsigned int i = 0; i < targetsCount; ++i) {
+            float time;
+            TMVec2 normal;
+            if(TMSweptAABB(box, displacement, targets[i], &time, &normal) && time < firstTime) {
+                firstTime = time;
+                firstNormal = normal;
+            }
+        }
+        if(firstTime > 1.0f) {
+            position->x += displacement.x;
+            position->y += displacement.y;
+            break;
+        }
+        position->x += displacement.x * firstTime;
+        position->y += displacement.y * firstTime;
+        if(firstNormal.x != 0.0f) velocity->x = -velocity->x;
+        if(firstNormal.y != 0.0f) velocity->y = -velocity->y;
+        remaining -= remaining * firstTime;
+        // manuel: out of impacts, stay at the contact instead of going through
+        if((unsigned int)++impacts == maxImpacts) break;
+    }
+    return impacts;
+}
+
+static int CellCoord(TMSpatialHash *hash, float value) {
+    return (int)floorf(value * hash->invCellSize);
+}
+
+static unsigned int CellBucket(TMSpatialHash *hash, int x, int y) {
+    unsigned int h = (unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u;
+    return h & (hash->bucketsCount - 1);
+}
+
+static unsigned int NextPowerOfTwo(unsigned int value) {
+    unsigned int result = 1;
+    while(result < value) result <<= 1;
+    return result;
+}
+
+TMSpatialHash *TMSpatialHashCreate(float cellSize, unsigned int capacity) {
+    TMSpatialHash *hash = (TMSpatialHash *)malloc(sizeof(TMSpatialHash));
+    hash->cellSize = cellSize;
+    hash->invCellSize = 1.0f / cellSize;
+    hash->itemsCapacity = capacity;
+    hash->items = (TMSpatialHashItem *)malloc(sizeof(TMSpatialHashItem) * capacity);
+    hash->itemsCount = 0;
+    // manuel: most boxes touch up to 4 cells, the entries grow if they need more
+    hash->entriesCapacity = capacity * 4;
+    hash->entries = (TMSpatialHashEntry *)malloc(sizeof(TMSpatialHashEntry) * hash->entriesCapacity);
+    hash->entriesCount = 0;
+    hash->bucketsCount = NextPowerOfTwo(capacity * 2);
+    hash->bucketStarts = (unsigned int *)malloc(sizeof(unsigned int) * (hash->bucketsCount + 1));
+    return hash;
+}
+
+void TMSpatialHashDestroy(TMSpatialHash *hash) {
+    free(hash->bucketStarts);
+    free(hash->entries);
+    free(hash->items);
+    free(hash);
+}
+
+void TMSpatialHashClear(TMSpatialHash *hash) {
+    hash->itemsCount = 0;
+    hash->entriesCount = 0;
+}
+
+bool TMSpatialHashInsert(TMSpatialHash *hash, unsigned int id, TMAABB box) {
+    if(hash->itemsCount == hash->itemsCapacity) return false;
+    TMSpatialHashItem *item = hash->items + hash->itemsCount++;
+    item->id = id;
+    item->box = box;
+    item->cellMinX = CellCoord(hash, box.min.x);
+    item->cellMinY = CellCoord(hash, box.min.y);
+    item->cellMaxX = CellCoord(hash, box.max.x);
+    item->cellMaxY = CellCoord(hash, box.max.y);
+    hash->entriesCount += (unsigned int)((item->cellMaxX - item->cellMinX + 1) * (item->cellMaxY - item->cellMinY + 1));
+    return true;
+}
+
+// counting sort of the entries by bucket: count, prefix sum, scatter
+void TMSpatialHashBuild(TMSpatialHash *hash) {
+    if(hash->entriesCount > hash->entriesCapacity) {
+        free(hash->entries);
+        hash->entriesCapacity = hash->entriesCount + hash->entriesCount / 2;
+        hash->entries = (TMSpatialHashEntry *)malloc(sizeof(TMSpatialHashEntry) * hash->entriesCapacity);
+    }
+
+    unsigned int *starts = hash->bucketStarts;
+    memset(starts, 0, sizeof(unsigned int) * (hash->bucketsCount + 1));
+    for(unsigned int i = 0; i < hash->itemsCount; ++i) {
+        TMSpatialHashItem *item = hash->items + i;
+        for(int y = item->cellMinY; y <= item->cellMaxY; ++y) {
+            for(int x = item->cellMinX; x <= item->cellMaxX; ++x) {
+                starts[CellBucket(hash, x, y) + 1]++;
+            }
+        }
+    }
+    for(unsigned int b = 0; b < hash->bucketsCount; ++b) {
+        starts[b + 1] += starts[b];
+    }
+    // scatter with starts[b] as the cursor, it ends up at the start of bucket b + 1
+    for(unsigned int i = 0; i < hash->itemsCount; ++i) {
+        TMSpatialHashItem *item = hash->items + i;
+        for(int y = item->cellMinY; y <= item->cellMaxY; ++y) {
+            for(int x = item->cellMinX; x <= item->cellMaxX; ++x) {
+                TMSpatialHashEntry *entry = hash->entries + starts[CellBucket(hash, x, y)]++;
+                entry->cellX = x;
+                entry->cellY = y;
+                entry->item = i;
+            }
+        }
+    }
+    for(unsigned int b = hash->bucketsCount; b > 0; --b) {
+        starts[b] = starts[b - 1];
+    }
+    starts[0] = 0;
+}
+
+static int MaxInt(int a, int b) {
+    return a > b ? a : b;
+}
+
+unsigned int TMSpatialHashQueryPairs(TMSpatialHash *hash, TMCollisionPair *pairs, unsigned int maxPairs) {
+    unsigned int count = 0;
+    for(unsigned int i = 0; i < hash->itemsCount; ++i) {
+        TMSpatialHashItem *a = hash->items + i;
+        for(int y = a->cellMinY; y <= a->cellMaxY; ++y) {
+            for(int x = a->cellMinX; x <= a->cellMaxX; ++x) {
+                unsigned int bucket = CellBucket(hash, x, y);
+                unsigned int end = hash->bucketStarts[bucket + 1];
+                for(unsigned int e = hash->bucketStarts[bucket]; e < end; ++e) {
+                    TMSpatialHashEntry *entry = hash->entries + e;
+                    // entries of other cells that share the bucket, and each pair once
+                    if(entry->item <= i || entry->cellX != x || entry->cellY != y) continue;
+                    TMSpatialHashItem *b = hash->items + entry->item;
+                    // manuel: two boxes can share many cells, only the first shared
+                    // cell (the min corner of their overlap) reports the pair
+                    if(x != MaxInt(a->cellMinX, b->cellMinX) || y != MaxInt(a->cellMinY, b->cellMinY)) continue;
+                    if(!TMAABBOverlap(a->box, b->box)) continue;
+                    if(count < maxPairs) {
+                        pairs[count].a = a->id < b->id ? a->id : b->id;
+                        pairs[count].b = a->id < b->id ? b->id : a->id;
+                    }
+                    count++;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+unsigned int TMSpatialHashQueryRect(TMSpatialHash *hash, TMAABB rect, unsigned int *ids, unsigned int maxIds) {
+    int minX = CellCoord(hash, rect.min.x);
+    int minY = CellCoord(hash, rect.min.y);
+    int maxX = CellCoord(hash, rect.max.x);
+    int maxY = CellCoord(hash, rect.max.y);
+    unsigned int count = 0;
+    for(int y = minY; y <= maxY; ++y) {
+        for(int x = minX; x <= maxX; ++x) {
+            unsigned int bucket = CellBucket(hash, x, y);
+            unsigned int end = hash->bucketStarts[bucket + 1];
+            for(unsigned int e = hash->bucketStarts[bucket]; e < end; ++e) {
+                TMSpatialHashEntry *entry = hash->entries + e;
+                if(entry->cellX != x || entry->cellY != y) continue;
+                TMSpatialHashItem *item = hash->items + entry->item;
+                // same trick as the pairs, the first cell shared with the rect reports it
+                if(x != MaxInt(minX, item->cellMinX) || y != MaxInt(minY, item->cellMinY)) continue;
+                if(!TMAABBOverlap(item->box, rect)) continue;
+                if(count < maxIds) ids[count] = item->id;
+                count++;
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,58 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_COLLISION_H
+#define MY_APPLICATION_TM_COLLISION_H
+
+#include "utils/tm_math.h"
+
+struct TMAABB {
+    TMVec2 min;
+    TMVec2 max;
+};
+
+// ids of two boxes that overlap, a < b
+struct TMCollisionPair {
+    unsigned int a;
+    unsigned int b;
+};
+
+struct TMSpatialHash;
+
+TMAABB TMAABBFromCenter(TMVec2 center, TMVec2 halfSize);
+bool TMAABBOverlap(TMAABB a, TMAABB b);
+
+// Continuous collision of a box moving by displacement against a still target.
+// Returns true if they touch during the move, time is the fraction of the
+// displacement at the impact (0..1) and normal points out of the face that was hit.
+// Boxes that already overlap at the start hit at time 0 on the face of least
+// penetration, unless they move out through it. Boxes that move away never hit, so
+// a box resting against or stuck in a target can leave it.
+bool TMSweptAABB(TMAABB box, TMVec2 displacement, TMAABB target, float *time, TMVec2 *normal);
+// Moves a box of halfSize centered at position by velocity * dt. Every time it hits
+// one of the targets it stops at the impact, reflects the velocity on the normal and
+// keeps going with the time left, up to maxImpacts times. A box that starts inside a
+// target is pushed out on the face of least penetration first, and its velocity is
+// reflected if it was moving in, that counts as an impact. Returns the impacts
+int TMSweptAABBBounce(TMVec2 *position, TMVec2 *velocity, TMVec2 halfSize, float dt,
+                      const TMAABB *targets, unsigned int targetsCount, unsigned int maxImpacts);
+
+// Broadphase over a uniform grid of square cells. The cells live in a hash table so
+// the world has no bounds. Rebuild it every step: Clear, Insert every box,
+// Build, then ask for the overlapping pairs or for the boxes inside a rect.
+// Pick the cell size around the size of the common objects. A box spanning many
+// cells is stored once per cell.
+TMSpatialHash *TMSpatialHashCreate(float cellSize, unsigned int capacity);
+void TMSpatialHashDestroy(TMSpatialHash *hash);
+void TMSpatialHashClear(TMSpatialHash *hash);
+// returns false when the hash is full, the id is whatever the caller wants back
+bool TMSpatialHashInsert(TMSpatialHash *hash, unsigned int id, TMAABB box);
+void TMSpatialHashBuild(TMSpatialHash *hash);
+// every pair of overlapping boxes once, returns the number of pairs found. Only the
+// first maxPairs are written, call again with a bigger array if it returned more
+unsigned int TMSpatialHashQueryPairs(TMSpatialHash *hash, TMCollisionPair *pairs, unsigned int maxPairs);
+// ids of the boxes that overlap rect, each once. Same return as QueryPairs
+unsigned int TMSpatialHashQueryRect(TMSpatialHash *hash, TMAABB rect, unsigned int *ids, unsigned int maxIds);
+
+#endif //MY_APPLICATION_TM_COLLISION_H
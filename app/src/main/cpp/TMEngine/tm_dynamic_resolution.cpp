@@ -0,0 +1,74 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_dynamic_resolution.h"
+
+#define TM_DYNAMIC_RESOLUTION_SMOOTHING 0.1f
+#define TM_DYNAMIC_RESOLUTION_STEP_DOWN 0.1f
+#define TM_DYNAMIC_RESOLUTION_STEP_UP 0.05f
+// frames to wait after a change before trusting the average again
+#define TM_DYNAMIC_RESOLUTION_SETTLE_FRAMES 15
+#define TM_DYNAMIC_RESOLUTION_INCREASE_FRAMES 120
+#define TM_DYNAMIC_RESOLUTION_MAX_INCREASE_FRAMES 1920
+
+void TMDynamicResolutionInitialize(TMDynamicResolution *resolution, float targetFrameTime,
+                                   float minScale, float maxScale) {
+    resolution->scale = maxScale;
+    resolution->minScale = minScale;
+    resolution->maxScale = maxScale;
+    resolution->targetFrameTime = targetFrameTime;
+    resolution->averageFrameTime = targetFrameTime;
+    resolution->framesSinceChange = 0;
+    resolution->framesToIncrease = TM_DYNAMIC_RESOLUTION_INCREASE_FRAMES;
+    resolution->lastChangeWasIncrease = false;
+}
+
+bool TMDynamicResolutionUpdate(TMDynamicResolution *resolution, float frameTime) {
+    if(frameTime <= 0.0f) return false;
+    // a frame this long is a hitch (loading, app switch), not a fill rate problem
+    if(frameTime > resolution->targetFrameTime * 4.0f) return false;
+
+    resolution->averageFrameTime += (frameTime - resolution->averageFrameTime) * TM_DYNAMIC_RESOLUTION_SMOOTHING;
+    resolution->framesSinceChange++;
+    if(resolution->framesSinceChange < TM_DYNAMIC_RESOLUTION_SETTLE_FRAMES) return false;
+
+    float average = resolution->averageFrameTime;
+    float target = resolution->targetFrameTime;
+    if(average > target * 1.1f && resolution->scale > resolution->minScale) {
+        // a step up that missed the target is undone, anything else drops a full step
+        float step = TM_DYNAMIC_RESOLUTION_STEP_DOWN;
+        if(resolution->lastChangeWasIncrease) {
+            step = TM_DYNAMIC_RESOLUTION_STEP_UP;
+            if(resolution->framesToIncrease < TM_DYNAMIC_RESOLUTION_MAX_INCREASE_FRAMES) {
+                resolution->framesToIncrease *= 2;
+            }
+        }
+        resolution->scale -= step;
+        if(resolution->scale < resolution->minScale) resolution->scale = resolution->minScale;
+        resolution->lastChangeWasIncrease = false;
+        resolution->framesSinceChange = 0;
+        // start from the target so the old slow frames do not cause a second drop
+        resolution->averageFrameTime = target;
+        return true;
+    }
+    if(average < target * 1.02f && resolution->scale < resolution->maxScale &&
+       resolution->framesSinceChange >= resolution->framesToIncrease) {
+        resolution->scale += TM_DYNAMIC_RESOLUTION_STEP_UP;
+        if(resolution->scale > resolution->maxScale) resolution->scale = resolution->maxScale;
+        resolution->lastChangeWasIncrease = true;
+        resolution->framesSinceChange = 0;
+        return true;
+    }
+    return false;
+}
+
+void TMDynamicResolutionGetSize(TMDynamicResolution *resolution, int width, int height,
+                                int *scaledWidth, int *scaledHeight) {
+    int w = ((int)(width * resolution->scale) + 7) & ~7;
+    int h = ((int)(height * resolution->scale) + 7) & ~7;
+    if(w > width) w = width;
+    if(h > height) h = height;
+    *scaledWidth = w < 8 ? 8 : w;
+    *scaledHeight = h < 8 ? 8 : h;
+}
@@ -0,0 +1,31 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_DYNAMIC_RESOLUTION_H
+#define MY_APPLICATION_TM_DYNAMIC_RESOLUTION_H
+
+// Picks the scale of the internal render resolution from the measured frame time.
+// The scale drops quickly when frames run over the target and climbs back slowly
+// while they are on target. A step up that makes frames miss again is undone and the next one
+// waits twice as long, so the scale settles instead of bouncing every few seconds.
+struct TMDynamicResolution {
+    float scale;
+    float minScale;
+    float maxScale;
+    float targetFrameTime;
+    float averageFrameTime;
+    int framesSinceChange;
+    int framesToIncrease;
+    bool lastChangeWasIncrease;
+};
+
+void TMDynamicResolutionInitialize(TMDynamicResolution *resolution, float targetFrameTime,
+                                   float minScale, float maxScale);
+// feed the time of the last frame in seconds, returns true if the scale changed
+bool TMDynamicResolutionUpdate(TMDynamicResolution *resolution, float frameTime);
+// width * scale and height * scale rounded up to multiples of 8, never above width and height
+void TMDynamicResolutionGetSize(TMDynamicResolution *resolution, int width, int height,
+                                int *scaledWidth, int *scaledHeight);
+
+#endif //MY_APPLICATION_TM_DYNAMIC_RESOLUTION_H
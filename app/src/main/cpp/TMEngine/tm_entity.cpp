@@ -0,0 +1,120 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_entity.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+const TMEntity TM_ENTITY_NULL = {0, 0};
+
+TMEntityStore *TMEntityStoreCreate(unsigned int capacity) {
+    TMEntityStore *store = (TMEntityStore *)malloc(sizeof(TMEntityStore));
+    store->capacity = capacity;
+    store->count = 0;
+    store->entities = (TMEntity *)malloc(sizeof(TMEntity) * capacity);
+    store->masks = (unsigned int *)malloc(sizeof(unsigned int) * capacity);
+    store->positions = (TMVec2 *)malloc(sizeof(TMVec2) * capacity);
+    store->previousPositions = (TMVec2 *)malloc(sizeof(TMVec2) * capacity);
+    store->velocities = (TMVec2 *)malloc(sizeof(TMVec2) * capacity);
+    store->sizes = (TMVec2 *)malloc(sizeof(TMVec2) * capacity);
+    store->sprites = (TMEntitySprite *)malloc(sizeof(TMEntitySprite) * capacity);
+    store->colliders = (TMEntityCollider *)malloc(sizeof(TMEntityCollider) * capacity);
+    store->denseIndices = (unsigned int *)malloc(sizeof(unsigned int) * capacity);
+    store->generations = (unsigned int *)malloc(sizeof(unsigned int) * capacity);
+    store->freeIndices = (unsigned int *)malloc(sizeof(unsigned int) * capacity);
+    memset(store->generations, 0, sizeof(unsigned int) * capacity);
+    TMEntityStoreClear(store);
+    return store;
+}
+
+void TMEntityStoreDestroy(TMEntityStore *store) {
+    free(store->freeIndices);
+    free(store->generations);
+    free(store->denseIndices);
+    free(store->colliders);
+    free(store->sprites);
+    free(store->sizes);
+    free(store->velocities);
+    free(store->previousPositions);
+    free(store->positions);
+    free(store->masks);
+    free(store->entities);
+    free(store);
+}
+
+void TMEntityStoreClear(TMEntityStore *store) {
+    // manuel: every live entity dies, bump the generations so their handles fail
+    for(unsigned int i = 0; i < store->count; ++i) {
+        store->generations[store->entities[i].index]++;
+    }
+    store->count = 0;
+    // hand out the low indices first
+    store->freeCount = store->capacity;
+    for(unsigned int i = 0; i < store->capacity; ++i) {
+        store->freeIndices[i] = store->capacity - 1 - i;
+    }
+}
+
+TMEntity TMEntityCreate(TMEntityStore *store, unsigned int components) {
+    if(store->freeCount == 0) return TM_ENTITY_NULL;
+    unsigned int index = store->freeIndices[--store->freeCount];
+    if(store->generations[index] == 0) store->generations[index] = 1;
+
+    unsigned int dense = store->count++;
+    TMEntity entity = {index, store->generations[index]};
+    store->denseIndices[index] = dense;
+    store->entities[dense] = entity;
+    store->masks[dense] = components;
+    store->positions[dense] = TMVec2{0, 0};
+    store->previousPositions[dense] = TMVec2{0, 0};
+    store->velocities[dense] = TMVec2{0, 0};
+    store->sizes[dense] = TMVec2{0, 0};
+    memset(store->sprites + dense, 0, sizeof(TMEntitySprite));
+    memset(store->colliders + dense, 0, sizeof(TMEntityCollider));
+    return entity;
+}
+
+bool TMEntityIsAlive(TMEntityStore *store, TMEntity entity) {
+    return entity.generation != 0 && entity.index < store->capacity &&
+           store->generations[entity.index] == entity.generation &&
+           store->denseIndices[entity.index] < store->count &&
+           store->entities[store->denseIndices[entity.index]].index == entity.index;
+}
+
+int TMEntityGetIndex(TMEntityStore *store, TMEntity entity) {
+    if(!TMEntityIsAlive(store, entity)) return -1;
+    return (int)store->denseIndices[entity.index];
+}
+
+void TMEntityDestroy(TMEntityStore *store, TMEntity entity) {
+    if(!TMEntityIsAlive(store, entity)) return;
+    unsigned int dense = store->denseIndices[entity.index];
+    unsigned int last = --store->count;
+    if(dense != last) {
+        // manuel: keep the arrays packed, the last entity fills the hole
+        store->entities[dense] = store->entities[last];
+        store->masks[dense] = store->masks[last];
+        store->positions[dense] = store->positions[last];
+        store->previousPositions[dense] = store->previousPositions[last];
+        store->velocities[dense] = store->velocities[last];
+        store->sizes[dense] = store->sizes[last];
+        store->sprites[dense] = store->sprites[last];
+        store->colliders[dense] = store->colliders[last];
+        store->denseIndices[store->entities[dense].index] = dense;
+    }
+    store->generations[entity.index]++;
+    store->freeIndices[store->freeCount++] = entity.index;
+}
+
+void TMEntityStoreIntegrate(TMEntityStore *store, float dt, unsigned int skipComponents) {
+    unsigned int moving = TM_COMPONENT_POSITION | TM_COMPONENT_VELOCITY;
+    for(unsigned int i = 0; i < store->count; ++i) {
+        store->previousPositions[i] = store->positions[i];
+        if((store->masks[i] & moving) == moving && !(store->masks[i] & skipComponents)) {
+            store->positions[i].x += store->velocities[i].x * dt;
+            store->positions[i].y += store->velocities[i].y * dt;
+        }
+    }
+}
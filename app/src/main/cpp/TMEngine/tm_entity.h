@@ -0,0 +1,81 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_ENTITY_H
+#define MY_APPLICATION_TM_ENTITY_H
+
+#include "utils/tm_math.h"
+
+// Entity store with the components kept as dense structure of arrays. Every live
+// entity has a slot in [0, count) of each array, removing one moves the last entity
+// into the hole, so systems loop over tightly packed arrays and check the mask.
+// Handles stay valid while the entity lives, the generation makes handles of
+// destroyed entities fail instead of pointing at whatever reused the slot.
+
+#define TM_COMPONENT_POSITION (1 << 0)
+#define TM_COMPONENT_VELOCITY (1 << 1)
+#define TM_COMPONENT_SIZE     (1 << 2)
+#define TM_COMPONENT_SPRITE   (1 << 3)
+#define TM_COMPONENT_COLLIDER (1 << 4)
+
+// collides with others but is never moved by a collision
+#define TM_COLLIDER_STATIC (1 << 0)
+
+// index into the store's handle table, generation 0 is never used by a live entity
+struct TMEntity {
+    unsigned int index;
+    unsigned int generation;
+};
+
+struct TMEntitySprite {
+    // the game decides what the id means (atlas region, texture, ...)
+    unsigned int id;
+    unsigned int layer;
+};
+
+struct TMEntityCollider {
+    // axis aligned box around the position
+    TMVec2 halfSize;
+    unsigned int flags;
+};
+
+struct TMEntityStore {
+    unsigned int capacity;
+    unsigned int count;
+
+    // dense, indexed [0, count)
+    TMEntity *entities;
+    unsigned int *masks;
+    TMVec2 *positions;
+    // position before the last TMEntityStoreIntegrate, for render interpolation
+    TMVec2 *previousPositions;
+    TMVec2 *velocities;
+    TMVec2 *sizes;
+    TMEntitySprite *sprites;
+    TMEntityCollider *colliders;
+
+    // indexed by TMEntity::index
+    unsigned int *denseIndices;
+    unsigned int *generations;
+    unsigned int *freeIndices;
+    unsigned int freeCount;
+};
+
+TMEntityStore *TMEntityStoreCreate(unsigned int capacity);
+void TMEntityStoreDestroy(TMEntityStore *store);
+void TMEntityStoreClear(TMEntityStore *store);
+// returns TM_ENTITY_NULL when the store is full, the components start zeroed
+TMEntity TMEntityCreate(TMEntityStore *store, unsigned int components);
+void TMEntityDestroy(TMEntityStore *store, TMEntity entity);
+bool TMEntityIsAlive(TMEntityStore *store, TMEntity entity);
+// slot of the entity in the dense arrays, only valid until the next destroy. -1 if it is dead
+int TMEntityGetIndex(TMEntityStore *store, TMEntity entity);
+
+// system: previousPositions = positions, then positions += velocities * dt. Entities
+// with any of the skipComponents keep their position, something else moves them
+void TMEntityStoreIntegrate(TMEntityStore *store, float dt, unsigned int skipComponents);
+
+extern const TMEntity TM_ENTITY_NULL;
+
+#endif //MY_APPLICATION_TM_ENTITY_H
@@ -0,0 +1,423 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_job_system.h"
+
+#include <stdio.h>
+#include <sched.h>
+#include <unistd.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#define TM_JOB_SYSTEM_MAX_THREADS 16
+// both powers of two
+#define TM_JOB_SYSTEM_QUEUE_SIZE 2048
+#define TM_JOB_SYSTEM_SLOTS_PER_THREAD 2048
+#define TM_JOB_SYSTEM_SHARED_SIZE 1024
+#define TM_JOB_SYSTEM_BACKGROUND_SIZE 256
+// tries to find work before a worker goes to sleep
+#define TM_JOB_SYSTEM_SPIN_COUNT 64
+#define TM_JOB_SYSTEM_CACHE_LINE 64
+
+struct TMJob {
+    TMJobFunction function;
+    TMJobRangeFunction rangeFunction;
+    void *data;
+    unsigned int begin;
+    unsigned int end;
+    TMJobCounter *counter;
+};
+
+// a job lives in a slot of the thread that started it until some thread takes it
+struct TMJobSlot {
+    TMJob job;
+    std::atomic<bool> used;
+};
+
+// Chase-Lev deque (the C11 version by Le, Pop, Cohen and Zappa Nardelli).
+// Only the owner pushes and pops at the bottom, anybody steals from the top
+struct TMJobQueue {
+    alignas(TM_JOB_SYSTEM_CACHE_LINE) std::atomic<long long> top;
+    alignas(TM_JOB_SYSTEM_CACHE_LINE) std::atomic<long long> bottom;
+    alignas(TM_JOB_SYSTEM_CACHE_LINE) std::atomic<TMJobSlot *> slots[TM_JOB_SYSTEM_QUEUE_SIZE];
+};
+
+// ring of jobs behind the shared mutex
+struct TMJobRing {
+    TMJob *jobs;
+    unsigned int size;
+    unsigned int head;
+    unsigned int count;
+};
+
+struct TMJobThread {
+    TMJobQueue queue;
+    TMJobSlot slots[TM_JOB_SYSTEM_SLOTS_PER_THREAD];
+    unsigned int nextSlot;
+    unsigned int random;
+    std::thread thread;
+};
+
+struct TMJobSystem {
+    // thread 0 is the one that created the job system, the rest are the workers
+    TMJobThread *threads;
+    int threadsCount;
+
+    // jobs started by threads without a queue, and the background jobs of any thread.
+    // Only the workers take background jobs
+    std::mutex sharedMutex;
+    TMJob sharedJobs[TM_JOB_SYSTEM_SHARED_SIZE];
+    TMJob backgroundJobs[TM_JOB_SYSTEM_BACKGROUND_SIZE];
+    TMJobRing shared;
+    TMJobRing background;
+
+    // jobs started and not taken yet, the workers sleep while it is zero
+    std::atomic<int> queuedCount;
+    std::atomic<int> sleepingCount;
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::atomic<bool> quit;
+
+    cpu_set_t bigCores;
+};
+
+static thread_local TMJobSystem *tlsJobSystem;
+static thread_local int tlsThreadIndex;
+
+static bool QueuePush(TMJobQueue *queue, TMJobSlot *slot) {
+    long long bottom = queue->bottom.load(std::memory_order_relaxed);
+    long long top = queue->top.load(std::memory_order_acquire);
+    if(bottom - top >= TM_JOB_SYSTEM_QUEUE_SIZE) return false;
+    queue->slots[bottom & (TM_JOB_SYSTEM_QUEUE_SIZE - 1)].store(slot, std::memory_order_relaxed);
+    // publishes the slot and the job in it to the thieves
+    queue->bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+static TMJobSlot *QueuePop(TMJobQueue *queue) {
+    long long bottom = queue->bottom.load(std::memory_order_relaxed) - 1;
+    queue->bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long top = queue->top.load(std::memory_order_relaxed);
+    if(top > bottom) {
+        queue->bottom.store(bottom + 1, std::memory_order_relaxed);
+        return NULL;
+    }
+    TMJobSlot *slot = queue->slots[bottom & (TM_JOB_SYSTEM_QUEUE_SIZE - 1)].load(std::memory_order_relaxed);
+    if(top == bottom) {
+        // manuel: the last job, race the thieves for it
+        if(!queue->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            slot = NULL;
+        }
+        queue->bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return slot;
+}
+
+static TMJobSlot *QueueSteal(TMJobQueue *queue) {
+    long long top = queue->top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long bottom = queue->bottom.load(std::memory_order_acquire);
+    if(top >= bottom) return NULL;
+    TMJobSlot *slot = queue->slots[top & (TM_JOB_SYSTEM_QUEUE_SIZE - 1)].load(std::memory_order_relaxed);
+    if(!queue->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return NULL;
+    }
+    return slot;
+}
+
+static void Execute(TMJob job) {
+    if(job.rangeFunction) {
+        job.rangeFunction(job.data, job.begin, job.end);
+    } else {
+        job.function(job.data);
+    }
+    if(job.counter) {
+        job.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+// copies the job out so the slot can be reused right away
+static TMJob TakeSlot(TMJobSystem *jobSystem, TMJobSlot *slot) {
+    TMJob job = slot->job;
+    slot->used.store(false, std::memory_order_release);
+    jobSystem->queuedCount.fetch_sub(1, std::memory_order_relaxed);
+    return job;
+}
+
+static bool TakeShared(TMJobSystem *jobSystem, TMJobRing *ring, TMJob *job) {
+    std::lock_guard<std::mutex> lock(jobSystem->sharedMutex);
+    if(ring->count == 0) return false;
+    *job = ring->jobs[ring->head];
+    ring->head = (ring->head + 1) % ring->size;
+    ring->count--;
+    jobSystem->queuedCount.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+static bool PutShared(TMJobSystem *jobSystem, TMJobRing *ring, TMJob job) {
+    std::lock_guard<std::mutex> lock(jobSystem->sharedMutex);
+    if(ring->count == ring->size) return false;
+    ring->jobs[(ring->head + ring->count) % ring->size] = job;
+    ring->count++;
+    return true;
+}
+
+// own queue first, then steal starting at a random thread, then the shared queue and
+// the background jobs last, only if background. threadIndex is -1 for threads without
+// a queue. manuel: a thread helping inside a wait passes background false, the jobs
+// it waits for are in the deques or the shared queue and a long background job (a
+// texture decode) would keep it from returning long after they are done
+static bool FindJob(TMJobSystem *jobSystem, int threadIndex, bool background, TMJob *job) {
+    TMJobSlot *slot = NULL;
+    unsigned int start = 0;
+    if(threadIndex >= 0) {
+        TMJobThread *thread = jobSystem->threads + threadIndex;
+        slot = QueuePop(&thread->queue);
+        if(slot) {
+            *job = TakeSlot(jobSystem, slot);
+            return true;
+        }
+        thread->random ^= thread->random << 13;
+        thread->random ^= thread->random >> 17;
+        thread->random ^= thread->random << 5;
+        start = thread->random;
+    }
+    if(jobSystem->queuedCount.load(std::memory_order_relaxed) <= 0) return false;
+    for(int i = 0; i < jobSystem->threadsCount; ++i) {
+        int victim = (int)((start + i) % (unsigned int)jobSystem->threadsCount);
+        if(victim == threadIndex) continue;
+        slot = QueueSteal(&jobSystem->threads[victim].queue);
+        if(slot) {
+            *job = TakeSlot(jobSystem, slot);
+            return true;
+        }
+    }
+    if(TakeShared(jobSystem, &jobSystem->shared, job)) return true;
+    return background && TakeShared(jobSystem, &jobSystem->background, job);
+}
+
+static int CurrentThreadIndex(TMJobSystem *jobSystem) {
+    return tlsJobSystem == jobSystem ? tlsThreadIndex : -1;
+}
+
+static bool RunOne(TMJobSystem *jobSystem, bool background) {
+    TMJob job;
+    if(!FindJob(jobSystem, CurrentThreadIndex(jobSystem), background, &job)) return false;
+    Execute(job);
+    return true;
+}
+
+static void WakeWorker(TMJobSystem *jobSystem) {
+    jobSystem->queuedCount.fetch_add(1, std::memory_order_seq_cst);
+    if(jobSystem->sleepingCount.load(std::memory_order_seq_cst) > 0) {
+        // manuel: taking the lock makes sure the sleeper is inside wait and gets the notify
+        std::lock_guard<std::mutex> lock(jobSystem->sleepMutex);
+        jobSystem->sleepCondition.notify_one();
+    }
+}
+
+static void WorkerMain(TMJobSystem *jobSystem, int threadIndex) {
+    tlsJobSystem = jobSystem;
+    tlsThreadIndex = threadIndex;
+    sched_setaffinity(0, sizeof(cpu_set_t), &jobSystem->bigCores);
+
+    int spins = 0;
+    for(;;) {
+        TMJob job;
+        if(FindJob(jobSystem, threadIndex, true, &job)) {
+            Execute(job);
+            spins = 0;
+            continue;
+        }
+        if(jobSystem->quit.load(std::memory_order_acquire)) break;
+        if(++spins < TM_JOB_SYSTEM_SPIN_COUNT) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(jobSystem->sleepMutex);
+        jobSystem->sleepingCount.fetch_add(1, std::memory_order_seq_cst);
+        jobSystem->sleepCondition.wait(lock, [jobSystem] {
+            return jobSystem->queuedCount.load(std::memory_order_seq_cst) > 0 ||
+                   jobSystem->quit.load(std::memory_order_acquire);
+        });
+        jobSystem->sleepingCount.fetch_sub(1, std::memory_order_relaxed);
+        spins = 0;
+    }
+}
+
+// manuel: the big cores are the ones with a max frequency above the slowest cluster,
+// all of them if every core is the same
+static int FindBigCores(cpu_set_t *bigCores) {
+    // every core the kernel knows of, hardware_concurrency only counts the online ones
+    // and misses the highest ids when a core in the middle is off
+    int coresCount = (int)sysconf(_SC_NPROCESSORS_CONF);
+    if(coresCount < 1) coresCount = 1;
+    if(coresCount > CPU_SETSIZE) coresCount = CPU_SETSIZE;
+    // 0 when the max frequency can't be read, offline cores have none and are left out
+    long frequencies[CPU_SETSIZE];
+    long minFrequency = 0;
+    for(int i = 0; i < coresCount; ++i) {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", i);
+        frequencies[i] = 0;
+        FILE *file = fopen(path, "r");
+        if(file) {
+            if(fscanf(file, "%ld", frequencies + i) != 1 || frequencies[i] < 0) frequencies[i] = 0;
+            fclose(file);
+        }
+        if(frequencies[i] > 0 && (minFrequency == 0 || frequencies[i] < minFrequency)) {
+            minFrequency = frequencies[i];
+        }
+    }
+    CPU_ZERO(bigCores);
+    int bigCount = 0;
+    for(int i = 0; i < coresCount; ++i) {
+        if(minFrequency > 0 && frequencies[i] > minFrequency) {
+            CPU_SET(i, bigCores);
+            bigCount++;
+        }
+    }
+    if(bigCount == 0) {
+        // every core the same or no frequency readable, the online cores this thread can use
+        if(sched_getaffinity(0, sizeof(cpu_set_t), bigCores) != 0) {
+            CPU_ZERO(bigCores);
+            CPU_SET(0, bigCores);
+        }
+        bigCount = CPU_COUNT(bigCores);
+    }
+    return bigCount;
+}
+
+TMJobSystem *TMJobSystemCreate(int workersCount) {
+    TMJobSystem *jobSystem = new TMJobSystem();
+    int bigCount = FindBigCores(&jobSystem->bigCores);
+    if(workersCount <= 0) workersCount = bigCount - 1;
+    if(workersCount < 1) workersCount = 1;
+    if(workersCount > TM_JOB_SYSTEM_MAX_THREADS - 1) workersCount = TM_JOB_SYSTEM_MAX_THREADS - 1;
+
+    jobSystem->threadsCount = workersCount + 1;
+    jobSystem->threads = new TMJobThread[jobSystem->threadsCount];
+    for(int i = 0; i < jobSystem->threadsCount; ++i) {
+        TMJobThread *thread = jobSystem->threads + i;
+        thread->queue.top.store(0);
+        thread->queue.bottom.store(0);
+        for(int j = 0; j < TM_JOB_SYSTEM_SLOTS_PER_THREAD; ++j) {
+            thread->slots[j].used.store(false);
+        }
+        thread->nextSlot = 0;
+        thread->random = 2463534242u + (unsigned int)i * 7919u;
+    }
+    jobSystem->shared = TMJobRing{jobSystem->sharedJobs, TM_JOB_SYSTEM_SHARED_SIZE, 0, 0};
+    jobSystem->background = TMJobRing{jobSystem->backgroundJobs, TM_JOB_SYSTEM_BACKGROUND_SIZE, 0, 0};
+    jobSystem->queuedCount.store(0);
+    jobSystem->sleepingCount.store(0);
+    jobSystem->quit.store(false);
+
+    tlsJobSystem = jobSystem;
+    tlsThreadIndex = 0;
+    for(int i = 1; i < jobSystem->threadsCount; ++i) {
+        jobSystem->threads[i].thread = std::thread(WorkerMain, jobSystem, i);
+    }
+    return jobSystem;
+}
+
+void TMJobSystemDestroy(TMJobSystem *jobSystem) {
+    // manuel: the jobs of the creating thread can only be popped by it or stolen
+    while(RunOne(jobSystem, true)) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(jobSystem->sleepMutex);
+        jobSystem->quit.store(true, std::memory_order_release);
+    }
+    jobSystem->sleepCondition.notify_all();
+    for(int i = 1; i < jobSystem->threadsCount; ++i) {
+        jobSystem->threads[i].thread.join();
+    }
+    if(tlsJobSystem == jobSystem) tlsJobSystem = NULL;
+    delete[] jobSystem->threads;
+    delete jobSystem;
+}
+
+int TMJobSystemGetWorkersCount(TMJobSystem *jobSystem) {
+    return jobSystem->threadsCount - 1;
+}
+
+static void Submit(TMJobSystem *jobSystem, TMJob job) {
+    if(job.counter) job.counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    int threadIndex = CurrentThreadIndex(jobSystem);
+    if(threadIndex < 0) {
+        if(PutShared(jobSystem, &jobSystem->shared, job)) {
+            WakeWorker(jobSystem);
+        } else {
+            Execute(job);
+        }
+        return;
+    }
+
+    TMJobThread *thread = jobSystem->threads + threadIndex;
+    TMJobSlot *slot = thread->slots + (thread->nextSlot++ & (TM_JOB_SYSTEM_SLOTS_PER_THREAD - 1));
+    // manuel: every slot is waiting in some queue, help until the oldest one is taken
+    while(slot->used.load(std::memory_order_acquire)) {
+        if(!RunOne(jobSystem, false)) std::this_thread::yield();
+    }
+    slot->job = job;
+    slot->used.store(true, std::memory_order_relaxed);
+    if(QueuePush(&thread->queue, slot)) {
+        WakeWorker(jobSystem);
+    } else {
+        slot->used.store(false, std::memory_order_relaxed);
+        Execute(job);
+    }
+}
+
+void TMJobSystemRun(TMJobSystem *jobSystem, TMJobFunction function, void *data, TMJobCounter *counter) {
+    TMJob job{};
+    job.function = function;
+    job.data = data;
+    job.counter = counter;
+    Submit(jobSystem, job);
+}
+
+void TMJobSystemRunBackground(TMJobSystem *jobSystem, TMJobFunction function, void *data, TMJobCounter *counter) {
+    TMJob job{};
+    job.function = function;
+    job.data = data;
+    job.counter = counter;
+    if(counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+    if(PutShared(jobSystem, &jobSystem->background, job)) {
+        WakeWorker(jobSystem);
+    } else {
+        Execute(job);
+    }
+}
+
+void TMJobSystemWait(TMJobSystem *jobSystem, TMJobCounter *counter) {
+    while(counter->pending.load(std::memory_order_acquire) > 0) {
+        if(!RunOne(jobSystem, false)) std::this_thread::yield();
+    }
+}
+
+void TMJobSystemParallelFor(TMJobSystem *jobSystem, unsigned int count, unsigned int batchSize,
+                            TMJobRangeFunction function, void *data) {
+    if(batchSize < 1) batchSize = 1;
+    if(count <= batchSize) {
+        if(count > 0) function(data, 0, count);
+        return;
+    }
+    TMJobCounter counter;
+    counter.pending.store(0, std::memory_order_relaxed);
+    for(unsigned int begin = 0; begin < count; begin += batchSize) {
+        TMJob job{};
+        job.rangeFunction = function;
+        job.data = data;
+        job.begin = begin;
+        job.end = count - begin > batchSize ? begin + batchSize : count;
+        job.counter = &counter;
+        Submit(jobSystem, job);
+    }
+    TMJobSystemWait(jobSystem, &counter);
+}
@@ -0,0 +1,46 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_JOB_SYSTEM_H
+#define MY_APPLICATION_TM_JOB_SYSTEM_H
+
+#include <atomic>
+
+struct TMJobSystem;
+
+// Counts the jobs started with it that did not finish yet. Zero it before use,
+// a job can wait on a counter to depend on other jobs.
+struct TMJobCounter {
+    std::atomic<int> pending;
+};
+
+typedef void (*TMJobFunction)(void *data);
+// runs the items [begin, end) of a TMJobSystemParallelFor
+typedef void (*TMJobRangeFunction)(void *data, unsigned int begin, unsigned int end);
+
+// Fixed pool of worker threads, one per big core minus the thread that creates it.
+// Every worker and the creating thread own a work stealing deque: jobs are pushed
+// and popped at the bottom of the own deque, idle threads steal from the top of the
+// others. Other threads (render thread, ...) can run and wait jobs too, their jobs
+// go through a shared queue. Waiting threads run jobs instead of blocking, so jobs
+// can start jobs and wait for them.
+// workersCount 0 picks one per big core minus one.
+TMJobSystem *TMJobSystemCreate(int workersCount);
+// waits for the jobs in flight
+void TMJobSystemDestroy(TMJobSystem *jobSystem);
+int TMJobSystemGetWorkersCount(TMJobSystem *jobSystem);
+// counter can be NULL for fire and forget jobs
+void TMJobSystemRun(TMJobSystem *jobSystem, TMJobFunction function, void *data, TMJobCounter *counter);
+// long jobs nobody waits for in the frame (decoding, loading). Only the workers run them,
+// a thread inside TMJobSystemWait or TMJobSystemParallelFor never picks one up. Runs
+// right away on the calling thread if too many are queued
+void TMJobSystemRunBackground(TMJobSystem *jobSystem, TMJobFunction function, void *data, TMJobCounter *counter);
+// returns when the counter reaches zero, runs other jobs meanwhile except background ones
+void TMJobSystemWait(TMJobSystem *jobSystem, TMJobCounter *counter);
+// splits [0, count) in batches of batchSize items and runs them on every core, the
+// calling thread included. Returns when all the batches are done
+void TMJobSystemParallelFor(TMJobSystem *jobSystem, unsigned int count, unsigned int batchSize,
+                            TMJobRangeFunction function, void *data);
+
+#endif //MY_APPLICATION_TM_JOB_SYSTEM_H
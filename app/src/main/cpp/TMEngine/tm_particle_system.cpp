@@ -0,0 +1,373 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_particle_system.h"
+#include "tm_renderer.h"
+#include "utils/tm_memory_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// build with TM_PARTICLE_NO_SIMD to compare against the scalar loops
+#if defined(__ARM_NEON) && !defined(TM_PARTICLE_NO_SIMD)
+#include <arm_neon.h>
+#define TM_PARTICLE_SIMD
+#elif defined(__SSE2__) && !defined(TM_PARTICLE_NO_SIMD)
+#include <emmintrin.h>
+#define TM_PARTICLE_SIMD
+#endif
+
+// one float array per particle component
+#define PARTICLE_POSITION_X 0
+#define PARTICLE_POSITION_Y 1
+#define PARTICLE_VELOCITY_X 2
+#define PARTICLE_VELOCITY_Y 3
+#define PARTICLE_ACCELERATION_X 4
+#define PARTICLE_ACCELERATION_Y 5
+#define PARTICLE_LIFE 6
+#define PARTICLE_SIZE 7
+#define PARTICLE_SIZE_DELTA 8
+#define PARTICLE_RED 9
+#define PARTICLE_GREEN 10
+#define PARTICLE_BLUE 11
+#define PARTICLE_ALPHA 12
+#define PARTICLE_RED_DELTA 13
+#define PARTICLE_GREEN_DELTA 14
+#define PARTICLE_BLUE_DELTA 15
+#define PARTICLE_ALPHA_DELTA 16
+#define PARTICLE_STREAMS_COUNT 17
+
+#define PARTICLE_EMITTERS_PER_BLOCK 32
+
+struct TMParticleEmitter {
+    TMParticleEmitterDesc desc;
+    TMVec2 position;
+    TMVec2 previousPosition;
+    float time;
+    // fraction of a particle left from the last update
+    float spawnAccumulator;
+    TMParticleEmitter *prev;
+    TMParticleEmitter *next;
+};
+
+struct TMParticleSystem {
+    unsigned int capacity;
+    unsigned int count;
+    // capacity is a multiple of 4, so the SIMD loop can always work on full groups
+    float *streams[PARTICLE_STREAMS_COUNT];
+    unsigned int random;
+
+    TMMemoryPool *emitterPool;
+    TMParticleEmitter *emitters;
+
+    TMInstance *instances;
+    TMInstanceBuffer *instanceBuffer;
+};
+
+#if defined(TM_PARTICLE_SIMD) && defined(__ARM_NEON)
+
+typedef float32x4_t TMFloat4;
+static inline TMFloat4 Float4Load(const float *src) { return vld1q_f32(src); }
+static inline void Float4Store(float *dst, TMFloat4 value) { vst1q_f32(dst, value); }
+static inline TMFloat4 Float4Set(float value) { return vdupq_n_f32(value); }
+static inline TMFloat4 Float4Max(TMFloat4 a, TMFloat4 b) { return vmaxq_f32(a, b); }
+static inline TMFloat4 Float4Sub(TMFloat4 a, TMFloat4 b) { return vsubq_f32(a, b); }
+// a + b * c
+static inline TMFloat4 Float4MulAdd(TMFloat4 a, TMFloat4 b, TMFloat4 c) { return vmlaq_f32(a, b, c); }
+static inline TMFloat4 Float4Min(TMFloat4 a, TMFloat4 b) { return vminq_f32(a, b); }
+// channels already scaled to 0..255, red in the lowest byte
+static inline void Float4StoreColors(unsigned int *dst, TMFloat4 r, TMFloat4 g, TMFloat4 b, TMFloat4 a) {
+    uint32x4_t color = vcvtq_u32_f32(r);
+    color = vorrq_u32(color, vshlq_n_u32(vcvtq_u32_f32(g), 8));
+    color = vorrq_u32(color, vshlq_n_u32(vcvtq_u32_f32(b), 16));
+    color = vorrq_u32(color, vshlq_n_u32(vcvtq_u32_f32(a), 24));
+    vst1q_u32(dst, color);
+}
+
+#elif defined(TM_PARTICLE_SIMD) && defined(__SSE2__)
+
+typedef __m128 TMFloat4;
+static inline TMFloat4 Float4Load(const float *src) { return _mm_loadu_ps(src); }
+static inline void Float4Store(float *dst, TMFloat4 value) { _mm_storeu_ps(dst, value); }
+static inline TMFloat4 Float4Set(float value) { return _mm_set1_ps(value); }
+static inline TMFloat4 Float4Max(TMFloat4 a, TMFloat4 b) { return _mm_max_ps(a, b); }
+static inline TMFloat4 Float4Sub(TMFloat4 a, TMFloat4 b) { return _mm_sub_ps(a, b); }
+// a + b * c
+static inline TMFloat4 Float4MulAdd(TMFloat4 a, TMFloat4 b, TMFloat4 c) { return _mm_add_ps(a, _mm_mul_ps(b, c)); }
+static inline TMFloat4 Float4Min(TMFloat4 a, TMFloat4 b) { return _mm_min_ps(a, b); }
+// channels already scaled to 0..255, red in the lowest byte
+static inline void Float4StoreColors(unsigned int *dst, TMFloat4 r, TMFloat4 g, TMFloat4 b, TMFloat4 a) {
+    __m128i color = _mm_cvttps_epi32(r);
+    color = _mm_or_si128(color, _mm_slli_epi32(_mm_cvttps_epi32(g), 8));
+    color = _mm_or_si128(color, _mm_slli_epi32(_mm_cvttps_epi32(b), 16));
+    color = _mm_or_si128(color, _mm_slli_epi32(_mm_cvttps_epi32(a), 24));
+    _mm_storeu_si128((__m128i *)dst, color);
+}
+
+#endif
+
+// xorshift, good enough for effects
+static float RandomFloat(TMParticleSystem *system) {
+    unsigned int x = system->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    system->random = x;
+    return (float)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+static float RandomRange(TMParticleSystem *system, float min, float max) {
+    return min + (max - min) * RandomFloat(system);
+}
+
+static void Spawn(TMParticleSystem *system, const TMParticleEmitterDesc *desc, TMVec2 position) {
+    if(system->count == system->capacity) return;
+    unsigned int i = system->count++;
+    float **streams = system->streams;
+
+    float angle = desc->direction + RandomRange(system, -desc->spread, desc->spread);
+    float speed = RandomRange(system, desc->speedMin, desc->speedMax);
+    float lifetime = RandomRange(system, desc->lifetimeMin, desc->lifetimeMax);
+    if(lifetime < 0.001f) lifetime = 0.001f;
+    float invLifetime = 1.0f / lifetime;
+    float size = RandomRange(system, desc->sizeMin, desc->sizeMax);
+
+    streams[PARTICLE_POSITION_X][i] = position.x;
+    streams[PARTICLE_POSITION_Y][i] = position.y;
+    streams[PARTICLE_VELOCITY_X][i] = cosf(angle) * speed;
+    streams[PARTICLE_VELOCITY_Y][i] = sinf(angle) * speed;
+    streams[PARTICLE_ACCELERATION_X][i] = desc->acceleration.x;
+    streams[PARTICLE_ACCELERATION_Y][i] = desc->acceleration.y;
+    streams[PARTICLE_LIFE][i] = lifetime;
+    streams[PARTICLE_SIZE][i] = size;
+    streams[PARTICLE_SIZE_DELTA][i] = (size * desc->sizeEnd - size) * invLifetime;
+    for(int c = 0; c < 4; ++c) {
+        streams[PARTICLE_RED + c][i] = desc->colorStart.v[c];
+        streams[PARTICLE_RED_DELTA + c][i] = (desc->colorEnd.v[c] - desc->colorStart.v[c]) * invLifetime;
+    }
+}
+
+// manuel: semi implicit euler, the velocity first and the position with the new velocity.
+// The size and the color change linearly, so they are integrated the same way
+static void Integrate(TMParticleSystem *system, float dt) {
+    float **streams = system->streams;
+    float *posX = streams[PARTICLE_POSITION_X];
+    float *posY = streams[PARTICLE_POSITION_Y];
+    float *velX = streams[PARTICLE_VELOCITY_X];
+    float *velY = streams[PARTICLE_VELOCITY_Y];
+    float *accX = streams[PARTICLE_ACCELERATION_X];
+    float *accY = streams[PARTICLE_ACCELERATION_Y];
+    float *life = streams[PARTICLE_LIFE];
+    float *size = streams[PARTICLE_SIZE];
+    float *sizeDelta = streams[PARTICLE_SIZE_DELTA];
+#if defined(TM_PARTICLE_SIMD)
+    // the slots past count hold old particles, integrating them is harmless
+    unsigned int count = (system->count + 3) & ~3u;
+    TMFloat4 step = Float4Set(dt);
+    TMFloat4 zero = Float4Set(0.0f);
+    for(unsigned int i = 0; i < count; i += 4) {
+        TMFloat4 vx = Float4MulAdd(Float4Load(velX + i), Float4Load(accX + i), step);
+        TMFloat4 vy = Float4MulAdd(Float4Load(velY + i), Float4Load(accY + i), step);
+        Float4Store(velX + i, vx);
+        Float4Store(velY + i, vy);
+        Float4Store(posX + i, Float4MulAdd(Float4Load(posX + i), vx, step));
+        Float4Store(posY + i, Float4MulAdd(Float4Load(posY + i), vy, step));
+        Float4Store(life + i, Float4Sub(Float4Load(life + i), step));
+        Float4Store(size + i, Float4Max(Float4MulAdd(Float4Load(size + i), Float4Load(sizeDelta + i), step), zero));
+        for(int c = 0; c < 4; ++c) {
+            float *color = streams[PARTICLE_RED + c];
+            float *colorDelta = streams[PARTICLE_RED_DELTA + c];
+            Float4Store(color + i, Float4MulAdd(Float4Load(color + i), Float4Load(colorDelta + i), step));
+        }
+    }
+#else
+    unsigned int count = system->count;
+    for(unsigned int i = 0; i < count; ++i) {
+        velX[i] += accX[i] * dt;
+        velY[i] += accY[i] * dt;
+        posX[i] += velX[i] * dt;
+        posY[i] += velY[i] * dt;
+        life[i] -= dt;
+        size[i] += sizeDelta[i] * dt;
+        if(size[i] < 0.0f) size[i] = 0.0f;
+    }
+    for(int c = 0; c < 4; ++c) {
+        float *color = streams[PARTICLE_RED + c];
+        float *colorDelta = streams[PARTICLE_RED_DELTA + c];
+        for(unsigned int i = 0; i < count; ++i) {
+            color[i] += colorDelta[i] * dt;
+        }
+    }
+#endif
+}
+
+// the last live particle takes the place of every dead one
+static void RemoveDead(TMParticleSystem *system) {
+    float *life = system->streams[PARTICLE_LIFE];
+    unsigned int i = 0;
+    while(i < system->count) {
+        if(life[i] > 0.0f) {
+            ++i;
+            continue;
+        }
+        unsigned int last = --system->count;
+        for(int s = 0; s < PARTICLE_STREAMS_COUNT; ++s) {
+            system->streams[s][i] = system->streams[s][last];
+        }
+    }
+}
+
+static void EmitterRelease(TMParticleSystem *system, TMParticleEmitter *emitter) {
+    if(emitter->prev) emitter->prev->next = emitter->next;
+    else system->emitters = emitter->next;
+    if(emitter->next) emitter->next->prev = emitter->prev;
+    TMMemoryPoolFree(system->emitterPool, emitter);
+}
+
+// returns false when the emitter is done
+static bool EmitterUpdate(TMParticleSystem *system, TMParticleEmitter *emitter, float dt) {
+    const TMParticleEmitterDesc *desc = &emitter->desc;
+    float spawnTime = dt;
+    if(desc->duration > 0.0f && emitter->time + dt > desc->duration) {
+        spawnTime = desc->duration - emitter->time;
+        if(spawnTime < 0.0f) spawnTime = 0.0f;
+    }
+    emitter->spawnAccumulator += desc->rate * spawnTime;
+    unsigned int spawnCount = (unsigned int)emitter->spawnAccumulator;
+    emitter->spawnAccumulator -= (float)spawnCount;
+    // manuel: spread them along the path of the emitter, a fast emitter leaves a line instead of clumps
+    for(unsigned int i = 0; i < spawnCount; ++i) {
+        float t = (float)(i + 1) / (float)spawnCount;
+        Spawn(system, desc, TMVec2Lerp(emitter->previousPosition, emitter->position, t));
+    }
+    emitter->previousPosition = emitter->position;
+    emitter->time += dt;
+    return desc->duration <= 0.0f || emitter->time < desc->duration;
+}
+
+TMParticleSystem *TMParticleSystemCreate(TMRenderer *renderer, unsigned int maxParticles) {
+    TMParticleSystem *system = (TMParticleSystem *)malloc(sizeof(TMParticleSystem));
+    system->capacity = (maxParticles + 3) & ~3u;
+    system->count = 0;
+    // manuel: all the streams in one block, each one a multiple of 16 bytes
+    size_t streamSize = sizeof(float) * system->capacity;
+    unsigned char *block = (unsigned char *)malloc(streamSize * PARTICLE_STREAMS_COUNT);
+    memset(block, 0, streamSize * PARTICLE_STREAMS_COUNT);
+    for(int s = 0; s < PARTICLE_STREAMS_COUNT; ++s) {
+        system->streams[s] = (float *)(block + streamSize * s);
+    }
+    system->random = 0x9E3779B9u;
+    system->emitterPool = TMMemoryPoolCreate(sizeof(TMParticleEmitter), PARTICLE_EMITTERS_PER_BLOCK);
+    system->emitters = NULL;
+    system->instances = (TMInstance *)malloc(sizeof(TMInstance) * system->capacity);
+    system->instanceBuffer = TMRendererInstanceBufferCreate(renderer, system->capacity);
+    return system;
+}
+
+void TMParticleSystemDestroy(TMRenderer *renderer, TMParticleSystem *system) {
+    TMRendererInstanceBufferDestroy(renderer, system->instanceBuffer);
+    free(system->instances);
+    TMMemoryPoolDestroy(system->emitterPool);
+    free(system->streams[0]);
+    free(system);
+}
+
+void TMParticleSystemUpdate(TMParticleSystem *system, float dt) {
+    TMParticleEmitter *emitter = system->emitters;
+    while(emitter) {
+        TMParticleEmitter *next = emitter->next;
+        if(!EmitterUpdate(system, emitter, dt)) {
+            EmitterRelease(system, emitter);
+        }
+        emitter = next;
+    }
+    Integrate(system, dt);
+    RemoveDead(system);
+}
+
+// RGBA8 of the particles [i, i + 4)
+static void PackColors(TMParticleSystem *system, unsigned int i, unsigned int *colors) {
+    float **streams = system->streams;
+#if defined(TM_PARTICLE_SIMD)
+    TMFloat4 zero = Float4Set(0.0f);
+    TMFloat4 one = Float4Set(1.0f);
+    TMFloat4 scale = Float4Set(255.0f);
+    TMFloat4 half = Float4Set(0.5f);
+    TMFloat4 channels[4];
+    for(int c = 0; c < 4; ++c) {
+        TMFloat4 value = Float4Min(Float4Max(Float4Load(streams[PARTICLE_RED + c] + i), zero), one);
+        channels[c] = Float4MulAdd(half, value, scale);
+    }
+    Float4StoreColors(colors, channels[0], channels[1], channels[2], channels[3]);
+#else
+    for(unsigned int p = 0; p < 4; ++p) {
+        unsigned int color = 0;
+        for(int c = 0; c < 4; ++c) {
+            float value = streams[PARTICLE_RED + c][i + p];
+            if(value < 0.0f) value = 0.0f;
+            if(value > 1.0f) value = 1.0f;
+            color |= (unsigned int)(value * 255.0f + 0.5f) << (c * 8);
+        }
+        colors[p] = color;
+    }
+#endif
+}
+
+void TMParticleSystemDraw(TMParticleSystem *system, TMBuffer quad) {
+    if(system->count == 0) return;
+    float *posX = system->streams[PARTICLE_POSITION_X];
+    float *posY = system->streams[PARTICLE_POSITION_Y];
+    float *size = system->streams[PARTICLE_SIZE];
+    unsigned int colors[4];
+    for(unsigned int i = 0; i < system->count; ++i) {
+        if((i & 3) == 0) PackColors(system, i, colors);
+        TMInstance *instance = system->instances + i;
+        instance->position = TMVec2{posX[i], posY[i]};
+        instance->scale = TMVec2{size[i], size[i]};
+        instance->rotation = 0.0f;
+        instance->color = colors[i & 3];
+        instance->uvRect[0] = 0;
+        instance->uvRect[1] = 0;
+        instance->uvRect[2] = 65535;
+        instance->uvRect[3] = 65535;
+    }
+    TMRendererInstanceBufferUpdate(system->instanceBuffer, system->instances, system->count);
+    TMRendererDrawBufferInstanced(quad, system->instanceBuffer, system->count);
+}
+
+unsigned int TMParticleSystemGetCount(TMParticleSystem *system) {
+    return system->count;
+}
+
+void TMParticleSystemBurst(TMParticleSystem *system, const TMParticleEmitterDesc *desc,
+                           TMVec2 position, unsigned int count) {
+    for(unsigned int i = 0; i < count; ++i) {
+        Spawn(system, desc, position);
+    }
+}
+
+TMParticleEmitter *TMParticleEmitterCreate(TMParticleSystem *system, const TMParticleEmitterDesc *desc,
+                                           TMVec2 position) {
+    TMParticleEmitter *emitter = (TMParticleEmitter *)TMMemoryPoolAlloc(system->emitterPool);
+    emitter->desc = *desc;
+    emitter->position = position;
+    emitter->previousPosition = position;
+    emitter->time = 0.0f;
+    emitter->spawnAccumulator = 0.0f;
+    emitter->prev = NULL;
+    emitter->next = system->emitters;
+    if(system->emitters) system->emitters->prev = emitter;
+    system->emitters = emitter;
+    TMParticleSystemBurst(system, desc, position, desc->burst);
+    return emitter;
+}
+
+void TMParticleEmitterDestroy(TMParticleSystem *system, TMParticleEmitter *emitter) {
+    EmitterRelease(system, emitter);
+}
+
+void TMParticleEmitterSetPosition(TMParticleEmitter *emitter, TMVec2 position) {
+    emitter->position = position;
+}
@@ -0,0 +1,67 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_PARTICLE_SYSTEM_H
+#define MY_APPLICATION_TM_PARTICLE_SYSTEM_H
+
+#include "utils/tm_math.h"
+
+struct TMRenderer;
+struct TMBuffer;
+struct TMParticleSystem;
+struct TMParticleEmitter;
+
+// Particles live in a structure of arrays, one float array per component, so the
+// update integrates position, velocity, lifetime, size and color four particles
+// at a time with NEON or SSE (scalar on other targets). Dead particles are replaced
+// by the last one, the live ones stay packed in [0, count).
+// Everything is drawn with one instanced draw of a quad, see TMInstance.
+
+struct TMParticleEmitterDesc {
+    // particles per second while the emitter lives
+    float rate;
+    // particles spawned at once when the emitter is created
+    unsigned int burst;
+    // seconds the emitter spawns for, 0 spawns until it is destroyed
+    float duration;
+    // particles leave at direction +- spread radians
+    float direction;
+    float spread;
+    float speedMin;
+    float speedMax;
+    float lifetimeMin;
+    float lifetimeMax;
+    float sizeMin;
+    float sizeMax;
+    // size at the end of the lifetime relative to the start size
+    float sizeEnd;
+    // gravity, wind, ...
+    TMVec2 acceleration;
+    // linear from colorStart to colorEnd over the lifetime, 0..1
+    TMVec4 colorStart;
+    TMVec4 colorEnd;
+};
+
+TMParticleSystem *TMParticleSystemCreate(TMRenderer *renderer, unsigned int maxParticles);
+// destroys the emitters too
+void TMParticleSystemDestroy(TMRenderer *renderer, TMParticleSystem *system);
+// spawns the particles of the emitters, then moves every particle dt seconds and removes the dead ones
+void TMParticleSystemUpdate(TMParticleSystem *system, float dt);
+// uploads the particles and draws them, the caller binds the instanced shader,
+// its uniforms and the texture before
+void TMParticleSystemDraw(TMParticleSystem *system, TMBuffer quad);
+unsigned int TMParticleSystemGetCount(TMParticleSystem *system);
+// spawns count particles at position right away, no emitter needed
+void TMParticleSystemBurst(TMParticleSystem *system, const TMParticleEmitterDesc *desc,
+                           TMVec2 position, unsigned int count);
+
+// Emitters come from a pool. An emitter with a duration is released by the
+// update once it is done, only keep the pointer of the ones without one
+TMParticleEmitter *TMParticleEmitterCreate(TMParticleSystem *system, const TMParticleEmitterDesc *desc,
+                                           TMVec2 position);
+void TMParticleEmitterDestroy(TMParticleSystem *system, TMParticleEmitter *emitter);
+// the particles of the next update spawn along the line from the last position to this one
+void TMParticleEmitterSetPosition(TMParticleEmitter *emitter, TMVec2 position);
+
+#endif //MY_APPLICATION_TM_PARTICLE_SYSTEM_H
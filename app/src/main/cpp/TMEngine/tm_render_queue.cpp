@@ -0,0 +1,180 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_render_queue.h"
+#include "tm_renderer.h"
+#include "utils/tm_handle_table.h"
+
+#include <stdlib.h>
+#include <memory.h>
+
+#define TM_RENDER_KEY_LAYER_SHIFT 56
+#define TM_RENDER_KEY_TRANSLUCENT_SHIFT 55
+#define TM_RENDER_KEY_ID_MASK 0xFFF
+#define TM_RENDER_KEY_DEPTH_MASK 0xFFFFFF
+
+struct TMRenderCommand {
+    TMBuffer buffer;
+    const TMShaderUniforms *shader;
+    TMTexture texture;
+    TMMat4 proj;
+    TMMat4 world;
+    unsigned int flags;
+};
+
+// the sort moves only the keys and the command index, never the commands
+struct TMRenderSortEntry {
+    uint64_t key;
+    unsigned int index;
+};
+
+struct TMRenderQueue {
+    TMRenderCommand *commands;
+    TMRenderSortEntry *entries;
+    TMRenderSortEntry *scratch;
+    unsigned int count;
+    unsigned int capacity;
+    bool sorted;
+};
+
+uint64_t TMRenderQueueMakeKey(unsigned int layer, bool translucent,
+                              TMShader shader, TMTexture texture, float depth) {
+    if(depth < 0.0f) depth = 0.0f;
+    if(depth > 1.0f) depth = 1.0f;
+    uint64_t depthBits = (uint64_t)(depth * TM_RENDER_KEY_DEPTH_MASK);
+    // manuel: the slot of the handle, nothing to resolve so keys can be made on any thread
+    uint64_t shaderBits = TM_HANDLE_INDEX(shader.handle) & TM_RENDER_KEY_ID_MASK;
+    uint64_t textureBits = TM_HANDLE_INDEX(texture.handle) & TM_RENDER_KEY_ID_MASK;
+
+    uint64_t key = (uint64_t)(layer & 0xFF) << TM_RENDER_KEY_LAYER_SHIFT;
+    if(translucent) {
+        key |= (uint64_t)1 << TM_RENDER_KEY_TRANSLUCENT_SHIFT;
+        key |= (TM_RENDER_KEY_DEPTH_MASK - depthBits) << 31;
+        key |= shaderBits << 19;
+        key |= textureBits << 7;
+    } else {
+        key |= shaderBits << 43;
+        key |= textureBits << 31;
+        key |= depthBits << 7;
+    }
+    return key;
+}
+
+static void QueueGrow(TMRenderQueue *queue, unsigned int capacity) {
+    queue->capacity = capacity;
+    queue->commands = (TMRenderCommand *)realloc(queue->commands, sizeof(TMRenderCommand) * capacity);
+    queue->entries = (TMRenderSortEntry *)realloc(queue->entries, sizeof(TMRenderSortEntry) * capacity);
+    queue->scratch = (TMRenderSortEntry *)realloc(queue->scratch, sizeof(TMRenderSortEntry) * capacity);
+}
+
+TMRenderQueue *TMRenderQueueCreate(unsigned int capacity) {
+    TMRenderQueue *queue = (TMRenderQueue *)malloc(sizeof(TMRenderQueue));
+    memset(queue, 0, sizeof(TMRenderQueue));
+    QueueGrow(queue, capacity > 0 ? capacity : 1);
+    TMRenderQueueClear(queue);
+    return queue;
+}
+
+void TMRenderQueueDestroy(TMRenderQueue *queue) {
+    free(queue->commands);
+    free(queue->entries);
+    free(queue->scratch);
+    free(queue);
+}
+
+void TMRenderQueueClear(TMRenderQueue *queue) {
+    queue->count = 0;
+    queue->sorted = true;
+}
+
+void TMRenderQueuePush(TMRenderQueue *queue, uint64_t key,
+                       TMBuffer buffer, const TMShaderUniforms *shader, TMTexture texture,
+                       TMMat4 proj, TMMat4 world, unsigned int flags) {
+    if(queue->count == queue->capacity) {
+        QueueGrow(queue, queue->capacity * 2);
+    }
+    TMRenderCommand *command = queue->commands + queue->count;
+    command->buffer = buffer;
+    command->shader = shader;
+    command->texture = texture;
+    command->proj = proj;
+    command->world = world;
+    command->flags = flags;
+    queue->entries[queue->count].key = key;
+    queue->entries[queue->count].index = queue->count;
+    queue->count++;
+    queue->sorted = false;
+}
+
+void TMRenderQueueSort(TMRenderQueue *queue) {
+    if(queue->sorted) return;
+
+    // LSD radix sort, 8 bits per pass. Passes where every key has the same
+    // byte are skipped, in practice most of the key bytes are constant
+    TMRenderSortEntry *src = queue->entries;
+    TMRenderSortEntry *dst = queue->scratch;
+    for(unsigned int shift = 0; shift < 64; shift += 8) {
+        unsigned int histogram[256] = {};
+        for(unsigned int i = 0; i < queue->count; ++i) {
+            histogram[(src[i].key >> shift) & 0xFF]++;
+        }
+        if(histogram[(src[0].key >> shift) & 0xFF] == queue->count) {
+            continue;
+        }
+        unsigned int offset = 0;
+        for(unsigned int i = 0; i < 256; ++i) {
+            unsigned int bucketCount = histogram[i];
+            histogram[i] = offset;
+            offset += bucketCount;
+        }
+        for(unsigned int i = 0; i < queue->count; ++i) {
+            dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+        TMRenderSortEntry *temp = src;
+        src = dst;
+        dst = temp;
+    }
+    queue->entries = src;
+    queue->scratch = dst;
+    queue->sorted = true;
+}
+
+void TMRenderQueueSubmit(TMRenderQueue *queue) {
+    TMRenderQueueSort(queue);
+
+    TMShader currentShader = {};
+    TMMat4 currentProj{};
+
+    for(unsigned int i = 0; i < queue->count; ++i) {
+        TMRenderCommand *command = queue->commands + queue->entries[i].index;
+        const TMShaderUniforms *shader = command->shader;
+
+        if(shader->shader.handle != currentShader.handle) {
+            currentShader = shader->shader;
+            TMRendererBindShader(currentShader);
+            currentProj = command->proj;
+            TMRendererShaderUpdate(currentShader, shader->proj, currentProj);
+        } else if(memcmp(&currentProj, &command->proj, sizeof(TMMat4)) != 0) {
+            currentProj = command->proj;
+            TMRendererShaderUpdate(currentShader, shader->proj, currentProj);
+        }
+        TMRendererShaderUpdate(currentShader, shader->world, command->world);
+
+        if(command->texture.handle) {
+            TMRendererTextureBind(command->texture, currentShader, shader->texture, 0);
+        }
+
+        if(command->flags & TM_RENDER_COMMAND_DEPTH_TEST) {
+            TMRendererDepthTestEnable();
+        } else {
+            TMRendererDepthTestDisable();
+        }
+
+        TMRendererDrawBuffer(command->buffer);
+    }
+}
+
+unsigned int TMRenderQueueGetCount(TMRenderQueue *queue) {
+    return queue->count;
+}
@@ -0,0 +1,39 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_RENDER_QUEUE_H
+#define MY_APPLICATION_TM_RENDER_QUEUE_H
+
+#include <stdint.h>
+#include "utils/tm_math.h"
+
+#define TM_RENDER_COMMAND_DEPTH_TEST (1 << 0)
+
+struct TMBuffer;
+struct TMShader;
+struct TMShaderUniforms;
+struct TMTexture;
+struct TMRenderQueue;
+
+// Sort key layout, from the most significant bit:
+//   opaque:      layer(8) | 0 | shader(12) | texture(12) | depth(24) front to back
+//   translucent: layer(8) | 1 | depth(24) back to front | shader(12) | texture(12)
+// depth is the normalized view distance in [0, 1].
+uint64_t TMRenderQueueMakeKey(unsigned int layer, bool translucent,
+                              TMShader shader, TMTexture texture, float depth);
+
+TMRenderQueue *TMRenderQueueCreate(unsigned int capacity);
+void TMRenderQueueDestroy(TMRenderQueue *queue);
+void TMRenderQueueClear(TMRenderQueue *queue);
+// A command draws buffer with shader and texture. The only uniforms it sets are the
+// proj and world matrices and the texture sampler of shader, anything else has to be
+// set on the shader before Submit. shader must stay alive until Submit
+void TMRenderQueuePush(TMRenderQueue *queue, uint64_t key,
+                       TMBuffer buffer, const TMShaderUniforms *shader, TMTexture texture,
+                       TMMat4 proj, TMMat4 world, unsigned int flags);
+void TMRenderQueueSort(TMRenderQueue *queue);
+void TMRenderQueueSubmit(TMRenderQueue *queue);
+unsigned int TMRenderQueueGetCount(TMRenderQueue *queue);
+
+#endif //MY_APPLICATION_TM_RENDER_QUEUE_H
@@ -0,0 +1,295 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_render_thread.h"
+#include "tm_renderer.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <android/log.h>
+#include <game-activity/native_app_glue/android_native_app_glue.h>
+
+#define TM_LOG_INFO(...) ((void)__android_log_print(ANDROID_LOG_INFO, "App2", __VA_ARGS__))
+#define TM_RENDER_THREAD_PACKETS 3
+// frames a window surface is tried again before the renderer is built again
+#define TM_RENDER_THREAD_SURFACE_RETRIES 3
+
+#define TM_SURFACE_COMMAND_NONE 0
+#define TM_SURFACE_COMMAND_CREATE 1
+#define TM_SURFACE_COMMAND_DESTROY 2
+
+struct TMRenderThread {
+    TMRenderThreadCallbacks callbacks;
+    android_app *pApp;
+    unsigned int surfaceFlags;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool running;
+    bool initialized;
+    bool quit;
+    // window changes requested by the game thread, it waits until they are done
+    int surfaceCommand;
+    // render thread only, the window surface failed without a context loss
+    bool surfacePending;
+    unsigned int surfaceRetries;
+
+    unsigned char *packets;
+    unsigned int packetSize;
+    // the game thread owns writeIndex, the render thread owns readIndex,
+    // readyIndex is the last published packet and is only swapped under the mutex
+    unsigned int writeIndex;
+    unsigned int readyIndex;
+    unsigned int readIndex;
+    bool fresh;
+
+    // held by the game thread while it builds a packet, a reload takes it so
+    // the game never reads the handles initialize and shutdown are rewriting
+    std::mutex frameMutex;
+    // counted under the mutex, a packet begun before a reload holds handles
+    // of the destroyed renderer and is dropped instead of published
+    unsigned int reloads;
+    unsigned int writeReloads;
+
+    std::atomic<int> width;
+    std::atomic<int> height;
+};
+
+static void RenderThreadPublishSize(TMRenderThread *renderThread, TMRenderer *renderer) {
+    TMRendererUpdateRenderArea(renderer);
+    renderThread->width = TMRendererGetWidth(renderer);
+    renderThread->height = TMRendererGetHeight(renderer);
+}
+
+// EGL_CONTEXT_LOST: every GL object is gone, rebuild them all on a new renderer
+static TMRenderer *RenderThreadReload(TMRenderThread *renderThread, TMRenderer *renderer) {
+    android_app *pApp = renderThread->pApp;
+    // manuel: stall the game thread until the new handles are in place and drop
+    // the packet it already published, the new tables can reuse its handles
+    std::lock_guard<std::mutex> frameLock(renderThread->frameMutex);
+    {
+        std::lock_guard<std::mutex> lock(renderThread->mutex);
+        renderThread->fresh = false;
+        renderThread->reloads++;
+    }
+    renderThread->condition.notify_all();
+    renderThread->callbacks.shutdown(renderThread->callbacks.userData, renderer);
+    TMRendererDestroy(renderer);
+    renderer = TMRendererCreate(pApp, pApp->activity->assetManager, renderThread->surfaceFlags);
+    RenderThreadPublishSize(renderThread, renderer);
+    renderThread->callbacks.initialize(renderThread->callbacks.userData, renderer);
+    return renderer;
+}
+
+// a surface can fail for other reasons than a lost context, it is tried again on the
+// next frames and the renderer is built again when it keeps failing
+static TMRenderer *RenderThreadSurfaceCreate(TMRenderThread *renderThread, TMRenderer *renderer) {
+    if(TMRendererSurfaceCreate(renderer, renderThread->pApp)) {
+        renderThread->surfacePending = false;
+        renderThread->surfaceRetries = 0;
+        RenderThreadPublishSize(renderThread, renderer);
+        return renderer;
+    }
+    if(TMRendererIsContextLost(renderer) || renderThread->surfaceRetries >= TM_RENDER_THREAD_SURFACE_RETRIES) {
+        renderer = RenderThreadReload(renderThread, renderer);
+        renderThread->surfacePending = !TMRendererHasSurface(renderer);
+        renderThread->surfaceRetries = 0;
+        return renderer;
+    }
+    TM_LOG_INFO("WARNING: window surface not created, trying again next frame\n");
+    renderThread->surfacePending = true;
+    renderThread->surfaceRetries++;
+    return renderer;
+}
+
+static void RenderThreadMain(TMRenderThread *renderThread) {
+    android_app *pApp = renderThread->pApp;
+    TMRenderer *renderer = TMRendererCreate(pApp, pApp->activity->assetManager, renderThread->surfaceFlags);
+    RenderThreadPublishSize(renderThread, renderer);
+    renderThread->callbacks.initialize(renderThread->callbacks.userData, renderer);
+
+    {
+        std::lock_guard<std::mutex> lock(renderThread->mutex);
+        renderThread->initialized = true;
+    }
+    renderThread->condition.notify_all();
+
+    for(;;) {
+        int surfaceCommand = TM_SURFACE_COMMAND_NONE;
+        {
+            std::unique_lock<std::mutex> lock(renderThread->mutex);
+            renderThread->condition.wait(lock, [renderThread] {
+                return renderThread->fresh || renderThread->quit ||
+                       renderThread->surfaceCommand != TM_SURFACE_COMMAND_NONE;
+            });
+            if(renderThread->quit) break;
+            surfaceCommand = renderThread->surfaceCommand;
+            if(surfaceCommand == TM_SURFACE_COMMAND_NONE) {
+                unsigned int temp = renderThread->readIndex;
+                renderThread->readIndex = renderThread->readyIndex;
+                renderThread->readyIndex = temp;
+                renderThread->fresh = false;
+            }
+        }
+
+        if(surfaceCommand != TM_SURFACE_COMMAND_NONE) {
+            if(surfaceCommand == TM_SURFACE_COMMAND_CREATE) {
+                renderer = RenderThreadSurfaceCreate(renderThread, renderer);
+            } else {
+                renderThread->surfacePending = false;
+                renderThread->surfaceRetries = 0;
+                TMRendererSurfaceDestroy(renderer);
+            }
+            {
+                std::lock_guard<std::mutex> lock(renderThread->mutex);
+                renderThread->surfaceCommand = TM_SURFACE_COMMAND_NONE;
+            }
+            renderThread->condition.notify_all();
+            continue;
+        }
+
+        // let the game thread publish the next frame while this one is drawn
+        renderThread->condition.notify_all();
+        if(!TMRendererHasSurface(renderer) && renderThread->surfacePending) {
+            renderer = RenderThreadSurfaceCreate(renderThread, renderer);
+        }
+        if(!TMRendererHasSurface(renderer)) continue;
+
+        RenderThreadPublishSize(renderThread, renderer);
+
+        void *packet = renderThread->packets + renderThread->readIndex * renderThread->packetSize;
+        renderThread->callbacks.render(renderThread->callbacks.userData, renderer, packet);
+        TMRendererPresent(renderer);
+        if(TMRendererIsContextLost(renderer)) {
+            renderer = RenderThreadReload(renderThread, renderer);
+        }
+    }
+
+    renderThread->callbacks.shutdown(renderThread->callbacks.userData, renderer);
+    TMRendererDestroy(renderer);
+}
+
+static void RenderThreadSurfaceCommand(TMRenderThread *renderThread, int command) {
+    if(!renderThread->running) return;
+    std::unique_lock<std::mutex> lock(renderThread->mutex);
+    renderThread->surfaceCommand = command;
+    renderThread->condition.notify_all();
+    renderThread->condition.wait(lock, [renderThread] {
+        return renderThread->surfaceCommand == TM_SURFACE_COMMAND_NONE;
+    });
+}
+
+void TMRenderThreadSurfaceCreate(TMRenderThread *renderThread) {
+    RenderThreadSurfaceCommand(renderThread, TM_SURFACE_COMMAND_CREATE);
+}
+
+void TMRenderThreadSurfaceDestroy(TMRenderThread *renderThread) {
+    RenderThreadSurfaceCommand(renderThread, TM_SURFACE_COMMAND_DESTROY);
+}
+
+TMRenderThread *TMRenderThreadCreate(TMRenderThreadCallbacks callbacks, unsigned int packetSize,
+                                     unsigned int surfaceFlags) {
+    TMRenderThread *renderThread = new TMRenderThread();
+    renderThread->callbacks = callbacks;
+    renderThread->surfaceFlags = surfaceFlags;
+    renderThread->pApp = NULL;
+    renderThread->running = false;
+    renderThread->initialized = false;
+    renderThread->quit = false;
+    renderThread->surfaceCommand = TM_SURFACE_COMMAND_NONE;
+    renderThread->surfacePending = false;
+    renderThread->surfaceRetries = 0;
+    renderThread->packetSize = packetSize;
+    renderThread->packets = (unsigned char *)malloc(packetSize * TM_RENDER_THREAD_PACKETS);
+    memset(renderThread->packets, 0, packetSize * TM_RENDER_THREAD_PACKETS);
+    renderThread->writeIndex = 0;
+    renderThread->readyIndex = 1;
+    renderThread->readIndex = 2;
+    renderThread->fresh = false;
+    renderThread->reloads = 0;
+    renderThread->writeReloads = 0;
+    renderThread->width = 0;
+    renderThread->height = 0;
+    return renderThread;
+}
+
+void TMRenderThreadDestroy(TMRenderThread *renderThread) {
+    TMRenderThreadStop(renderThread);
+    free(renderThread->packets);
+    delete renderThread;
+}
+
+void TMRenderThreadStart(TMRenderThread *renderThread, android_app *pApp) {
+    assert(!renderThread->running);
+    renderThread->pApp = pApp;
+    renderThread->initialized = false;
+    renderThread->quit = false;
+    renderThread->surfaceCommand = TM_SURFACE_COMMAND_NONE;
+    renderThread->fresh = false;
+    renderThread->running = true;
+    renderThread->thread = std::thread(RenderThreadMain, renderThread);
+
+    std::unique_lock<std::mutex> lock(renderThread->mutex);
+    renderThread->condition.wait(lock, [renderThread] {
+        return renderThread->initialized;
+    });
+}
+
+void TMRenderThreadStop(TMRenderThread *renderThread) {
+    if(!renderThread->running) return;
+    {
+        std::lock_guard<std::mutex> lock(renderThread->mutex);
+        renderThread->quit = true;
+    }
+    renderThread->condition.notify_all();
+    // the window is about to be destroyed, the surface must be gone before returning
+    renderThread->thread.join();
+    renderThread->running = false;
+    renderThread->pApp = NULL;
+}
+
+bool TMRenderThreadIsRunning(TMRenderThread *renderThread) {
+    return renderThread->running;
+}
+
+void *TMRenderThreadBeginFrame(TMRenderThread *renderThread) {
+    renderThread->frameMutex.lock();
+    {
+        std::lock_guard<std::mutex> lock(renderThread->mutex);
+        renderThread->writeReloads = renderThread->reloads;
+    }
+    return renderThread->packets + renderThread->writeIndex * renderThread->packetSize;
+}
+
+void TMRenderThreadEndFrame(TMRenderThread *renderThread) {
+    // the packet is built, a reload can run while this waits
+    renderThread->frameMutex.unlock();
+    {
+        std::unique_lock<std::mutex> lock(renderThread->mutex);
+        // never run more than one frame ahead of the render thread
+        renderThread->condition.wait(lock, [renderThread] {
+            return !renderThread->fresh || renderThread->quit;
+        });
+        if(renderThread->writeReloads != renderThread->reloads) return;
+        unsigned int temp = renderThread->writeIndex;
+        renderThread->writeIndex = renderThread->readyIndex;
+        renderThread->readyIndex = temp;
+        renderThread->fresh = true;
+    }
+    renderThread->condition.notify_all();
+}
+
+int TMRenderThreadGetWidth(TMRenderThread *renderThread) {
+    return renderThread->width;
+}
+
+int TMRenderThreadGetHeight(TMRenderThread *renderThread) {
+    return renderThread->height;
+}
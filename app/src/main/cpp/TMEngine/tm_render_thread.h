@@ -0,0 +1,51 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_RENDER_THREAD_H
+#define MY_APPLICATION_TM_RENDER_THREAD_H
+
+struct android_app;
+struct TMRenderer;
+struct TMRenderThread;
+
+// The render thread owns the EGL context and the TMRenderer. The game thread
+// fills a frame packet with everything needed to draw a frame and publishes it,
+// the render thread draws the last published packet while the game thread
+// builds the next one. Packets are plain data of packetSize bytes, three of
+// them rotate between the game thread, the render thread and the latest frame.
+struct TMRenderThreadCallbacks {
+    void *userData;
+    // called on the render thread after the renderer is created / before it is destroyed
+    void (*initialize)(void *userData, TMRenderer *renderer);
+    void (*shutdown)(void *userData, TMRenderer *renderer);
+    // called on the render thread with the latest published packet
+    void (*render)(void *userData, TMRenderer *renderer, void *packet);
+};
+
+// surfaceFlags are the TM_SURFACE_* buffers of the window, see TMRendererCreate
+TMRenderThread *TMRenderThreadCreate(TMRenderThreadCallbacks callbacks, unsigned int packetSize,
+                                     unsigned int surfaceFlags);
+void TMRenderThreadDestroy(TMRenderThread *renderThread);
+// blocks until the renderer is created and initialize returned (first APP_CMD_INIT_WINDOW)
+void TMRenderThreadStart(TMRenderThread *renderThread, android_app *pApp);
+// blocks until shutdown returned and the renderer is destroyed (APP_CMD_DESTROY)
+void TMRenderThreadStop(TMRenderThread *renderThread);
+// block until the render thread released / recreated the window surface, the
+// context and the GL objects are kept (APP_CMD_TERM_WINDOW / APP_CMD_INIT_WINDOW).
+// If the context was lost the renderer is recreated with shutdown + initialize,
+// which run while the game thread is outside BeginFrame / EndFrame
+void TMRenderThreadSurfaceDestroy(TMRenderThread *renderThread);
+void TMRenderThreadSurfaceCreate(TMRenderThread *renderThread);
+bool TMRenderThreadIsRunning(TMRenderThread *renderThread);
+// packet to fill on the game thread, valid until TMRenderThreadEndFrame. State the
+// initialize callback writes can be read until then, a reload waits for EndFrame
+void *TMRenderThreadBeginFrame(TMRenderThread *renderThread);
+// publishes the packet, waits if the render thread has not picked the previous one yet.
+// A packet begun before a context loss reload is dropped, its handles are gone
+void TMRenderThreadEndFrame(TMRenderThread *renderThread);
+// size of the render area as seen by the render thread
+int TMRenderThreadGetWidth(TMRenderThread *renderThread);
+int TMRenderThreadGetHeight(TMRenderThread *renderThread);
+
+#endif //MY_APPLICATION_TM_RENDER_THREAD_H
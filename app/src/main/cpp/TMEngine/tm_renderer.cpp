@@ -5,23 +5,37 @@
 #include "tm_renderer.h"
 #include "utils/tm_memory_pool.h"
 #include "utils/tm_file.h"
+#include "utils/tm_image.h"
+#include "utils/tm_ktx2.h"
+#include "utils/tm_shader_cache.h"
+#include "utils/tm_arena.h"
+#include "utils/tm_handle_table.h"
+#include "tm_renderer_state.h"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <stddef.h>
 #include <assert.h>
+#include <time.h>
+#include <algorithm>
 #include <EGL/egl.h>
 #include <GLES3/gl3.h>
 #include <android/log.h>
-#include <android/imagedecoder.h>
 #include <game-activity/native_app_glue/android_native_app_glue.h>
 
 // TODO: memset zero all the return structs
 
 #define TM_LOG_INFO(...) ((void)__android_log_print(ANDROID_LOG_INFO, "App2", __VA_ARGS__))
 #define TM_RENDERER_MEMORY_BLOCK_SIZE 100
+#define TM_SHADER_MAX_UNIFORMS 32
+#define TM_SHADER_MAX_UNIFORM_NAME 32
+// GL_KHR_texture_compression_astc_ldr, not in gl3.h
+#define TM_GL_COMPRESSED_RGBA_ASTC_4x4 0x93B0
+#define TM_GL_COMPRESSED_RGBA_ASTC_8x8 0x93B7
 
 
-struct TMBuffer {
+struct TMBufferData {
     unsigned int id;
     unsigned int vbo;
     unsigned int ebo;
@@ -29,20 +43,50 @@ struct TMBuffer {
     unsigned int verticesCount;
     unsigned short *indices;
     unsigned int indicesCount;
+    // instance buffer whose attributes are currently set in the vao
+    unsigned int instanceVbo;
 };
 
-struct TMShader {
+struct TMInstanceBuffer {
     unsigned int id;
+    unsigned int maxInstances;
 };
 
-struct TMTexture {
+static_assert(sizeof(TMInstance) == 32, "TMInstance must be 32 bytes");
+
+struct TMShaderUniform {
+    char name[TM_SHADER_MAX_UNIFORM_NAME];
+    int location;
+    unsigned int type;
+    int size;
+};
+
+struct TMShaderData {
+    unsigned int id;
+    TMShaderUniform uniforms[TM_SHADER_MAX_UNIFORMS];
+    unsigned int uniformsCount;
+};
+
+struct TMTextureData {
     unsigned int id;
     int width;
     int height;
+    // streaming upload in progress, swapped into id when it ends
+    unsigned int uploadId;
+    unsigned int uploadFormat;
+    int uploadWidth;
+    int uploadHeight;
+    int uploadLevels;
+    // color attachment of this framebuffer, only TMRendererFramebufferDestroy deletes it
+    TMFramebuffer *framebuffer;
 };
 
 struct TMFramebuffer {
     unsigned int id;
+    TMTexture color;
+    unsigned int depth;
+    int width;
+    int height;
 };
 
 struct TMRenderer {
@@ -51,19 +95,65 @@ struct TMRenderer {
     EGLDisplay display;
     EGLSurface surface;
     EGLContext context;
+    EGLConfig config;
+    // set when EGL reports EGL_CONTEXT_LOST, every GL object is gone
+    bool contextLost;
     EGLint width;
     EGLint height;
-
-    TMMemoryPool *buffersMemory;
-    TMMemoryPool *texturesMemory;
-    TMMemoryPool *shadersMemory;
+    // TM_SURFACE_* buffers the window surface was created with
+    unsigned int surfaceFlags;
+    // GL_KHR_texture_compression_astc_ldr, read once so any thread can ask
+    bool astcSupported;
+
+    // pass between TMRendererBeginPass and TMRendererEndPass
+    TMRenderPass pass;
+    bool inPass;
+
+    // seconds between the last two presents
+    double lastPresentTime;
+    float frameTime;
+
+    // TMBuffer, TMShader and TMTexture handles resolve into these
+    TMHandleTable *buffers;
+    TMHandleTable *textures;
+    TMHandleTable *shaders;
     TMMemoryPool *framebufferMemory;
+    TMMemoryPool *instanceBuffersMemory;
 
+    // pixel unpack buffer used as a ring by the streaming texture uploads
+    unsigned int uploadBuffer;
+    size_t uploadBufferSize;
+    size_t uploadBufferOffset;
+
+    TMRendererState state;
 };
 
-#include <vector>
+// the renderer that owns the GL context, handles passed without one resolve in its tables
+static TMRenderer *gRenderer;
+
+// manuel: a stale handle is a bug in the caller, catch it in debug and skip the call in release
+static TMBufferData *BufferGet(TMBuffer buffer) {
+    TMBufferData *data = (TMBufferData *)TMHandleTableGet(gRenderer->buffers, buffer.handle);
+    if(!data) TM_LOG_INFO("ERROR: invalid TMBuffer 0x%x\n", buffer.handle);
+    assert(data);
+    return data;
+}
+
+static TMShaderData *ShaderGet(TMShader shader) {
+    TMShaderData *data = (TMShaderData *)TMHandleTableGet(gRenderer->shaders, shader.handle);
+    if(!data) TM_LOG_INFO("ERROR: invalid TMShader 0x%x\n", shader.handle);
+    assert(data);
+    return data;
+}
 
-static void InitializeOpenGLContext(TMRenderer *renderer, android_app *pApp) {
+static TMTextureData *TextureGet(TMTexture texture) {
+    TMTextureData *data = (TMTextureData *)TMHandleTableGet(gRenderer->textures, texture.handle);
+    if(!data) TM_LOG_INFO("ERROR: invalid TMTexture 0x%x\n", texture.handle);
+    assert(data);
+    return data;
+}
+
+static void InitializeOpenGLContext(TMRenderer *renderer, android_app *pApp, unsigned int surfaceFlags) {
     TM_LOG_INFO("Initilizing OpenGL ES 3 ...\n");
 
     // init opengl es 3
@@ -73,14 +163,20 @@ static void InitializeOpenGLContext(TMRenderer *renderer, android_app *pApp) {
     renderer->context = EGL_NO_CONTEXT;
     renderer->width = 0;
     renderer->height = 0;
+    renderer->surfaceFlags = surfaceFlags;
 
+    // manuel: only ask for depth / stencil in the window if a pass draws with them there,
+    // a window without them saves the memory and the bandwidth of resolving them
+    EGLint depthSize = (surfaceFlags & TM_SURFACE_DEPTH) ? 24 : 0;
+    EGLint stencilSize = (surfaceFlags & TM_SURFACE_STENCIL) ? 8 : 0;
     EGLint attribs[] = {
             EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
             EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
             EGL_BLUE_SIZE, 8,
             EGL_GREEN_SIZE, 8,
             EGL_RED_SIZE, 8,
-            EGL_DEPTH_SIZE, 24,
+            EGL_DEPTH_SIZE, depthSize,
+            EGL_STENCIL_SIZE, stencilSize,
             EGL_NONE
     };
 
@@ -91,43 +187,44 @@ static void InitializeOpenGLContext(TMRenderer *renderer, android_app *pApp) {
     // figure out how many config there are
     EGLint numConfigs;
     eglChooseConfig(renderer->display, attribs, NULL, 0, &numConfigs);
+    assert(numConfigs > 0);
 
-    // TODO: fix this
     // get the list of configurations
-    std::unique_ptr<EGLConfig[]> supportedConfigs(new EGLConfig[numConfigs]);
-    eglChooseConfig(renderer->display, attribs, supportedConfigs.get(), numConfigs, &numConfigs);
+    TMArenaSavepoint scratch = TMArenaSave(TMArenaGetScratch());
+    EGLConfig *supportedConfigs = TM_ARENA_PUSH_ARRAY(scratch.arena, EGLConfig, numConfigs);
+    eglChooseConfig(renderer->display, attribs, supportedConfigs, numConfigs, &numConfigs);
 
-    // Find a config we like.
-    // Could likely just grab the first if we don't care about anything else in the config.
-    // Otherwise hook in your own heuristic
+    // Find a config we like. The sizes above are minimums, look for the exact
+    // ones so we don't pay for buffers we asked not to have
     EGLDisplay display = renderer->display;
-    void *selectedConfig = *std::find_if(
-            supportedConfigs.get(),
-            supportedConfigs.get() + numConfigs,
-            [&display](const EGLConfig &config) {
-                EGLint red, green, blue, depth;
+    EGLConfig *foundConfig = std::find_if(
+            supportedConfigs,
+            supportedConfigs + numConfigs,
+            [&display, depthSize, stencilSize](const EGLConfig &config) {
+                EGLint red, green, blue, depth, stencil;
                 if (eglGetConfigAttrib(display, config, EGL_RED_SIZE, &red)
                     && eglGetConfigAttrib(display, config, EGL_GREEN_SIZE, &green)
                     && eglGetConfigAttrib(display, config, EGL_BLUE_SIZE, &blue)
-                    && eglGetConfigAttrib(display, config, EGL_DEPTH_SIZE, &depth)) {
-                    return red == 8 && green == 8 && blue == 8 && depth == 24;
+                    && eglGetConfigAttrib(display, config, EGL_DEPTH_SIZE, &depth)
+                    && eglGetConfigAttrib(display, config, EGL_STENCIL_SIZE, &stencil)) {
+                    return red == 8 && green == 8 && blue == 8 && depth == depthSize && stencil == stencilSize;
                 }
                 return false;
             });
+    // eglChooseConfig sorts the smallest depth and stencil first, the first one is the closest
+    void *selectedConfig = foundConfig != supportedConfigs + numConfigs ? *foundConfig : supportedConfigs[0];
+    TMArenaRollback(scratch);
 
     assert(selectedConfig != NULL);
-
-    // create the proper window surface
-    EGLint format;
-    eglGetConfigAttrib(renderer->display, selectedConfig, EGL_NATIVE_VISUAL_ID, &format);
-    renderer->surface = eglCreateWindowSurface(renderer->display, selectedConfig, renderer->pApp->window, NULL);
+    renderer->config = selectedConfig;
+    renderer->contextLost = false;
 
     // Create a GLES 3 context
     EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
     renderer->context = eglCreateContext(renderer->display, selectedConfig, NULL, contextAttribs);
 
-    // make the context current
-    EGLBoolean madeCurrent = eglMakeCurrent(renderer->display, renderer->surface, renderer->surface, renderer->context);
+    // create the proper window surface and make the context current
+    bool madeCurrent = TMRendererSurfaceCreate(renderer, pApp);
 
     if(madeCurrent) {
         TM_LOG_INFO("context made current\n");
@@ -136,27 +233,98 @@ static void InitializeOpenGLContext(TMRenderer *renderer, android_app *pApp) {
     }
 
     assert(madeCurrent);
+}
+
+bool TMRendererSurfaceCreate(TMRenderer *renderer, android_app *pApp) {
+    assert(renderer->surface == EGL_NO_SURFACE);
+    renderer->pApp = pApp;
+    renderer->surface = eglCreateWindowSurface(renderer->display, renderer->config, pApp->window, NULL);
+    if(renderer->surface == EGL_NO_SURFACE) {
+        TM_LOG_INFO("ERROR: eglCreateWindowSurface 0x%x\n", eglGetError());
+        return false;
+    }
+
+    EGLBoolean madeCurrent = eglMakeCurrent(renderer->display, renderer->surface, renderer->surface, renderer->context);
+    if(!madeCurrent) {
+        EGLint error = eglGetError();
+        TM_LOG_INFO("ERROR: eglMakeCurrent 0x%x\n", error);
+        if(error == EGL_CONTEXT_LOST) renderer->contextLost = true;
+        // manuel: a surface that was never made current must not count as one, HasSurface draws to it
+        eglDestroySurface(renderer->display, renderer->surface);
+        renderer->surface = EGL_NO_SURFACE;
+        return false;
+    }
 
     // make width and height invalid so it gets updated the first frame
     renderer->width = -1;
     renderer->height = -1;
+    renderer->lastPresentTime = 0.0;
+    return true;
+}
+
+void TMRendererSurfaceDestroy(TMRenderer *renderer) {
+    if(renderer->surface == EGL_NO_SURFACE) return;
+    // manuel: keep the context current without a surface so the GL objects stay usable,
+    // drivers without EGL_KHR_surfaceless_context refuse it and the context is just released
+    if(!eglMakeCurrent(renderer->display, EGL_NO_SURFACE, EGL_NO_SURFACE, renderer->context)) {
+        eglMakeCurrent(renderer->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+    eglDestroySurface(renderer->display, renderer->surface);
+    renderer->surface = EGL_NO_SURFACE;
+}
+
+bool TMRendererHasSurface(TMRenderer *renderer) {
+    return renderer->surface != EGL_NO_SURFACE;
+}
 
+bool TMRendererIsContextLost(TMRenderer *renderer) {
+    return renderer->contextLost;
+}
+
+android_app *TMRendererGetApp(TMRenderer *renderer) {
+    return renderer->pApp;
 }
 
 TMRenderer *TMRendererCreate(android_app *pApp, AAssetManager *assetManager) {
+    return TMRendererCreate(pApp, assetManager, TM_SURFACE_DEPTH);
+}
+
+TMRenderer *TMRendererCreate(android_app *pApp, AAssetManager *assetManager, unsigned int surfaceFlags) {
     TMRenderer *renderer = (TMRenderer *)malloc(sizeof(TMRenderer));
 
-    InitializeOpenGLContext(renderer, pApp);
+    InitializeOpenGLContext(renderer, pApp, surfaceFlags);
+    renderer->inPass = false;
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    renderer->astcSupported = extensions && strstr(extensions, "GL_KHR_texture_compression_astc_ldr");
 
-    renderer->buffersMemory = TMMemoryPoolCreate(sizeof(TMBuffer), TM_RENDERER_MEMORY_BLOCK_SIZE);
-    renderer->texturesMemory = TMMemoryPoolCreate(sizeof(TMTexture), TM_RENDERER_MEMORY_BLOCK_SIZE);
-    renderer->shadersMemory = TMMemoryPoolCreate(sizeof(TMShader), TM_RENDERER_MEMORY_BLOCK_SIZE);
+    renderer->buffers = TMHandleTableCreate(sizeof(TMBufferData), TM_RENDERER_MEMORY_BLOCK_SIZE);
+    renderer->textures = TMHandleTableCreate(sizeof(TMTextureData), TM_RENDERER_MEMORY_BLOCK_SIZE);
+    renderer->shaders = TMHandleTableCreate(sizeof(TMShaderData), TM_RENDERER_MEMORY_BLOCK_SIZE);
     renderer->framebufferMemory = TMMemoryPoolCreate(sizeof(TMFramebuffer), TM_RENDERER_MEMORY_BLOCK_SIZE);
+    renderer->instanceBuffersMemory = TMMemoryPoolCreate(sizeof(TMInstanceBuffer), TM_RENDERER_MEMORY_BLOCK_SIZE);
+    renderer->uploadBuffer = 0;
+    renderer->uploadBufferSize = 0;
+    renderer->uploadBufferOffset = 0;
+    renderer->lastPresentTime = 0.0;
+    renderer->frameTime = 0.0f;
     renderer->assetManager = assetManager;
 
+    // set the initial state explicitly so the shadow state matches the context
+    memset(&renderer->state, 0, sizeof(TMRendererState));
+    gState = &renderer->state;
+    gRenderer = renderer;
+    gState->clearColor[0] = 0.5f;
+    gState->clearColor[1] = 0.1f;
+    gState->clearColor[2] = 0.1f;
+    gState->clearColor[3] = 1.0f;
+    gState->cullFace = false;
+    gState->cullFaceMode = GL_BACK;
+    gState->blend = true;
+    gState->depthTest = false;
 
     glClearColor(0.5f, 0.1f, 0.1f, 1.0f);
     glDisable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
     glEnable(GL_BLEND);
     glDisable(GL_DEPTH_TEST);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -166,19 +334,69 @@ TMRenderer *TMRendererCreate(android_app *pApp, AAssetManager *assetManager) {
 }
 
 void TMRendererDestroy(TMRenderer *renderer) {
-    TMMemoryPoolDestroy(renderer->buffersMemory);
-    TMMemoryPoolDestroy(renderer->texturesMemory);
-    TMMemoryPoolDestroy(renderer->shadersMemory);
+    // manuel: whatever the game did not destroy goes with the context, but say so
+    unsigned int framebuffersCount = 0;
+    for(unsigned int i = 0; i < TMHandleTableGetCount(renderer->textures); ++i) {
+        TMTextureData *data = (TMTextureData *)TMHandleTableGetAt(renderer->textures, i);
+        if(data->framebuffer) framebuffersCount++;
+    }
+    unsigned int texturesCount = TMHandleTableGetCount(renderer->textures) - framebuffersCount;
+    unsigned int leaked = TMHandleTableGetCount(renderer->buffers) +
+                          TMHandleTableGetCount(renderer->shaders) +
+                          texturesCount + framebuffersCount;
+    if(leaked > 0) {
+        TM_LOG_INFO("WARNING: %u buffers, %u shaders, %u textures and %u framebuffers still alive\n",
+                    TMHandleTableGetCount(renderer->buffers),
+                    TMHandleTableGetCount(renderer->shaders),
+                    texturesCount, framebuffersCount);
+    }
+    if(!renderer->contextLost) {
+        // the framebuffers first, they take their color texture with them
+        for(unsigned int i = TMHandleTableGetCount(renderer->textures); i > 0; --i) {
+            TMTextureData *data = (TMTextureData *)TMHandleTableGetAt(renderer->textures, i - 1);
+            if(data->framebuffer) TMRendererFramebufferDestroy(renderer, data->framebuffer);
+        }
+        while(TMHandleTableGetCount(renderer->buffers) > 0) {
+            TMRendererBufferDestroy(renderer, TMBuffer{TMHandleTableGetHandleAt(renderer->buffers, 0)});
+        }
+        while(TMHandleTableGetCount(renderer->shaders) > 0) {
+            TMRendererShaderDestroy(renderer, TMShader{TMHandleTableGetHandleAt(renderer->shaders, 0)});
+        }
+        while(TMHandleTableGetCount(renderer->textures) > 0) {
+            TMRendererTextureDestroy(renderer, TMTexture{TMHandleTableGetHandleAt(renderer->textures, 0)});
+        }
+    }
+    if(renderer->uploadBuffer) glDeleteBuffers(1, &renderer->uploadBuffer);
+    if(renderer->display != EGL_NO_DISPLAY) {
+        eglMakeCurrent(renderer->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if(renderer->context != EGL_NO_CONTEXT) eglDestroyContext(renderer->display, renderer->context);
+        if(renderer->surface != EGL_NO_SURFACE) eglDestroySurface(renderer->display, renderer->surface);
+        eglTerminate(renderer->display);
+    }
+    TMHandleTableDestroy(renderer->buffers);
+    TMHandleTableDestroy(renderer->textures);
+    TMHandleTableDestroy(renderer->shaders);
     TMMemoryPoolDestroy(renderer->framebufferMemory);
+    TMMemoryPoolDestroy(renderer->instanceBuffersMemory);
+    if(gState == &renderer->state) gState = NULL;
+    if(gRenderer == renderer) gRenderer = NULL;
     free(renderer);
 }
 
 void TMRendererDepthTestEnable() {
-    glEnable(GL_DEPTH_TEST);
+    TMStateEnable(GL_DEPTH_TEST, &gState->depthTest, true);
 }
 
 void TMRendererDepthTestDisable() {
-    glDisable(GL_DEPTH_TEST);
+    TMStateEnable(GL_DEPTH_TEST, &gState->depthTest, false);
+}
+
+void TMRendererBlendEnable() {
+    TMStateEnable(GL_BLEND, &gState->blend, true);
+}
+
+void TMRendererBlendDisable() {
+    TMStateEnable(GL_BLEND, &gState->blend, false);
 }
 
 int TMRendererGetWidth(TMRenderer *renderer) {
@@ -196,7 +414,9 @@ bool TMRendererUpdateRenderArea(TMRenderer *renderer) {
     if(width != renderer->width || height != renderer->height) {
         renderer->width = width;
         renderer->height = height;
-        glViewport(0, 0, width, height);
+        if(gState->framebuffer == 0) {
+            TMStateViewport(0, 0, width, height);
+        }
         return true;
     }
     return false;
@@ -204,26 +424,26 @@ bool TMRendererUpdateRenderArea(TMRenderer *renderer) {
 
 void TMRendererFaceCulling(bool value,  unsigned int flags) {
     if(value) {
-        glEnable(GL_CULL_FACE);
+        TMStateEnable(GL_CULL_FACE, &gState->cullFace, true);
         if (flags == TM_CULL_BACK) {
-            glCullFace(GL_BACK);
+            TMStateCullFace(GL_BACK);
             return;
         }
         if (flags == TM_CULL_FRONT) {
-            glCullFace(GL_FRONT);
+            TMStateCullFace(GL_FRONT);
             return;
         }
         if (flags == (TM_CULL_BACK | TM_CULL_FRONT)) {
-            glCullFace(GL_FRONT_AND_BACK);
+            TMStateCullFace(GL_FRONT_AND_BACK);
             return;
         }
     } else {
-        glDisable(GL_CULL_FACE);
+        TMStateEnable(GL_CULL_FACE, &gState->cullFace, false);
     }
 }
 
 void TMRendererClear(float r, float g, float b, float a, unsigned  int flags) {
-        glClearColor(r, g, b, a);
+        TMStateClearColor(r, g, b, a);
         unsigned int mask = 0;
         if(flags & TM_COLOR_BUFFER_BIT) mask |= GL_COLOR_BUFFER_BIT;
         if(flags & TM_DEPTH_BUFFER_BIT) mask |= GL_DEPTH_BUFFER_BIT;
@@ -231,19 +451,147 @@ void TMRendererClear(float r, float g, float b, float a, unsigned  int flags) {
         glClear(mask);
 }
 
+// attachments of the bound framebuffer named for glInvalidateFramebuffer,
+// the window surface uses different enums than a framebuffer object
+static int PassAttachments(TMRenderer *renderer, TMRenderPass *pass, bool color, bool depth, GLenum *attachments) {
+    int count = 0;
+    if(pass->framebuffer) {
+        if(color) attachments[count++] = GL_COLOR_ATTACHMENT0;
+        if(depth) attachments[count++] = GL_DEPTH_ATTACHMENT;
+    } else {
+        if(color) attachments[count++] = GL_COLOR;
+        if(depth && (renderer->surfaceFlags & TM_SURFACE_DEPTH)) attachments[count++] = GL_DEPTH;
+        if(depth && (renderer->surfaceFlags & TM_SURFACE_STENCIL)) attachments[count++] = GL_STENCIL;
+    }
+    return count;
+}
+
+void TMRendererBeginPass(TMRenderer *renderer, TMRenderPass *pass) {
+    assert(!renderer->inPass);
+    renderer->pass = *pass;
+    renderer->inPass = true;
+    TMRendererFramebufferBind(renderer, pass->framebuffer);
+
+    // manuel: tell the driver what it does not need to load into tile memory,
+    // contents we don't care about are invalidated and cleared ones never read
+    GLenum attachments[3];
+    int count = PassAttachments(renderer, pass,
+                                pass->colorLoad == TM_LOAD_ACTION_DONT_CARE,
+                                pass->depthLoad == TM_LOAD_ACTION_DONT_CARE, attachments);
+    if(count > 0) {
+        glInvalidateFramebuffer(GL_FRAMEBUFFER, count, attachments);
+    }
+
+    GLbitfield mask = 0;
+    if(pass->colorLoad == TM_LOAD_ACTION_CLEAR) {
+        TMStateClearColor(pass->clearColor[0], pass->clearColor[1], pass->clearColor[2], pass->clearColor[3]);
+        mask |= GL_COLOR_BUFFER_BIT;
+    }
+    if(pass->depthLoad == TM_LOAD_ACTION_CLEAR) {
+        glClearDepthf(pass->clearDepth);
+        mask |= GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+    }
+    if(mask) glClear(mask);
+}
+
+void TMRendererEndPass(TMRenderer *renderer) {
+    assert(renderer->inPass);
+    TMRenderPass *pass = &renderer->pass;
+
+    // manuel: anything not stored is dropped instead of written back to memory
+    GLenum attachments[3];
+    int count = PassAttachments(renderer, pass,
+                                pass->colorStore == TM_STORE_ACTION_DONT_CARE,
+                                pass->depthStore == TM_STORE_ACTION_DONT_CARE, attachments);
+    if(count > 0) {
+        glInvalidateFramebuffer(GL_FRAMEBUFFER, count, attachments);
+    }
+    renderer->inPass = false;
+}
+
+static double GetTime() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1000000000.0;
+}
+
 void TMRendererPresent(TMRenderer *renderer) {
     EGLBoolean swapResult = eglSwapBuffers(renderer->display, renderer->surface);
-    assert(swapResult == EGL_TRUE);
+    if(swapResult != EGL_TRUE) {
+        EGLint error = eglGetError();
+        TM_LOG_INFO("ERROR: eglSwapBuffers 0x%x\n", error);
+        // manuel: power events can take the context away, the owner has to recreate everything
+        if(error == EGL_CONTEXT_LOST) renderer->contextLost = true;
+        return;
+    }
+
+    // manuel: the swap blocks on vsync and on the gpu catching up, so the time
+    // between swaps is the real frame time
+    double now = GetTime();
+    if(renderer->lastPresentTime > 0.0) {
+        renderer->frameTime = (float)(now - renderer->lastPresentTime);
+    }
+    renderer->lastPresentTime = now;
 }
 
-TMBuffer *TMRendererBufferCreate(TMRenderer *renderer,
-                                 TMVertex *vertices, unsigned int verticesCount) {
-    TMBuffer *buffer = (TMBuffer *)TMMemoryPoolAlloc(renderer->buffersMemory);
+float TMRendererGetFrameTime(TMRenderer *renderer) {
+    return renderer->frameTime;
+}
+
+TMRendererStats TMRendererGetStats(TMRenderer *renderer) {
+    return renderer->state.stats;
+}
+
+void TMRendererResetStats(TMRenderer *renderer) {
+    renderer->state.stats.callsIssued = 0;
+    renderer->state.stats.callsElided = 0;
+}
+
+bool TMRendererBufferIsValid(TMRenderer *renderer, TMBuffer buffer) {
+    return TMHandleTableIsValid(renderer->buffers, buffer.handle);
+}
+
+bool TMRendererShaderIsValid(TMRenderer *renderer, TMShader shader) {
+    return TMHandleTableIsValid(renderer->shaders, shader.handle);
+}
+
+bool TMRendererTextureIsValid(TMRenderer *renderer, TMTexture texture) {
+    return TMHandleTableIsValid(renderer->textures, texture.handle);
+}
+
+unsigned int TMRendererGetBuffersCount(TMRenderer *renderer) {
+    return TMHandleTableGetCount(renderer->buffers);
+}
+
+TMBuffer TMRendererGetBuffer(TMRenderer *renderer, unsigned int index) {
+    return TMBuffer{TMHandleTableGetHandleAt(renderer->buffers, index)};
+}
+
+unsigned int TMRendererGetShadersCount(TMRenderer *renderer) {
+    return TMHandleTableGetCount(renderer->shaders);
+}
+
+TMShader TMRendererGetShader(TMRenderer *renderer, unsigned int index) {
+    return TMShader{TMHandleTableGetHandleAt(renderer->shaders, index)};
+}
+
+unsigned int TMRendererGetTexturesCount(TMRenderer *renderer) {
+    return TMHandleTableGetCount(renderer->textures);
+}
+
+TMTexture TMRendererGetTexture(TMRenderer *renderer, unsigned int index) {
+    return TMTexture{TMHandleTableGetHandleAt(renderer->textures, index)};
+}
+
+TMBuffer TMRendererBufferCreate(TMRenderer *renderer,
+                                TMVertex *vertices, unsigned int verticesCount) {
+    TMBufferData *data;
+    TMBuffer buffer = TMBuffer{TMHandleTableAdd(renderer->buffers, (void **)&data)};
 
     unsigned int VAO, VBO;
 
     glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    TMStateBindVertexArray(VAO);
 
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -254,24 +602,29 @@ TMBuffer *TMRendererBufferCreate(TMRenderer *renderer,
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TMVertex), (void *)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    buffer->id = VAO;
-    buffer->vbo = VBO;
-    buffer->vertices = vertices;
-    buffer->verticesCount = verticesCount;
+    data->id = VAO;
+    data->vbo = VBO;
+    data->ebo = 0;
+    data->vertices = vertices;
+    data->verticesCount = verticesCount;
+    data->indices = NULL;
+    data->indicesCount = 0;
+    data->instanceVbo = 0;
 
     return buffer;
 
 }
 
-TMBuffer *TMRendererBufferCreate(TMRenderer *renderer,
-                                 TMVertex *vertices, unsigned int verticesCount,
-                                 unsigned short *indices, unsigned int indicesCount) {
-    TMBuffer *buffer = (TMBuffer *)TMMemoryPoolAlloc(renderer->buffersMemory);
+TMBuffer TMRendererBufferCreate(TMRenderer *renderer,
+                                TMVertex *vertices, unsigned int verticesCount,
+                                unsigned short *indices, unsigned int indicesCount) {
+    TMBufferData *data;
+    TMBuffer buffer = TMBuffer{TMHandleTableAdd(renderer->buffers, (void **)&data)};
 
     unsigned int VAO, VBO, EBO;
 
     glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    TMStateBindVertexArray(VAO);
 
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -286,44 +639,179 @@ TMBuffer *TMRendererBufferCreate(TMRenderer *renderer,
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TMVertex), (void *)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    buffer->id = VAO;
-    buffer->vbo = VBO;
-    buffer->ebo = EBO;
-    buffer->vertices = vertices;
-    buffer->verticesCount = verticesCount;
-    buffer->indices = indices;
-    buffer->indicesCount = indicesCount;
+    data->id = VAO;
+    data->vbo = VBO;
+    data->ebo = EBO;
+    data->vertices = vertices;
+    data->verticesCount = verticesCount;
+    data->indices = indices;
+    data->indicesCount = indicesCount;
+    data->instanceVbo = 0;
 
     return buffer;
 
 }
 
-void TMRendererBufferDestroy(TMRenderer *renderer, TMBuffer *buffer) {
-    glDeleteBuffers(1, &buffer->vbo);
-    glDeleteBuffers(1, &buffer->ebo);
-    glDeleteVertexArrays(1, &buffer->id);
-    TMMemoryPoolFree(renderer->buffersMemory, (void *)buffer);
+TMBuffer TMRendererBufferCreateDynamic(TMRenderer *renderer, unsigned int verticesCount,
+                                       unsigned short *indices, unsigned int indicesCount) {
+    // the vertices are streamed every frame with TMRendererBufferUpdate,
+    // the indices are static
+    TMBuffer buffer = TMRendererBufferCreate(renderer, NULL, verticesCount, indices, indicesCount);
+    glBindBuffer(GL_ARRAY_BUFFER, BufferGet(buffer)->vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(TMVertex) * verticesCount, NULL, GL_STREAM_DRAW);
+    return buffer;
 }
 
-void TMRendererDrawBufferElements(TMBuffer *buffer) {
-    glBindVertexArray(buffer->id);
-    glDrawElements(GL_TRIANGLES, buffer->indicesCount, GL_UNSIGNED_SHORT, 0);
+void TMRendererBufferUpdate(TMBuffer buffer, TMVertex *vertices, unsigned int verticesCount) {
+    TMBufferData *data = BufferGet(buffer);
+    if(!data) return;
+    assert(verticesCount <= data->verticesCount);
+    glBindBuffer(GL_ARRAY_BUFFER, data->vbo);
+    // orphan the old storage so the driver does not stall on draws still using it
+    glBufferData(GL_ARRAY_BUFFER, sizeof(TMVertex) * data->verticesCount, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(TMVertex) * verticesCount, vertices);
 }
 
-void TMRendererDrawBufferArray(TMBuffer *buffer) {
-    glBindVertexArray(buffer->id);
-    glDrawArrays(GL_TRIANGLES, 0, buffer->verticesCount);
+void TMRendererBufferDestroy(TMRenderer *renderer, TMBuffer buffer) {
+    TMBufferData *data = (TMBufferData *)TMHandleTableGet(renderer->buffers, buffer.handle);
+    if(!data) {
+        TM_LOG_INFO("WARNING: TMBuffer 0x%x destroyed twice or never created\n", buffer.handle);
+        return;
+    }
+    glDeleteBuffers(1, &data->vbo);
+    if(data->ebo) glDeleteBuffers(1, &data->ebo);
+    TMStateForgetVertexArray(data->id);
+    glDeleteVertexArrays(1, &data->id);
+    TMHandleTableRemove(renderer->buffers, buffer.handle);
 }
 
-TMShader *TMRendererShaderCreate(TMRenderer *renderer, const char *vertPath, const char *fragPath) {
-    TMShader *shader = (TMShader *)TMMemoryPoolAlloc(renderer->shadersMemory);
+void TMRendererDrawBufferElements(TMBuffer buffer) {
+    TMBufferData *data = BufferGet(buffer);
+    if(!data) return;
+    TMStateBindVertexArray(data->id);
+    glDrawElements(GL_TRIANGLES, data->indicesCount, GL_UNSIGNED_SHORT, 0);
+}
 
-    // TODO: change this to work with files ...
-    TMFile vertFile = TMFileOpen(renderer->assetManager, vertPath);
-    TMFile fragFile = TMFileOpen(renderer->assetManager, fragPath);
-    const char *vertSource = (const char *)vertFile.data;
-    const char *fragSource = (const char *)fragFile.data;
+void TMRendererDrawBufferElements(TMBuffer buffer, unsigned int indicesCount, unsigned int indicesOffset) {
+    TMBufferData *data = BufferGet(buffer);
+    if(!data) return;
+    TMStateBindVertexArray(data->id);
+    glDrawElements(GL_TRIANGLES, indicesCount, GL_UNSIGNED_SHORT,
+                   (void *)(indicesOffset * sizeof(unsigned short)));
+}
+
+void TMRendererDrawBufferArray(TMBuffer buffer) {
+    TMBufferData *data = BufferGet(buffer);
+    if(!data) return;
+    TMStateBindVertexArray(data->id);
+    glDrawArrays(GL_TRIANGLES, 0, data->verticesCount);
+}
+
+void TMRendererDrawBuffer(TMBuffer buffer) {
+    TMBufferData *data = BufferGet(buffer);
+    if(!data) return;
+    if(data->ebo) {
+        TMRendererDrawBufferElements(buffer);
+    } else {
+        TMRendererDrawBufferArray(buffer);
+    }
+}
 
+TMInstanceBuffer *TMRendererInstanceBufferCreate(TMRenderer *renderer, unsigned int maxInstances) {
+    TMInstanceBuffer *instanceBuffer = (TMInstanceBuffer *)TMMemoryPoolAlloc(renderer->instanceBuffersMemory);
+    glGenBuffers(1, &instanceBuffer->id);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer->id);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(TMInstance) * maxInstances, NULL, GL_STREAM_DRAW);
+    instanceBuffer->maxInstances = maxInstances;
+    return instanceBuffer;
+}
+
+void TMRendererInstanceBufferDestroy(TMRenderer *renderer, TMInstanceBuffer *instanceBuffer) {
+    // manuel: glGenBuffers can hand this name to the next instance buffer, a vao that
+    // cached it would then skip re-pointing its attributes and read the deleted buffer
+    unsigned int buffersCount = TMHandleTableGetCount(renderer->buffers);
+    for(unsigned int i = 0; i < buffersCount; ++i) {
+        TMBufferData *data = (TMBufferData *)TMHandleTableGetAt(renderer->buffers, i);
+        if(data->instanceVbo == instanceBuffer->id) data->instanceVbo = 0;
+    }
+    glDeleteBuffers(1, &instanceBuffer->id);
+    TMMemoryPoolFree(renderer->instanceBuffersMemory, (void *)instanceBuffer);
+}
+
+void TMRendererInstanceBufferUpdate(TMInstanceBuffer *instanceBuffer,
+                                    TMInstance *instances, unsigned int instancesCount) {
+    assert(instancesCount <= instanceBuffer->maxInstances);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer->id);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(TMInstance) * instanceBuffer->maxInstances, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(TMInstance) * instancesCount, instances);
+}
+
+static void BufferAttachInstances(TMBufferData *buffer, TMInstanceBuffer *instanceBuffer) {
+    // the per instance stream lives in locations 2 to 6, see vert_instanced.glsl
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer->id);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TMInstance), (void *)offsetof(TMInstance, position));
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(TMInstance), (void *)offsetof(TMInstance, scale));
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(TMInstance), (void *)offsetof(TMInstance, rotation));
+    glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(TMInstance), (void *)offsetof(TMInstance, color));
+    glVertexAttribPointer(6, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(TMInstance), (void *)offsetof(TMInstance, uvRect));
+    for(unsigned int location = 2; location <= 6; ++location) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    buffer->instanceVbo = instanceBuffer->id;
+}
+
+void TMRendererDrawBufferInstanced(TMBuffer buffer, TMInstanceBuffer *instanceBuffer,
+                                   unsigned int instancesCount) {
+    TMBufferData *data = BufferGet(buffer);
+    if(!data) return;
+    TMStateBindVertexArray(data->id);
+    if(data->instanceVbo != instanceBuffer->id) {
+        BufferAttachInstances(data, instanceBuffer);
+    }
+    if(data->ebo) {
+        glDrawElementsInstanced(GL_TRIANGLES, data->indicesCount, GL_UNSIGNED_SHORT, 0, instancesCount);
+    } else {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, data->verticesCount, instancesCount);
+    }
+}
+
+static void ShaderReflectUniforms(TMShaderData *shader) {
+    shader->uniformsCount = 0;
+
+    int activeUniforms = 0;
+    glGetProgramiv(shader->id, GL_ACTIVE_UNIFORMS, &activeUniforms);
+    if(activeUniforms > TM_SHADER_MAX_UNIFORMS) {
+        TM_LOG_INFO("WARNING: shader has %d uniforms, only %d are cached\n",
+                    activeUniforms, TM_SHADER_MAX_UNIFORMS);
+        activeUniforms = TM_SHADER_MAX_UNIFORMS;
+    }
+
+    for(int i = 0; i < activeUniforms; ++i) {
+        TMShaderUniform *uniform = &shader->uniforms[shader->uniformsCount];
+        // manuel: read into a big buffer, a name cut to TM_SHADER_MAX_UNIFORM_NAME
+        // would be cached and never match the name the game asks for
+        char name[256];
+        int length = 0;
+        glGetActiveUniform(shader->id, i, sizeof(name), &length, &uniform->size, &uniform->type, name);
+        // arrays are reported as "name[0]", store them as "name"
+        char *bracket = strchr(name, '[');
+        if(bracket) *bracket = 0;
+        bool fits = strlen(name) < TM_SHADER_MAX_UNIFORM_NAME;
+        if(!fits) TM_LOG_INFO("ERROR: uniform %s is longer than %d characters, it is not cached\n",
+                              name, TM_SHADER_MAX_UNIFORM_NAME - 1);
+        assert(fits);
+        if(!fits) continue;
+        strcpy(uniform->name, name);
+        uniform->location = glGetUniformLocation(shader->id, uniform->name);
+        // uniforms inside uniform blocks have no location
+        if(uniform->location >= 0) {
+            shader->uniformsCount++;
+        }
+    }
+}
+
+static unsigned int ShaderCompileProgram(const char *vertSource, const char *fragSource, bool retrievable) {
     // TODO: ...
     int success;
     char infoLog[512];
@@ -351,6 +839,9 @@ TMShader *TMRendererShaderCreate(TMRenderer *renderer, const char *vertPath, con
     unsigned int program = glCreateProgram();
     glAttachShader(program, vertShader);
     glAttachShader(program, fragShader);
+    if(retrievable) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(program);
     glGetProgramiv(program, GL_LINK_STATUS, &success);
     if(!success) {
@@ -361,109 +852,296 @@ TMShader *TMRendererShaderCreate(TMRenderer *renderer, const char *vertPath, con
     glDeleteShader(vertShader);
     glDeleteShader(fragShader);
 
-    shader->id = program;
+    return program;
+}
 
-    TMFileClose(&vertFile);
-    TMFileClose(&fragFile);
+// returns 0 if there is no usable binary, the compiled program then overwrites the file
+static unsigned int ShaderLoadCachedProgram(const char *path, uint64_t key) {
+    unsigned int binaryFormat = 0;
+    void *binary = NULL;
+    size_t binarySize = 0;
+    TMArenaSavepoint scratch = TMArenaSave(TMArenaGetScratch());
+    if(!TMShaderCacheLoad(path, key, scratch.arena, &binaryFormat, &binary, &binarySize)) {
+        return 0;
+    }
+
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, binaryFormat, binary, (GLsizei)binarySize);
+    TMArenaRollback(scratch);
+
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if(!success) {
+        // manuel: the driver can reject a binary it wrote itself, e.g. after an update
+        TM_LOG_INFO("Shader cache: binary rejected %s\n", path);
+        glDeleteProgram(program);
+        TMShaderCacheRemove(path);
+        return 0;
+    }
+    return program;
+}
+
+static void ShaderStoreCachedProgram(const char *path, uint64_t key, unsigned int program) {
+    int binarySize = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if(binarySize <= 0) return;
+
+    TMArenaSavepoint scratch = TMArenaSave(TMArenaGetScratch());
+    void *binary = TMArenaAlloc(scratch.arena, binarySize);
+    GLenum binaryFormat = 0;
+    GLsizei length = 0;
+    glGetProgramBinary(program, binarySize, &length, &binaryFormat, binary);
+    if(length > 0 && !TMShaderCacheStore(path, key, binaryFormat, binary, length)) {
+        TM_LOG_INFO("Shader cache: can't write %s\n", path);
+    }
+    TMArenaRollback(scratch);
+}
+
+static bool ShaderCacheAvailable(TMRenderer *renderer) {
+    int formatsCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatsCount);
+    return formatsCount > 0 && renderer->pApp && renderer->pApp->activity->internalDataPath;
+}
+
+TMShader TMRendererShaderCreate(TMRenderer *renderer, const char *vertPath, const char *fragPath) {
+    TMShaderData *data;
+    TMShader shader = TMShader{TMHandleTableAdd(renderer->shaders, (void **)&data)};
+
+    // manuel: the sources are only needed until the program is linked
+    TMArenaSavepoint scratch = TMArenaSave(TMArenaGetScratch());
+    TMFile vertFile = TMFileOpen(renderer->assetManager, vertPath, scratch.arena);
+    TMFile fragFile = TMFileOpen(renderer->assetManager, fragPath, scratch.arena);
+    const char *vertSource = (const char *)vertFile.data;
+    const char *fragSource = (const char *)fragFile.data;
+
+    // manuel: try the program binary from the last run before compiling
+    unsigned int program = 0;
+    bool useCache = vertSource && fragSource && ShaderCacheAvailable(renderer);
+    char cachePath[512];
+    uint64_t cacheKey = 0;
+    if(useCache) {
+        char driver[512];
+        snprintf(driver, sizeof(driver), "%s|%s|%s",
+                 (const char *)glGetString(GL_VENDOR),
+                 (const char *)glGetString(GL_RENDERER),
+                 (const char *)glGetString(GL_VERSION));
+        cacheKey = TMShaderCacheKey(vertSource, fragSource, driver);
+        TMShaderCachePath(renderer->pApp->activity->internalDataPath, vertPath, fragPath,
+                          cachePath, sizeof(cachePath));
+        program = ShaderLoadCachedProgram(cachePath, cacheKey);
+    }
+
+    if(!program) {
+        program = ShaderCompileProgram(vertSource, fragSource, useCache);
+        int success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if(useCache && success) {
+            ShaderStoreCachedProgram(cachePath, cacheKey, program);
+        }
+    }
+
+    data->id = program;
+    ShaderReflectUniforms(data);
+
+    TMArenaRollback(scratch);
 
     return shader;
 }
 
-void TMRendererShaderDestroy(TMRenderer *renderer, TMShader *shader) {
-    glDeleteShader(shader->id);
-    TMMemoryPoolFree(renderer->shadersMemory, (void *)shader);
+void TMRendererShaderDestroy(TMRenderer *renderer, TMShader shader) {
+    TMShaderData *data = (TMShaderData *)TMHandleTableGet(renderer->shaders, shader.handle);
+    if(!data) {
+        TM_LOG_INFO("WARNING: TMShader 0x%x destroyed twice or never created\n", shader.handle);
+        return;
+    }
+    TMStateForgetProgram(data->id);
+    glDeleteProgram(data->id);
+    TMHandleTableRemove(renderer->shaders, shader.handle);
+}
+
+void TMRendererBindShader(TMShader shader) {
+    TMShaderData *data = ShaderGet(shader);
+    if(!data) return;
+    TMStateUseProgram(data->id);
+}
+
+void TMRendererUnbindShader(TMShader shader) {
+    (void)shader;
+    TMStateUseProgram(0);
+}
+
+unsigned int TMRendererShaderGetId(TMShader shader) {
+    TMShaderData *data = ShaderGet(shader);
+    return data ? data->id : 0;
+}
+
+TMUniform TMRendererShaderGetUniform(TMShader shader, const char *varName) {
+    TMShaderData *data = ShaderGet(shader);
+    // -1 is silently ignored by glUniform*, same as glGetUniformLocation on a missing name
+    TMUniform missing = TMUniform{-1, shader.handle, 0, 0};
+    if(!data) return missing;
+    bool fits = strlen(varName) < TM_SHADER_MAX_UNIFORM_NAME;
+    if(!fits) TM_LOG_INFO("ERROR: uniform %s is longer than %d characters\n", varName, TM_SHADER_MAX_UNIFORM_NAME - 1);
+    assert(fits);
+    if(!fits) return missing;
+    for(unsigned int i = 0; i < data->uniformsCount; ++i) {
+        TMShaderUniform *uniform = &data->uniforms[i];
+        if(strcmp(uniform->name, varName) == 0) {
+            return TMUniform{uniform->location, shader.handle, uniform->type, uniform->size};
+        }
+    }
+    return missing;
+}
+
+static bool UniformIsInt(unsigned int type) {
+    switch(type) {
+        case GL_INT: case GL_BOOL:
+        case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE: case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY_SHADOW: case GL_SAMPLER_CUBE_SHADOW:
+        case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_CUBE: case GL_INT_SAMPLER_2D_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D: case GL_UNSIGNED_INT_SAMPLER_CUBE:
+        case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// manuel: a uniform of another shader or of another type writes whatever sits at its
+// location without a GL error, catch it in debug. type GL_INT also takes bools and samplers
+static void UniformCheck(TMShader shader, TMUniform uniform, unsigned int type, int count) {
+#ifdef NDEBUG
+    (void)shader; (void)uniform; (void)type; (void)count;
+#else
+    if(uniform.location < 0) return;
+    bool sameShader = uniform.shader == shader.handle;
+    bool sameType = type == GL_INT ? UniformIsInt(uniform.type) : uniform.type == type;
+    if(!sameShader) TM_LOG_INFO("ERROR: uniform of TMShader 0x%x used with 0x%x\n", uniform.shader, shader.handle);
+    if(!sameType) TM_LOG_INFO("ERROR: uniform of type 0x%x updated as 0x%x\n", uniform.type, type);
+    assert(sameShader && sameType);
+    assert(count <= uniform.size);
+#endif
+}
+
+void TMRendererShaderUpdate(TMShader shader, const char *varName, float value) {
+    TMRendererShaderUpdate(shader, TMRendererShaderGetUniform(shader, varName), value);
+}
+
+void TMRendererShaderUpdate(TMShader shader, const char *varName, int value) {
+    TMRendererShaderUpdate(shader, TMRendererShaderGetUniform(shader, varName), value);
+}
+
+void TMRendererShaderUpdate(TMShader shader, const char *varName, TMVec3 value) {
+    TMRendererShaderUpdate(shader, TMRendererShaderGetUniform(shader, varName), value);
+}
+
+void TMRendererShaderUpdate(TMShader shader, const char *varName, TMVec4 value) {
+    TMRendererShaderUpdate(shader, TMRendererShaderGetUniform(shader, varName), value);
+}
+
+void TMRendererShaderUpdate(TMShader shader, const char *varName, TMMat4 value) {
+    TMRendererShaderUpdate(shader, TMRendererShaderGetUniform(shader, varName), value);
 }
 
-void TMRendererBindShader(TMShader *shader) {
-    glUseProgram(shader->id);
+void TMRendererShaderUpdate(TMShader shader, const char *varName, int size, int *array) {
+    TMRendererShaderUpdate(shader, TMRendererShaderGetUniform(shader, varName), size, array);
 }
 
-void TMRendererUnbindShader(TMShader *shader) {
-    glUseProgram(0);
+void TMRendererShaderUpdate(TMShader shader, const char *varName, int size, TMMat4 *array) {
+    TMRendererShaderUpdate(shader, TMRendererShaderGetUniform(shader, varName), size, array);
 }
 
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, float value) {
-    int varLoc = glGetUniformLocation(shader->id, varName);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, float value) {
     TMRendererBindShader(shader);
-    glUniform1f(varLoc, value);
+    UniformCheck(shader, uniform, GL_FLOAT, 1);
+    glUniform1f(uniform.location, value);
 }
 
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, int value) {
-    int varLoc = glGetUniformLocation(shader->id, varName);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, int value) {
     TMRendererBindShader(shader);
-    glUniform1i(varLoc, value);
+    UniformCheck(shader, uniform, GL_INT, 1);
+    glUniform1i(uniform.location, value);
 }
 
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, TMVec3 value) {
-    int varLoc = glGetUniformLocation(shader->id, varName);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, TMVec3 value) {
     TMRendererBindShader(shader);
-    glUniform3fv(varLoc, 1, value.v);
+    UniformCheck(shader, uniform, GL_FLOAT_VEC3, 1);
+    glUniform3fv(uniform.location, 1, value.v);
 }
 
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, TMVec4 value) {
-    int varLoc = glGetUniformLocation(shader->id, varName);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, TMVec4 value) {
     TMRendererBindShader(shader);
-    glUniform4fv(varLoc, 1, value.v);
+    UniformCheck(shader, uniform, GL_FLOAT_VEC4, 1);
+    glUniform4fv(uniform.location, 1, value.v);
 }
 
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, TMMat4 value) {
-    int varLoc = glGetUniformLocation(shader->id, varName);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, TMMat4 value) {
     TMRendererBindShader(shader);
-    glUniformMatrix4fv(varLoc, 1, false, value.v);
+    UniformCheck(shader, uniform, GL_FLOAT_MAT4, 1);
+    glUniformMatrix4fv(uniform.location, 1, false, value.v);
 }
 
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, int size, int *array) {
-    int varLoc = glGetUniformLocation(shader->id, varName);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, int size, int *array) {
     TMRendererBindShader(shader);
-    glUniform1iv(varLoc, size, array);
+    UniformCheck(shader, uniform, GL_INT, size);
+    glUniform1iv(uniform.location, size, array);
 }
 
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, int size, TMMat4 *array) {
-    int varLoc = glGetUniformLocation(shader->id, varName);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, int size, TMMat4 *array) {
     TMRendererBindShader(shader);
-    glUniformMatrix4fv(varLoc, size, false, (float *)array);
-}
-
-TMTexture *TMRendererTextureCreate(TMRenderer *renderer, const char *filepath) {
-    TMTexture *texture = (TMTexture *)TMMemoryPoolAlloc(renderer->texturesMemory);
-
-    AAsset *file = AAssetManager_open(renderer->assetManager, filepath, AASSET_MODE_BUFFER);
-
-    // manuel: make a decoder to turn in into a texture
-    AImageDecoder *androidDecoder = NULL;
-    int result = AImageDecoder_createFromAAsset(file, &androidDecoder);
-    assert(result == ANDROID_IMAGE_DECODER_SUCCESS);
-
-    // manuel: make sure we get 8 bits per channel RGBA
-    AImageDecoder_setAndroidBitmapFormat(androidDecoder, ANDROID_BITMAP_FORMAT_RGBA_8888);
-
-    const AImageDecoderHeaderInfo *header = NULL;
-    header = AImageDecoder_getHeaderInfo(androidDecoder);
-
-    int width = AImageDecoderHeaderInfo_getWidth(header);
-    int height = AImageDecoderHeaderInfo_getHeight(header);
-    int stride = AImageDecoder_getMinimumStride(androidDecoder);
-
-    // TODO(manuel): fix this ...
-#if 0
-    // manuel: alloc memory for the texture
-    unsigned int *imageData = (unsigned int *)malloc(width * height * sizeof(unsigned int));
-    int decodeResult = AImageDecoder_decodeImage(androidDecoder, imageData, stride, width*height);
-    assert(decodeResult == ANDROID_IMAGE_DECODER_SUCCESS);
-#else if
-    // Get the bitmap data of the image
-    auto upAndroidImageData = std::make_unique<std::vector<uint8_t>>(height * stride);
-    auto decodeResult = AImageDecoder_decodeImage(
-            androidDecoder,
-            upAndroidImageData->data(),
-            stride,
-            upAndroidImageData->size());
-    assert(decodeResult == ANDROID_IMAGE_DECODER_SUCCESS);
-#endif
+    UniformCheck(shader, uniform, GL_FLOAT_MAT4, size);
+    glUniformMatrix4fv(uniform.location, size, false, (float *)array);
+}
+
+static bool EndsWith(const char *str, const char *suffix) {
+    size_t strLen = strlen(str);
+    size_t suffixLen = strlen(suffix);
+    return strLen >= suffixLen && strcmp(str + strLen - suffixLen, suffix) == 0;
+}
+
+bool TMRendererTexturePngPath(const char *filepath, char *buffer, size_t bufferSize) {
+    if(!EndsWith(filepath, ".ktx2")) return false;
+    int length = (int)(strlen(filepath) - strlen(".ktx2"));
+    return snprintf(buffer, bufferSize, "%.*s.png", length, filepath) < (int)bufferSize;
+}
+
+TMTexture TMRendererTextureCreate(TMRenderer *renderer, const char *filepath) {
+    char pngPath[256];
+    if(EndsWith(filepath, ".ktx2")) {
+        TMArenaSavepoint scratch = TMArenaSave(TMArenaGetScratch());
+        TMFile file = TMFileOpen(renderer->assetManager, filepath, scratch.arena);
+        TMTexture texture = TMTexture{TM_HANDLE_NULL};
+        if(file.data) {
+            texture = TMRendererTextureCreateCompressed(renderer, file.data, file.size);
+        }
+        TMArenaRollback(scratch);
+        if(texture.handle) return texture;
+        // manuel: missing file or a format the device can't sample, the png next to it always works
+        TM_LOG_INFO("Error Loading compressed texture: %s, trying the png", filepath);
+        if(!TMRendererTexturePngPath(filepath, pngPath, sizeof(pngPath))) {
+            return texture;
+        }
+        filepath = pngPath;
+    }
+
+    TMImage image = TMImageLoad(renderer->assetManager, filepath);
+    if(!image.pixels) {
+        TM_LOG_INFO("Error Loading texture: %s", filepath);
+        return TMTexture{TM_HANDLE_NULL};
+    }
+    TMTexture texture = TMRendererTextureCreate(renderer, image.pixels, image.width, image.height);
+    TMImageFree(&image);
+    return texture;
+}
+
+TMTexture TMRendererTextureCreate(TMRenderer *renderer, const unsigned char *pixels, int width, int height) {
+    TMTextureData *data;
+    TMTexture texture = TMTexture{TMHandleTableAdd(renderer->textures, (void **)&data)};
+
     // manuel: create opengl texture
     GLuint textureId;
     glGenTextures(1, &textureId);
-    glBindTexture(GL_TEXTURE_2D, textureId);
+    TMStateBindTexture(gState->activeTextureUnit, textureId);
 
     // manuel: Clamp to the edge, you'll get odd results alpha blending if you don't
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -482,44 +1160,362 @@ TMTexture *TMRendererTextureCreate(TMRenderer *renderer, const char *filepath) {
             0, // border (always 0)
             GL_RGBA, // format
             GL_UNSIGNED_BYTE, // type
-            upAndroidImageData->data() // Data to upload
+            pixels // Data to upload
     );
 
     // manuel: generate mip levels. Not really needed for 2D, but good to do
     glGenerateMipmap(GL_TEXTURE_2D);
 
-    AImageDecoder_delete(androidDecoder);
-    AAsset_close(file);
+    data->id = textureId;
+    data->width = width;
+    data->height = height;
+    data->uploadId = 0;
+
+    return texture;
+}
+
+static GLenum CompressedFormat(unsigned int vkFormat) {
+    switch(vkFormat) {
+        case TM_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK: return GL_COMPRESSED_RGB8_ETC2;
+        case TM_VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK: return GL_COMPRESSED_RGBA8_ETC2_EAC;
+        case TM_VK_FORMAT_ASTC_4x4_UNORM_BLOCK: return TM_GL_COMPRESSED_RGBA_ASTC_4x4;
+        case TM_VK_FORMAT_ASTC_8x8_UNORM_BLOCK: return TM_GL_COMPRESSED_RGBA_ASTC_8x8;
+        default: return 0;
+    }
+}
+
+bool TMRendererTextureFormatSupported(TMRenderer *renderer, unsigned int vkFormat) {
+    if(vkFormat == 0) return true;
+    GLenum format = CompressedFormat(vkFormat);
+    if(format == GL_COMPRESSED_RGB8_ETC2 || format == GL_COMPRESSED_RGBA8_ETC2_EAC) {
+        return true; // ETC2 is core in GLES3
+    }
+    return format && renderer->astcSupported;
+}
+
+TMTexture TMRendererTextureCreateCompressed(TMRenderer *renderer, const void *data, size_t size) {
+    TMKtx2 ktx2;
+    if(!TMKtx2Parse(data, size, &ktx2)) {
+        return TMTexture{TM_HANDLE_NULL};
+    }
+    if(!TMRendererTextureFormatSupported(renderer, ktx2.vkFormat)) {
+        return TMTexture{TM_HANDLE_NULL};
+    }
+    GLenum format = CompressedFormat(ktx2.vkFormat);
+
+    TMTextureData *textureData;
+    TMTexture texture = TMTexture{TMHandleTableAdd(renderer->textures, (void **)&textureData)};
+
+    GLuint textureId;
+    glGenTextures(1, &textureId);
+    TMStateBindTexture(gState->activeTextureUnit, textureId);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // manuel: the mip chain comes from the file, the driver can't generate mips for compressed formats
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, ktx2.levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, ktx2.levelCount - 1);
 
-    texture->id = textureId;
-    texture->width = width;
-    texture->height = height;
+    for(unsigned int i = 0; i < ktx2.levelCount; ++i) {
+        TMKtx2Level *level = ktx2.levels + i;
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, format, level->width, level->height, 0,
+                               (GLsizei)level->size, level->data);
+    }
+
+    textureData->id = textureId;
+    textureData->width = ktx2.width;
+    textureData->height = ktx2.height;
+    textureData->uploadId = 0;
 
     return texture;
 }
 
-void TMRendererTextureBind(TMTexture *texture, TMShader *shader, const char *varName, int textureIndex) {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture->id);
-    TMRendererShaderUpdate(shader, varName, textureIndex);
+bool TMRendererTextureUploadBegin(TMTexture handle, unsigned int vkFormat, int width, int height, int levels) {
+    TMTextureData *texture = TextureGet(handle);
+    if(!texture) return false;
+    assert(texture->uploadId == 0);
+    // manuel: the loader checks this when it decodes, this only keeps a bad format away from the driver
+    if(!TMRendererTextureFormatSupported(gRenderer, vkFormat)) {
+        TM_LOG_INFO("ERROR: texture format %u is not supported by the device\n", vkFormat);
+        return false;
+    }
+    GLenum format = vkFormat ? CompressedFormat(vkFormat) : GL_RGBA8;
+
+    // manuel: uncompressed textures get the full mip chain generated when the upload ends
+    if(!vkFormat) {
+        levels = 1;
+        for(int size = width > height ? width : height; size > 1; size >>= 1) levels++;
+    }
+
+    glGenTextures(1, &texture->uploadId);
+    TMStateBindTexture(gState->activeTextureUnit, texture->uploadId);
+    glTexStorage2D(GL_TEXTURE_2D, levels, format, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (vkFormat && levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    texture->uploadFormat = vkFormat;
+    texture->uploadWidth = width;
+    texture->uploadHeight = height;
+    texture->uploadLevels = levels;
+    return true;
 }
 
-void TMRendererTextureUnbind(TMTexture *texture, int textureIndex) {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glActiveTexture(GL_TEXTURE0);
+bool TMRendererTextureUploadRows(TMRenderer *renderer, TMTexture handle, int level, int y, int rows,
+                                 const void *data, size_t size) {
+    TMTextureData *texture = TextureGet(handle);
+    if(!texture) return false;
+    assert(texture->uploadId);
+
+    // manuel: copy into the ring buffer and let the driver read it from there, the
+    // ring is orphaned when it wraps so we never write over data still in flight
+    if(size > renderer->uploadBufferSize) {
+        if(!renderer->uploadBuffer) glGenBuffers(1, &renderer->uploadBuffer);
+        renderer->uploadBufferSize = size > 1024 * 1024 ? size : 1024 * 1024;
+        renderer->uploadBufferOffset = renderer->uploadBufferSize;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, renderer->uploadBuffer);
+    if(renderer->uploadBufferOffset + size > renderer->uploadBufferSize) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, renderer->uploadBufferSize, NULL, GL_STREAM_DRAW);
+        renderer->uploadBufferOffset = 0;
+    }
+    size_t offset = renderer->uploadBufferOffset;
+    void *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, size,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    const void *pixels = (const void *)offset;
+    if(dst) {
+        memcpy(dst, data, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        renderer->uploadBufferOffset = (offset + size + 15) & ~(size_t)15;
+    } else {
+        // manuel: the driver refused the mapping, upload these rows from client memory
+        // and check they made it, undefined rows must never be swapped in
+        TM_LOG_INFO("WARNING: can't map the upload buffer 0x%x, uploading from client memory\n", glGetError());
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        while(glGetError() != GL_NO_ERROR) {}
+        pixels = data;
+    }
+
+    int width = texture->uploadWidth >> level;
+    if(width < 1) width = 1;
+    TMStateBindTexture(gState->activeTextureUnit, texture->uploadId);
+    if(texture->uploadFormat) {
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, y, width, rows,
+                                  CompressedFormat(texture->uploadFormat), (GLsizei)size, pixels);
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, y, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if(!dst) {
+        GLenum error = glGetError();
+        if(error != GL_NO_ERROR) {
+            TM_LOG_INFO("ERROR: texture upload of level %d rows %d-%d failed 0x%x\n", level, y, y + rows, error);
+            return false;
+        }
+    }
+    return true;
 }
 
-void TMRendererTextureDestroy(TMRenderer *renderer, TMTexture *texture) {
+void TMRendererTextureUploadEnd(TMTexture handle) {
+    TMTextureData *texture = TextureGet(handle);
+    if(!texture) return;
+    assert(texture->uploadId);
+    if(!texture->uploadFormat) {
+        TMStateBindTexture(gState->activeTextureUnit, texture->uploadId);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    TMStateForgetTexture(texture->id);
     glDeleteTextures(1, &texture->id);
-    TMMemoryPoolFree(renderer->texturesMemory, (void *)texture);
+    texture->id = texture->uploadId;
+    texture->width = texture->uploadWidth;
+    texture->height = texture->uploadHeight;
+    texture->uploadId = 0;
+}
+
+void TMRendererTextureUploadCancel(TMTexture handle) {
+    TMTextureData *texture = TextureGet(handle);
+    if(!texture || !texture->uploadId) return;
+    TMStateForgetTexture(texture->uploadId);
+    glDeleteTextures(1, &texture->uploadId);
+    texture->uploadId = 0;
+}
+
+void TMRendererTextureSetClampToEdge(TMTexture texture) {
+    TMTextureData *data = TextureGet(texture);
+    if(!data) return;
+    TMStateBindTexture(gState->activeTextureUnit, data->id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
 
-TMFramebuffer *TMRendererFramebufferCreate(TMRenderer *renderer) {
+void TMRendererTextureSetMaxMipLevel(TMTexture texture, int maxMipLevel) {
+    TMTextureData *data = TextureGet(texture);
+    if(!data) return;
+    TMStateBindTexture(gState->activeTextureUnit, data->id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxMipLevel);
+}
+
+int TMRendererTextureGetWidth(TMTexture texture) {
+    TMTextureData *data = TextureGet(texture);
+    return data ? data->width : 0;
+}
+
+int TMRendererTextureGetHeight(TMTexture texture) {
+    TMTextureData *data = TextureGet(texture);
+    return data ? data->height : 0;
+}
+
+AAssetManager *TMRendererGetAssetManager(TMRenderer *renderer) {
+    return renderer->assetManager;
+}
+
+void TMRendererTextureBind(TMTexture texture, TMShader shader, const char *varName, int textureIndex) {
+    TMRendererTextureBind(texture, shader, TMRendererShaderGetUniform(shader, varName), textureIndex);
+}
+
+void TMRendererTextureBind(TMTexture texture, TMShader shader, TMUniform uniform, int textureIndex) {
+    TMTextureData *data = TextureGet(texture);
+    if(!data) return;
+    TMStateBindTexture(textureIndex, data->id);
+    TMRendererShaderUpdate(shader, uniform, textureIndex);
+}
+
+void TMRendererTextureUnbind(TMTexture texture, int textureIndex) {
+    (void)texture;
+    TMStateBindTexture(textureIndex, 0);
+}
+
+unsigned int TMRendererTextureGetId(TMTexture texture) {
+    TMTextureData *data = TextureGet(texture);
+    return data ? data->id : 0;
+}
+
+void TMRendererTextureDestroy(TMRenderer *renderer, TMTexture texture) {
+    TMTextureData *data = (TMTextureData *)TMHandleTableGet(renderer->textures, texture.handle);
+    if(!data) {
+        TM_LOG_INFO("WARNING: TMTexture 0x%x destroyed twice or never created\n", texture.handle);
+        return;
+    }
+    if(data->framebuffer) {
+        TM_LOG_INFO("WARNING: TMTexture 0x%x belongs to a framebuffer, destroy the framebuffer\n",
+                    texture.handle);
+        return;
+    }
+    TMStateForgetTexture(data->id);
+    glDeleteTextures(1, &data->id);
+    if(data->uploadId) {
+        TMStateForgetTexture(data->uploadId);
+        glDeleteTextures(1, &data->uploadId);
+    }
+    TMHandleTableRemove(renderer->textures, texture.handle);
+}
+
+static void FramebufferAllocate(TMFramebuffer *framebuffer, int width, int height) {
+    // manuel: immutable storage, resizing makes new attachments
+    TMTextureData *color = TextureGet(framebuffer->color);
+    glGenTextures(1, &color->id);
+    TMStateBindTexture(gState->activeTextureUnit, color->id);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    color->width = width;
+    color->height = height;
+    color->uploadId = 0;
+
+    glGenRenderbuffers(1, &framebuffer->depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, framebuffer->depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    unsigned int previous = gState->framebuffer;
+    TMStateBindFramebuffer(framebuffer->id);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color->id, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, framebuffer->depth);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if(status != GL_FRAMEBUFFER_COMPLETE) {
+        TM_LOG_INFO("ERROR: framebuffer %dx%d incomplete 0x%x\n", width, height, status);
+    }
+    TMStateBindFramebuffer(previous);
+
+    framebuffer->width = width;
+    framebuffer->height = height;
+}
+
+static void FramebufferRelease(TMFramebuffer *framebuffer) {
+    TMTextureData *color = TextureGet(framebuffer->color);
+    TMStateForgetTexture(color->id);
+    glDeleteTextures(1, &color->id);
+    glDeleteRenderbuffers(1, &framebuffer->depth);
+    color->id = 0;
+    framebuffer->depth = 0;
+}
+
+TMFramebuffer *TMRendererFramebufferCreate(TMRenderer *renderer, int width, int height) {
     TMFramebuffer *framebuffer = (TMFramebuffer *)TMMemoryPoolAlloc(renderer->framebufferMemory);
+    TMTextureData *color;
+    framebuffer->color = TMTexture{TMHandleTableAdd(renderer->textures, (void **)&color)};
+    color->framebuffer = framebuffer;
+    glGenFramebuffers(1, &framebuffer->id);
+    FramebufferAllocate(framebuffer, width > 0 ? width : 1, height > 0 ? height : 1);
     return framebuffer;
 }
 
 void TMRendererFramebufferDestroy(TMRenderer *renderer, TMFramebuffer *framebuffer) {
+    if(gState->framebuffer == framebuffer->id) {
+        TMStateBindFramebuffer(0);
+    }
+    FramebufferRelease(framebuffer);
+    glDeleteFramebuffers(1, &framebuffer->id);
+    TMHandleTableRemove(renderer->textures, framebuffer->color.handle);
     TMMemoryPoolFree(renderer->framebufferMemory, (void *)framebuffer);
 }
+
+void TMRendererFramebufferResize(TMFramebuffer *framebuffer, int width, int height) {
+    if(width < 1) width = 1;
+    if(height < 1) height = 1;
+    if(framebuffer->width == width && framebuffer->height == height) return;
+    bool bound = gState->framebuffer == framebuffer->id;
+    FramebufferRelease(framebuffer);
+    FramebufferAllocate(framebuffer, width, height);
+    if(bound) TMStateViewport(0, 0, width, height);
+}
+
+void TMRendererFramebufferBind(TMRenderer *renderer, TMFramebuffer *framebuffer) {
+    if(framebuffer) {
+        TMStateBindFramebuffer(framebuffer->id);
+        TMStateViewport(0, 0, framebuffer->width, framebuffer->height);
+    } else {
+        TMStateBindFramebuffer(0);
+        TMStateViewport(0, 0, renderer->width, renderer->height);
+    }
+}
+
+void TMRendererFramebufferBlit(TMRenderer *renderer, TMFramebuffer *framebuffer) {
+    // manuel: bilinear upscale straight into the window surface, no extra shader pass
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer->id);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, framebuffer->width, framebuffer->height,
+                      0, 0, renderer->width, renderer->height,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    TMStateForgetFramebuffer();
+    TMStateBindFramebuffer(0);
+    TMStateViewport(0, 0, renderer->width, renderer->height);
+}
+
+TMTexture TMRendererFramebufferGetTexture(TMFramebuffer *framebuffer) {
+    return framebuffer->color;
+}
+
+int TMRendererFramebufferGetWidth(TMFramebuffer *framebuffer) {
+    return framebuffer->width;
+}
+
+int TMRendererFramebufferGetHeight(TMFramebuffer *framebuffer) {
+    return framebuffer->height;
+}
@@ -12,61 +12,234 @@
 #define TM_CULL_BACK (1 << 0)
 #define TM_CULL_FRONT (1 << 1)
 
+// buffers of the window surface besides color
+#define TM_SURFACE_DEPTH (1 << 0)
+#define TM_SURFACE_STENCIL (1 << 1)
+
+// what a render pass does with an attachment when it begins
+#define TM_LOAD_ACTION_LOAD 0
+#define TM_LOAD_ACTION_CLEAR 1
+#define TM_LOAD_ACTION_DONT_CARE 2
+// and when it ends
+#define TM_STORE_ACTION_STORE 0
+#define TM_STORE_ACTION_DONT_CARE 1
+
+#include <stddef.h>
 #include "utils/tm_math.h"
 
 struct android_app;
 struct AAssetManager;
 
 struct TMRenderer;
-struct TMBuffer;
-struct TMShader;
-struct TMTexture;
 struct TMFramebuffer;
+struct TMInstanceBuffer;
+
+// Buffers, shaders and textures are 32 bit generational handles into dense tables
+// owned by the renderer (see utils/tm_handle_table.h). They are plain values, they can
+// be copied to other threads or into command packets, but only the thread that owns
+// the GL context resolves them. Using a destroyed one logs and does nothing instead of
+// touching freed memory. A zeroed handle is no resource
+struct TMBuffer {
+    unsigned int handle;
+};
+
+struct TMShader {
+    unsigned int handle;
+};
+
+struct TMTexture {
+    unsigned int handle;
+};
 
 struct TMVertex {
     TMVec3 position;
     TMVec2 uv;
 };
 
+// per instance data for TMRendererDrawBufferInstanced, 32 bytes.
+// Instances are placed on the XY plane: world = translate * rotateZ * scale
+struct TMInstance {
+    TMVec2 position;
+    TMVec2 scale;
+    float rotation;
+    unsigned int color;           // RGBA8 tint, red in the lowest byte
+    unsigned short uvRect[4];     // u0, v0, u1, v1 normalized to 0..65535
+};
+
+// handle to a uniform of a shader, resolve it once with TMRendererShaderGetUniform
+// and use it to update the uniform without any string lookup. It remembers the shader
+// and the GL type it was resolved with, debug builds assert both on every update
+struct TMUniform {
+    int location;
+    unsigned int shader;
+    unsigned int type;
+    int size;
+};
+
+// a shader and the uniforms TMSpriteBatch and TMRenderQueue set on it, resolve
+// them once after the shader is created, the engine never looks them up by name
+struct TMShaderUniforms {
+    TMShader shader;
+    TMUniform proj;
+    TMUniform world;
+    TMUniform texture;
+};
+
+// number of GL state changes sent to the driver and skipped because
+// the shadowed state was already the requested one
+struct TMRendererStats {
+    unsigned int callsIssued;
+    unsigned int callsElided;
+};
+
+// A render pass covers everything drawn into one target between
+// TMRendererBeginPass and TMRendererEndPass. On tile based GPUs the load and
+// store actions decide what is read into and written out of tile memory:
+// DONT_CARE avoids the read / the write back, CLEAR avoids the read.
+// The depth actions also apply to stencil.
+struct TMRenderPass {
+    TMFramebuffer *framebuffer; // NULL is the window surface
+    unsigned int colorLoad;
+    unsigned int colorStore;
+    unsigned int depthLoad;
+    unsigned int depthStore;
+    float clearColor[4];
+    float clearDepth;
+};
+
+// creates the window surface with a depth buffer
 TMRenderer *TMRendererCreate(android_app *pApp, AAssetManager *assetManager);
+// surfaceFlags is a combination of TM_SURFACE_*, 0 for a color only window
+TMRenderer *TMRendererCreate(android_app *pApp, AAssetManager *assetManager, unsigned int surfaceFlags);
 void TMRendererDestroy(TMRenderer *renderer);
+// The window surface lives from APP_CMD_INIT_WINDOW to APP_CMD_TERM_WINDOW, the
+// context and every GL object outlive it. Create returns false if the surface
+// could not be made current, check TMRendererIsContextLost to know if a reload is needed
+bool TMRendererSurfaceCreate(TMRenderer *renderer, android_app *pApp);
+void TMRendererSurfaceDestroy(TMRenderer *renderer);
+bool TMRendererHasSurface(TMRenderer *renderer);
+// true after EGL reported EGL_CONTEXT_LOST, destroy the renderer and create it again
+bool TMRendererIsContextLost(TMRenderer *renderer);
+android_app *TMRendererGetApp(TMRenderer *renderer);
 void TMRendererDepthTestEnable();
 void TMRendererDepthTestDisable();
+void TMRendererBlendEnable();
+void TMRendererBlendDisable();
 void TMRendererFaceCulling(bool value,  unsigned int flags);
 int TMRendererGetWidth(TMRenderer *renderer);
 int TMRendererGetHeight(TMRenderer *renderer);
+AAssetManager *TMRendererGetAssetManager(TMRenderer *renderer);
 bool TMRendererUpdateRenderArea(TMRenderer *renderer);
 void TMRendererClear(float r, float g, float b, float a, unsigned  int flags);
+void TMRendererBeginPass(TMRenderer *renderer, TMRenderPass *pass);
+void TMRendererEndPass(TMRenderer *renderer);
 void TMRendererPresent(TMRenderer *renderer);
+// seconds between the last two TMRendererPresent calls
+float TMRendererGetFrameTime(TMRenderer *renderer);
+TMRendererStats TMRendererGetStats(TMRenderer *renderer);
+void TMRendererResetStats(TMRenderer *renderer);
+
+// O(1), false for zeroed handles and handles of destroyed resources
+bool TMRendererBufferIsValid(TMRenderer *renderer, TMBuffer buffer);
+bool TMRendererShaderIsValid(TMRenderer *renderer, TMShader shader);
+bool TMRendererTextureIsValid(TMRenderer *renderer, TMTexture texture);
+// live resources, index in [0, count). Creating or destroying one changes the order
+unsigned int TMRendererGetBuffersCount(TMRenderer *renderer);
+TMBuffer TMRendererGetBuffer(TMRenderer *renderer, unsigned int index);
+unsigned int TMRendererGetShadersCount(TMRenderer *renderer);
+TMShader TMRendererGetShader(TMRenderer *renderer, unsigned int index);
+unsigned int TMRendererGetTexturesCount(TMRenderer *renderer);
+TMTexture TMRendererGetTexture(TMRenderer *renderer, unsigned int index);
+
+
+TMBuffer TMRendererBufferCreate(TMRenderer *renderer,
+                                TMVertex *vertices, unsigned int verticesCount);
+TMBuffer TMRendererBufferCreate(TMRenderer *renderer,
+                                TMVertex *vertices, unsigned int verticesCount,
+                                unsigned short *indices, unsigned int indicesCount);
+TMBuffer TMRendererBufferCreateDynamic(TMRenderer *renderer, unsigned int verticesCount,
+                                       unsigned short *indices, unsigned int indicesCount);
+void TMRendererBufferUpdate(TMBuffer buffer, TMVertex *vertices, unsigned int verticesCount);
+void TMRendererBufferDestroy(TMRenderer *renderer, TMBuffer buffer);
+void TMRendererDrawBufferElements(TMBuffer buffer);
+void TMRendererDrawBufferElements(TMBuffer buffer, unsigned int indicesCount, unsigned int indicesOffset);
+void TMRendererDrawBufferArray(TMBuffer buffer);
+void TMRendererDrawBuffer(TMBuffer buffer);
+
+TMInstanceBuffer *TMRendererInstanceBufferCreate(TMRenderer *renderer, unsigned int maxInstances);
+void TMRendererInstanceBufferDestroy(TMRenderer *renderer, TMInstanceBuffer *instanceBuffer);
+void TMRendererInstanceBufferUpdate(TMInstanceBuffer *instanceBuffer,
+                                    TMInstance *instances, unsigned int instancesCount);
+void TMRendererDrawBufferInstanced(TMBuffer buffer, TMInstanceBuffer *instanceBuffer,
+                                   unsigned int instancesCount);
+
+TMShader TMRendererShaderCreate(TMRenderer *renderer, const char *vertPath, const char *fragPath);
+void TMRendererShaderDestroy(TMRenderer *renderer, TMShader shader);
+void TMRendererBindShader(TMShader shader);
+void TMRendererUnbindShader(TMShader shader);
+unsigned int TMRendererShaderGetId(TMShader shader);
+TMUniform TMRendererShaderGetUniform(TMShader shader, const char *varName);
+void TMRendererShaderUpdate(TMShader shader, const char *varName, float value);
+void TMRendererShaderUpdate(TMShader shader, const char *varName, int value);
+void TMRendererShaderUpdate(TMShader shader, const char *varName, TMVec3 value);
+void TMRendererShaderUpdate(TMShader shader, const char *varName, TMVec4 value);
+void TMRendererShaderUpdate(TMShader shader, const char *varName, TMMat4 value);
+void TMRendererShaderUpdate(TMShader shader, const char *varName, int size, int *array);
+void TMRendererShaderUpdate(TMShader shader, const char *varName, int size, TMMat4 *array);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, float value);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, int value);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, TMVec3 value);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, TMVec4 value);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, TMMat4 value);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, int size, int *array);
+void TMRendererShaderUpdate(TMShader shader, TMUniform uniform, int size, TMMat4 *array);
+
+// .ktx2 files are uploaded as they are (compressed, with their mip chain), anything else is decoded to RGBA8
+// a .ktx2 that is missing or in a format the device can't sample loads the .png with the same name
+TMTexture TMRendererTextureCreate(TMRenderer *renderer, const char *filepath);
+TMTexture TMRendererTextureCreate(TMRenderer *renderer, const unsigned char *pixels, int width, int height);
+// data is the content of a KTX2 file with an ETC2 or ASTC format, a zeroed handle if the device can't sample it
+TMTexture TMRendererTextureCreateCompressed(TMRenderer *renderer, const void *data, size_t size);
+// vkFormat 0 (RGBA8) or one of tm_ktx2.h, any thread can ask
+bool TMRendererTextureFormatSupported(TMRenderer *renderer, unsigned int vkFormat);
+// the .png fallback of a .ktx2 path, false if filepath is not a .ktx2 or the buffer is too small
+bool TMRendererTexturePngPath(const char *filepath, char *buffer, size_t bufferSize);
+// Streaming upload into a texture that keeps sampling its current image until
+// TMRendererTextureUploadEnd swaps the new one in. vkFormat is 0 for RGBA8, which
+// gets its mips generated at the end, or a compressed format from tm_ktx2.h whose
+// levels are all uploaded. Rows of compressed formats are multiples of the block height.
+// Returns false, and the texture keeps its image, if the device can't sample vkFormat
+bool TMRendererTextureUploadBegin(TMTexture texture, unsigned int vkFormat, int width, int height, int levels);
+// false if the rows did not reach the texture, cancel the upload then
+bool TMRendererTextureUploadRows(TMRenderer *renderer, TMTexture texture, int level, int y, int rows,
+                                 const void *data, size_t size);
+void TMRendererTextureUploadEnd(TMTexture texture);
+// drops the upload in progress, the texture keeps its current image
+void TMRendererTextureUploadCancel(TMTexture texture);
+void TMRendererTextureSetClampToEdge(TMTexture texture);
+void TMRendererTextureSetMaxMipLevel(TMTexture texture, int maxMipLevel);
+int TMRendererTextureGetWidth(TMTexture texture);
+int TMRendererTextureGetHeight(TMTexture texture);
+void TMRendererTextureDestroy(TMRenderer *renderer, TMTexture texture);
+unsigned int TMRendererTextureGetId(TMTexture texture);
+void TMRendererTextureBind(TMTexture texture, TMShader shader, const char *varName, int textureIndex);
+void TMRendererTextureBind(TMTexture texture, TMShader shader, TMUniform uniform, int textureIndex);
+void TMRendererTextureUnbind(TMTexture texture, int textureIndex);
 
 
-TMBuffer *TMRendererBufferCreate(TMRenderer *renderer,
-                                 TMVertex *vertices, unsigned int verticesCount);
-TMBuffer *TMRendererBufferCreate(TMRenderer *renderer,
-                                 TMVertex *vertices, unsigned int verticesCount,
-                                 unsigned short *indices, unsigned int indicesCount);
-void TMRendererBufferDestroy(TMRenderer *renderer, TMBuffer *buffer);
-void TMRendererDrawBufferElements(TMBuffer *buffer);
-void TMRendererDrawBufferArray(TMBuffer *buffer);
-
-TMShader *TMRendererShaderCreate(TMRenderer *renderer, const char *vertPath, const char *fragPath);
-void TMRendererShaderDestroy(TMRenderer *renderer, TMShader *shader);
-void TMRendererBindShader(TMShader *shader);
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, float value);
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, int value);
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, TMVec3 value);
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, TMVec4 value);
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, TMMat4 value);
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, int size, int *array);
-void TMRendererShaderUpdate(TMShader *shader, const char *varName, int size, TMMat4 *array);
-
-TMTexture *TMRendererTextureCreate(TMRenderer *renderer, const char *filepath);
-void TMRendererTextureDestroy(TMRenderer *renderer, TMTexture *texture);
-void TMRendererTextureBind(TMTexture *texture, TMShader *shader, const char *varName, int textureIndex);
-void TMRendererTextureUnbind(TMTexture *texture, int textureIndex);
-
-
-TMFramebuffer *TMRendererFramebufferCreate(TMRenderer *renderer);
+// render target with an RGBA8 color texture and a 24 bit depth buffer
+TMFramebuffer *TMRendererFramebufferCreate(TMRenderer *renderer, int width, int height);
 void TMRendererFramebufferDestroy(TMRenderer *renderer, TMFramebuffer *framebuffer);
+// reallocates the attachments if the size changed, the contents are lost
+void TMRendererFramebufferResize(TMFramebuffer *framebuffer, int width, int height);
+// NULL binds the window surface, the viewport is set to the size of the target
+void TMRendererFramebufferBind(TMRenderer *renderer, TMFramebuffer *framebuffer);
+// stretches the color attachment over the whole window surface and binds it
+void TMRendererFramebufferBlit(TMRenderer *renderer, TMFramebuffer *framebuffer);
+// the color attachment, can be bound like any other texture. Owned by the framebuffer,
+// TMRendererTextureDestroy refuses it
+TMTexture TMRendererFramebufferGetTexture(TMFramebuffer *framebuffer);
+int TMRendererFramebufferGetWidth(TMFramebuffer *framebuffer);
+int TMRendererFramebufferGetHeight(TMFramebuffer *framebuffer);
 
 #endif //MY_APPLICATION_TM_SHADER_H
@@ -0,0 +1,121 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_renderer_state.h"
+
+#include <assert.h>
+#include <GLES3/gl3.h>
+
+TMRendererState *gState;
+
+void TMStateUseProgram(unsigned int program) {
+    if(gState->program == program) {
+        gState->stats.callsElided++;
+        return;
+    }
+    glUseProgram(program);
+    gState->program = program;
+    gState->stats.callsIssued++;
+}
+
+void TMStateBindVertexArray(unsigned int vertexArray) {
+    if(gState->vertexArray == vertexArray) {
+        gState->stats.callsElided++;
+        return;
+    }
+    glBindVertexArray(vertexArray);
+    gState->vertexArray = vertexArray;
+    gState->stats.callsIssued++;
+}
+
+void TMStateBindTexture(unsigned int unit, unsigned int texture) {
+    assert(unit < TM_RENDERER_MAX_TEXTURE_UNITS);
+    if(gState->textures[unit] == texture) {
+        gState->stats.callsElided++;
+        return;
+    }
+    if(gState->activeTextureUnit != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        gState->activeTextureUnit = unit;
+        gState->stats.callsIssued++;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    gState->textures[unit] = texture;
+    gState->stats.callsIssued++;
+}
+
+void TMStateEnable(unsigned int cap, bool *shadow, bool value) {
+    if(*shadow == value) {
+        gState->stats.callsElided++;
+        return;
+    }
+    if(value) glEnable(cap);
+    else glDisable(cap);
+    *shadow = value;
+    gState->stats.callsIssued++;
+}
+
+void TMStateCullFace(unsigned int mode) {
+    if(gState->cullFaceMode == mode) {
+        gState->stats.callsElided++;
+        return;
+    }
+    glCullFace(mode);
+    gState->cullFaceMode = mode;
+    gState->stats.callsIssued++;
+}
+
+void TMStateClearColor(float r, float g, float b, float a) {
+    float *color = gState->clearColor;
+    if(color[0] == r && color[1] == g && color[2] == b && color[3] == a) {
+        gState->stats.callsElided++;
+        return;
+    }
+    glClearColor(r, g, b, a);
+    color[0] = r; color[1] = g; color[2] = b; color[3] = a;
+    gState->stats.callsIssued++;
+}
+
+void TMStateForgetProgram(unsigned int program) {
+    if(gState->program == program) gState->program = 0;
+}
+
+void TMStateForgetVertexArray(unsigned int vertexArray) {
+    if(gState->vertexArray == vertexArray) gState->vertexArray = 0;
+}
+
+void TMStateForgetFramebuffer() {
+    // no framebuffer has this name, the next bind always reaches the driver
+    gState->framebuffer = ~0u;
+}
+
+void TMStateBindFramebuffer(unsigned int framebuffer) {
+    if(gState->framebuffer == framebuffer) {
+        gState->stats.callsElided++;
+        return;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    gState->framebuffer = framebuffer;
+    gState->stats.callsIssued++;
+}
+
+void TMStateViewport(int x, int y, int width, int height) {
+    if(gState->viewport[0] == x && gState->viewport[1] == y &&
+       gState->viewport[2] == width && gState->viewport[3] == height) {
+        gState->stats.callsElided++;
+        return;
+    }
+    glViewport(x, y, width, height);
+    gState->viewport[0] = x;
+    gState->viewport[1] = y;
+    gState->viewport[2] = width;
+    gState->viewport[3] = height;
+    gState->stats.callsIssued++;
+}
+
+void TMStateForgetTexture(unsigned int texture) {
+    for(int i = 0; i < TM_RENDERER_MAX_TEXTURE_UNITS; ++i) {
+        if(gState->textures[i] == texture) gState->textures[i] = 0;
+    }
+}
@@ -0,0 +1,51 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_RENDERER_STATE_H
+#define MY_APPLICATION_TM_RENDERER_STATE_H
+
+#include "tm_renderer.h"
+
+#define TM_RENDERER_MAX_TEXTURE_UNITS 16
+
+// shadow copy of the GL context state, every state change goes through it
+// so calls that would not change anything never reach the driver
+struct TMRendererState {
+    unsigned int program;
+    unsigned int vertexArray;
+    unsigned int activeTextureUnit;
+    unsigned int textures[TM_RENDERER_MAX_TEXTURE_UNITS];
+    bool depthTest;
+    bool cullFace;
+    unsigned int cullFaceMode;
+    bool blend;
+    float clearColor[4];
+    unsigned int framebuffer;
+    int viewport[4];
+    TMRendererStats stats;
+};
+
+// the state of the context current on this thread, there is only one GL context
+extern TMRendererState *gState;
+
+// every call is counted in gState->stats, issued when it reaches the driver
+// and elided when the shadow already had the value
+void TMStateUseProgram(unsigned int program);
+void TMStateBindVertexArray(unsigned int vertexArray);
+// makes unit the active texture unit only if the bind is issued
+void TMStateBindTexture(unsigned int unit, unsigned int texture);
+// cap is GL_DEPTH_TEST, GL_CULL_FACE or GL_BLEND and shadow its field in gState
+void TMStateEnable(unsigned int cap, bool *shadow, bool value);
+void TMStateCullFace(unsigned int mode);
+void TMStateClearColor(float r, float g, float b, float a);
+void TMStateBindFramebuffer(unsigned int framebuffer);
+void TMStateViewport(int x, int y, int width, int height);
+// GL unbinds deleted objects from the current context, keep the shadow in sync
+void TMStateForgetProgram(unsigned int program);
+void TMStateForgetVertexArray(unsigned int vertexArray);
+void TMStateForgetTexture(unsigned int texture);
+// after binding GL_READ_FRAMEBUFFER / GL_DRAW_FRAMEBUFFER directly the shadow no longer knows the binding
+void TMStateForgetFramebuffer();
+
+#endif //MY_APPLICATION_TM_RENDERER_STATE_H
@@ -0,0 +1,84 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_run_loop.h"
+
+#define TM_RUN_LOOP_HOOK(loop, name) \
+    do { if((loop)->hooks.name) (loop)->hooks.name((loop)->hooks.userData); } while(0)
+
+void TMRunLoopInitialize(TMRunLoop *loop, TMRunLoopLooper looper, TMRunLoopHooks hooks, int idleTimeoutMs) {
+    loop->looper = looper;
+    loop->hooks = hooks;
+    loop->idleTimeoutMs = idleTimeoutMs;
+    loop->hasWindow = false;
+    loop->resumed = false;
+    loop->destroyed = false;
+}
+
+void TMRunLoopOnWindowCreated(TMRunLoop *loop) {
+    if(loop->hasWindow) return;
+    loop->hasWindow = true;
+    TM_RUN_LOOP_HOOK(loop, windowCreated);
+}
+
+void TMRunLoopOnWindowDestroyed(TMRunLoop *loop) {
+    if(!loop->hasWindow) return;
+    loop->hasWindow = false;
+    TM_RUN_LOOP_HOOK(loop, windowDestroyed);
+}
+
+void TMRunLoopOnResume(TMRunLoop *loop) {
+    if(loop->resumed) return;
+    loop->resumed = true;
+    TM_RUN_LOOP_HOOK(loop, resumed);
+}
+
+void TMRunLoopOnPause(TMRunLoop *loop) {
+    if(!loop->resumed) return;
+    loop->resumed = false;
+    TM_RUN_LOOP_HOOK(loop, paused);
+}
+
+void TMRunLoopOnDestroy(TMRunLoop *loop) {
+    if(loop->destroyed) return;
+    // manuel: the platform may skip the intermediate steps, keep the hooks balanced
+    TMRunLoopOnPause(loop);
+    TMRunLoopOnWindowDestroyed(loop);
+    loop->destroyed = true;
+    TM_RUN_LOOP_HOOK(loop, destroyed);
+}
+
+bool TMRunLoopIsActive(TMRunLoop *loop) {
+    return loop->hasWindow && loop->resumed && !loop->destroyed;
+}
+
+int TMRunLoopGetTimeout(TMRunLoop *loop) {
+    return TMRunLoopIsActive(loop) ? 0 : loop->idleTimeoutMs;
+}
+
+int TMRunLoopPumpEvents(TMRunLoop *loop) {
+    int eventsCount = 0;
+    int timeout = TMRunLoopGetTimeout(loop);
+    while(!loop->destroyed && eventsCount < TM_RUN_LOOP_MAX_EVENTS_PER_PUMP &&
+          loop->looper.poll(loop->looper.userData, timeout)) {
+        eventsCount++;
+        // only the first wait blocks, after that just take what is already queued
+        timeout = 0;
+    }
+    return eventsCount;
+}
+
+bool TMRunLoopStep(TMRunLoop *loop) {
+    TMRunLoopPumpEvents(loop);
+    if(loop->destroyed) return false;
+    if(TMRunLoopIsActive(loop)) {
+        TM_RUN_LOOP_HOOK(loop, frame);
+    }
+    return !loop->destroyed;
+}
+
+void TMRunLoopRun(TMRunLoop *loop) {
+    while(TMRunLoopStep(loop)) {
+    }
+}
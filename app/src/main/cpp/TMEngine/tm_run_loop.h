@@ -0,0 +1,68 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_RUN_LOOP_H
+#define MY_APPLICATION_TM_RUN_LOOP_H
+
+// Engine main loop. Decides when to block and when to run frames, and tracks the
+// app lifecycle. It knows nothing about the platform: events come from a looper
+// and the platform layer reports lifecycle changes with the TMRunLoopOn* calls,
+// usually from inside the looper's poll.
+//
+// Every iteration drains all pending events. While there is a window and the app
+// is resumed it runs a frame. Otherwise it blocks in the looper for up to
+// idleTimeoutMs, so a backgrounded app does not burn a core.
+
+// long enough to not wake up a backgrounded app for nothing, short enough
+// to notice a destroy request without an event
+#define TM_RUN_LOOP_DEFAULT_IDLE_TIMEOUT_MS 500
+// events handled in one pump before running a frame anyway, a flood of
+// input events must not starve rendering
+#define TM_RUN_LOOP_MAX_EVENTS_PER_PUMP 256
+
+struct TMRunLoopLooper {
+    void *userData;
+    // wait up to timeoutMs (0 does not block, -1 waits forever) for one event and
+    // dispatch it. Returns true if something was dispatched
+    bool (*poll)(void *userData, int timeoutMs);
+};
+
+struct TMRunLoopHooks {
+    void *userData;
+    // any of them can be NULL
+    void (*windowCreated)(void *userData);
+    void (*windowDestroyed)(void *userData);
+    void (*resumed)(void *userData);
+    void (*paused)(void *userData);
+    void (*destroyed)(void *userData);
+    // one update and render, only called while active
+    void (*frame)(void *userData);
+};
+
+struct TMRunLoop {
+    TMRunLoopLooper looper;
+    TMRunLoopHooks hooks;
+    int idleTimeoutMs;
+    bool hasWindow;
+    bool resumed;
+    bool destroyed;
+};
+
+void TMRunLoopInitialize(TMRunLoop *loop, TMRunLoopLooper looper, TMRunLoopHooks hooks, int idleTimeoutMs);
+void TMRunLoopOnWindowCreated(TMRunLoop *loop);
+void TMRunLoopOnWindowDestroyed(TMRunLoop *loop);
+void TMRunLoopOnResume(TMRunLoop *loop);
+void TMRunLoopOnPause(TMRunLoop *loop);
+void TMRunLoopOnDestroy(TMRunLoop *loop);
+// frames run only while there is a window and the app is resumed
+bool TMRunLoopIsActive(TMRunLoop *loop);
+// how long the next poll may block: 0 when active, idleTimeoutMs otherwise
+int TMRunLoopGetTimeout(TMRunLoop *loop);
+// drains every pending event, blocking for the first one if idle. Returns the events dispatched
+int TMRunLoopPumpEvents(TMRunLoop *loop);
+// one iteration: pump the events, then run a frame if active. Returns false once destroyed
+bool TMRunLoopStep(TMRunLoop *loop);
+void TMRunLoopRun(TMRunLoop *loop);
+
+#endif //MY_APPLICATION_TM_RUN_LOOP_H
@@ -0,0 +1,187 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_sprite_batch.h"
+#include "tm_renderer.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+
+// indices are unsigned short so one draw can address at most 65536 vertices
+#define TM_SPRITE_BATCH_MAX_SPRITES (65536 / 4)
+#define TM_SPRITE_BATCH_INITIAL_CAPACITY 256
+
+struct TMSprite {
+    const TMShaderUniforms *shader;
+    TMTexture texture;
+    unsigned int layer;
+    unsigned int order;
+    TMVec2 position;
+    TMVec2 size;
+    float rotation;
+    TMVec4 uvRect;
+};
+
+struct TMSpriteBatch {
+    TMBuffer buffer;
+    TMVertex *vertices;
+    unsigned short *indices;
+    unsigned int maxSprites;
+
+    TMSprite *sprites;
+    unsigned int spritesCount;
+    unsigned int spritesCapacity;
+
+    const TMShaderUniforms *shader;
+    TMMat4 proj;
+    unsigned int drawCalls;
+};
+
+TMSpriteBatch *TMSpriteBatchCreate(TMRenderer *renderer, unsigned int maxSprites) {
+    TMSpriteBatch *batch = (TMSpriteBatch *)malloc(sizeof(TMSpriteBatch));
+    memset(batch, 0, sizeof(TMSpriteBatch));
+
+    if(maxSprites > TM_SPRITE_BATCH_MAX_SPRITES) maxSprites = TM_SPRITE_BATCH_MAX_SPRITES;
+    batch->maxSprites = maxSprites;
+
+    batch->vertices = (TMVertex *)malloc(sizeof(TMVertex) * maxSprites * 4);
+    batch->indices = (unsigned short *)malloc(sizeof(unsigned short) * maxSprites * 6);
+    for(unsigned int i = 0; i < maxSprites; ++i) {
+        unsigned short *index = batch->indices + i * 6;
+        unsigned short vertex = (unsigned short)(i * 4);
+        index[0] = vertex + 0;
+        index[1] = vertex + 1;
+        index[2] = vertex + 2;
+        index[3] = vertex + 0;
+        index[4] = vertex + 2;
+        index[5] = vertex + 3;
+    }
+    batch->buffer = TMRendererBufferCreateDynamic(renderer, maxSprites * 4,
+                                                  batch->indices, maxSprites * 6);
+
+    batch->spritesCapacity = TM_SPRITE_BATCH_INITIAL_CAPACITY;
+    batch->sprites = (TMSprite *)malloc(sizeof(TMSprite) * batch->spritesCapacity);
+
+    return batch;
+}
+
+void TMSpriteBatchDestroy(TMRenderer *renderer, TMSpriteBatch *batch) {
+    TMRendererBufferDestroy(renderer, batch->buffer);
+    free(batch->sprites);
+    free(batch->indices);
+    free(batch->vertices);
+    free(batch);
+}
+
+void TMSpriteBatchBegin(TMSpriteBatch *batch, const TMShaderUniforms *shader, TMMat4 proj) {
+    batch->shader = shader;
+    batch->proj = proj;
+    batch->spritesCount = 0;
+    batch->drawCalls = 0;
+}
+
+void TMSpriteBatchPush(TMSpriteBatch *batch, TMTexture texture,
+                       TMVec2 position, TMVec2 size, float rotation, TMVec4 uvRect) {
+    TMSpriteBatchPush(batch, batch->shader, texture, 0, position, size, rotation, uvRect);
+}
+
+void TMSpriteBatchPush(TMSpriteBatch *batch, const TMShaderUniforms *shader, TMTexture texture, unsigned int layer,
+                       TMVec2 position, TMVec2 size, float rotation, TMVec4 uvRect) {
+    if(batch->spritesCount == batch->spritesCapacity) {
+        batch->spritesCapacity *= 2;
+        batch->sprites = (TMSprite *)realloc(batch->sprites, sizeof(TMSprite) * batch->spritesCapacity);
+    }
+    TMSprite *sprite = batch->sprites + batch->spritesCount;
+    sprite->shader = shader;
+    sprite->texture = texture;
+    sprite->layer = layer;
+    sprite->order = batch->spritesCount++;
+    sprite->position = position;
+    sprite->size = size;
+    sprite->rotation = rotation;
+    sprite->uvRect = uvRect;
+}
+
+static bool SpriteLess(const TMSprite &a, const TMSprite &b) {
+    if(a.layer != b.layer) return a.layer < b.layer;
+    if(a.shader->shader.handle != b.shader->shader.handle) return a.shader->shader.handle < b.shader->shader.handle;
+    if(a.texture.handle != b.texture.handle) return a.texture.handle < b.texture.handle;
+    return a.order < b.order;
+}
+
+static void WriteQuad(TMVertex *vertices, TMSprite *sprite) {
+    // same corners and uvs as the unit quad in models.h, rotated like TMMat4RotateZ
+    static const float corners[4][2] = {
+            { 0.5f,  0.5f},
+            {-0.5f,  0.5f},
+            {-0.5f, -0.5f},
+            { 0.5f, -0.5f}
+    };
+    TMVec4 uv = sprite->uvRect;
+    float u[4] = {uv.x, uv.z, uv.z, uv.x};
+    float v[4] = {uv.y, uv.y, uv.w, uv.w};
+
+    float c = cosf(sprite->rotation);
+    float s = sinf(sprite->rotation);
+    for(int i = 0; i < 4; ++i) {
+        float x = corners[i][0] * sprite->size.x;
+        float y = corners[i][1] * sprite->size.y;
+        vertices[i].position.x = sprite->position.x + c * x + s * y;
+        vertices[i].position.y = sprite->position.y - s * x + c * y;
+        vertices[i].position.z = 0.0f;
+        vertices[i].uv.x = u[i];
+        vertices[i].uv.y = v[i];
+    }
+}
+
+static void DrawRun(TMSpriteBatch *batch, TMSprite *first, unsigned int start, unsigned int count,
+                    TMShader *currentShader) {
+    const TMShaderUniforms *shader = first->shader;
+    if(currentShader->handle != shader->shader.handle) {
+        *currentShader = shader->shader;
+        TMRendererBindShader(shader->shader);
+        TMRendererShaderUpdate(shader->shader, shader->proj, batch->proj);
+        TMRendererShaderUpdate(shader->shader, shader->world, TMMat4Identity());
+    }
+    TMRendererTextureBind(first->texture, shader->shader, shader->texture, 0);
+    TMRendererDrawBufferElements(batch->buffer, count * 6, start * 6);
+    batch->drawCalls++;
+}
+
+void TMSpriteBatchEnd(TMSpriteBatch *batch) {
+    std::sort(batch->sprites, batch->sprites + batch->spritesCount, SpriteLess);
+
+    TMShader currentShader = {};
+
+    // the vertex buffer holds maxSprites, bigger batches are uploaded in chunks
+    for(unsigned int first = 0; first < batch->spritesCount; first += batch->maxSprites) {
+        TMSprite *sprites = batch->sprites + first;
+        unsigned int count = batch->spritesCount - first;
+        if(count > batch->maxSprites) count = batch->maxSprites;
+
+        for(unsigned int i = 0; i < count; ++i) {
+            WriteQuad(batch->vertices + i * 4, sprites + i);
+        }
+        TMRendererBufferUpdate(batch->buffer, batch->vertices, count * 4);
+
+        unsigned int runStart = 0;
+        for(unsigned int i = 1; i <= count; ++i) {
+            if(i == count ||
+               sprites[i].shader->shader.handle != sprites[runStart].shader->shader.handle ||
+               sprites[i].texture.handle != sprites[runStart].texture.handle) {
+                DrawRun(batch, sprites + runStart, runStart, i - runStart, &currentShader);
+                runStart = i;
+            }
+        }
+    }
+
+    batch->spritesCount = 0;
+}
+
+unsigned int TMSpriteBatchGetDrawCalls(TMSpriteBatch *batch) {
+    return batch->drawCalls;
+}
@@ -0,0 +1,31 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_SPRITE_BATCH_H
+#define MY_APPLICATION_TM_SPRITE_BATCH_H
+
+#include "utils/tm_math.h"
+
+struct TMRenderer;
+struct TMShaderUniforms;
+struct TMTexture;
+struct TMSpriteBatch;
+
+// Sprites pushed between Begin and End are sorted by layer, shader and texture
+// and drawn with one draw call per run of sprites that share the same state.
+// Layers are drawn in increasing order, inside a layer the order is not guaranteed.
+// The uvRect is {u0, v0, u1, v1}. The batch sets proj, world and texture of the
+// shaders it is given, they must stay alive until End.
+
+TMSpriteBatch *TMSpriteBatchCreate(TMRenderer *renderer, unsigned int maxSprites);
+void TMSpriteBatchDestroy(TMRenderer *renderer, TMSpriteBatch *batch);
+void TMSpriteBatchBegin(TMSpriteBatch *batch, const TMShaderUniforms *shader, TMMat4 proj);
+void TMSpriteBatchPush(TMSpriteBatch *batch, TMTexture texture,
+                       TMVec2 position, TMVec2 size, float rotation, TMVec4 uvRect);
+void TMSpriteBatchPush(TMSpriteBatch *batch, const TMShaderUniforms *shader, TMTexture texture, unsigned int layer,
+                       TMVec2 position, TMVec2 size, float rotation, TMVec4 uvRect);
+void TMSpriteBatchEnd(TMSpriteBatch *batch);
+unsigned int TMSpriteBatchGetDrawCalls(TMSpriteBatch *batch);
+
+#endif //MY_APPLICATION_TM_SPRITE_BATCH_H
@@ -0,0 +1,195 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_texture_atlas.h"
+#include "tm_renderer.h"
+#include "utils/tm_rect_packer.h"
+#include "utils/tm_arena.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include <algorithm>
+
+#define TM_TEXTURE_ATLAS_MAX_PAGES 8
+#define TM_TEXTURE_ATLAS_MAX_REGIONS 256
+// rects start on a multiple of this so the first mip levels keep them on their own texels
+#define TM_TEXTURE_ATLAS_ALIGNMENT 4
+
+struct TMAtlasEntry {
+    TMImage image;
+    int page;
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+struct TMAtlasPage {
+    TMRectPacker *packer;
+    TMTexture texture;
+    int width;
+    int height;
+};
+
+struct TMTextureAtlas {
+    TMRenderer *renderer;
+    int pageWidth;
+    int pageHeight;
+    int padding;
+
+    TMAtlasEntry entries[TM_TEXTURE_ATLAS_MAX_REGIONS];
+    unsigned int entriesCount;
+    TMAtlasPage pages[TM_TEXTURE_ATLAS_MAX_PAGES];
+    unsigned int pagesCount;
+};
+
+TMTextureAtlas *TMTextureAtlasCreate(TMRenderer *renderer, int pageWidth, int pageHeight, int padding) {
+    TMTextureAtlas *atlas = (TMTextureAtlas *)malloc(sizeof(TMTextureAtlas));
+    memset(atlas, 0, sizeof(TMTextureAtlas));
+    atlas->renderer = renderer;
+    atlas->pageWidth = pageWidth;
+    atlas->pageHeight = pageHeight;
+    atlas->padding = padding;
+    return atlas;
+}
+
+void TMTextureAtlasDestroy(TMRenderer *renderer, TMTextureAtlas *atlas) {
+    for(unsigned int i = 0; i < atlas->entriesCount; ++i) {
+        TMImageFree(&atlas->entries[i].image);
+    }
+    for(unsigned int i = 0; i < atlas->pagesCount; ++i) {
+        if(atlas->pages[i].texture.handle) TMRendererTextureDestroy(renderer, atlas->pages[i].texture);
+        TMRectPackerDestroy(atlas->pages[i].packer);
+    }
+    free(atlas);
+}
+
+int TMTextureAtlasAdd(TMTextureAtlas *atlas, const char *filepath) {
+    TMImage image = TMImageLoad(TMRendererGetAssetManager(atlas->renderer), filepath);
+    assert(image.pixels);
+    return TMTextureAtlasAdd(atlas, image);
+}
+
+int TMTextureAtlasAdd(TMTextureAtlas *atlas, TMImage image) {
+    assert(atlas->entriesCount < TM_TEXTURE_ATLAS_MAX_REGIONS);
+    TMAtlasEntry *entry = atlas->entries + atlas->entriesCount;
+    entry->image = image;
+    entry->page = -1;
+    entry->width = image.width;
+    entry->height = image.height;
+    return (int)atlas->entriesCount++;
+}
+
+static int AlignUp(int value, int alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static TMAtlasPage *AddPage(TMTextureAtlas *atlas, int width, int height) {
+    assert(atlas->pagesCount < TM_TEXTURE_ATLAS_MAX_PAGES);
+    TMAtlasPage *page = atlas->pages + atlas->pagesCount++;
+    page->packer = TMRectPackerCreate(width, height);
+    page->texture = TMTexture{};
+    page->width = width;
+    page->height = height;
+    return page;
+}
+
+// copies the image and extrudes its border pixels into the padding around it
+static void BlitWithGutter(unsigned char *dst, int dstWidth, int dstHeight,
+                           TMImage *image, int x, int y, int padding) {
+    for(int row = -padding; row < image->height + padding; ++row) {
+        int dstY = y + row;
+        if(dstY < 0 || dstY >= dstHeight) continue;
+        int srcY = std::min(std::max(row, 0), image->height - 1);
+        unsigned int *srcRow = (unsigned int *)(image->pixels + srcY * image->width * 4);
+        unsigned int *dstRow = (unsigned int *)(dst + dstY * dstWidth * 4);
+        for(int col = -padding; col < image->width + padding; ++col) {
+            int dstX = x + col;
+            if(dstX < 0 || dstX >= dstWidth) continue;
+            int srcX = std::min(std::max(col, 0), image->width - 1);
+            dstRow[dstX] = srcRow[srcX];
+        }
+    }
+}
+
+void TMTextureAtlasBuild(TMTextureAtlas *atlas) {
+    // pack the tallest images first, skyline packing works best that way
+    unsigned int order[TM_TEXTURE_ATLAS_MAX_REGIONS];
+    unsigned int orderCount = 0;
+    for(unsigned int i = 0; i < atlas->entriesCount; ++i) {
+        if(atlas->entries[i].page < 0) order[orderCount++] = i;
+    }
+    std::sort(order, order + orderCount, [atlas](unsigned int a, unsigned int b) {
+        return atlas->entries[a].image.height > atlas->entries[b].image.height;
+    });
+
+    unsigned int firstNewPage = atlas->pagesCount;
+    for(unsigned int i = 0; i < orderCount; ++i) {
+        TMAtlasEntry *entry = atlas->entries + order[i];
+        int width = AlignUp(entry->image.width + atlas->padding * 2, TM_TEXTURE_ATLAS_ALIGNMENT);
+        int height = AlignUp(entry->image.height + atlas->padding * 2, TM_TEXTURE_ATLAS_ALIGNMENT);
+
+        int x, y;
+        for(unsigned int page = firstNewPage; page < atlas->pagesCount; ++page) {
+            if(TMRectPackerPack(atlas->pages[page].packer, width, height, &x, &y)) {
+                entry->page = (int)page;
+                break;
+            }
+        }
+        if(entry->page < 0) {
+            // images bigger than a page get a page of their own
+            TMAtlasPage *page = AddPage(atlas, std::max(width, atlas->pageWidth),
+                                        std::max(height, atlas->pageHeight));
+            bool packed = TMRectPackerPack(page->packer, width, height, &x, &y);
+            assert(packed);
+            entry->page = (int)atlas->pagesCount - 1;
+        }
+        entry->x = x + atlas->padding;
+        entry->y = y + atlas->padding;
+    }
+
+    for(unsigned int pageIndex = firstNewPage; pageIndex < atlas->pagesCount; ++pageIndex) {
+        TMAtlasPage *page = atlas->pages + pageIndex;
+        size_t size = (size_t)page->width * page->height * 4;
+        TMArenaSavepoint scratch = TMArenaSave(TMArenaGetScratch());
+        unsigned char *pixels = (unsigned char *)TMArenaAlloc(scratch.arena, size);
+        memset(pixels, 0, size);
+        for(unsigned int i = 0; i < orderCount; ++i) {
+            TMAtlasEntry *entry = atlas->entries + order[i];
+            if(entry->page != (int)pageIndex) continue;
+            BlitWithGutter(pixels, page->width, page->height,
+                           &entry->image, entry->x, entry->y, atlas->padding);
+        }
+        page->texture = TMRendererTextureCreate(atlas->renderer, pixels, page->width, page->height);
+        TMRendererTextureSetClampToEdge(page->texture);
+        // mip levels past the gutter size would mix neighbour images
+        int maxMipLevel = 0;
+        while((2 << maxMipLevel) <= atlas->padding) ++maxMipLevel;
+        TMRendererTextureSetMaxMipLevel(page->texture, maxMipLevel);
+        TMArenaRollback(scratch);
+    }
+
+    for(unsigned int i = 0; i < orderCount; ++i) {
+        TMImageFree(&atlas->entries[order[i]].image);
+    }
+}
+
+TMAtlasRegion TMTextureAtlasGetRegion(TMTextureAtlas *atlas, int region) {
+    assert(region >= 0 && region < (int)atlas->entriesCount);
+    TMAtlasEntry *entry = atlas->entries + region;
+    assert(entry->page >= 0);
+    TMAtlasPage *page = atlas->pages + entry->page;
+    TMAtlasRegion result;
+    result.texture = page->texture;
+    result.uvRect.x = (float)entry->x / (float)page->width;
+    result.uvRect.y = (float)entry->y / (float)page->height;
+    result.uvRect.z = (float)(entry->x + entry->width) / (float)page->width;
+    result.uvRect.w = (float)(entry->y + entry->height) / (float)page->height;
+    return result;
+}
+
+unsigned int TMTextureAtlasGetPagesCount(TMTextureAtlas *atlas) {
+    return atlas->pagesCount;
+}
@@ -0,0 +1,32 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_TEXTURE_ATLAS_H
+#define MY_APPLICATION_TM_TEXTURE_ATLAS_H
+
+#include "utils/tm_math.h"
+#include "utils/tm_image.h"
+#include "tm_renderer.h"
+
+struct TMTextureAtlas;
+
+// sub rect of an atlas page, uvRect is {u0, v0, u1, v1} like the sprite batch
+struct TMAtlasRegion {
+    TMTexture texture;
+    TMVec4 uvRect;
+};
+
+// Images are added first and packed into as few pages as possible by
+// TMTextureAtlasBuild. Every image gets padding pixels of its own edge
+// around it so filtering and the first mip levels do not bleed.
+TMTextureAtlas *TMTextureAtlasCreate(TMRenderer *renderer, int pageWidth, int pageHeight, int padding);
+void TMTextureAtlasDestroy(TMRenderer *renderer, TMTextureAtlas *atlas);
+int TMTextureAtlasAdd(TMTextureAtlas *atlas, const char *filepath);
+// the atlas takes ownership of the image pixels
+int TMTextureAtlasAdd(TMTextureAtlas *atlas, TMImage image);
+void TMTextureAtlasBuild(TMTextureAtlas *atlas);
+TMAtlasRegion TMTextureAtlasGetRegion(TMTextureAtlas *atlas, int region);
+unsigned int TMTextureAtlasGetPagesCount(TMTextureAtlas *atlas);
+
+#endif //MY_APPLICATION_TM_TEXTURE_ATLAS_H
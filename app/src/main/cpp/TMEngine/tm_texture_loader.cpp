@@ -0,0 +1,312 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_texture_loader.h"
+#include "tm_renderer.h"
+#include "tm_job_system.h"
+#include "utils/tm_file.h"
+#include "utils/tm_image.h"
+#include "utils/tm_ktx2.h"
+
+#include <android/log.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <mutex>
+
+#define TM_LOG_INFO(...) ((void)__android_log_print(ANDROID_LOG_INFO, "App2", __VA_ARGS__))
+#define TM_TEXTURE_LOADER_MAX_REQUESTS 64
+#define TM_TEXTURE_LOADER_MAX_PATH 256
+
+struct TMTextureRequest {
+    bool used;
+    char path[TM_TEXTURE_LOADER_MAX_PATH];
+    TMTexture texture;
+
+    // written by the worker
+    bool failed;
+    bool compressed;
+    TMImage image;
+    TMFile file;
+    TMKtx2 ktx2;
+
+    // upload progress, in rows of texels or rows of blocks
+    unsigned int level;
+    unsigned int row;
+};
+
+// fifo of request indices
+struct TMTextureRequestRing {
+    unsigned int indices[TM_TEXTURE_LOADER_MAX_REQUESTS];
+    unsigned int head;
+    unsigned int count;
+};
+
+struct TMTextureLoader;
+
+// one decode job per request
+struct TMTextureDecodeJob {
+    TMTextureLoader *loader;
+    TMTextureRequest *request;
+};
+
+struct TMTextureLoader {
+    TMRenderer *renderer;
+    AAssetManager *assetManager;
+
+    TMJobSystem *jobSystem;
+    TMJobCounter decoding;
+    std::mutex mutex;
+
+    // the slots and the ring are only touched under the mutex,
+    // a request being decoded or uploaded is owned by that thread
+    TMTextureRequest requests[TM_TEXTURE_LOADER_MAX_REQUESTS];
+    TMTextureDecodeJob jobs[TM_TEXTURE_LOADER_MAX_REQUESTS];
+    TMTextureRequestRing decoded;
+    TMTextureRequest *uploading;
+    unsigned int pendingCount;
+};
+
+static void RingPush(TMTextureRequestRing *ring, unsigned int index) {
+    assert(ring->count < TM_TEXTURE_LOADER_MAX_REQUESTS);
+    ring->indices[(ring->head + ring->count) % TM_TEXTURE_LOADER_MAX_REQUESTS] = index;
+    ring->count++;
+}
+
+static unsigned int RingPop(TMTextureRequestRing *ring) {
+    assert(ring->count > 0);
+    unsigned int index = ring->indices[ring->head];
+    ring->head = (ring->head + 1) % TM_TEXTURE_LOADER_MAX_REQUESTS;
+    ring->count--;
+    return index;
+}
+
+static bool EndsWith(const char *str, const char *suffix) {
+    size_t strLen = strlen(str);
+    size_t suffixLen = strlen(suffix);
+    return strLen >= suffixLen && strcmp(str + strLen - suffixLen, suffix) == 0;
+}
+
+static void RequestDecode(TMTextureLoader *loader, TMTextureRequest *request) {
+    const char *path = request->path;
+    char pngPath[TM_TEXTURE_LOADER_MAX_PATH];
+    if(EndsWith(request->path, ".ktx2")) {
+        request->compressed = true;
+        request->file = TMFileOpen(loader->assetManager, request->path);
+        unsigned int blockBytes, blockWidth, blockHeight;
+        request->failed = !request->file.data ||
+                          !TMKtx2Parse(request->file.data, request->file.size, &request->ktx2) ||
+                          !TMKtx2FormatBlock(request->ktx2.vkFormat, &blockBytes, &blockWidth, &blockHeight) ||
+                          !TMRendererTextureFormatSupported(loader->renderer, request->ktx2.vkFormat);
+        if(!request->failed || !TMRendererTexturePngPath(request->path, pngPath, sizeof(pngPath))) return;
+        // manuel: the png next to it always works, decode that one instead
+        TM_LOG_INFO("Error Loading compressed texture: %s, trying the png", request->path);
+        TMFileClose(&request->file);
+        path = pngPath;
+    }
+    request->compressed = false;
+    request->image = TMImageLoad(loader->assetManager, path);
+    request->failed = request->image.pixels == NULL;
+}
+
+static void RequestRelease(TMTextureRequest *request) {
+    if(request->compressed) {
+        TMFileClose(&request->file);
+    } else {
+        TMImageFree(&request->image);
+    }
+    request->used = false;
+}
+
+static void DecodeJob(void *data) {
+    TMTextureDecodeJob *job = (TMTextureDecodeJob *)data;
+    TMTextureLoader *loader = job->loader;
+    RequestDecode(loader, job->request);
+    std::lock_guard<std::mutex> lock(loader->mutex);
+    RingPush(&loader->decoded, (unsigned int)(job->request - loader->requests));
+}
+
+TMTextureLoader *TMTextureLoaderCreate(TMRenderer *renderer, TMJobSystem *jobSystem) {
+    TMTextureLoader *loader = new TMTextureLoader();
+    loader->renderer = renderer;
+    loader->assetManager = TMRendererGetAssetManager(renderer);
+    loader->jobSystem = jobSystem;
+    loader->decoding.pending.store(0);
+    memset(loader->requests, 0, sizeof(loader->requests));
+    memset(&loader->decoded, 0, sizeof(loader->decoded));
+    loader->uploading = NULL;
+    loader->pendingCount = 0;
+    return loader;
+}
+
+void TMTextureLoaderDestroy(TMTextureLoader *loader) {
+    // manuel: the decode jobs point into the loader
+    TMJobSystemWait(loader->jobSystem, &loader->decoding);
+    for(int i = 0; i < TM_TEXTURE_LOADER_MAX_REQUESTS; ++i) {
+        if(loader->requests[i].used) RequestRelease(loader->requests + i);
+    }
+    delete loader;
+}
+
+TMTexture TMTextureLoaderLoad(TMTextureLoader *loader, const char *filepath) {
+    if(strlen(filepath) >= TM_TEXTURE_LOADER_MAX_PATH) {
+        return TMRendererTextureCreate(loader->renderer, filepath);
+    }
+
+    TMTextureRequest *request = NULL;
+    {
+        std::lock_guard<std::mutex> lock(loader->mutex);
+        for(int i = 0; i < TM_TEXTURE_LOADER_MAX_REQUESTS; ++i) {
+            if(!loader->requests[i].used) {
+                request = loader->requests + i;
+                memset(request, 0, sizeof(TMTextureRequest));
+                request->used = true;
+                break;
+            }
+        }
+    }
+    if(!request) {
+        // manuel: too many loads in flight, just load it now
+        return TMRendererTextureCreate(loader->renderer, filepath);
+    }
+
+    const unsigned char white[4] = {255, 255, 255, 255};
+    TMTexture texture = TMRendererTextureCreate(loader->renderer, white, 1, 1);
+    snprintf(request->path, sizeof(request->path), "%s", filepath);
+    request->texture = texture;
+    {
+        std::lock_guard<std::mutex> lock(loader->mutex);
+        loader->pendingCount++;
+    }
+    TMTextureDecodeJob *job = loader->jobs + (request - loader->requests);
+    job->loader = loader;
+    job->request = request;
+    TMJobSystemRunBackground(loader->jobSystem, DecodeJob, job, &loader->decoding);
+    return texture;
+}
+
+// uploads whole rows until the budget is spent, at least one row per call.
+// Returns the number of bytes uploaded and sets done when the last row is in,
+// failed is set when the rows did not reach the texture
+static size_t RequestUploadSlice(TMTextureLoader *loader, TMTextureRequest *request, size_t budget,
+                                 bool *done, bool *failed) {
+    const unsigned char *data;
+    unsigned int width, height, rowsCount, rowBytes, rowHeight;
+    if(request->compressed) {
+        unsigned int blockBytes, blockWidth, blockHeight;
+        TMKtx2FormatBlock(request->ktx2.vkFormat, &blockBytes, &blockWidth, &blockHeight);
+        TMKtx2Level *level = request->ktx2.levels + request->level;
+        data = level->data;
+        width = level->width;
+        height = level->height;
+        rowsCount = (height + blockHeight - 1) / blockHeight;
+        rowBytes = (width + blockWidth - 1) / blockWidth * blockBytes;
+        rowHeight = blockHeight;
+    } else {
+        data = request->image.pixels;
+        width = request->image.width;
+        height = request->image.height;
+        rowsCount = height;
+        rowBytes = width * 4;
+        rowHeight = 1;
+    }
+
+    unsigned int rows = (unsigned int)(budget / rowBytes);
+    if(rows < 1) rows = 1;
+    if(rows > rowsCount - request->row) rows = rowsCount - request->row;
+
+    unsigned int y = request->row * rowHeight;
+    unsigned int texelRows = rows * rowHeight;
+    if(y + texelRows > height) texelRows = height - y;
+    size_t size = (size_t)rows * rowBytes;
+    *done = false;
+    *failed = !TMRendererTextureUploadRows(loader->renderer, request->texture, request->level, y, texelRows,
+                                           data + (size_t)request->row * rowBytes, size);
+    if(*failed) return size;
+
+    request->row += rows;
+    if(request->row == rowsCount) {
+        request->row = 0;
+        request->level++;
+        *done = !request->compressed || request->level == request->ktx2.levelCount;
+    }
+    return size;
+}
+
+void TMTextureLoaderUpdate(TMTextureLoader *loader, size_t budgetBytes) {
+    size_t uploaded = 0;
+    while(uploaded < budgetBytes) {
+        TMTextureRequest *request = loader->uploading;
+        if(!request) {
+            {
+                std::lock_guard<std::mutex> lock(loader->mutex);
+                if(loader->decoded.count == 0) break;
+                request = loader->requests + RingPop(&loader->decoded);
+            }
+            if(request->failed) {
+                TM_LOG_INFO("Error Loading texture: %s", request->path);
+                std::lock_guard<std::mutex> lock(loader->mutex);
+                RequestRelease(request);
+                loader->pendingCount--;
+                continue;
+            }
+        }
+
+        // manuel: the texture can be destroyed while it loads, drop what is left of it
+        if(!TMRendererTextureIsValid(loader->renderer, request->texture)) {
+            loader->uploading = NULL;
+            std::lock_guard<std::mutex> lock(loader->mutex);
+            RequestRelease(request);
+            loader->pendingCount--;
+            continue;
+        }
+
+        if(!loader->uploading) {
+            bool began;
+            if(request->compressed) {
+                began = TMRendererTextureUploadBegin(request->texture, request->ktx2.vkFormat,
+                                                     request->ktx2.width, request->ktx2.height,
+                                                     request->ktx2.levelCount);
+            } else {
+                began = TMRendererTextureUploadBegin(request->texture, 0,
+                                                     request->image.width, request->image.height, 1);
+            }
+            if(!began) {
+                TM_LOG_INFO("Error Uploading texture: %s", request->path);
+                std::lock_guard<std::mutex> lock(loader->mutex);
+                RequestRelease(request);
+                loader->pendingCount--;
+                continue;
+            }
+            loader->uploading = request;
+        }
+
+        bool done = false;
+        bool failed = false;
+        uploaded += RequestUploadSlice(loader, request, budgetBytes - uploaded, &done, &failed);
+        if(failed) {
+            // manuel: the texture keeps its placeholder instead of rows that never arrived
+            TM_LOG_INFO("Error Uploading texture: %s", request->path);
+            TMRendererTextureUploadCancel(request->texture);
+            loader->uploading = NULL;
+            std::lock_guard<std::mutex> lock(loader->mutex);
+            RequestRelease(request);
+            loader->pendingCount--;
+            continue;
+        }
+        if(done) {
+            TMRendererTextureUploadEnd(request->texture);
+            loader->uploading = NULL;
+            std::lock_guard<std::mutex> lock(loader->mutex);
+            RequestRelease(request);
+            loader->pendingCount--;
+        }
+    }
+}
+
+unsigned int TMTextureLoaderGetPendingCount(TMTextureLoader *loader) {
+    std::lock_guard<std::mutex> lock(loader->mutex);
+    return loader->pendingCount;
+}
@@ -0,0 +1,31 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_TEXTURE_LOADER_H
+#define MY_APPLICATION_TM_TEXTURE_LOADER_H
+
+#include <stddef.h>
+
+struct TMRenderer;
+struct TMTexture;
+struct TMTextureLoader;
+struct TMJobSystem;
+
+// Loads textures without blocking the GL thread. TMTextureLoaderLoad returns a
+// texture that samples a 1x1 white placeholder right away, a job reads and
+// decodes the file (PNG or KTX2) and TMTextureLoaderUpdate uploads the result
+// a few rows at a time. The texture handle stays the same once the real image is in.
+// A KTX2 that can't be read loads the PNG with the same name instead.
+// Destroying a texture before its load finished drops the rest of the load.
+
+TMTextureLoader *TMTextureLoaderCreate(TMRenderer *renderer, TMJobSystem *jobSystem);
+// waits for the decode jobs, loads still in flight keep their placeholder
+void TMTextureLoaderDestroy(TMTextureLoader *loader);
+TMTexture TMTextureLoaderLoad(TMTextureLoader *loader, const char *filepath);
+// GL thread, once per frame: uploads at most about budgetBytes of decoded data
+void TMTextureLoaderUpdate(TMTextureLoader *loader, size_t budgetBytes);
+// loads that did not finish uploading yet
+unsigned int TMTextureLoaderGetPendingCount(TMTextureLoader *loader);
+
+#endif //MY_APPLICATION_TM_TEXTURE_LOADER_H
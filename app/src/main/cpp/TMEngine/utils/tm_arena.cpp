@@ -0,0 +1,172 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_arena.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+// the data of the block follows the header
+struct TMArenaBlock {
+    TMArenaBlock *prev;
+    size_t size;
+    size_t used;
+};
+
+static TMArenaBlock *BlockCreate(size_t size) {
+    TMArenaBlock *block = (TMArenaBlock *)malloc(sizeof(TMArenaBlock) + size);
+    block->prev = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+static unsigned char *BlockData(TMArenaBlock *block) {
+    return (unsigned char *)(block + 1);
+}
+
+// NULL if it does not fit
+static void *BlockAlloc(TMArenaBlock *block, size_t size, size_t alignment) {
+    uintptr_t base = (uintptr_t)BlockData(block);
+    uintptr_t start = (base + block->used + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+    if(start + size > base + block->size) return NULL;
+    block->used = start + size - base;
+    return (void *)start;
+}
+
+// manuel: keep the biggest block around, a rollback followed by the same work
+// doesn't have to malloc it again
+static void BlockRelease(TMArena *arena, TMArenaBlock *block) {
+    arena->size -= block->size;
+    if(!arena->spare || arena->spare->size < block->size) {
+        free(arena->spare);
+        arena->spare = block;
+    } else {
+        free(block);
+    }
+}
+
+TMArena *TMArenaCreate(size_t size) {
+    TMArena *arena = (TMArena *)malloc(sizeof(TMArena));
+    arena->current = BlockCreate(size);
+    arena->spare = NULL;
+    arena->size = size;
+    return arena;
+}
+
+void TMArenaDestroy(TMArena *arena) {
+    TMArenaBlock *block = arena->current;
+    while(block) {
+        TMArenaBlock *prev = block->prev;
+        free(block);
+        block = prev;
+    }
+    free(arena->spare);
+    free(arena);
+}
+
+void *TMArenaAlloc(TMArena *arena, size_t size) {
+    return TMArenaAllocAligned(arena, size, TM_ARENA_DEFAULT_ALIGNMENT);
+}
+
+void *TMArenaAllocAligned(TMArena *arena, size_t size, size_t alignment) {
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    void *result = BlockAlloc(arena->current, size, alignment);
+    if(result) return result;
+
+    // manuel: the new block doubles the arena, or fits the allocation if that is bigger
+    size_t needed = size + alignment;
+    TMArenaBlock *block = NULL;
+    if(arena->spare && arena->spare->size >= needed) {
+        block = arena->spare;
+        block->used = 0;
+        arena->spare = NULL;
+    } else {
+        block = BlockCreate(needed > arena->size ? needed : arena->size);
+    }
+    block->prev = arena->current;
+    arena->current = block;
+    arena->size += block->size;
+    return BlockAlloc(block, size, alignment);
+}
+
+void TMArenaReset(TMArena *arena) {
+    if(arena->current->prev) {
+        // manuel: the work did not fit in one block, next time it will
+        size_t size = arena->size;
+        TMArenaBlock *block = arena->current;
+        while(block) {
+            TMArenaBlock *prev = block->prev;
+            free(block);
+            block = prev;
+        }
+        free(arena->spare);
+        arena->spare = NULL;
+        arena->current = BlockCreate(size);
+        arena->size = size;
+    }
+    arena->current->used = 0;
+}
+
+TMArenaSavepoint TMArenaSave(TMArena *arena) {
+    TMArenaSavepoint savepoint;
+    savepoint.arena = arena;
+    savepoint.block = arena->current;
+    savepoint.used = arena->current->used;
+    return savepoint;
+}
+
+void TMArenaRollback(TMArenaSavepoint savepoint) {
+    TMArena *arena = savepoint.arena;
+    while(arena->current != savepoint.block) {
+        TMArenaBlock *block = arena->current;
+        assert(block->prev);
+        arena->current = block->prev;
+        BlockRelease(arena, block);
+    }
+    arena->current->used = savepoint.used;
+}
+
+// destroys the scratch arena when its thread ends
+struct TMArenaScratch {
+    TMArena *arena;
+    ~TMArenaScratch() {
+        if(arena) TMArenaDestroy(arena);
+    }
+};
+
+static thread_local TMArenaScratch gScratch;
+
+TMArena *TMArenaGetScratch() {
+    if(!gScratch.arena) {
+        gScratch.arena = TMArenaCreate(TM_ARENA_SCRATCH_SIZE);
+    }
+    return gScratch.arena;
+}
+
+TMFrameArena *TMFrameArenaCreate(size_t size) {
+    TMFrameArena *frameArena = (TMFrameArena *)malloc(sizeof(TMFrameArena));
+    frameArena->arenas[0] = TMArenaCreate(size);
+    frameArena->arenas[1] = TMArenaCreate(size);
+    frameArena->frame = 0;
+    return frameArena;
+}
+
+void TMFrameArenaDestroy(TMFrameArena *frameArena) {
+    TMArenaDestroy(frameArena->arenas[0]);
+    TMArenaDestroy(frameArena->arenas[1]);
+    free(frameArena);
+}
+
+TMArena *TMFrameArenaBegin(TMFrameArena *frameArena) {
+    frameArena->frame++;
+    TMArena *arena = frameArena->arenas[frameArena->frame & 1];
+    TMArenaReset(arena);
+    return arena;
+}
+
+TMArena *TMFrameArenaGet(TMFrameArena *frameArena) {
+    return frameArena->arenas[frameArena->frame & 1];
+}
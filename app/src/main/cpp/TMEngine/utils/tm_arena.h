@@ -0,0 +1,67 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_ARENA_H
+#define MY_APPLICATION_TM_ARENA_H
+
+#include <stddef.h>
+
+// Linear allocator for short lived data. Allocations bump a pointer, nothing is
+// freed one by one: a savepoint rolls everything after it back, a reset frees it all.
+// When a block is full the arena chains a new one, a reset merges them in one block
+// as big as all of them, so after a few frames the same work never mallocs again.
+
+#define TM_ARENA_DEFAULT_ALIGNMENT 16
+// per thread scratch, see TMArenaGetScratch
+#define TM_ARENA_SCRATCH_SIZE (256 * 1024)
+
+struct TMArenaBlock;
+
+struct TMArena {
+    TMArenaBlock *current;
+    // the biggest block given back by a rollback, the next growth reuses it
+    TMArenaBlock *spare;
+    // sum of the sizes of the chained blocks
+    size_t size;
+};
+
+struct TMArenaSavepoint {
+    TMArena *arena;
+    TMArenaBlock *block;
+    size_t used;
+};
+
+TMArena *TMArenaCreate(size_t size);
+void TMArenaDestroy(TMArena *arena);
+void *TMArenaAlloc(TMArena *arena, size_t size);
+// alignment must be a power of two
+void *TMArenaAllocAligned(TMArena *arena, size_t size, size_t alignment);
+// everything allocated is gone, savepoints taken before are invalid
+void TMArenaReset(TMArena *arena);
+TMArenaSavepoint TMArenaSave(TMArena *arena);
+// frees everything allocated after the savepoint
+void TMArenaRollback(TMArenaSavepoint savepoint);
+
+#define TM_ARENA_PUSH_ARRAY(arena, type, count) \
+    ((type *)TMArenaAllocAligned((arena), sizeof(type) * (count), alignof(type)))
+
+// Arena of the calling thread, created on first use and destroyed with the thread.
+// Take a savepoint before using it and roll it back before returning, never hand
+// its memory to the caller
+TMArena *TMArenaGetScratch();
+
+// Two arenas used on alternate frames. What was allocated in a frame is still
+// valid during the next one, so it can be read after the frame that made it
+struct TMFrameArena {
+    TMArena *arenas[2];
+    unsigned int frame;
+};
+
+TMFrameArena *TMFrameArenaCreate(size_t size);
+void TMFrameArenaDestroy(TMFrameArena *frameArena);
+// flips to the other arena and resets it, call it once at the start of every frame
+TMArena *TMFrameArenaBegin(TMFrameArena *frameArena);
+TMArena *TMFrameArenaGet(TMFrameArena *frameArena);
+
+#endif //MY_APPLICATION_TM_ARENA_H
@@ -0,0 +1,276 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_concurrent_pool.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <new>
+#include <atomic>
+#include <mutex>
+
+#define CHUNK_NULL 0xFFFFFFFFu
+#define CHUNK_HEADER_SIZE 16
+#define MAX_BLOCKS 32
+
+// before every chunk, the free list links are chunk indices
+struct TMChunkHeader {
+    unsigned int index;
+    // next chunk of the same magazine
+    std::atomic<unsigned int> next;
+    // first chunk of the next magazine in the shared list, only on the first chunk of a magazine
+    std::atomic<unsigned int> nextMagazine;
+    // chunks in the magazine, only on the first chunk of a magazine
+    unsigned int count;
+};
+
+static_assert(sizeof(TMChunkHeader) == CHUNK_HEADER_SIZE, "chunk header must keep the data 16 byte aligned");
+
+struct TMMagazine {
+    unsigned int head;
+    unsigned int count;
+};
+
+// only touched by the thread that owns the slot. The previous magazine is always
+// empty or full, so a thread that frees and allocates around the border doesn't
+// hit the shared list every time
+struct alignas(64) TMThreadCache {
+    TMMagazine loaded;
+    TMMagazine previous;
+};
+
+struct TMConcurrentPool {
+    // low 32 bits the first chunk of the first magazine, high 32 bits the tag
+    alignas(64) std::atomic<uint64_t> head;
+
+    alignas(64) unsigned int chunkSize;
+    unsigned int stride;
+    // the first block has 1 << firstBlockShift chunks, every next one doubles the capacity
+    unsigned int firstBlockShift;
+    std::mutex growMutex;
+    unsigned int blockCount;
+    unsigned char *blocks[MAX_BLOCKS];
+
+    TMThreadCache caches[TM_CONCURRENT_POOL_MAX_THREADS];
+};
+
+// manuel: thread slots are shared by all the pools, a thread that ends gives its
+// slot back and the next thread takes it with the magazines still in it
+static std::mutex gSlotsMutex;
+static int gFreeSlots[TM_CONCURRENT_POOL_MAX_THREADS];
+static int gFreeSlotsCount;
+static int gNextSlot;
+
+struct TMThreadSlot {
+    // -1 not assigned yet, -2 no slot left
+    int index = -1;
+    ~TMThreadSlot() {
+        if(index < 0) return;
+        std::lock_guard<std::mutex> lock(gSlotsMutex);
+        gFreeSlots[gFreeSlotsCount++] = index;
+    }
+};
+
+static thread_local TMThreadSlot gThreadSlot;
+
+static int GetThreadSlot() {
+    if(gThreadSlot.index == -1) {
+        std::lock_guard<std::mutex> lock(gSlotsMutex);
+        if(gFreeSlotsCount > 0) {
+            gThreadSlot.index = gFreeSlots[--gFreeSlotsCount];
+        } else if(gNextSlot < TM_CONCURRENT_POOL_MAX_THREADS) {
+            gThreadSlot.index = gNextSlot++;
+        } else {
+            gThreadSlot.index = -2;
+        }
+    }
+    return gThreadSlot.index;
+}
+
+static unsigned int BlockChunkCount(TMConcurrentPool *pool, unsigned int block) {
+    return block == 0 ? 1u << pool->firstBlockShift : 1u << (pool->firstBlockShift + block - 1);
+}
+
+static TMChunkHeader *ChunkHeader(TMConcurrentPool *pool, unsigned int index) {
+    // manuel: block 0 has indices [0, F), block k [F << (k - 1), F << k), the highest
+    // bit of the index tells the block
+    unsigned int block = 0;
+    unsigned int offset = index;
+    if(index >> pool->firstBlockShift) {
+        unsigned int highestBit = 31 - __builtin_clz(index);
+        block = highestBit - pool->firstBlockShift + 1;
+        offset = index - (1u << highestBit);
+    }
+    return (TMChunkHeader *)(pool->blocks[block] + (size_t)offset * pool->stride);
+}
+
+static uint64_t MakeHead(uint64_t oldHead, unsigned int index) {
+    return (((oldHead >> 32) + 1) << 32) | index;
+}
+
+// the magazines first ... last are linked by nextMagazine already
+static void PushMagazines(TMConcurrentPool *pool, unsigned int first, TMChunkHeader *last) {
+    uint64_t oldHead = pool->head.load(std::memory_order_relaxed);
+    for(;;) {
+        last->nextMagazine.store((unsigned int)oldHead, std::memory_order_relaxed);
+        if(pool->head.compare_exchange_weak(oldHead, MakeHead(oldHead, first),
+                                            std::memory_order_release, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+static void PushMagazine(TMConcurrentPool *pool, TMMagazine magazine) {
+    TMChunkHeader *header = ChunkHeader(pool, magazine.head);
+    header->count = magazine.count;
+    PushMagazines(pool, magazine.head, header);
+}
+
+// false when the shared list is empty
+static bool PopMagazine(TMConcurrentPool *pool, TMMagazine *magazine) {
+    uint64_t oldHead = pool->head.load(std::memory_order_acquire);
+    for(;;) {
+        unsigned int index = (unsigned int)oldHead;
+        if(index == CHUNK_NULL) return false;
+        // manuel: another thread can pop this magazine and change the link after we read it,
+        // the tag makes the swap fail then
+        unsigned int next = ChunkHeader(pool, index)->nextMagazine.load(std::memory_order_relaxed);
+        if(pool->head.compare_exchange_weak(oldHead, MakeHead(oldHead, next),
+                                            std::memory_order_acquire, std::memory_order_acquire)) {
+            magazine->head = index;
+            magazine->count = ChunkHeader(pool, index)->count;
+            return true;
+        }
+    }
+}
+
+// adds a block as big as the pool and gives it to the shared list in full magazines
+static void Grow(TMConcurrentPool *pool) {
+    std::lock_guard<std::mutex> lock(pool->growMutex);
+    // someone else grew while we waited
+    if((unsigned int)pool->head.load(std::memory_order_acquire) != CHUNK_NULL) return;
+    unsigned int block = pool->blockCount;
+    assert(block < MAX_BLOCKS);
+    unsigned int count = BlockChunkCount(pool, block);
+    unsigned int base = block == 0 ? 0 : count;
+    pool->blocks[block] = (unsigned char *)malloc((size_t)pool->stride * count);
+    pool->blockCount++;
+
+    TMChunkHeader *lastMagazine = NULL;
+    for(unsigned int i = 0; i < count; i += TM_CONCURRENT_POOL_MAGAZINE_SIZE) {
+        unsigned int magazineCount = count - i < TM_CONCURRENT_POOL_MAGAZINE_SIZE ?
+                                     count - i : TM_CONCURRENT_POOL_MAGAZINE_SIZE;
+        for(unsigned int j = 0; j < magazineCount; ++j) {
+            unsigned int index = base + i + j;
+            TMChunkHeader *header = new(ChunkHeader(pool, index)) TMChunkHeader();
+            header->index = index;
+            header->next.store(j + 1 < magazineCount ? index + 1 : CHUNK_NULL, std::memory_order_relaxed);
+            header->nextMagazine.store(CHUNK_NULL, std::memory_order_relaxed);
+            header->count = magazineCount;
+        }
+        TMChunkHeader *first = ChunkHeader(pool, base + i);
+        if(lastMagazine) lastMagazine->nextMagazine.store(base + i, std::memory_order_relaxed);
+        lastMagazine = first;
+    }
+    PushMagazines(pool, base, lastMagazine);
+}
+
+static void TakeMagazine(TMConcurrentPool *pool, TMMagazine *magazine) {
+    while(!PopMagazine(pool, magazine)) {
+        Grow(pool);
+    }
+}
+
+static TMChunkHeader *MagazinePop(TMConcurrentPool *pool, TMMagazine *magazine) {
+    TMChunkHeader *header = ChunkHeader(pool, magazine->head);
+    magazine->head = header->next.load(std::memory_order_relaxed);
+    magazine->count--;
+    return header;
+}
+
+static void MagazinePush(TMMagazine *magazine, TMChunkHeader *header) {
+    header->next.store(magazine->head, std::memory_order_relaxed);
+    magazine->head = header->index;
+    magazine->count++;
+}
+
+TMConcurrentPool *TMConcurrentPoolCreate(unsigned int chunkSize, unsigned int numChunk) {
+    TMConcurrentPool *pool = new TMConcurrentPool();
+    pool->head.store(CHUNK_NULL);
+    pool->chunkSize = chunkSize;
+    pool->stride = CHUNK_HEADER_SIZE + ((chunkSize + 15) & ~15u);
+    pool->firstBlockShift = 0;
+    while((1u << pool->firstBlockShift) < numChunk && pool->firstBlockShift < 20) {
+        pool->firstBlockShift++;
+    }
+    pool->blockCount = 0;
+    for(int i = 0; i < TM_CONCURRENT_POOL_MAX_THREADS; ++i) {
+        pool->caches[i].loaded = TMMagazine{CHUNK_NULL, 0};
+        pool->caches[i].previous = TMMagazine{CHUNK_NULL, 0};
+    }
+    Grow(pool);
+    return pool;
+}
+
+void TMConcurrentPoolDestroy(TMConcurrentPool *pool) {
+    for(unsigned int i = 0; i < pool->blockCount; ++i) {
+        free(pool->blocks[i]);
+    }
+    delete pool;
+}
+
+void *TMConcurrentPoolAlloc(TMConcurrentPool *pool) {
+    int slot = GetThreadSlot();
+    TMChunkHeader *header;
+    if(slot < 0) {
+        // manuel: no cache, take a magazine for one chunk and give the rest back
+        TMMagazine magazine;
+        TakeMagazine(pool, &magazine);
+        header = MagazinePop(pool, &magazine);
+        if(magazine.count > 0) PushMagazine(pool, magazine);
+    } else {
+        TMThreadCache *cache = pool->caches + slot;
+        if(cache->loaded.count == 0) {
+            if(cache->previous.count > 0) {
+                TMMagazine temp = cache->loaded;
+                cache->loaded = cache->previous;
+                cache->previous = temp;
+            } else {
+                TakeMagazine(pool, &cache->loaded);
+            }
+        }
+        header = MagazinePop(pool, &cache->loaded);
+    }
+    return (unsigned char *)header + CHUNK_HEADER_SIZE;
+}
+
+void TMConcurrentPoolFree(TMConcurrentPool *pool, void *mem) {
+    TMChunkHeader *header = (TMChunkHeader *)((unsigned char *)mem - CHUNK_HEADER_SIZE);
+    unsigned int index = header->index;
+    int slot = GetThreadSlot();
+    if(slot < 0) {
+        header->next.store(CHUNK_NULL, std::memory_order_relaxed);
+        PushMagazine(pool, TMMagazine{index, 1});
+        return;
+    }
+    TMThreadCache *cache = pool->caches + slot;
+    if(cache->loaded.count == TM_CONCURRENT_POOL_MAGAZINE_SIZE) {
+        if(cache->previous.count > 0) {
+            PushMagazine(pool, cache->previous);
+        }
+        cache->previous = cache->loaded;
+        cache->loaded = TMMagazine{CHUNK_NULL, 0};
+    }
+    MagazinePush(&cache->loaded, header);
+}
+
+unsigned int TMConcurrentPoolGetCapacity(TMConcurrentPool *pool) {
+    std::lock_guard<std::mutex> lock(pool->growMutex);
+    unsigned int capacity = 0;
+    for(unsigned int i = 0; i < pool->blockCount; ++i) {
+        capacity += BlockChunkCount(pool, i);
+    }
+    return capacity;
+}
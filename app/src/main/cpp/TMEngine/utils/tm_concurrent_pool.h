@@ -0,0 +1,31 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_CONCURRENT_POOL_H
+#define MY_APPLICATION_TM_CONCURRENT_POOL_H
+
+// TMMemoryPool that any thread can use at the same time, a chunk can be freed by
+// a different thread than the one that allocated it.
+// Every thread keeps two small magazines of free chunks and only touches the shared
+// free list to take or give back a whole magazine. The shared list is lock free, its
+// head is a chunk index plus a tag that changes on every update, so a chunk that was
+// popped and pushed back while another thread looked at it can't fool the swap (ABA).
+// Only growing takes a lock. A thread that ends leaves its magazines to the next thread.
+
+#define TM_CONCURRENT_POOL_MAGAZINE_SIZE 32
+// threads past this one go to the shared list for every chunk
+#define TM_CONCURRENT_POOL_MAX_THREADS 64
+
+struct TMConcurrentPool;
+
+// numChunk is the size of the first block, rounded up to a power of two
+TMConcurrentPool *TMConcurrentPoolCreate(unsigned int chunkSize, unsigned int numChunk);
+// no other thread can be using the pool
+void TMConcurrentPoolDestroy(TMConcurrentPool *pool);
+void *TMConcurrentPoolAlloc(TMConcurrentPool *pool);
+void TMConcurrentPoolFree(TMConcurrentPool *pool, void *mem);
+// chunks in all the blocks
+unsigned int TMConcurrentPoolGetCapacity(TMConcurrentPool *pool);
+
+#endif //MY_APPLICATION_TM_CONCURRENT_POOL_H
@@ -3,6 +3,7 @@
 //
 
 #include "tm_file.h"
+#include "tm_arena.h"
 
 #include <android/log.h>
 
@@ -10,7 +11,7 @@
 
 #define TM_LOG_INFO(...) ((void)__android_log_print(ANDROID_LOG_INFO, "App2", __VA_ARGS__))
 
-TMFile TMFileOpen(AAssetManager *assetManager, const char *filepath) {
+static TMFile FileRead(AAssetManager *assetManager, const char *filepath, TMArena *arena) {
     TMFile result{};
     AAsset *file = AAssetManager_open(assetManager, filepath, AASSET_MODE_BUFFER);
     if(!file) {
@@ -19,7 +20,7 @@ TMFile TMFileOpen(AAssetManager *assetManager, const char *filepath) {
     }
 
     long fileSize = AAsset_getLength(file);
-    result.data = malloc(fileSize + 1);
+    result.data = arena ? TMArenaAlloc(arena, fileSize + 1) : malloc(fileSize + 1);
     result.size = fileSize;
     AAsset_read (file,result.data,fileSize);
     char *buffer = (char *)result.data;
@@ -29,6 +30,14 @@ TMFile TMFileOpen(AAssetManager *assetManager, const char *filepath) {
     return result;
 }
 
+TMFile TMFileOpen(AAssetManager *assetManager, const char *filepath) {
+    return FileRead(assetManager, filepath, NULL);
+}
+
+TMFile TMFileOpen(AAssetManager *assetManager, const char *filepath, TMArena *arena) {
+    return FileRead(assetManager, filepath, arena);
+}
+
 void TMFileClose(TMFile *file) {
     if(file->data) free(file->data);
     file->data = NULL;
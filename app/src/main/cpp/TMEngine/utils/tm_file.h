@@ -8,12 +8,16 @@
 #include <stddef.h>
 #include <android/asset_manager.h>
 
+struct TMArena;
+
 struct TMFile {
     void *data;
     size_t size;
 };
 
 TMFile TMFileOpen(AAssetManager  *assetManager, const char *filepath);
+// the data lives in the arena, don't TMFileClose it
+TMFile TMFileOpen(AAssetManager  *assetManager, const char *filepath, TMArena *arena);
 void TMFileClose(TMFile *file);
 
 
@@ -0,0 +1,108 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_handle_table.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+
+static void TableGrow(TMHandleTable *table, unsigned int capacity) {
+    table->capacity = capacity;
+    table->elements = (unsigned char *)realloc(table->elements, (size_t)table->elementSize * capacity);
+    table->handles = (unsigned int *)realloc(table->handles, sizeof(unsigned int) * capacity);
+    table->denseIndices = (unsigned int *)realloc(table->denseIndices, sizeof(unsigned int) * capacity);
+    table->generations = (unsigned int *)realloc(table->generations, sizeof(unsigned int) * capacity);
+    table->freeSlots = (unsigned int *)realloc(table->freeSlots, sizeof(unsigned int) * capacity);
+}
+
+TMHandleTable *TMHandleTableCreate(unsigned int elementSize, unsigned int capacity) {
+    TMHandleTable *table = (TMHandleTable *)malloc(sizeof(TMHandleTable));
+    memset(table, 0, sizeof(TMHandleTable));
+    table->elementSize = elementSize;
+    TableGrow(table, capacity > 0 ? capacity : 1);
+    return table;
+}
+
+void TMHandleTableDestroy(TMHandleTable *table) {
+    free(table->elements);
+    free(table->handles);
+    free(table->denseIndices);
+    free(table->generations);
+    free(table->freeSlots);
+    free(table);
+}
+
+unsigned int TMHandleTableAdd(TMHandleTable *table, void **element) {
+    unsigned int slot;
+    if(table->freeCount > 0) {
+        slot = table->freeSlots[--table->freeCount];
+    } else {
+        // manuel: every slot ever used is live or free, so slotsCount never passes the capacity
+        if(table->slotsCount == table->capacity) {
+            TableGrow(table, table->capacity * 2);
+        }
+        assert(table->slotsCount <= TM_HANDLE_INDEX_MASK);
+        slot = table->slotsCount++;
+        table->generations[slot] = 1;
+    }
+
+    unsigned int index = table->count++;
+    unsigned int handle = (table->generations[slot] << TM_HANDLE_INDEX_BITS) | slot;
+    table->denseIndices[slot] = index;
+    table->handles[index] = handle;
+    void *data = table->elements + (size_t)table->elementSize * index;
+    memset(data, 0, table->elementSize);
+    if(element) *element = data;
+    return handle;
+}
+
+bool TMHandleTableRemove(TMHandleTable *table, unsigned int handle) {
+    if(!TMHandleTableIsValid(table, handle)) return false;
+    unsigned int slot = TM_HANDLE_INDEX(handle);
+    unsigned int index = table->denseIndices[slot];
+    unsigned int last = --table->count;
+    if(index != last) {
+        memcpy(table->elements + (size_t)table->elementSize * index,
+               table->elements + (size_t)table->elementSize * last, table->elementSize);
+        unsigned int movedHandle = table->handles[last];
+        table->handles[index] = movedHandle;
+        table->denseIndices[TM_HANDLE_INDEX(movedHandle)] = index;
+    }
+    // manuel: a slot that used every generation is retired, reusing it would
+    // make its oldest handles valid again
+    if(table->generations[slot] == TM_HANDLE_MAX_GENERATION) {
+        table->generations[slot] = 0;
+    } else {
+        table->generations[slot]++;
+        table->freeSlots[table->freeCount++] = slot;
+    }
+    return true;
+}
+
+bool TMHandleTableIsValid(TMHandleTable *table, unsigned int handle) {
+    unsigned int slot = TM_HANDLE_INDEX(handle);
+    unsigned int generation = TM_HANDLE_GENERATION(handle);
+    return generation != 0 && slot < table->slotsCount && table->generations[slot] == generation &&
+           table->handles[table->denseIndices[slot]] == handle;
+}
+
+void *TMHandleTableGet(TMHandleTable *table, unsigned int handle) {
+    if(!TMHandleTableIsValid(table, handle)) return NULL;
+    return table->elements + (size_t)table->elementSize * table->denseIndices[TM_HANDLE_INDEX(handle)];
+}
+
+unsigned int TMHandleTableGetCount(TMHandleTable *table) {
+    return table->count;
+}
+
+void *TMHandleTableGetAt(TMHandleTable *table, unsigned int index) {
+    assert(index < table->count);
+    return table->elements + (size_t)table->elementSize * index;
+}
+
+unsigned int TMHandleTableGetHandleAt(TMHandleTable *table, unsigned int index) {
+    assert(index < table->count);
+    return table->handles[index];
+}
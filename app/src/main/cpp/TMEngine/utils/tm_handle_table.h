@@ -0,0 +1,57 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_HANDLE_TABLE_H
+#define MY_APPLICATION_TM_HANDLE_TABLE_H
+
+// Dense array of fixed size elements addressed by 32 bit generational handles.
+// The low TM_HANDLE_INDEX_BITS of a handle are a slot, the high bits the generation
+// of the slot when the element was added. Live elements are packed in [0, count),
+// removing one moves the last element into the hole, so looping over them touches
+// only live data. A handle of a removed element fails to resolve instead of reaching
+// whatever reused its slot. Pointers to elements are only valid until the next add
+// or remove, keep the handle instead.
+
+#define TM_HANDLE_INDEX_BITS 20
+#define TM_HANDLE_INDEX_MASK ((1u << TM_HANDLE_INDEX_BITS) - 1)
+#define TM_HANDLE_MAX_GENERATION ((1u << (32 - TM_HANDLE_INDEX_BITS)) - 1)
+// generation 0 is never used, so 0 is never a valid handle
+#define TM_HANDLE_NULL 0
+
+#define TM_HANDLE_INDEX(handle) ((handle) & TM_HANDLE_INDEX_MASK)
+#define TM_HANDLE_GENERATION(handle) ((handle) >> TM_HANDLE_INDEX_BITS)
+
+struct TMHandleTable {
+    unsigned int elementSize;
+    unsigned int capacity;
+    unsigned int count;
+
+    // dense, indexed [0, count)
+    unsigned char *elements;
+    unsigned int *handles;
+
+    // indexed by slot, [0, slotsCount)
+    unsigned int *denseIndices;
+    unsigned int *generations;
+    unsigned int slotsCount;
+    unsigned int *freeSlots;
+    unsigned int freeCount;
+};
+
+// capacity is a hint, the table doubles when it is full
+TMHandleTable *TMHandleTableCreate(unsigned int elementSize, unsigned int capacity);
+void TMHandleTableDestroy(TMHandleTable *table);
+// the new element starts zeroed, element is optional
+unsigned int TMHandleTableAdd(TMHandleTable *table, void **element);
+// false if the handle is not live, nothing is removed then
+bool TMHandleTableRemove(TMHandleTable *table, unsigned int handle);
+bool TMHandleTableIsValid(TMHandleTable *table, unsigned int handle);
+// NULL if the handle is not live
+void *TMHandleTableGet(TMHandleTable *table, unsigned int handle);
+unsigned int TMHandleTableGetCount(TMHandleTable *table);
+// live elements and their handles by dense index, [0, TMHandleTableGetCount)
+void *TMHandleTableGetAt(TMHandleTable *table, unsigned int index);
+unsigned int TMHandleTableGetHandleAt(TMHandleTable *table, unsigned int index);
+
+#endif //MY_APPLICATION_TM_HANDLE_TABLE_H
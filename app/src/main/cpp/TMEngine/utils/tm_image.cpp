@@ -0,0 +1,70 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_image.h"
+
+#include <android/log.h>
+#include <android/imagedecoder.h>
+
+#include <stdlib.h>
+#include <memory.h>
+
+#define TM_LOG_INFO(...) ((void)__android_log_print(ANDROID_LOG_INFO, "App2", __VA_ARGS__))
+
+TMImage TMImageLoad(AAssetManager *assetManager, const char *filepath) {
+    TMImage result{};
+    AAsset *file = AAssetManager_open(assetManager, filepath, AASSET_MODE_BUFFER);
+    if(!file) {
+        TM_LOG_INFO("Error Loading image: %s", filepath);
+        return result;
+    }
+
+    // manuel: make a decoder to turn in into a texture
+    AImageDecoder *androidDecoder = NULL;
+    int decoderResult = AImageDecoder_createFromAAsset(file, &androidDecoder);
+    if(decoderResult != ANDROID_IMAGE_DECODER_SUCCESS) {
+        TM_LOG_INFO("Error Decoding image: %s", filepath);
+        AAsset_close(file);
+        return result;
+    }
+
+    // manuel: make sure we get 8 bits per channel RGBA
+    AImageDecoder_setAndroidBitmapFormat(androidDecoder, ANDROID_BITMAP_FORMAT_RGBA_8888);
+
+    const AImageDecoderHeaderInfo *header = AImageDecoder_getHeaderInfo(androidDecoder);
+    int width = AImageDecoderHeaderInfo_getWidth(header);
+    int height = AImageDecoderHeaderInfo_getHeight(header);
+    size_t stride = AImageDecoder_getMinimumStride(androidDecoder);
+
+    unsigned char *pixels = (unsigned char *)malloc(height * stride);
+    int decodeResult = AImageDecoder_decodeImage(androidDecoder, pixels, stride, height * stride);
+    AImageDecoder_delete(androidDecoder);
+    AAsset_close(file);
+
+    if(decodeResult != ANDROID_IMAGE_DECODER_SUCCESS) {
+        TM_LOG_INFO("Error Decoding image: %s", filepath);
+        free(pixels);
+        return result;
+    }
+
+    // the minimum stride can be padded, keep the rows tightly packed
+    size_t rowSize = width * 4;
+    if(stride != rowSize) {
+        for(int y = 1; y < height; ++y) {
+            memmove(pixels + y * rowSize, pixels + y * stride, rowSize);
+        }
+    }
+
+    result.pixels = pixels;
+    result.width = width;
+    result.height = height;
+    return result;
+}
+
+void TMImageFree(TMImage *image) {
+    if(image->pixels) free(image->pixels);
+    image->pixels = NULL;
+    image->width = 0;
+    image->height = 0;
+}
@@ -0,0 +1,20 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_IMAGE_H
+#define MY_APPLICATION_TM_IMAGE_H
+
+#include <android/asset_manager.h>
+
+// decoded image, RGBA 8 bits per channel, rows tightly packed from the top
+struct TMImage {
+    unsigned char *pixels;
+    int width;
+    int height;
+};
+
+TMImage TMImageLoad(AAssetManager *assetManager, const char *filepath);
+void TMImageFree(TMImage *image);
+
+#endif //MY_APPLICATION_TM_IMAGE_H
@@ -0,0 +1,220 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_ktx2.h"
+
+#include <memory.h>
+
+// File layout (all values little endian):
+//   identifier(12) | header(9 x u32) | index(4 x u32, 2 x u64) | level index(levelCount x 3 x u64)
+//   | data format descriptor | key/value data | mip levels from the smallest to the biggest
+#define TM_KTX2_HEADER_SIZE 80
+#define TM_KTX2_LEVEL_INDEX_SIZE 24
+
+// khr_df.h values used to describe the block compressed formats
+#define TM_KHR_DF_MODEL_ETC2 161
+#define TM_KHR_DF_MODEL_ASTC 162
+#define TM_KHR_DF_PRIMARIES_BT709 1
+#define TM_KHR_DF_TRANSFER_LINEAR 1
+#define TM_KHR_DF_CHANNEL_ETC2_COLOR 2
+#define TM_KHR_DF_CHANNEL_ETC2_ALPHA 15
+#define TM_KHR_DF_CHANNEL_ASTC_DATA 0
+
+static const unsigned char gKtx2Identifier[12] = {
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+static unsigned int ReadU32(const unsigned char *src) {
+    return (unsigned int)src[0] | ((unsigned int)src[1] << 8) |
+           ((unsigned int)src[2] << 16) | ((unsigned int)src[3] << 24);
+}
+
+static uint64_t ReadU64(const unsigned char *src) {
+    return (uint64_t)ReadU32(src) | ((uint64_t)ReadU32(src + 4) << 32);
+}
+
+static void WriteU32(unsigned char *dst, unsigned int value) {
+    dst[0] = (unsigned char)(value);
+    dst[1] = (unsigned char)(value >> 8);
+    dst[2] = (unsigned char)(value >> 16);
+    dst[3] = (unsigned char)(value >> 24);
+}
+
+static void WriteU64(unsigned char *dst, uint64_t value) {
+    WriteU32(dst, (unsigned int)value);
+    WriteU32(dst + 4, (unsigned int)(value >> 32));
+}
+
+static unsigned int LevelSize(unsigned int size, unsigned int level) {
+    size >>= level;
+    return size > 0 ? size : 1;
+}
+
+bool TMKtx2FormatBlock(unsigned int vkFormat, unsigned int *blockBytes,
+                       unsigned int *blockWidth, unsigned int *blockHeight) {
+    switch(vkFormat) {
+        case TM_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK: {
+            *blockBytes = 8; *blockWidth = 4; *blockHeight = 4;
+        } return true;
+        case TM_VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+        case TM_VK_FORMAT_ASTC_4x4_UNORM_BLOCK: {
+            *blockBytes = 16; *blockWidth = 4; *blockHeight = 4;
+        } return true;
+        case TM_VK_FORMAT_ASTC_8x8_UNORM_BLOCK: {
+            *blockBytes = 16; *blockWidth = 8; *blockHeight = 8;
+        } return true;
+        default:
+            return false;
+    }
+}
+
+bool TMKtx2Parse(const void *data, size_t size, TMKtx2 *ktx2) {
+    const unsigned char *file = (const unsigned char *)data;
+    memset(ktx2, 0, sizeof(TMKtx2));
+    if(size < TM_KTX2_HEADER_SIZE || memcmp(file, gKtx2Identifier, sizeof(gKtx2Identifier)) != 0) {
+        return false;
+    }
+
+    unsigned int vkFormat = ReadU32(file + 12);
+    unsigned int width = ReadU32(file + 20);
+    unsigned int height = ReadU32(file + 24);
+    unsigned int depth = ReadU32(file + 28);
+    unsigned int layerCount = ReadU32(file + 32);
+    unsigned int faceCount = ReadU32(file + 36);
+    unsigned int levelCount = ReadU32(file + 40);
+    unsigned int supercompression = ReadU32(file + 44);
+
+    // only plain 2D textures, a levelCount of 0 asks the loader to generate the mips
+    if(width == 0 || height == 0 || depth > 1 || layerCount > 1 || faceCount != 1 || supercompression != 0) {
+        return false;
+    }
+    if(levelCount == 0) levelCount = 1;
+    if(levelCount > TM_KTX2_MAX_LEVELS) {
+        return false;
+    }
+    if(size < TM_KTX2_HEADER_SIZE + (size_t)levelCount * TM_KTX2_LEVEL_INDEX_SIZE) {
+        return false;
+    }
+
+    unsigned int blockBytes = 0, blockWidth = 1, blockHeight = 1;
+    bool knownFormat = TMKtx2FormatBlock(vkFormat, &blockBytes, &blockWidth, &blockHeight);
+
+    ktx2->vkFormat = vkFormat;
+    ktx2->width = width;
+    ktx2->height = height;
+    ktx2->levelCount = levelCount;
+    for(unsigned int i = 0; i < levelCount; ++i) {
+        const unsigned char *entry = file + TM_KTX2_HEADER_SIZE + i * TM_KTX2_LEVEL_INDEX_SIZE;
+        uint64_t offset = ReadU64(entry);
+        uint64_t length = ReadU64(entry + 8);
+        if(offset > size || length > size - offset) {
+            return false;
+        }
+        TMKtx2Level *level = ktx2->levels + i;
+        level->data = file + offset;
+        level->size = (size_t)length;
+        level->width = LevelSize(width, i);
+        level->height = LevelSize(height, i);
+        if(knownFormat) {
+            size_t blocksX = (level->width + blockWidth - 1) / blockWidth;
+            size_t blocksY = (level->height + blockHeight - 1) / blockHeight;
+            if(level->size != blocksX * blocksY * blockBytes) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// basic data format descriptor block, one sample per 64 bit plane
+static unsigned int WriteDataFormatDescriptor(unsigned int vkFormat, unsigned char *dst) {
+    unsigned int blockBytes = 0, blockWidth = 0, blockHeight = 0;
+    TMKtx2FormatBlock(vkFormat, &blockBytes, &blockWidth, &blockHeight);
+
+    unsigned int colorModel = TM_KHR_DF_MODEL_ASTC;
+    unsigned int channels[2] = {TM_KHR_DF_CHANNEL_ASTC_DATA, 0};
+    unsigned int samplesCount = 1;
+    unsigned int sampleBits = 128;
+    if(vkFormat == TM_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK) {
+        colorModel = TM_KHR_DF_MODEL_ETC2;
+        channels[0] = TM_KHR_DF_CHANNEL_ETC2_COLOR;
+        sampleBits = 64;
+    } else if(vkFormat == TM_VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK) {
+        colorModel = TM_KHR_DF_MODEL_ETC2;
+        channels[0] = TM_KHR_DF_CHANNEL_ETC2_ALPHA;
+        channels[1] = TM_KHR_DF_CHANNEL_ETC2_COLOR;
+        samplesCount = 2;
+        sampleBits = 64;
+    }
+
+    unsigned int blockSize = 24 + 16 * samplesCount;
+    unsigned int totalSize = 4 + blockSize;
+    if(!dst) return totalSize;
+
+    memset(dst, 0, totalSize);
+    WriteU32(dst, totalSize);
+    WriteU32(dst + 4, 0); // vendor khronos, descriptor type basic
+    WriteU32(dst + 8, 2 | (blockSize << 16)); // version 1.3
+    WriteU32(dst + 12, colorModel | (TM_KHR_DF_PRIMARIES_BT709 << 8) | (TM_KHR_DF_TRANSFER_LINEAR << 16));
+    WriteU32(dst + 16, (blockWidth - 1) | ((blockHeight - 1) << 8));
+    WriteU32(dst + 20, blockBytes);
+    for(unsigned int i = 0; i < samplesCount; ++i) {
+        unsigned char *sample = dst + 28 + i * 16;
+        WriteU32(sample, (i * sampleBits) | ((sampleBits - 1) << 16) | (channels[i] << 24));
+        WriteU32(sample + 4, 0);
+        WriteU32(sample + 8, 0);
+        WriteU32(sample + 12, 0xFFFFFFFF);
+    }
+    return totalSize;
+}
+
+size_t TMKtx2Write(TMKtx2 *ktx2, unsigned char *buffer, size_t bufferSize) {
+    unsigned int blockBytes = 0, blockWidth = 0, blockHeight = 0;
+    if(!TMKtx2FormatBlock(ktx2->vkFormat, &blockBytes, &blockWidth, &blockHeight)) {
+        return 0;
+    }
+
+    unsigned int dfdOffset = TM_KTX2_HEADER_SIZE + ktx2->levelCount * TM_KTX2_LEVEL_INDEX_SIZE;
+    unsigned int dfdSize = WriteDataFormatDescriptor(ktx2->vkFormat, NULL);
+
+    // level data is aligned to the block size, smallest level first so a
+    // streaming loader can show something before the whole file is read
+    size_t offsets[TM_KTX2_MAX_LEVELS];
+    size_t size = dfdOffset + dfdSize;
+    for(int i = (int)ktx2->levelCount - 1; i >= 0; --i) {
+        size = (size + blockBytes - 1) / blockBytes * blockBytes;
+        offsets[i] = size;
+        size += ktx2->levels[i].size;
+    }
+    if(!buffer) return size;
+    if(bufferSize < size) return 0;
+
+    memset(buffer, 0, size);
+    memcpy(buffer, gKtx2Identifier, sizeof(gKtx2Identifier));
+    WriteU32(buffer + 12, ktx2->vkFormat);
+    WriteU32(buffer + 16, 1); // typeSize
+    WriteU32(buffer + 20, ktx2->width);
+    WriteU32(buffer + 24, ktx2->height);
+    WriteU32(buffer + 28, 0); // pixelDepth
+    WriteU32(buffer + 32, 0); // layerCount
+    WriteU32(buffer + 36, 1); // faceCount
+    WriteU32(buffer + 40, ktx2->levelCount);
+    WriteU32(buffer + 44, 0); // supercompressionScheme
+    WriteU32(buffer + 48, dfdOffset);
+    WriteU32(buffer + 52, dfdSize);
+    WriteU32(buffer + 56, 0); // no key/value data
+    WriteU32(buffer + 60, 0);
+    WriteU64(buffer + 64, 0); // no supercompression global data
+    WriteU64(buffer + 72, 0);
+
+    for(unsigned int i = 0; i < ktx2->levelCount; ++i) {
+        unsigned char *entry = buffer + TM_KTX2_HEADER_SIZE + i * TM_KTX2_LEVEL_INDEX_SIZE;
+        WriteU64(entry, offsets[i]);
+        WriteU64(entry + 8, ktx2->levels[i].size);
+        WriteU64(entry + 16, ktx2->levels[i].size);
+        memcpy(buffer + offsets[i], ktx2->levels[i].data, ktx2->levels[i].size);
+    }
+    WriteDataFormatDescriptor(ktx2->vkFormat, buffer + dfdOffset);
+    return size;
+}
@@ -0,0 +1,48 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_KTX2_H
+#define MY_APPLICATION_TM_KTX2_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Minimal KTX2 reader / writer for 2D textures without supercompression.
+// Has no platform dependencies so it is shared with the offline converter
+
+#define TM_KTX2_MAX_LEVELS 16
+
+// VkFormat values of the formats we use
+#define TM_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK 147
+#define TM_VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK 151
+#define TM_VK_FORMAT_ASTC_4x4_UNORM_BLOCK 157
+#define TM_VK_FORMAT_ASTC_8x8_UNORM_BLOCK 171
+
+struct TMKtx2Level {
+    const unsigned char *data;
+    size_t size;
+    unsigned int width;
+    unsigned int height;
+};
+
+struct TMKtx2 {
+    unsigned int vkFormat;
+    unsigned int width;
+    unsigned int height;
+    unsigned int levelCount;
+    TMKtx2Level levels[TM_KTX2_MAX_LEVELS];
+};
+
+// the levels point into data, which must outlive the result. Returns false on a malformed file
+bool TMKtx2Parse(const void *data, size_t size, TMKtx2 *ktx2);
+
+// block size in bytes and texels of a supported format, false if the format is unknown
+bool TMKtx2FormatBlock(unsigned int vkFormat, unsigned int *blockBytes,
+                       unsigned int *blockWidth, unsigned int *blockHeight);
+
+// writes a file with the levels of ktx2 (level 0 is the biggest), returns the
+// size needed. Call it with buffer NULL to get the size first
+size_t TMKtx2Write(TMKtx2 *ktx2, unsigned char *buffer, size_t bufferSize);
+
+#endif //MY_APPLICATION_TM_KTX2_H
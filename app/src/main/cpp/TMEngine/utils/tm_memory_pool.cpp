@@ -6,95 +6,311 @@
 
 #include <stdlib.h>
 #include <memory.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 #define TM_EXPORT __attribute__((visibility("default")))
 
-TM_EXPORT TMMemoryPool *TMMemoryPoolCreate(unsigned int chunkSize, unsigned int numChunk) {
+// threads the chunks of the block one after the other, the last one points to tail
+static void LinkChunks(TMMemoryPool *memoryPool, TMMemoryPoolBlock *block, unsigned char *tail) {
+    unsigned char *current = block->memory;
+    unsigned char *last = block->memory + (size_t)memoryPool->stride * (block->chunkCount - 1);
+    while(current != last) {
+        unsigned char *next = current + memoryPool->stride;
+        *(unsigned char **)current = next;
+        current = next;
+    }
+    *(unsigned char **)last = tail;
+}
+
+// threads the chunks of the block in front of the free list
+static void BlockLinkChunks(TMMemoryPool *memoryPool, TMMemoryPoolBlock *block) {
+    LinkChunks(memoryPool, block, memoryPool->head);
+    memoryPool->head = block->memory;
+    memoryPool->freeCount += block->chunkCount;
+}
+
+static TMMemoryPoolBlock *ChunkBlock(TMMemoryPool *memoryPool, void *chunk) {
+    return memoryPool->blockArray + (((unsigned char *)chunk - memoryPool->reserve) >> memoryPool->blockShift);
+}
+
+static void PushFreeBlock(TMMemoryPool *memoryPool, TMMemoryPoolBlock *block) {
+    block->prevFree = NULL;
+    block->nextFree = memoryPool->freeBlocks;
+    if(memoryPool->freeBlocks) memoryPool->freeBlocks->prevFree = block;
+    memoryPool->freeBlocks = block;
+}
+
+static void UnlinkFreeBlock(TMMemoryPool *memoryPool, TMMemoryPoolBlock *block) {
+    if(block->prevFree) block->prevFree->nextFree = block->nextFree;
+    else memoryPool->freeBlocks = block->nextFree;
+    if(block->nextFree) block->nextFree->prevFree = block->prevFree;
+}
+
+// virtual pools: every chunk of the block on its own free list and the block in front of the free blocks
+static void VirtualBlockLinkChunks(TMMemoryPool *memoryPool, TMMemoryPoolBlock *block) {
+    LinkChunks(memoryPool, block, NULL);
+    block->head = block->memory;
+    block->usedCount = 0;
+    memoryPool->freeCount += block->chunkCount;
+    memoryPool->emptyBlockCount++;
+    PushFreeBlock(memoryPool, block);
+}
+
+// the block has no live chunk, its free list holds all its chunks
+static void ReleaseBlock(TMMemoryPool *memoryPool, TMMemoryPoolBlock *block) {
+    UnlinkFreeBlock(memoryPool, block);
+    block->head = NULL;
+    block->committed = false;
+    memoryPool->freeCount -= block->chunkCount;
+    memoryPool->chunkCount -= block->chunkCount;
+    memoryPool->emptyBlockCount--;
+    // the pages read back as zero if the block is mapped again, PROT_NONE makes
+    // a use after free fault instead of reading them
+    size_t blockSize = (size_t)1 << memoryPool->blockShift;
+    madvise(block->memory, blockSize, MADV_DONTNEED);
+    mprotect(block->memory, blockSize, PROT_NONE);
+}
+
+static void AddBlock(TMMemoryPool *memoryPool, unsigned int chunkCount) {
+    // manuel: the block array doubles too, so adding a block never copies it all
+    if(memoryPool->blockCount == memoryPool->blockCapacity) {
+        memoryPool->blockCapacity = memoryPool->blockCapacity ? memoryPool->blockCapacity * 2 : 4;
+        memoryPool->blockArray = (TMMemoryPoolBlock *)realloc(memoryPool->blockArray,
+                                                              sizeof(TMMemoryPoolBlock) * memoryPool->blockCapacity);
+    }
+    TMMemoryPoolBlock *block = memoryPool->blockArray + memoryPool->blockCount++;
+    block->chunkCount = chunkCount;
+    block->usedCount = 0;
+    block->committed = true;
+    block->head = NULL;
+    void *memory = NULL;
+    if(posix_memalign(&memory, memoryPool->alignment, (size_t)memoryPool->stride * chunkCount) != 0) {
+        memory = NULL;
+    }
+    assert(memory);
+    block->memory = (unsigned char *)memory;
+    memoryPool->chunkCount += chunkCount;
+    BlockLinkChunks(memoryPool, block);
+}
+
+// maps a block of the reservation, false when it is full
+static bool AddVirtualBlock(TMMemoryPool *memoryPool) {
+    // manuel: blocks given back by a trim first, the reservation only grows when they are all in use
+    TMMemoryPoolBlock *block = NULL;
+    for(unsigned int i = 0; i < memoryPool->blockCount; ++i) {
+        if(!memoryPool->blockArray[i].committed) {
+            block = memoryPool->blockArray + i;
+            break;
+        }
+    }
+    if(!block) {
+        if(memoryPool->blockCount == memoryPool->blockCapacity) return false;
+        block = memoryPool->blockArray + memoryPool->blockCount;
+        block->memory = memoryPool->reserve + ((size_t)memoryPool->blockCount << memoryPool->blockShift);
+        block->chunkCount = memoryPool->chunksPerBlock;
+        block->committed = false;
+        block->head = NULL;
+        memoryPool->blockCount++;
+    }
+    if(mprotect(block->memory, (size_t)1 << memoryPool->blockShift, PROT_READ | PROT_WRITE) != 0) {
+        return false;
+    }
+    block->committed = true;
+    memoryPool->chunkCount += block->chunkCount;
+    VirtualBlockLinkChunks(memoryPool, block);
+    return true;
+}
+
+// manuel: as big as everything we have, the capacity doubles on every growth.
+// Virtual pools add blocks of the same size until the chunks fit
+static void Grow(TMMemoryPool *memoryPool, unsigned int minChunkCount) {
+    if(memoryPool->reserve) {
+        unsigned int target = memoryPool->freeCount + minChunkCount;
+        while(memoryPool->freeCount < target && AddVirtualBlock(memoryPool)) {}
+        return;
+    }
+    unsigned int chunkCount = memoryPool->chunkCount > memoryPool->numChunk ? memoryPool->chunkCount : memoryPool->numChunk;
+    if(chunkCount < minChunkCount) chunkCount = minChunkCount;
+    AddBlock(memoryPool, chunkCount);
+}
+
+static void *VirtualAlloc(TMMemoryPool *memoryPool) {
+    if(!memoryPool->freeBlocks) {
+        Grow(memoryPool, 1);
+        if(!memoryPool->freeBlocks) return NULL;
+    }
+    TMMemoryPoolBlock *block = memoryPool->freeBlocks;
+    unsigned char *chunk = block->head;
+    block->head = *(unsigned char **)chunk;
+    memoryPool->freeCount--;
+    if(block->usedCount++ == 0) memoryPool->emptyBlockCount--;
+    if(!block->head) UnlinkFreeBlock(memoryPool, block);
+    return (void *)chunk;
+}
+
+static void VirtualFree(TMMemoryPool *memoryPool, void *mem) {
+    unsigned char *chunk = (unsigned char *)mem;
+    TMMemoryPoolBlock *block = ChunkBlock(memoryPool, chunk);
+    if(!block->head) PushFreeBlock(memoryPool, block);
+    *(unsigned char **)chunk = block->head;
+    block->head = chunk;
+    memoryPool->freeCount++;
+    if(--block->usedCount > 0) return;
+    memoryPool->emptyBlockCount++;
+    // manuel: keep a block worth of free chunks out of this one, a pool that frees and
+    // allocates around a block border must not map and unmap it every time
+    if(memoryPool->freeCount >= block->chunkCount + memoryPool->chunksPerBlock) {
+        ReleaseBlock(memoryPool, block);
+    }
+}
+
+static TMMemoryPool *PoolCreate(unsigned int chunkSize, unsigned int numChunk, unsigned int alignment) {
+    assert(alignment <= TM_MEMORY_POOL_MAX_ALIGNMENT && (alignment & (alignment - 1)) == 0);
     TMMemoryPool *memoryPool = (TMMemoryPool *)malloc(sizeof(TMMemoryPool));
     memset(memoryPool, 0, sizeof(TMMemoryPool));
 
+    // manuel: a free chunk stores the next pointer, it needs room and alignment for it
+    if(alignment < sizeof(unsigned char *)) alignment = sizeof(unsigned char *);
+    unsigned int size = chunkSize > sizeof(unsigned char *) ? chunkSize : sizeof(unsigned char *);
     memoryPool->chunkSize = chunkSize;
-    memoryPool->numChunk = numChunk;
-
-    unsigned int blockArraySize = sizeof(unsigned char *) * (memoryPool->blockCount + 1);
-    unsigned char **newBlockArray = (unsigned char **)malloc(blockArraySize);
-
-    // alloc the memory block
-    unsigned int trueChunkSize = memoryPool->chunkSize + HEADER_SIZE;
-    unsigned int blockSize = trueChunkSize * memoryPool->numChunk;
-    unsigned char *newBlock = (unsigned char *)malloc(blockSize);
-    newBlockArray[memoryPool->blockCount++] = newBlock;
-
-    // initialize the free list
-    unsigned char *current = newBlock;
-    unsigned char *end = newBlock + blockSize;
-    while(current != end) {
-        unsigned char *next = current + trueChunkSize;
-        unsigned char **header = (unsigned char **)current;
-        *header = (next < end) ? next : NULL;
-        current = next;
+    memoryPool->numChunk = numChunk > 0 ? numChunk : 1;
+    memoryPool->alignment = alignment;
+    memoryPool->stride = (size + alignment - 1) & ~(alignment - 1);
+    return memoryPool;
+}
+
+TM_EXPORT TMMemoryPool *TMMemoryPoolCreate(unsigned int chunkSize, unsigned int numChunk) {
+    return TMMemoryPoolCreate(chunkSize, numChunk, TM_MEMORY_POOL_DEFAULT_ALIGNMENT);
+}
+
+TM_EXPORT TMMemoryPool *TMMemoryPoolCreate(unsigned int chunkSize, unsigned int numChunk, unsigned int alignment) {
+    TMMemoryPool *memoryPool = PoolCreate(chunkSize, numChunk, alignment);
+    AddBlock(memoryPool, memoryPool->numChunk);
+    return memoryPool;
+}
+
+TM_EXPORT TMMemoryPool *TMMemoryPoolCreateVirtual(unsigned int chunkSize, unsigned int numChunk, unsigned int alignment,
+                                                  size_t reserveSize) {
+    TMMemoryPool *memoryPool = PoolCreate(chunkSize, numChunk, alignment);
+
+    // manuel: power of two blocks, finding the block of a chunk is a shift
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t blockSize = pageSize;
+    memoryPool->blockShift = __builtin_ctzl(pageSize);
+    while(blockSize < (size_t)memoryPool->stride * memoryPool->numChunk) {
+        blockSize <<= 1;
+        memoryPool->blockShift++;
     }
-    memoryPool->head = newBlock;
-    memoryPool->blockArray = newBlockArray;
+    memoryPool->chunksPerBlock = (unsigned int)(blockSize / memoryPool->stride);
+    memoryPool->blockCapacity = (unsigned int)(reserveSize >> memoryPool->blockShift);
+    if(memoryPool->blockCapacity == 0) memoryPool->blockCapacity = 1;
+    memoryPool->reserveSize = (size_t)memoryPool->blockCapacity << memoryPool->blockShift;
+    memoryPool->blockArray = (TMMemoryPoolBlock *)malloc(sizeof(TMMemoryPoolBlock) * memoryPool->blockCapacity);
 
+    // address space only, nothing is backed until a block is mapped read / write
+    void *reserve = mmap(NULL, memoryPool->reserveSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(reserve == MAP_FAILED) {
+        free(memoryPool->blockArray);
+        free(memoryPool);
+        return NULL;
+    }
+    memoryPool->reserve = (unsigned char *)reserve;
+    AddVirtualBlock(memoryPool);
     return memoryPool;
 }
 
 TM_EXPORT void TMMemoryPoolDestroy(TMMemoryPool *memoryPool) {
-    for(int i = 0; i < memoryPool->blockCount; ++i) {
-        free(memoryPool->blockArray[i]);
+    if(memoryPool->reserve) {
+        munmap(memoryPool->reserve, memoryPool->reserveSize);
+    } else {
+        for(unsigned int i = 0; i < memoryPool->blockCount; ++i) {
+            free(memoryPool->blockArray[i].memory);
+        }
     }
     free(memoryPool->blockArray);
     free(memoryPool);
 }
 
 TM_EXPORT void *TMMemoryPoolAlloc(TMMemoryPool *memoryPool) {
-    if(memoryPool->head) {
-        unsigned char *chunk = memoryPool->head;
-        unsigned char **next = (unsigned char **)chunk;
-        memoryPool->head = *next;
-        unsigned char *data = chunk + HEADER_SIZE;
-        return (void *)data;
+    if(memoryPool->reserve) return VirtualAlloc(memoryPool);
+    if(!memoryPool->head) {
+        Grow(memoryPool, 1);
+        if(!memoryPool->head) return NULL;
+    }
+    unsigned char *chunk = memoryPool->head;
+    memoryPool->head = *(unsigned char **)chunk;
+    memoryPool->freeCount--;
+    return (void *)chunk;
+}
+
+TM_EXPORT void TMMemoryPoolFree(TMMemoryPool *memoryPool, void *mem) {
+    if(memoryPool->reserve) {
+        VirtualFree(memoryPool, mem);
+        return;
     }
+    unsigned char *chunk = (unsigned char *)mem;
+    *(unsigned char **)chunk = memoryPool->head;
+    memoryPool->head = chunk;
+    memoryPool->freeCount++;
+}
 
-    // grow the blockArray
-    unsigned int blockArraySize = sizeof(unsigned char *) * (memoryPool->blockCount + 1);
-    unsigned char **newBlockArray = (unsigned char **)malloc(blockArraySize);
+TM_EXPORT void TMMemoryPoolReserve(TMMemoryPool *memoryPool, unsigned int count) {
+    if(memoryPool->freeCount >= count) return;
+    Grow(memoryPool, count - memoryPool->freeCount);
+}
 
-    // copy any existent block
-    for(int i = 0; i < memoryPool->blockCount; ++i) {
-        newBlockArray[i] = memoryPool->blockArray[i];
+TM_EXPORT bool TMMemoryPoolAllocBulk(TMMemoryPool *memoryPool, void **mems, unsigned int count) {
+    TMMemoryPoolReserve(memoryPool, count);
+    if(memoryPool->freeCount < count) return false;
+    if(memoryPool->reserve) {
+        for(unsigned int i = 0; i < count; ++i) mems[i] = VirtualAlloc(memoryPool);
+        return true;
     }
-    free(memoryPool->blockArray);
+    unsigned char *chunk = memoryPool->head;
+    for(unsigned int i = 0; i < count; ++i) {
+        mems[i] = (void *)chunk;
+        chunk = *(unsigned char **)chunk;
+    }
+    memoryPool->head = chunk;
+    memoryPool->freeCount -= count;
+    return true;
+}
 
-    // alloc the new memory block
-    unsigned int trueChunkSize = memoryPool->chunkSize + HEADER_SIZE;
-    unsigned int blockSize = trueChunkSize * memoryPool->numChunk;
-    unsigned char *newBlock = (unsigned char *)malloc(blockSize);
-    newBlockArray[memoryPool->blockCount++] = newBlock;
-
-    // initialize the free list
-    unsigned char *current = newBlock;
-    unsigned char *end = newBlock + blockSize;
-    while(current != end) {
-        unsigned char *next = current + trueChunkSize;
-        unsigned char **header = (unsigned char **)current;
-        *header = (next < end) ? next : NULL;
-        current = next;
+TM_EXPORT void TMMemoryPoolFreeBulk(TMMemoryPool *memoryPool, void **mems, unsigned int count) {
+    if(count == 0) return;
+    if(memoryPool->reserve) {
+        for(unsigned int i = 0; i < count; ++i) VirtualFree(memoryPool, mems[i]);
+        return;
     }
-    memoryPool->head = newBlock;
-    memoryPool->blockArray = newBlockArray;
+    // manuel: chain them in order and splice the chain in front of the list
+    for(unsigned int i = 0; i < count - 1; ++i) {
+        *(unsigned char **)mems[i] = (unsigned char *)mems[i + 1];
+    }
+    *(unsigned char **)mems[count - 1] = memoryPool->head;
+    memoryPool->head = (unsigned char *)mems[0];
+    memoryPool->freeCount += count;
+}
 
-    unsigned char *chunk = memoryPool->head;
-    unsigned char **next = (unsigned char **)chunk;
-    memoryPool->head = *next;
-    unsigned char *data = chunk + HEADER_SIZE;
-    return data;
+TM_EXPORT void TMMemoryPoolReset(TMMemoryPool *memoryPool) {
+    memoryPool->head = NULL;
+    memoryPool->freeBlocks = NULL;
+    memoryPool->freeCount = 0;
+    memoryPool->emptyBlockCount = 0;
+    // the first block ends up in front, so it is used first again
+    for(unsigned int i = memoryPool->blockCount; i > 0; --i) {
+        TMMemoryPoolBlock *block = memoryPool->blockArray + i - 1;
+        if(!block->committed) continue;
+        if(memoryPool->reserve) VirtualBlockLinkChunks(memoryPool, block);
+        else BlockLinkChunks(memoryPool, block);
+    }
 }
 
-TM_EXPORT void TMMemoryPoolFree(TMMemoryPool *memoryPool, void *mem) {
-    unsigned char *chunk = ((unsigned char *)mem - HEADER_SIZE);
-    unsigned char **next = (unsigned char **)chunk;
-    *next = memoryPool->head;
-    memoryPool->head = chunk;
-}
\ No newline at end of file
+TM_EXPORT void TMMemoryPoolTrim(TMMemoryPool *memoryPool) {
+    if(!memoryPool->reserve) return;
+    for(unsigned int i = 0; i < memoryPool->blockCount && memoryPool->emptyBlockCount > 0; ++i) {
+        TMMemoryPoolBlock *block = memoryPool->blockArray + i;
+        if(block->committed && block->usedCount == 0) ReleaseBlock(memoryPool, block);
+    }
+}
@@ -5,19 +5,81 @@
 #ifndef MY_APPLICATION_TM_MEMORY_POOL_H
 #define MY_APPLICATION_TM_MEMORY_POOL_H
 
-#define HEADER_SIZE sizeof(unsigned char *)
+#include <stddef.h>
 
+// chunks start at a multiple of the alignment, it is a power of two up to the cache line
+#define TM_MEMORY_POOL_DEFAULT_ALIGNMENT 16
+#define TM_MEMORY_POOL_MAX_ALIGNMENT 64
+
+struct TMMemoryPoolBlock {
+    unsigned char *memory;
+    unsigned int chunkCount;
+    // only kept by virtual pools: chunks handed out, if the pages are mapped, the free
+    // chunks of the block and the links of the blocks with free chunks
+    unsigned int usedCount;
+    bool committed;
+    unsigned char *head;
+    TMMemoryPoolBlock *prevFree;
+    TMMemoryPoolBlock *nextFree;
+};
+
+// Fixed size chunks carved out of big blocks. A free chunk holds the link to the next
+// free chunk in its first bytes, so chunks have no header: they are the chunk size
+// rounded up to the alignment and packed one after the other.
+// When the list runs out the pool adds a block as big as everything it already has,
+// so the capacity doubles and the number of blocks stays small.
+// A virtual pool reserves address space once and maps blocks of the same size inside
+// it as it grows. Every block keeps its own free list, so when a free leaves a block
+// with no live chunk and the rest of the pool has at least a block worth of free
+// chunks, its pages go back to the system without looking at the other blocks.
 struct TMMemoryPool {
-    unsigned char **blockArray;
+    TMMemoryPoolBlock *blockArray;
+    // free list of the pool, virtual pools use freeBlocks and the list of each block
     unsigned char *head;
     unsigned int chunkSize;
     unsigned int numChunk;
+    unsigned int alignment;
+    // distance between two chunks
+    unsigned int stride;
     unsigned int blockCount;
+    unsigned int blockCapacity;
+    // chunks in all the blocks and chunks in the free list
+    unsigned int chunkCount;
+    unsigned int freeCount;
+
+    // virtual pools only, reserve is NULL otherwise. Block i starts at reserve + (i << blockShift)
+    unsigned char *reserve;
+    size_t reserveSize;
+    unsigned int blockShift;
+    unsigned int chunksPerBlock;
+    // committed blocks with no live chunk
+    unsigned int emptyBlockCount;
+    // blocks with at least one free chunk, allocations come from the first one
+    TMMemoryPoolBlock *freeBlocks;
 };
 
+// numChunk is the size of the first block
 TMMemoryPool *TMMemoryPoolCreate(unsigned int chunkSize, unsigned int numChunk);
+TMMemoryPool *TMMemoryPoolCreate(unsigned int chunkSize, unsigned int numChunk, unsigned int alignment);
+// blocks of at least numChunk chunks rounded up to a power of two number of pages,
+// reserveSize bytes of address space are reserved but only the blocks in use are mapped.
+// Alloc returns NULL when the reservation is full. Returns NULL when the address space
+// can't be reserved
+TMMemoryPool *TMMemoryPoolCreateVirtual(unsigned int chunkSize, unsigned int numChunk, unsigned int alignment,
+                                        size_t reserveSize);
 void TMMemoryPoolDestroy(TMMemoryPool *memoryPool);
 void *TMMemoryPoolAlloc(TMMemoryPool *memoryPool);
 void TMMemoryPoolFree(TMMemoryPool *memoryPool, void *mem);
+// makes sure the next count allocations don't need a new block
+void TMMemoryPoolReserve(TMMemoryPool *memoryPool, unsigned int count);
+// fills mems with count chunks / gives back the count chunks in mems. AllocBulk returns
+// false and takes nothing when the pool can't give count chunks (a full virtual pool)
+bool TMMemoryPoolAllocBulk(TMMemoryPool *memoryPool, void **mems, unsigned int count);
+void TMMemoryPoolFreeBulk(TMMemoryPool *memoryPool, void **mems, unsigned int count);
+// every chunk is free again, the blocks are kept. Pointers from before are invalid
+void TMMemoryPoolReset(TMMemoryPool *memoryPool);
+// virtual pools: gives the pages of every block with no live chunk back to the system,
+// the slack Free keeps included. Does nothing on other pools
+void TMMemoryPoolTrim(TMMemoryPool *memoryPool);
 
 #endif //MY_APPLICATION_TM_MEMORY_POOL_H
@@ -0,0 +1,116 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_rect_packer.h"
+
+#include <stdlib.h>
+#include <memory.h>
+
+TMRectPacker *TMRectPackerCreate(int width, int height) {
+    TMRectPacker *packer = (TMRectPacker *)malloc(sizeof(TMRectPacker));
+    memset(packer, 0, sizeof(TMRectPacker));
+    packer->width = width;
+    packer->height = height;
+    packer->nodesCapacity = 64;
+    packer->nodes = (TMRectPackerNode *)malloc(sizeof(TMRectPackerNode) * packer->nodesCapacity);
+    TMRectPackerReset(packer);
+    return packer;
+}
+
+void TMRectPackerDestroy(TMRectPacker *packer) {
+    free(packer->nodes);
+    free(packer);
+}
+
+void TMRectPackerReset(TMRectPacker *packer) {
+    packer->nodesCount = 1;
+    packer->nodes[0].x = 0;
+    packer->nodes[0].y = 0;
+    packer->nodes[0].width = packer->width;
+}
+
+// y where a rect of the given width can sit if placed at node index, -1 if it does not fit
+static int SkylineFit(TMRectPacker *packer, unsigned int index, int width, int height) {
+    int x = packer->nodes[index].x;
+    if(x + width > packer->width) return -1;
+    int y = 0;
+    int widthLeft = width;
+    while(widthLeft > 0) {
+        if(index == packer->nodesCount) return -1;
+        TMRectPackerNode *node = packer->nodes + index;
+        if(node->y > y) y = node->y;
+        if(y + height > packer->height) return -1;
+        widthLeft -= node->width;
+        ++index;
+    }
+    return y;
+}
+
+static void NodeInsert(TMRectPacker *packer, unsigned int index, TMRectPackerNode node) {
+    if(packer->nodesCount == packer->nodesCapacity) {
+        packer->nodesCapacity *= 2;
+        packer->nodes = (TMRectPackerNode *)realloc(packer->nodes, sizeof(TMRectPackerNode) * packer->nodesCapacity);
+    }
+    memmove(packer->nodes + index + 1, packer->nodes + index,
+            sizeof(TMRectPackerNode) * (packer->nodesCount - index));
+    packer->nodes[index] = node;
+    packer->nodesCount++;
+}
+
+static void NodeRemove(TMRectPacker *packer, unsigned int index) {
+    memmove(packer->nodes + index, packer->nodes + index + 1,
+            sizeof(TMRectPackerNode) * (packer->nodesCount - index - 1));
+    packer->nodesCount--;
+}
+
+bool TMRectPackerPack(TMRectPacker *packer, int width, int height, int *x, int *y) {
+    // find the position with the lowest top edge, on ties the narrowest node
+    int bestIndex = -1;
+    int bestTop = packer->height + 1;
+    int bestWidth = packer->width + 1;
+    for(unsigned int i = 0; i < packer->nodesCount; ++i) {
+        int fitY = SkylineFit(packer, i, width, height);
+        if(fitY < 0) continue;
+        int top = fitY + height;
+        if(top < bestTop || (top == bestTop && packer->nodes[i].width < bestWidth)) {
+            bestIndex = (int)i;
+            bestTop = top;
+            bestWidth = packer->nodes[i].width;
+        }
+    }
+    if(bestIndex < 0) return false;
+
+    TMRectPackerNode node;
+    node.x = packer->nodes[bestIndex].x;
+    node.y = bestTop;
+    node.width = width;
+    *x = node.x;
+    *y = bestTop - height;
+    NodeInsert(packer, bestIndex, node);
+
+    // shrink or remove the nodes now covered by the new one
+    unsigned int i = bestIndex + 1;
+    while(i < packer->nodesCount) {
+        TMRectPackerNode *prev = packer->nodes + i - 1;
+        TMRectPackerNode *curr = packer->nodes + i;
+        int prevRight = prev->x + prev->width;
+        if(curr->x >= prevRight) break;
+        int shrink = prevRight - curr->x;
+        curr->x += shrink;
+        curr->width -= shrink;
+        if(curr->width > 0) break;
+        NodeRemove(packer, i);
+    }
+
+    // merge neighbours at the same height
+    for(i = 0; i + 1 < packer->nodesCount;) {
+        if(packer->nodes[i].y == packer->nodes[i + 1].y) {
+            packer->nodes[i].width += packer->nodes[i + 1].width;
+            NodeRemove(packer, i + 1);
+        } else {
+            ++i;
+        }
+    }
+    return true;
+}
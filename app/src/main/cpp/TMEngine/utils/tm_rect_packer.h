@@ -0,0 +1,31 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_RECT_PACKER_H
+#define MY_APPLICATION_TM_RECT_PACKER_H
+
+// skyline bottom-left packer, places rects in a width x height area.
+// Has no platform dependencies
+
+struct TMRectPackerNode {
+    int x;
+    int y;
+    int width;
+};
+
+struct TMRectPacker {
+    TMRectPackerNode *nodes;
+    unsigned int nodesCount;
+    unsigned int nodesCapacity;
+    int width;
+    int height;
+};
+
+TMRectPacker *TMRectPackerCreate(int width, int height);
+void TMRectPackerDestroy(TMRectPacker *packer);
+void TMRectPackerReset(TMRectPacker *packer);
+// returns false if the rect does not fit
+bool TMRectPackerPack(TMRectPacker *packer, int width, int height, int *x, int *y);
+
+#endif //MY_APPLICATION_TM_RECT_PACKER_H
@@ -0,0 +1,123 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_shader_cache.h"
+#include "tm_arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// File layout, little endian:
+//   magic(4) | version(u32) | key(u64) | binaryFormat(u32) | binarySize(u32) | checksum(u32) | binary
+#define TM_SHADER_CACHE_MAGIC "TMPB"
+#define TM_SHADER_CACHE_VERSION 1
+#define TM_SHADER_CACHE_HEADER_SIZE 28
+#define TM_SHADER_CACHE_MAX_BINARY (16 * 1024 * 1024)
+
+#define TM_FNV_OFFSET 0xcbf29ce484222325ull
+#define TM_FNV_PRIME 0x100000001b3ull
+
+static uint64_t Fnv1a(uint64_t hash, const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    for(size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= TM_FNV_PRIME;
+    }
+    return hash;
+}
+
+static void WriteU32(unsigned char *dst, unsigned int value) {
+    for(int i = 0; i < 4; ++i) dst[i] = (unsigned char)(value >> (i * 8));
+}
+
+static unsigned int ReadU32(const unsigned char *src) {
+    return (unsigned int)src[0] | ((unsigned int)src[1] << 8) |
+           ((unsigned int)src[2] << 16) | ((unsigned int)src[3] << 24);
+}
+
+uint64_t TMShaderCacheKey(const char *vertSource, const char *fragSource, const char *driver) {
+    // the terminators are hashed too so moving text from one source to the other changes the key
+    uint64_t hash = TM_FNV_OFFSET;
+    hash = Fnv1a(hash, vertSource, strlen(vertSource) + 1);
+    hash = Fnv1a(hash, fragSource, strlen(fragSource) + 1);
+    hash = Fnv1a(hash, driver, strlen(driver) + 1);
+    return hash;
+}
+
+void TMShaderCachePath(const char *directory, const char *vertPath, const char *fragPath,
+                       char *path, size_t pathSize) {
+    uint64_t hash = TM_FNV_OFFSET;
+    hash = Fnv1a(hash, vertPath, strlen(vertPath) + 1);
+    hash = Fnv1a(hash, fragPath, strlen(fragPath) + 1);
+    snprintf(path, pathSize, "%s/shader_%016llx.bin", directory, (unsigned long long)hash);
+}
+
+bool TMShaderCacheLoad(const char *path, uint64_t key, TMArena *arena, unsigned int *binaryFormat,
+                       void **binary, size_t *binarySize) {
+    *binary = NULL;
+    *binarySize = 0;
+    FILE *file = fopen(path, "rb");
+    if(!file) return false;
+
+    unsigned char header[TM_SHADER_CACHE_HEADER_SIZE];
+    bool result = false;
+    if(fread(header, 1, sizeof(header), file) == sizeof(header) &&
+       memcmp(header, TM_SHADER_CACHE_MAGIC, 4) == 0 &&
+       ReadU32(header + 4) == TM_SHADER_CACHE_VERSION &&
+       ReadU32(header + 8) == (unsigned int)key &&
+       ReadU32(header + 12) == (unsigned int)(key >> 32)) {
+        unsigned int format = ReadU32(header + 16);
+        unsigned int size = ReadU32(header + 20);
+        unsigned int checksum = ReadU32(header + 24);
+        if(size > 0 && size <= TM_SHADER_CACHE_MAX_BINARY) {
+            TMArenaSavepoint savepoint = TMArenaSave(arena);
+            void *data = TMArenaAlloc(arena, size);
+            // the file must end right after the binary
+            if(fread(data, 1, size, file) == size && fgetc(file) == EOF &&
+               (unsigned int)Fnv1a(TM_FNV_OFFSET, data, size) == checksum) {
+                *binaryFormat = format;
+                *binary = data;
+                *binarySize = size;
+                result = true;
+            } else {
+                TMArenaRollback(savepoint);
+            }
+        }
+    }
+    fclose(file);
+    return result;
+}
+
+bool TMShaderCacheStore(const char *path, uint64_t key, unsigned int binaryFormat,
+                        const void *binary, size_t binarySize) {
+    if(binarySize == 0 || binarySize > TM_SHADER_CACHE_MAX_BINARY) return false;
+
+    char tempPath[512];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    FILE *file = fopen(tempPath, "wb");
+    if(!file) return false;
+
+    unsigned char header[TM_SHADER_CACHE_HEADER_SIZE];
+    memcpy(header, TM_SHADER_CACHE_MAGIC, 4);
+    WriteU32(header + 4, TM_SHADER_CACHE_VERSION);
+    WriteU32(header + 8, (unsigned int)key);
+    WriteU32(header + 12, (unsigned int)(key >> 32));
+    WriteU32(header + 16, binaryFormat);
+    WriteU32(header + 20, (unsigned int)binarySize);
+    WriteU32(header + 24, (unsigned int)Fnv1a(TM_FNV_OFFSET, binary, binarySize));
+
+    bool written = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+                   fwrite(binary, 1, binarySize, file) == binarySize;
+    written = (fclose(file) == 0) && written;
+    if(!written || rename(tempPath, path) != 0) {
+        remove(tempPath);
+        return false;
+    }
+    return true;
+}
+
+void TMShaderCacheRemove(const char *path) {
+    remove(path);
+}
@@ -0,0 +1,34 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_SHADER_CACHE_H
+#define MY_APPLICATION_TM_SHADER_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct TMArena;
+
+// Program binaries saved to disk so the next launch can skip compiling.
+// One file per program, named after the paths of its sources. The file stores a
+// key that hashes both sources and the driver string and a checksum of the binary,
+// a file that does not match is treated as a miss. After an edited shader or a
+// driver update the program compiles again and its new binary replaces the stale
+// one, so the directory never holds more than one file per program.
+// No GL here, the renderer does the GL side.
+
+uint64_t TMShaderCacheKey(const char *vertSource, const char *fragSource, const char *driver);
+// <directory>/shader_<hash of the paths>.bin
+void TMShaderCachePath(const char *directory, const char *vertPath, const char *fragPath,
+                       char *path, size_t pathSize);
+// binary is allocated in the arena. Returns false on a missing or invalid file
+bool TMShaderCacheLoad(const char *path, uint64_t key, TMArena *arena, unsigned int *binaryFormat,
+                       void **binary, size_t *binarySize);
+// writes to <path>.tmp and renames it, a crash never leaves half a file. A .tmp left
+// behind is overwritten by the next store of the same program
+bool TMShaderCacheStore(const char *path, uint64_t key, unsigned int binaryFormat,
+                        const void *binary, size_t binarySize);
+void TMShaderCacheRemove(const char *path);
+
+#endif //MY_APPLICATION_TM_SHADER_CACHE_H
@@ -1,6 +1,9 @@
 #include <jni.h>
 
 #include "TMEngine/tm_input.h"
+#include "TMEngine/tm_render_thread.h"
+#include "TMEngine/tm_run_loop.h"
+#include "TMEngine/tm_clock.h"
 #include "Game/game.h"
 
 
@@ -12,6 +15,120 @@ extern "C" {
 
 #include <game-activity/native_app_glue/android_native_app_glue.c>
 
+#ifdef TM_RENDER_THREAD
+
+static void RenderThreadInitialize(void *userData, TMRenderer *renderer) {
+    GameInitializeRenderer((GameState *)userData, renderer);
+}
+
+static void RenderThreadShutdown(void *userData, TMRenderer *renderer) {
+    GameShutdownRenderer((GameState *)userData, renderer);
+}
+
+static void RenderThreadRender(void *userData, TMRenderer *renderer, void *packet) {
+    GameRenderFrame((GameState *)userData, (GameFrame *)packet);
+}
+
+static TMRenderThread *gRenderThread;
+
+#endif
+
+static TMRunLoop gRunLoop;
+static TMInput gInput;
+static TMClock gClock;
+
+// manuel: the first window creates everything, later ones only get a new surface
+static void OnWindowCreated(void *userData) {
+    android_app *pApp = (android_app *)userData;
+    if (pApp->userData) {
+#ifdef TM_RENDER_THREAD
+        TMRenderThreadSurfaceCreate(gRenderThread);
+#else
+        GameWindowCreated((GameState *) pApp->userData, pApp);
+#endif
+        return;
+    }
+    pApp->userData = (void *) malloc(sizeof(GameState));
+    GameState *gameState = (GameState *) pApp->userData;
+#ifdef TM_RENDER_THREAD
+    GameInitializeSimulation(gameState);
+    TMRenderThreadCallbacks callbacks{};
+    callbacks.userData = gameState;
+    callbacks.initialize = RenderThreadInitialize;
+    callbacks.shutdown = RenderThreadShutdown;
+    callbacks.render = RenderThreadRender;
+    // manuel: the scene has its own depth buffer, the window only needs color
+    gRenderThread = TMRenderThreadCreate(callbacks, sizeof(GameFrame), 0);
+    TMRenderThreadStart(gRenderThread, pApp);
+#else
+    GameInitialize(gameState, pApp, pApp->activity->assetManager);
+#endif
+}
+
+static void OnWindowDestroyed(void *userData) {
+    android_app *pApp = (android_app *)userData;
+    if (pApp->userData) {
+#ifdef TM_RENDER_THREAD
+        // the render thread releases the surface before the window goes away
+        TMRenderThreadSurfaceDestroy(gRenderThread);
+#else
+        GameWindowDestroyed((GameState *) pApp->userData);
+#endif
+    }
+}
+
+static void OnDestroyed(void *userData) {
+    android_app *pApp = (android_app *)userData;
+    if (pApp->userData) {
+#ifdef TM_RENDER_THREAD
+        TMRenderThreadDestroy(gRenderThread);
+        gRenderThread = NULL;
+        GameShutdownSimulation((GameState *) pApp->userData);
+#else
+        GameShutdown((GameState *) pApp->userData);
+#endif
+        free(pApp->userData);
+        pApp->userData = NULL;
+    }
+}
+
+// manuel: the time spent in the background is not simulated
+static void OnResumed(void *userData) {
+    TMClockReset(&gClock);
+}
+
+static void OnFrame(void *userData) {
+    android_app *pApp = (android_app *)userData;
+    if (!pApp->userData) return;
+    GameState *gameState = (GameState *)pApp->userData;
+
+    TMInputHandle(&gInput, pApp);
+
+#ifdef TM_RENDER_THREAD
+    gameState->width = TMRenderThreadGetWidth(gRenderThread);
+    gameState->height = TMRenderThreadGetHeight(gRenderThread);
+#endif
+
+    // manuel: run the simulation steps that fit in the time since the last frame
+    int steps = TMClockTick(&gClock);
+    for(int i = 0; i < steps; ++i) {
+        GameUpdate(gameState, &gInput, TMClockGetStepTime(&gClock));
+    }
+
+#ifdef TM_RENDER_THREAD
+    // build the next frame while the render thread draws the previous one
+    GameFrame *frame = (GameFrame *)TMRenderThreadBeginFrame(gRenderThread);
+    GameBuildFrame(gameState, frame, TMClockGetAlpha(&gClock));
+    TMRenderThreadEndFrame(gRenderThread);
+#else
+    GameRender(gameState, TMClockGetAlpha(&gClock));
+#endif
+
+    for(int i = 0; i < 16; ++i) {
+        gInput.lastMotions[i] = gInput.currMotions[i];
+    }
+}
+
 /*!
  * Handles commands sent to this Android application
  * @param pApp the app the commands are coming from
@@ -21,31 +138,37 @@ extern "C" {
 void handle_cmd(android_app *pApp, int32_t cmd) {
     switch (cmd) {
         case APP_CMD_INIT_WINDOW: {
-            pApp->userData = (void *) malloc(sizeof(GameState));
-            GameState *gameState = (GameState *) pApp->userData;
-            GameInitialize(gameState, pApp, pApp->activity->assetManager);
+            TMRunLoopOnWindowCreated(&gRunLoop);
         } break;
         case APP_CMD_TERM_WINDOW: {
-            if (pApp->userData) {
-                GameState *gameState = (GameState *) pApp->userData;
-                GameShutdown(gameState);
-                free(pApp->userData);
-                pApp->userData = NULL;
-            }
+            TMRunLoopOnWindowDestroyed(&gRunLoop);
+        } break;
+        case APP_CMD_RESUME: {
+            TMRunLoopOnResume(&gRunLoop);
+        } break;
+        case APP_CMD_PAUSE: {
+            TMRunLoopOnPause(&gRunLoop);
+        } break;
+        case APP_CMD_DESTROY: {
+            TMRunLoopOnDestroy(&gRunLoop);
         } break;
         default:
             break;
     }
 }
 
-void android_poll_events(android_app *pApp) {
+// waits for one event of the app looper and dispatches it
+static bool AndroidLooperPoll(void *userData, int timeoutMs) {
+    android_app *pApp = (android_app *)userData;
     int events;
-    android_poll_source *pSource;
-    if (ALooper_pollAll(0, nullptr, &events, (void **) &pSource) >= 0) {
-        if (pSource) {
-            pSource->process(pApp, pSource);
-        }
+    android_poll_source *pSource = NULL;
+    int result = ALooper_pollOnce(timeoutMs, nullptr, &events, (void **) &pSource);
+    if (result == ALOOPER_POLL_CALLBACK) return true;
+    if (result < 0) return false;
+    if (pSource) {
+        pSource->process(pApp, pSource);
     }
+    return true;
 }
 
 /*!
@@ -55,26 +178,25 @@ void android_main(struct android_app *pApp) {
     // register an event handler for Android events
     pApp->onAppCmd = handle_cmd;
 
-    TMInput input;
-    TMInputInitialize(&input);
-
-    while(!pApp->destroyRequested) {
-        android_poll_events(pApp);
-        if(pApp->userData) {
-            GameState *gameState = (GameState *)pApp->userData;
-
-            TMInputHandle(&input, pApp);
-
-            GameUpdate(gameState, &input, 0);
-
-            GameRender(gameState);
-
-            for(int i = 0; i < 16; ++i) {
-                input.lastMotions[i] = input.currMotions[i];
-            }
-        }
+    TMInputInitialize(&gInput);
+    TMClockInitialize(&gClock, GAME_SIMULATION_STEP, GAME_SIMULATION_MAX_STEPS);
+
+    TMRunLoopLooper looper{};
+    looper.userData = pApp;
+    looper.poll = AndroidLooperPoll;
+    TMRunLoopHooks hooks{};
+    hooks.userData = pApp;
+    hooks.windowCreated = OnWindowCreated;
+    hooks.windowDestroyed = OnWindowDestroyed;
+    hooks.resumed = OnResumed;
+    hooks.destroyed = OnDestroyed;
+    hooks.frame = OnFrame;
+    // manuel: in the background wake up now and then even without events
+    TMRunLoopInitialize(&gRunLoop, looper, hooks, TM_RUN_LOOP_DEFAULT_IDLE_TIMEOUT_MS);
+
+    while (!pApp->destroyRequested && TMRunLoopStep(&gRunLoop)) {
     }
-
+    TMRunLoopOnDestroy(&gRunLoop);
 }
 
 
@@ -0,0 +1,172 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// TMArena test. Checks the alignment of every allocation, that data survives the
+// arena growing, that nested savepoints give back exactly what came after them and
+// keep the biggest block for the next growth, that a reset merges the chained blocks
+// so the same work fits without growing, that a frame arena keeps the last frame
+// alive, and that every thread gets its own scratch arena. Run it under ASan to see
+// the blocks of the threads go away with them.
+// usage: tm_arena_test
+
+#include "utils/tm_arena.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <thread>
+#include <atomic>
+
+#define TEST_ARENA_SIZE 1024
+#define TEST_THREADS 4
+
+static bool Aligned(void *memory, size_t alignment) {
+    return ((uintptr_t)memory & (alignment - 1)) == 0;
+}
+
+static bool Filled(const unsigned char *memory, size_t size, unsigned char value) {
+    for(size_t i = 0; i < size; ++i) {
+        if(memory[i] != value) return false;
+    }
+    return true;
+}
+
+static void TestAlignment() {
+    TMArena *arena = TMArenaCreate(TEST_ARENA_SIZE);
+    bool aligned = true;
+    for(int i = 0; i < 1000; ++i) {
+        size_t alignment = (size_t)1 << (i % 8);
+        void *memory = TMArenaAllocAligned(arena, (size_t)(i % 37) + 1, alignment);
+        if(!memory || !Aligned(memory, alignment)) aligned = false;
+        if(!Aligned(TMArenaAlloc(arena, 3), TM_ARENA_DEFAULT_ALIGNMENT)) aligned = false;
+    }
+    Check(aligned, "every alignment up to 128 across blocks");
+    double *doubles = TM_ARENA_PUSH_ARRAY(arena, double, 5);
+    Check(Aligned(doubles, alignof(double)), "TM_ARENA_PUSH_ARRAY aligns to the type");
+    TMArenaDestroy(arena);
+}
+
+static void TestGrowth() {
+    TMArena *arena = TMArenaCreate(TEST_ARENA_SIZE);
+    unsigned char *chunks[64];
+    for(int i = 0; i < 64; ++i) {
+        chunks[i] = (unsigned char *)TMArenaAlloc(arena, 100);
+        memset(chunks[i], i, 100);
+    }
+    unsigned char *big = (unsigned char *)TMArenaAlloc(arena, TEST_ARENA_SIZE * 20);
+    memset(big, 0xAB, TEST_ARENA_SIZE * 20);
+    bool intact = Filled(big, TEST_ARENA_SIZE * 20, 0xAB);
+    for(int i = 0; i < 64; ++i) {
+        if(!Filled(chunks[i], 100, (unsigned char)i)) intact = false;
+    }
+    Check(intact, "data survives the arena growing");
+    Check(arena->size > TEST_ARENA_SIZE * 20, "the arena grew");
+
+    // manuel: the same work after a reset fits in the one merged block
+    size_t size = arena->size;
+    TMArenaReset(arena);
+    TMArenaBlock *block = arena->current;
+    Check(arena->size == size && TMArenaAlloc(arena, size - 256) && arena->current == block,
+          "reset merges the blocks in one");
+    TMArenaReset(arena);
+    for(int i = 0; i < 64; ++i) TMArenaAlloc(arena, 100);
+    TMArenaAlloc(arena, TEST_ARENA_SIZE * 20);
+    Check(arena->current == block && arena->size == size, "the same work does not grow again");
+    TMArenaDestroy(arena);
+}
+
+static void TestSavepoints() {
+    TMArena *arena = TMArenaCreate(TEST_ARENA_SIZE);
+    TMArenaAlloc(arena, 10);
+    TMArenaSavepoint outer = TMArenaSave(arena);
+    unsigned char *first = (unsigned char *)TMArenaAlloc(arena, 100);
+    memset(first, 1, 100);
+    TMArenaSavepoint inner = TMArenaSave(arena);
+    void *second = TMArenaAlloc(arena, 200);
+    TMArenaRollback(inner);
+    Check(TMArenaAlloc(arena, 200) == second && Filled(first, 100, 1), "inner rollback keeps what came before");
+
+    // rolling back past a growth gives the blocks back but keeps the biggest one
+    size_t size = arena->size;
+    TMArenaSavepoint grown = TMArenaSave(arena);
+    for(int i = 0; i < 100; ++i) TMArenaAlloc(arena, 500);
+    TMArenaRollback(grown);
+    Check(arena->size == size && arena->current == grown.block, "rollback releases the grown blocks");
+    Check(arena->spare != NULL, "the biggest one stays as spare");
+    TMArenaAlloc(arena, 500 * 3);
+    Check(arena->spare == NULL, "the next growth takes the spare");
+
+    TMArenaRollback(outer);
+    Check(TMArenaAlloc(arena, 100) == first, "outer rollback gives everything back");
+    TMArenaDestroy(arena);
+}
+
+static void TestFrameArena() {
+    TMFrameArena *frameArena = TMFrameArenaCreate(TEST_ARENA_SIZE);
+    TMArena *arena = TMFrameArenaBegin(frameArena);
+    unsigned char *previous = (unsigned char *)TMArenaAlloc(arena, 64);
+    memset(previous, 7, 64);
+    bool kept = true;
+    bool alternates = true;
+    for(int frame = 0; frame < 10; ++frame) {
+        TMArena *next = TMFrameArenaBegin(frameArena);
+        if(next == arena || TMFrameArenaGet(frameArena) != next) alternates = false;
+        unsigned char *current = (unsigned char *)TMArenaAlloc(next, 64);
+        memset(current, 8 + frame, 64);
+        if(!Filled(previous, 64, (unsigned char)(frame == 0 ? 7 : 7 + frame))) kept = false;
+        previous = current;
+        arena = next;
+    }
+    Check(alternates, "frames alternate between the two arenas");
+    Check(kept, "the last frame is still valid during the next");
+    TMFrameArenaDestroy(frameArena);
+}
+
+static std::atomic<int> gArrived;
+static std::atomic<bool> gRelease;
+
+// manuel: the threads stay alive until main compared their arenas, the arena of a
+// thread that ended can come back from malloc for the next one
+static void ScratchThread(TMArena **result) {
+    TMArena *scratch = TMArenaGetScratch();
+    TMArenaSavepoint savepoint = TMArenaSave(scratch);
+    memset(TMArenaAlloc(scratch, TM_ARENA_SCRATCH_SIZE * 2), 1, TM_ARENA_SCRATCH_SIZE * 2);
+    TMArenaRollback(savepoint);
+    *result = TMArenaGetScratch() == scratch ? scratch : NULL;
+    gArrived.fetch_add(1);
+    while(!gRelease.load()) std::this_thread::yield();
+}
+
+static void TestScratch() {
+    TMArena *arenas[TEST_THREADS];
+    std::thread threads[TEST_THREADS];
+    gArrived.store(0);
+    gRelease.store(false);
+    for(int i = 0; i < TEST_THREADS; ++i) threads[i] = std::thread(ScratchThread, arenas + i);
+    while(gArrived.load() < TEST_THREADS) std::this_thread::yield();
+    bool same = true;
+    bool distinct = true;
+    for(int i = 0; i < TEST_THREADS; ++i) {
+        if(!arenas[i]) same = false;
+        if(arenas[i] == TMArenaGetScratch()) distinct = false;
+        for(int j = 0; j < i; ++j) {
+            if(arenas[i] == arenas[j]) distinct = false;
+        }
+    }
+    gRelease.store(true);
+    for(int i = 0; i < TEST_THREADS; ++i) threads[i].join();
+    Check(same && TMArenaGetScratch() == TMArenaGetScratch(), "a thread gets the same scratch every time");
+    Check(distinct, "each thread has its own scratch");
+}
+
+int main() {
+    TestAlignment();
+    TestGrowth();
+    TestSavepoints();
+    TestFrameArena();
+    TestScratch();
+    if(ChecksFailed()) return 1;
+    return 0;
+}
@@ -0,0 +1,136 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// Rect packer benchmark: packs sets of random sprite sized rects into one page the way
+// TMTextureAtlasBuild does, padded, aligned to 4 and tallest first, and once more in
+// the order they came in. Prints how many rects fit, the page occupancy and the time
+// per insert, and checks that no packed rect leaves the page or overlaps another one.
+// usage: tm_atlas_bench [page_size] [padding]
+
+#include "utils/tm_rect_packer.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+#define BENCH_RECTS 4096
+#define BENCH_RUNS 5
+// same as TM_TEXTURE_ATLAS_ALIGNMENT
+#define BENCH_ALIGNMENT 4
+
+struct BenchRect {
+    int width;
+    int height;
+    int x;
+    int y;
+    bool packed;
+};
+
+struct BenchSet {
+    const char *name;
+    int minSize;
+    int maxSize;
+};
+
+static int AlignUp(int value, int alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static int RandomInt(int min, int max) {
+    return min + rand() % (max - min + 1);
+}
+
+// marks every pixel a packed rect covers, a pixel marked twice is an overlap
+static bool RectsValid(BenchRect *rects, unsigned int count, int pageSize, unsigned char *coverage) {
+    memset(coverage, 0, (size_t)pageSize * pageSize);
+    for(unsigned int i = 0; i < count; ++i) {
+        BenchRect *rect = rects + i;
+        if(!rect->packed) continue;
+        if(rect->x < 0 || rect->y < 0 || rect->x + rect->width > pageSize || rect->y + rect->height > pageSize) {
+            fprintf(stderr, "rect %u (%d %d %d %d) leaves the page\n", i, rect->x, rect->y, rect->width, rect->height);
+            return false;
+        }
+        for(int y = rect->y; y < rect->y + rect->height; ++y) {
+            unsigned char *row = coverage + (size_t)y * pageSize;
+            for(int x = rect->x; x < rect->x + rect->width; ++x) {
+                if(row[x]) {
+                    fprintf(stderr, "rect %u overlaps another rect at %d %d\n", i, x, y);
+                    return false;
+                }
+                row[x] = 1;
+            }
+        }
+    }
+    return true;
+}
+
+static bool Bench(BenchSet *set, bool sorted, int pageSize, int padding, unsigned char *coverage) {
+    srand(1234);
+    BenchRect *rects = (BenchRect *)malloc(sizeof(BenchRect) * BENCH_RECTS);
+    for(unsigned int i = 0; i < BENCH_RECTS; ++i) {
+        rects[i].width = AlignUp(RandomInt(set->minSize, set->maxSize) + padding * 2, BENCH_ALIGNMENT);
+        rects[i].height = AlignUp(RandomInt(set->minSize, set->maxSize) + padding * 2, BENCH_ALIGNMENT);
+    }
+    if(sorted) {
+        std::stable_sort(rects, rects + BENCH_RECTS, [](const BenchRect &a, const BenchRect &b) {
+            return a.height > b.height;
+        });
+    }
+
+    // a few runs, keep the best one. Every rect is tried, the ones that do not fit count too
+    TMRectPacker *packer = TMRectPackerCreate(pageSize, pageSize);
+    double bestTime = 1e9;
+    for(int run = 0; run < BENCH_RUNS; ++run) {
+        TMRectPackerReset(packer);
+        double start = GetTime();
+        for(unsigned int i = 0; i < BENCH_RECTS; ++i) {
+            BenchRect *rect = rects + i;
+            rect->packed = TMRectPackerPack(packer, rect->width, rect->height, &rect->x, &rect->y);
+        }
+        double time = GetTime() - start;
+        if(time < bestTime) bestTime = time;
+    }
+    TMRectPackerDestroy(packer);
+
+    unsigned int packedCount = 0;
+    double packedArea = 0.0;
+    for(unsigned int i = 0; i < BENCH_RECTS; ++i) {
+        if(!rects[i].packed) continue;
+        packedCount++;
+        packedArea += (double)rects[i].width * rects[i].height;
+    }
+    bool valid = RectsValid(rects, BENCH_RECTS, pageSize, coverage);
+    printf("%-8s %-8s %8u %10.1f%% %12.1f %8s\n", set->name, sorted ? "tallest" : "random", packedCount,
+           packedArea * 100.0 / ((double)pageSize * pageSize), bestTime * 1e9 / BENCH_RECTS,
+           valid ? "ok" : "FAILED");
+    free(rects);
+    return valid;
+}
+
+int main(int argc, char **argv) {
+    int pageSize = argc > 1 ? atoi(argv[1]) : 2048;
+    int padding = argc > 2 ? atoi(argv[2]) : 1;
+    if(pageSize < 64) pageSize = 64;
+    if(padding < 0) padding = 0;
+
+    BenchSet sets[] = {
+        {"icons", 16, 32},
+        {"sprites", 8, 128},
+        {"mixed", 4, 256},
+    };
+    unsigned char *coverage = (unsigned char *)malloc((size_t)pageSize * pageSize);
+
+    printf("page %dx%d, padding %d, %d rects per set\n", pageSize, pageSize, padding, BENCH_RECTS);
+    printf("%-8s %-8s %8s %11s %12s %8s\n", "set", "order", "packed", "occupancy", "ns / insert", "overlap");
+    bool valid = true;
+    for(unsigned int i = 0; i < sizeof(sets) / sizeof(sets[0]); ++i) {
+        valid = Bench(sets + i, true, pageSize, padding, coverage) && valid;
+        valid = Bench(sets + i, false, pageSize, padding, coverage) && valid;
+    }
+    free(coverage);
+    return valid ? 0 : 1;
+}
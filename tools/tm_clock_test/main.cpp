@@ -0,0 +1,120 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// TMClock test with the step and the catch-up limit of the game. Feeds frame times
+// instead of reading the real clock and checks that the simulation advances 60 steps
+// per second of real time at any refresh rate, with steady and with jittery frames,
+// that after a hitch at most maxSteps run and the rest is dropped, that alpha is the
+// remainder of the accumulator as a fraction of a step, and that Reset and the first
+// Tick never catch up.
+// usage: tm_clock_test
+
+#include "tm_clock.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+
+// same as GAME_SIMULATION_STEP and GAME_SIMULATION_MAX_STEPS
+#define TEST_STEP (1.0f / 60.0f)
+#define TEST_MAX_STEPS 5
+#define TEST_SECONDS 10
+
+// manuel: steps plus alpha is the simulated time in steps, it has to match the
+// real time up to rounding, a step can be one frame late when alpha is ~1
+static bool SimulatedTime(TMClock *clock, int steps, double seconds) {
+    double simulated = (double)steps + TMClockGetAlpha(clock);
+    return fabs(simulated - seconds / TEST_STEP) < 1e-3;
+}
+
+static void TestRefreshRates() {
+    const int rates[] = {30, 60, 90, 120, 144, 240};
+    char what[128];
+    for(unsigned int r = 0; r < sizeof(rates) / sizeof(rates[0]); ++r) {
+        TMClock clock;
+        TMClockInitialize(&clock, TEST_STEP, TEST_MAX_STEPS);
+        int steps = 0;
+        int maxStepsPerFrame = 0;
+        for(int frame = 0; frame < rates[r] * TEST_SECONDS; ++frame) {
+            int frameSteps = TMClockAdvance(&clock, 1.0 / rates[r]);
+            if(frameSteps > maxStepsPerFrame) maxStepsPerFrame = frameSteps;
+            steps += frameSteps;
+        }
+        int expectedPerFrame = (int)ceil(60.0 / rates[r]);
+        snprintf(what, sizeof(what), "%3d Hz: %d steps in %d s", rates[r], steps, TEST_SECONDS);
+        Check(SimulatedTime(&clock, steps, TEST_SECONDS) && maxStepsPerFrame <= expectedPerFrame, what);
+    }
+}
+
+static void TestJitter() {
+    TMClock clock;
+    TMClockInitialize(&clock, TEST_STEP, TEST_MAX_STEPS);
+    // frame times between 4 and 40 ms, never a hitch big enough to hit the cap
+    unsigned int random = 0x9E3779B9u;
+    double seconds = 0.0;
+    int steps = 0;
+    bool alphaInRange = true;
+    for(int frame = 0; frame < 10000; ++frame) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        double frameTime = 0.004 + 0.036 * (double)(random % 1000) / 1000.0;
+        seconds += frameTime;
+        steps += TMClockAdvance(&clock, frameTime);
+        float alpha = TMClockGetAlpha(&clock);
+        if(alpha < 0.0f || alpha > 1.0f) alphaInRange = false;
+    }
+    Check(SimulatedTime(&clock, steps, seconds), "jittery frames keep the simulated time");
+    Check(alphaInRange, "alpha stays in 0..1");
+}
+
+static void TestCatchUp() {
+    TMClock clock;
+    TMClockInitialize(&clock, TEST_STEP, TEST_MAX_STEPS);
+    Check(TMClockAdvance(&clock, 2.0) == TEST_MAX_STEPS && TMClockGetAlpha(&clock) == 0.0f,
+          "2 s hitch runs maxSteps and drops the rest");
+    Check(TMClockAdvance(&clock, TEST_STEP) == 1, "next frame is back to one step");
+
+    TMClockInitialize(&clock, TEST_STEP, TEST_MAX_STEPS);
+    Check(TMClockAdvance(&clock, TEST_STEP * 2.5) == 2 && fabsf(TMClockGetAlpha(&clock) - 0.5f) < 1e-4f,
+          "2.5 steps: 2 steps and alpha 0.5");
+    Check(TMClockAdvance(&clock, TEST_STEP * 0.25) == 0 && fabsf(TMClockGetAlpha(&clock) - 0.75f) < 1e-4f,
+          "quarter step: no step and alpha 0.75");
+    Check(TMClockAdvance(&clock, TEST_STEP * 0.25) == 1 && fabsf(TMClockGetAlpha(&clock)) < 1e-4f,
+          "remainder completes a step");
+    Check(TMClockAdvance(&clock, -1.0) == 0 && fabsf(TMClockGetAlpha(&clock)) < 1e-4f,
+          "negative frame time ignored");
+
+    TMClockInitialize(&clock, TEST_STEP, 0);
+    Check(TMClockAdvance(&clock, 1.0) == 1, "maxSteps 0 still runs one step");
+}
+
+static void TestReset() {
+    TMClock clock;
+    TMClockInitialize(&clock, TEST_STEP, TEST_MAX_STEPS);
+    TMClockAdvance(&clock, TEST_STEP * 0.9);
+    TMClockReset(&clock);
+    Check(TMClockGetAlpha(&clock) == 0.0f && TMClockAdvance(&clock, TEST_STEP * 0.5) == 0,
+          "reset drops the accumulated time");
+
+    // manuel: the first tick after a pause must not see the time spent paused
+    TMClockReset(&clock);
+    Check(TMClockTick(&clock) == 0, "first tick runs no step");
+    usleep(50 * 1000);
+    int steps = TMClockTick(&clock);
+    Check(steps >= 2 && steps <= TEST_MAX_STEPS, "tick after 50 ms runs about 3 steps");
+    TMClockReset(&clock);
+    usleep(50 * 1000);
+    Check(TMClockTick(&clock) == 0, "tick after a reset ignores the pause");
+}
+
+int main() {
+    TestRefreshRates();
+    TestJitter();
+    TestCatchUp();
+    TestReset();
+    if(ChecksFailed()) return 1;
+    return 0;
+}
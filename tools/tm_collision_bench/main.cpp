@@ -0,0 +1,106 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// Broadphase benchmark: n boxes of 8 to 32 units scattered over a world that grows
+// with n so the density stays the same, like a level with more and more stuff in it.
+// Times one step of the spatial hash (clear, insert, build, pairs) and a viewport
+// query against testing every pair. Brute force is skipped when it would take minutes.
+// usage: tm_collision_bench [cell_size]
+
+#include "tm_collision.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#define BENCH_BRUTE_FORCE_MAX 20000
+
+static float RandomFloat(float min, float max) {
+    return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+static unsigned int BruteForcePairs(TMAABB *boxes, unsigned int count) {
+    unsigned int pairs = 0;
+    for(unsigned int i = 0; i < count; ++i) {
+        for(unsigned int j = i + 1; j < count; ++j) {
+            if(TMAABBOverlap(boxes[i], boxes[j])) pairs++;
+        }
+    }
+    return pairs;
+}
+
+int main(int argc, char **argv) {
+    float cellSize = argc > 1 ? (float)atof(argv[1]) : 32.0f;
+    const unsigned int counts[] = {100, 1000, 10000, 100000};
+
+    printf("cell size %.0f\n", cellSize);
+    printf("%8s %10s %12s %12s %12s %10s\n", "boxes", "pairs", "hash ms", "brute ms", "query ms", "visible");
+    for(unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+        unsigned int count = counts[c];
+        srand(1234);
+        // manuel: about 4 boxes in a 100x100 area
+        float worldSize = sqrtf((float)count / 4.0f) * 100.0f;
+        TMAABB *boxes = (TMAABB *)malloc(sizeof(TMAABB) * count);
+        for(unsigned int i = 0; i < count; ++i) {
+            TMVec2 center{RandomFloat(0, worldSize), RandomFloat(0, worldSize)};
+            TMVec2 halfSize{RandomFloat(4, 16), RandomFloat(4, 16)};
+            boxes[i] = TMAABBFromCenter(center, halfSize);
+        }
+
+        TMSpatialHash *hash = TMSpatialHashCreate(cellSize, count);
+        TMCollisionPair *pairs = (TMCollisionPair *)malloc(sizeof(TMCollisionPair) * count * 4);
+        unsigned int *ids = (unsigned int *)malloc(sizeof(unsigned int) * count);
+
+        // a few runs, keep the best one
+        double hashTime = 1e9;
+        unsigned int pairsCount = 0;
+        for(int run = 0; run < 5; ++run) {
+            double start = GetTime();
+            TMSpatialHashClear(hash);
+            for(unsigned int i = 0; i < count; ++i) {
+                TMSpatialHashInsert(hash, i, boxes[i]);
+            }
+            TMSpatialHashBuild(hash);
+            pairsCount = TMSpatialHashQueryPairs(hash, pairs, count * 4);
+            double time = GetTime() - start;
+            if(time < hashTime) hashTime = time;
+        }
+
+        // a phone screen worth of world in the middle
+        TMAABB viewport{TMVec2{worldSize * 0.5f - 540, worldSize * 0.5f - 1200},
+                        TMVec2{worldSize * 0.5f + 540, worldSize * 0.5f + 1200}};
+        double queryTime = 1e9;
+        unsigned int visibleCount = 0;
+        for(int run = 0; run < 5; ++run) {
+            double start = GetTime();
+            visibleCount = TMSpatialHashQueryRect(hash, viewport, ids, count);
+            double time = GetTime() - start;
+            if(time < queryTime) queryTime = time;
+        }
+
+        char bruteText[32];
+        if(count <= BENCH_BRUTE_FORCE_MAX) {
+            double start = GetTime();
+            unsigned int brutePairs = BruteForcePairs(boxes, count);
+            snprintf(bruteText, sizeof(bruteText), "%.3f", (GetTime() - start) * 1000.0);
+            if(brutePairs != pairsCount) {
+                fprintf(stderr, "pairs mismatch: hash %u brute force %u\n", pairsCount, brutePairs);
+                return 1;
+            }
+        } else {
+            snprintf(bruteText, sizeof(bruteText), "skipped");
+        }
+
+        printf("%8u %10u %12.3f %12s %12.3f %10u\n", count, pairsCount, hashTime * 1000.0, bruteText,
+               queryTime * 1000.0, visibleCount);
+
+        free(ids);
+        free(pairs);
+        TMSpatialHashDestroy(hash);
+        free(boxes);
+    }
+    return 0;
+}
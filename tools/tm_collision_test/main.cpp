@@ -0,0 +1,152 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// TMSweptAABB and TMSweptAABBBounce test. Checks the time and the normal of hits on
+// every face, misses, boxes resting against a target, boxes that start inside a target
+// moving in or out, and that a ball bouncing for a long time in a closed box with a
+// paddle that jumps onto it never ends up inside anything.
+// usage: tm_collision_test
+
+#include "tm_collision.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define TEST_EPSILON 1e-4f
+#define TEST_STEPS 100000
+#define TEST_MAX_IMPACTS 8
+
+static bool Near(float a, float b) {
+    return fabsf(a - b) < TEST_EPSILON;
+}
+
+static bool Hit(TMAABB box, TMVec2 displacement, TMAABB target, float expectedTime, TMVec2 expectedNormal) {
+    float time = -1.0f;
+    TMVec2 normal{0, 0};
+    if(!TMSweptAABB(box, displacement, target, &time, &normal)) return false;
+    return Near(time, expectedTime) && normal.x == expectedNormal.x && normal.y == expectedNormal.y;
+}
+
+static bool Miss(TMAABB box, TMVec2 displacement, TMAABB target) {
+    float time;
+    TMVec2 normal;
+    return !TMSweptAABB(box, displacement, target, &time, &normal);
+}
+
+// depth of the deepest overlap between the box and any target
+static float MaxPenetration(TMVec2 position, TMVec2 halfSize, const TMAABB *targets, unsigned int count) {
+    TMAABB box = TMAABBFromCenter(position, halfSize);
+    float deepest = 0.0f;
+    for(unsigned int i = 0; i < count; ++i) {
+        float x = fminf(box.max.x - targets[i].min.x, targets[i].max.x - box.min.x);
+        float y = fminf(box.max.y - targets[i].min.y, targets[i].max.y - box.min.y);
+        float depth = fminf(x, y);
+        if(depth > deepest) deepest = depth;
+    }
+    return deepest;
+}
+
+static void TestSweep() {
+    TMAABB target{TMVec2{0, 0}, TMVec2{10, 10}};
+    TMVec2 halfSize{1, 1};
+    Check(Hit(TMAABBFromCenter(TMVec2{-5, 5}, halfSize), TMVec2{8, 0}, target, 0.5f, TMVec2{-1, 0}),
+          "hit on the left face at half the move");
+    Check(Hit(TMAABBFromCenter(TMVec2{15, 5}, halfSize), TMVec2{-8, 0}, target, 0.5f, TMVec2{1, 0}),
+          "hit on the right face");
+    Check(Hit(TMAABBFromCenter(TMVec2{5, -3}, halfSize), TMVec2{0, 4}, target, 0.5f, TMVec2{0, -1}),
+          "hit on the bottom face");
+    Check(Hit(TMAABBFromCenter(TMVec2{5, 13}, halfSize), TMVec2{0, -4}, target, 0.5f, TMVec2{0, 1}),
+          "hit on the top face");
+    Check(Hit(TMAABBFromCenter(TMVec2{-5, 15}, halfSize), TMVec2{8, -8}, target, 0.5f, TMVec2{-1, 0}) ||
+          Hit(TMAABBFromCenter(TMVec2{-5, 15}, halfSize), TMVec2{8, -8}, target, 0.5f, TMVec2{0, 1}),
+          "corner hit picks one of the faces");
+
+    Check(Miss(TMAABBFromCenter(TMVec2{-5, 5}, halfSize), TMVec2{3, 0}, target), "stops short of the target");
+    Check(Miss(TMAABBFromCenter(TMVec2{-5, 15}, halfSize), TMVec2{20, 0}, target), "passes above the target");
+    Check(Miss(TMAABBFromCenter(TMVec2{-5, 5}, halfSize), TMVec2{-8, 0}, target), "moves away");
+    Check(Miss(TMAABBFromCenter(TMVec2{-1, 5}, halfSize), TMVec2{-4, 0}, target), "resting against it and leaving");
+    Check(Hit(TMAABBFromCenter(TMVec2{-1, 5}, halfSize), TMVec2{4, 0}, target, 0.0f, TMVec2{-1, 0}),
+          "resting against it and pushing in hits at 0");
+
+    // manuel: the ones that used to be ignored, the box starts inside the target
+    Check(Hit(TMAABBFromCenter(TMVec2{0.5f, 5}, halfSize), TMVec2{4, 0}, target, 0.0f, TMVec2{-1, 0}),
+          "inside and moving in hits at 0 on the nearest face");
+    Check(Hit(TMAABBFromCenter(TMVec2{5, 9.5f}, halfSize), TMVec2{3, -3}, target, 0.0f, TMVec2{0, 1}),
+          "inside and moving in picks the least penetration");
+    Check(Miss(TMAABBFromCenter(TMVec2{0.5f, 5}, halfSize), TMVec2{-4, 0}, target),
+          "inside and moving out of the nearest face leaves");
+    Check(Miss(TMAABBFromCenter(TMVec2{0.5f, 5}, halfSize), TMVec2{0, 0}, target), "inside and still does not hit");
+}
+
+static void TestBounce() {
+    TMAABB target{TMVec2{0, 0}, TMVec2{10, 10}};
+    TMVec2 halfSize{1, 1};
+
+    TMVec2 position{-5, 5};
+    TMVec2 velocity{8, 0};
+    int impacts = TMSweptAABBBounce(&position, &velocity, halfSize, 1.0f, &target, 1, TEST_MAX_IMPACTS);
+    Check(impacts == 1 && Near(position.x, -5) && velocity.x == -8, "bounces back with the time left");
+
+    position = TMVec2{0.5f, 5};
+    velocity = TMVec2{4, 1};
+    impacts = TMSweptAABBBounce(&position, &velocity, halfSize, 0.5f, &target, 1, TEST_MAX_IMPACTS);
+    Check(impacts == 1 && velocity.x == -4 && velocity.y == 1 && Near(position.x, -3) && Near(position.y, 5.5f),
+          "starts inside: pushed out, reflected and moved");
+
+    position = TMVec2{0.5f, 5};
+    velocity = TMVec2{-4, 0};
+    impacts = TMSweptAABBBounce(&position, &velocity, halfSize, 0.5f, &target, 1, TEST_MAX_IMPACTS);
+    Check(impacts == 1 && velocity.x == -4 && Near(position.x, -3), "starts inside moving out: keeps its velocity");
+
+    position = TMVec2{0.5f, 5};
+    velocity = TMVec2{4, 0};
+    impacts = TMSweptAABBBounce(&position, &velocity, halfSize, 0.5f, &target, 1, 1);
+    Check(impacts == 1 && Near(position.x, -1) && velocity.x == -4, "out of impacts stays pushed out");
+}
+
+// manuel: the game case, a ball in a closed box and a paddle that teleports under
+// the finger, sometimes right on top of the ball
+static void TestClosedBox() {
+    const float size = 100.0f;
+    const float thickness = 50.0f;
+    TMAABB targets[5] = {
+        TMAABB{TMVec2{-size - thickness, -size}, TMVec2{-size, size}},
+        TMAABB{TMVec2{size, -size}, TMVec2{size + thickness, size}},
+        TMAABB{TMVec2{-size, -size - thickness}, TMVec2{size, -size}},
+        TMAABB{TMVec2{-size, size}, TMVec2{size, size + thickness}},
+        TMAABB{},
+    };
+    TMVec2 halfSize{4, 4};
+    TMVec2 paddleHalfSize{20, 5};
+    TMVec2 position{0, 0};
+    TMVec2 velocity{900, 700};
+    srand(1234);
+    float deepest = 0.0f;
+    float speed = sqrtf(velocity.x * velocity.x + velocity.y * velocity.y);
+    bool keepsSpeed = true;
+    for(int step = 0; step < TEST_STEPS; ++step) {
+        // there is always room for the ball between the paddle and the walls
+        TMVec2 paddle{(float)(rand() % 120 - 60), (float)(rand() % 120 - 60)};
+        targets[4] = TMAABBFromCenter(paddle, paddleHalfSize);
+        TMSweptAABBBounce(&position, &velocity, halfSize, 1.0f / 60.0f, targets, 5, TEST_MAX_IMPACTS);
+        float penetration = MaxPenetration(position, halfSize, targets, 5);
+        if(penetration > deepest) deepest = penetration;
+        if(!Near(sqrtf(velocity.x * velocity.x + velocity.y * velocity.y), speed)) keepsSpeed = false;
+    }
+    char what[128];
+    snprintf(what, sizeof(what), "closed box with a jumping paddle, deepest %.4f", deepest);
+    Check(deepest < 0.01f, what);
+    Check(keepsSpeed, "bounces keep the speed");
+    Check(fabsf(position.x) < size && fabsf(position.y) < size, "ball still inside the box");
+}
+
+int main() {
+    TestSweep();
+    TestBounce();
+    TestClosedBox();
+    if(ChecksFailed()) return 1;
+    return 0;
+}
@@ -0,0 +1,152 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// TMDynamicResolution test with the target and the scale range of the game. Feeds
+// frame times instead of rendering and checks that the scale drops a full step once
+// the average is over 1.1 times the target, that a step up which misses the target is
+// undone and the next one waits twice as long, that hitches over 4 times the target
+// are ignored, that the scale stays inside its range, and that the scaled size is
+// rounded up to multiples of 8 and never bigger than the surface. Last it runs a
+// simulated fill bound GPU, frame time grows with the pixels drawn, and checks the
+// scale settles where the frames fit the target.
+// usage: tm_dynamic_resolution_test
+
+#include "tm_dynamic_resolution.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <math.h>
+
+// same as GameInitialize
+#define TEST_TARGET (1.0f / 60.0f)
+#define TEST_MIN_SCALE 0.5f
+#define TEST_MAX_SCALE 1.0f
+
+static bool Near(float a, float b) {
+    return fabsf(a - b) < 1e-4f;
+}
+
+// feeds frameTime frames times, returns how many of them changed the scale
+static int Feed(TMDynamicResolution *resolution, float frameTime, int frames) {
+    int changes = 0;
+    for(int i = 0; i < frames; ++i) {
+        if(TMDynamicResolutionUpdate(resolution, frameTime)) changes++;
+    }
+    return changes;
+}
+
+static void TestStepDown() {
+    TMDynamicResolution resolution;
+    TMDynamicResolutionInitialize(&resolution, TEST_TARGET, TEST_MIN_SCALE, TEST_MAX_SCALE);
+    Check(Feed(&resolution, TEST_TARGET * 1.05f, 600) == 0 && Near(resolution.scale, 1.0f),
+          "1.05x target keeps the scale");
+
+    TMDynamicResolutionInitialize(&resolution, TEST_TARGET, TEST_MIN_SCALE, TEST_MAX_SCALE);
+    int frames = 0;
+    while(!TMDynamicResolutionUpdate(&resolution, TEST_TARGET * 1.2f) && frames < 600) frames++;
+    Check(frames < 600 && Near(resolution.scale, 0.9f), "1.2x target drops a full step");
+    Check(!resolution.lastChangeWasIncrease && Near(resolution.averageFrameTime, TEST_TARGET),
+          "average restarts from the target after a drop");
+    Check(Feed(&resolution, TEST_TARGET * 1.2f, 14) == 0, "no second drop while it settles");
+}
+
+static void TestUndoStepUp() {
+    TMDynamicResolution resolution;
+    TMDynamicResolutionInitialize(&resolution, TEST_TARGET, TEST_MIN_SCALE, TEST_MAX_SCALE);
+    Feed(&resolution, TEST_TARGET * 1.2f, 15);
+    Check(Near(resolution.scale, 0.9f), "slow frames drop to 0.9");
+
+    int framesToIncrease = resolution.framesToIncrease;
+    Check(Feed(&resolution, TEST_TARGET, framesToIncrease - 1) == 0, "no step up before framesToIncrease");
+    Check(TMDynamicResolutionUpdate(&resolution, TEST_TARGET) && Near(resolution.scale, 0.95f) &&
+          resolution.lastChangeWasIncrease, "on target frames step up to 0.95");
+
+    Check(Feed(&resolution, TEST_TARGET * 1.2f, 15) == 1 && Near(resolution.scale, 0.9f),
+          "missed step up is undone by a small step");
+    Check(resolution.framesToIncrease == framesToIncrease * 2, "next step up waits twice as long");
+    Check(Feed(&resolution, TEST_TARGET, framesToIncrease * 2 - 1) == 0 &&
+          TMDynamicResolutionUpdate(&resolution, TEST_TARGET) && Near(resolution.scale, 0.95f),
+          "step up after the doubled wait");
+}
+
+static void TestHitch() {
+    TMDynamicResolution resolution;
+    TMDynamicResolutionInitialize(&resolution, TEST_TARGET, TEST_MIN_SCALE, TEST_MAX_SCALE);
+    Feed(&resolution, TEST_TARGET, 10);
+    TMDynamicResolution before = resolution;
+    Check(Feed(&resolution, TEST_TARGET * 5.0f, 100) == 0 && resolution.scale == before.scale &&
+          resolution.averageFrameTime == before.averageFrameTime &&
+          resolution.framesSinceChange == before.framesSinceChange, "hitches over 4x target are ignored");
+    Check(Feed(&resolution, 0.0f, 10) == 0 && resolution.framesSinceChange == before.framesSinceChange,
+          "zero frame times are ignored");
+}
+
+static void TestClamp() {
+    TMDynamicResolution resolution;
+    TMDynamicResolutionInitialize(&resolution, TEST_TARGET, TEST_MIN_SCALE, TEST_MAX_SCALE);
+    Feed(&resolution, TEST_TARGET * 2.0f, 6000);
+    Check(Near(resolution.scale, TEST_MIN_SCALE), "slow frames stop at minScale");
+    Check(Feed(&resolution, TEST_TARGET * 2.0f, 600) == 0, "no change at minScale");
+
+    TMDynamicResolutionInitialize(&resolution, TEST_TARGET, TEST_MIN_SCALE, TEST_MAX_SCALE);
+    Check(Feed(&resolution, TEST_TARGET * 0.5f, 6000) == 0 && resolution.scale == TEST_MAX_SCALE,
+          "fast frames stay at maxScale");
+
+    // a step up past maxScale is clamped to it
+    TMDynamicResolutionInitialize(&resolution, TEST_TARGET, TEST_MIN_SCALE, 0.93f);
+    resolution.scale = 0.9f;
+    Feed(&resolution, TEST_TARGET, resolution.framesToIncrease);
+    Check(resolution.scale == 0.93f, "step up clamped to maxScale");
+}
+
+static void TestGetSize() {
+    TMDynamicResolution resolution;
+    TMDynamicResolutionInitialize(&resolution, TEST_TARGET, TEST_MIN_SCALE, TEST_MAX_SCALE);
+    int width, height;
+    resolution.scale = 0.75f;
+    TMDynamicResolutionGetSize(&resolution, 1000, 563, &width, &height);
+    Check(width == 752 && height == 424, "1000x563 at 0.75 rounds up to 752x424");
+    resolution.scale = 0.5f;
+    TMDynamicResolutionGetSize(&resolution, 2400, 1080, &width, &height);
+    Check(width == 1200 && height == 544, "2400x1080 at 0.5 is 1200x544");
+    resolution.scale = 1.0f;
+    TMDynamicResolutionGetSize(&resolution, 1001, 563, &width, &height);
+    Check(width == 1001 && height == 563, "rounding never goes over the surface");
+    resolution.scale = 0.5f;
+    TMDynamicResolutionGetSize(&resolution, 10, 10, &width, &height);
+    Check(width == 8 && height == 8, "tiny surfaces get at least 8x8");
+}
+
+// manuel: half the frame is fixed cost, the rest scales with the pixels drawn.
+// At scale 1 a frame takes 1.4x the target, it fits at about 0.75
+static float FillBoundFrameTime(float scale) {
+    return TEST_TARGET * (0.5f + 0.9f * scale * scale);
+}
+
+static void TestFillBound() {
+    TMDynamicResolution resolution;
+    TMDynamicResolutionInitialize(&resolution, TEST_TARGET, TEST_MIN_SCALE, TEST_MAX_SCALE);
+    int lateChanges = 0;
+    const int frames = 60 * 120;
+    for(int frame = 0; frame < frames; ++frame) {
+        bool changed = TMDynamicResolutionUpdate(&resolution, FillBoundFrameTime(resolution.scale));
+        if(changed && frame >= frames / 2) lateChanges++;
+    }
+    char what[128];
+    snprintf(what, sizeof(what), "fill bound GPU settles at %.2f, %.2fx target",
+             resolution.scale, FillBoundFrameTime(resolution.scale) / TEST_TARGET);
+    Check(resolution.scale < 1.0f && FillBoundFrameTime(resolution.scale) < TEST_TARGET * 1.1f, what);
+    Check(lateChanges <= 2, "at most 2 changes in the last minute");
+}
+
+int main() {
+    TestStepDown();
+    TestUndoStepUp();
+    TestHitch();
+    TestClamp();
+    TestGetSize();
+    TestFillBound();
+    if(ChecksFailed()) return 1;
+    return 0;
+}
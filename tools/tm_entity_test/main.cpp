@@ -0,0 +1,151 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// TMEntityStore test. Runs random creates and destroys against a plain list of the
+// live handles and checks after every one that the dense arrays stay packed, that every
+// live handle finds its own components after the last entity moved into a hole, and
+// that destroyed handles, handles from before a Clear and handles of a reused slot
+// fail. Also checks the full store, the zeroed components and the integrate mask.
+// usage: tm_entity_test
+
+#include "tm_entity.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_CAPACITY 256
+#define TEST_OPERATIONS 100000
+
+// manuel: every entity carries its own index in the position, so a component that
+// moved without its entity is found right away
+static void Tag(TMEntityStore *store, TMEntity entity) {
+    int i = TMEntityGetIndex(store, entity);
+    store->positions[i] = TMVec2{(float)entity.index, (float)entity.generation};
+    store->sprites[i].id = entity.index;
+}
+
+static bool Tagged(TMEntityStore *store, TMEntity entity) {
+    int i = TMEntityGetIndex(store, entity);
+    return i >= 0 && store->positions[i].x == (float)entity.index &&
+           store->positions[i].y == (float)entity.generation && store->sprites[i].id == entity.index;
+}
+
+// the dense arrays and the live handles hold the same entities
+static bool Consistent(TMEntityStore *store, TMEntity *live, unsigned int liveCount) {
+    if(store->count != liveCount || store->count + store->freeCount != store->capacity) return false;
+    for(unsigned int i = 0; i < liveCount; ++i) {
+        if(!Tagged(store, live[i])) return false;
+    }
+    for(unsigned int i = 0; i < store->count; ++i) {
+        if(store->denseIndices[store->entities[i].index] != i) return false;
+    }
+    return true;
+}
+
+static void TestChurn() {
+    TMEntityStore *store = TMEntityStoreCreate(TEST_CAPACITY);
+    TMEntity live[TEST_CAPACITY];
+    unsigned int liveCount = 0;
+    TMEntity dead[TEST_CAPACITY];
+    unsigned int deadCount = 0;
+    bool consistent = true;
+    bool deadFail = true;
+    srand(1234);
+    for(int op = 0; op < TEST_OPERATIONS; ++op) {
+        // manuel: lean to creates while it is emptier, so it goes full and empty often
+        bool create = liveCount == 0 || (liveCount < TEST_CAPACITY && rand() % 100 < 55);
+        if(create) {
+            TMEntity entity = TMEntityCreate(store, TM_COMPONENT_POSITION | TM_COMPONENT_SPRITE);
+            Tag(store, entity);
+            live[liveCount++] = entity;
+        } else {
+            unsigned int victim = (unsigned int)rand() % liveCount;
+            TMEntity entity = live[victim];
+            TMEntityDestroy(store, entity);
+            live[victim] = live[--liveCount];
+            dead[deadCount++ % TEST_CAPACITY] = entity;
+        }
+        consistent = consistent && Consistent(store, live, liveCount);
+    }
+    unsigned int checkedDead = deadCount < TEST_CAPACITY ? deadCount : TEST_CAPACITY;
+    for(unsigned int i = 0; i < checkedDead; ++i) {
+        if(TMEntityIsAlive(store, dead[i]) || TMEntityGetIndex(store, dead[i]) != -1) deadFail = false;
+    }
+    Check(consistent, "random churn keeps components with entities");
+    Check(deadFail, "destroyed handles fail after the slot is reused");
+
+    TMEntity entity = live[0];
+    TMEntityDestroy(store, entity);
+    TMEntityDestroy(store, entity);
+    Check(store->count == liveCount - 1, "double destroy is ignored");
+
+    TMEntityStoreClear(store);
+    bool cleared = store->count == 0 && store->freeCount == TEST_CAPACITY;
+    for(unsigned int i = 1; i < liveCount; ++i) {
+        if(TMEntityIsAlive(store, live[i])) cleared = false;
+    }
+    Check(cleared, "clear kills every handle");
+    TMEntityStoreDestroy(store);
+}
+
+static void TestFull() {
+    TMEntityStore *store = TMEntityStoreCreate(4);
+    TMEntity entities[4];
+    for(int i = 0; i < 4; ++i) entities[i] = TMEntityCreate(store, TM_COMPONENT_POSITION);
+    TMEntity extra = TMEntityCreate(store, TM_COMPONENT_POSITION);
+    Check(extra.generation == 0 && !TMEntityIsAlive(store, extra), "full store returns TM_ENTITY_NULL");
+    Check(!TMEntityIsAlive(store, TM_ENTITY_NULL), "TM_ENTITY_NULL is never alive");
+    Check(!TMEntityIsAlive(store, TMEntity{100, 1}), "index out of range is not alive");
+
+    TMEntityDestroy(store, entities[2]);
+    TMEntity reused = TMEntityCreate(store, TM_COMPONENT_POSITION);
+    Check(reused.index == entities[2].index && reused.generation != entities[2].generation &&
+          !TMEntityIsAlive(store, entities[2]) && TMEntityIsAlive(store, reused),
+          "reused slot gets a new generation");
+    TMEntityStoreDestroy(store);
+}
+
+static void TestComponents() {
+    TMEntityStore *store = TMEntityStoreCreate(8);
+    TMEntity entity = TMEntityCreate(store, TM_COMPONENT_POSITION | TM_COMPONENT_VELOCITY);
+    int i = TMEntityGetIndex(store, entity);
+    store->positions[i] = TMVec2{5, 5};
+    store->velocities[i] = TMVec2{3, 4};
+    store->sprites[i] = TMEntitySprite{7, 2};
+    store->colliders[i].flags = TM_COLLIDER_STATIC;
+    TMEntityDestroy(store, entity);
+    entity = TMEntityCreate(store, TM_COMPONENT_POSITION);
+    i = TMEntityGetIndex(store, entity);
+    Check(store->positions[i].x == 0 && store->velocities[i].y == 0 && store->sprites[i].id == 0 &&
+          store->colliders[i].flags == 0, "new entity starts with zeroed components");
+
+    TMEntity moving = TMEntityCreate(store, TM_COMPONENT_POSITION | TM_COMPONENT_VELOCITY);
+    TMEntity collider = TMEntityCreate(store, TM_COMPONENT_POSITION | TM_COMPONENT_VELOCITY |
+                                              TM_COMPONENT_COLLIDER);
+    TMEntity still = TMEntityCreate(store, TM_COMPONENT_VELOCITY);
+    TMEntity entities[] = {moving, collider, still};
+    for(int e = 0; e < 3; ++e) {
+        int index = TMEntityGetIndex(store, entities[e]);
+        store->positions[index] = TMVec2{1, 1};
+        store->velocities[index] = TMVec2{10, -10};
+    }
+    TMEntityStoreIntegrate(store, 0.5f, TM_COMPONENT_COLLIDER);
+    int m = TMEntityGetIndex(store, moving);
+    int c = TMEntityGetIndex(store, collider);
+    int s = TMEntityGetIndex(store, still);
+    Check(store->positions[m].x == 6 && store->positions[m].y == -4 && store->previousPositions[m].x == 1,
+          "integrate moves position plus velocity");
+    Check(store->positions[c].x == 1 && store->previousPositions[c].x == 1, "skipped components keep their position");
+    Check(store->positions[s].x == 1, "velocity without position does not move");
+    TMEntityStoreDestroy(store);
+}
+
+int main() {
+    TestChurn();
+    TestFull();
+    TestComponents();
+    if(ChecksFailed()) return 1;
+    return 0;
+}
@@ -0,0 +1,214 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// TMRendererState test and driver call count benchmark. The GL entry points come from
+// mock_gl.cpp and only count themselves. The test checks that the shadow elides only
+// calls that would not change the driver state, keeps the driver and the shadow in sync
+// across texture units and deleted objects, and that its issued counter matches the
+// calls the mock saw. The benchmark draws the frame GameRender used to draw, a
+// background, two paddles, a ball and a row of bricks, once the way the renderer did it
+// before the uniform cache and the state shadow and once through them, and prints the
+// driver calls per frame of each.
+// usage: tm_gl_state_bench [bricksCount]
+
+#include "tm_renderer_state.h"
+#include "mock_gl.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GLES3/gl3.h>
+
+#define BENCH_FRAMES 1000
+
+#define BENCH_PROGRAM 3
+#define BENCH_VAO 5
+#define BENCH_BACKGROUND_TEXTURE 10
+#define BENCH_PADDLE1_TEXTURE 11
+#define BENCH_PADDLE2_TEXTURE 12
+#define BENCH_BALL_TEXTURE 13
+#define BENCH_BRICK_TEXTURE 14
+
+// the defaults TMRendererCreate gives the shadow
+static void StateReset(TMRendererState *state) {
+    memset(state, 0, sizeof(TMRendererState));
+    state->clearColor[0] = 0.5f;
+    state->clearColor[1] = 0.1f;
+    state->clearColor[2] = 0.1f;
+    state->clearColor[3] = 1.0f;
+    state->cullFaceMode = GL_BACK;
+    state->blend = true;
+    gState = state;
+}
+
+static void Test() {
+    TMRendererState state;
+    StateReset(&state);
+    MockGLReset();
+
+    TMStateUseProgram(BENCH_PROGRAM);
+    TMStateUseProgram(BENCH_PROGRAM);
+    Check(gCalls.useProgram == 1 && gMockProgram == BENCH_PROGRAM, "program bound once");
+    TMStateForgetProgram(BENCH_PROGRAM);
+    TMStateUseProgram(BENCH_PROGRAM);
+    Check(gCalls.useProgram == 2, "program bound again after a delete");
+
+    TMStateBindTexture(0, BENCH_BALL_TEXTURE);
+    TMStateBindTexture(0, BENCH_BALL_TEXTURE);
+    Check(gCalls.bindTexture == 1 && gCalls.activeTexture == 0, "texture on unit 0 bound once");
+    TMStateBindTexture(1, BENCH_BRICK_TEXTURE);
+    Check(gCalls.activeTexture == 1 && gMockActiveTexture == 1 && gMockTextures[1] == BENCH_BRICK_TEXTURE,
+          "texture on unit 1 changes the active unit");
+    TMStateBindTexture(0, BENCH_BALL_TEXTURE);
+    Check(gCalls.bindTexture == 2 && gMockTextures[0] == BENCH_BALL_TEXTURE,
+          "unit 0 still holds its texture");
+    TMStateBindTexture(0, BENCH_PADDLE1_TEXTURE);
+    Check(gMockActiveTexture == 0 && gMockTextures[0] == BENCH_PADDLE1_TEXTURE &&
+          gMockTextures[1] == BENCH_BRICK_TEXTURE, "unit 0 rebound without touching unit 1");
+    TMStateForgetTexture(BENCH_BRICK_TEXTURE);
+    unsigned int binds = gCalls.bindTexture;
+    TMStateBindTexture(1, BENCH_BRICK_TEXTURE);
+    Check(gCalls.bindTexture == binds + 1, "texture bound again after a delete");
+
+    TMStateEnable(GL_BLEND, &gState->blend, true);
+    TMStateEnable(GL_DEPTH_TEST, &gState->depthTest, false);
+    Check(gCalls.enable == 0 && gCalls.disable == 0, "default enables elided");
+    TMStateEnable(GL_DEPTH_TEST, &gState->depthTest, true);
+    TMStateEnable(GL_DEPTH_TEST, &gState->depthTest, true);
+    TMStateEnable(GL_DEPTH_TEST, &gState->depthTest, false);
+    Check(gCalls.enable == 1 && gCalls.disable == 1, "depth test toggled once each way");
+
+    TMStateClearColor(0.1f, 0.5f, 0.1f, 1.0f);
+    TMStateClearColor(0.1f, 0.5f, 0.1f, 1.0f);
+    TMStateViewport(0, 0, 1280, 720);
+    TMStateViewport(0, 0, 1280, 720);
+    TMStateViewport(0, 0, 640, 360);
+    TMStateBindFramebuffer(7);
+    TMStateBindFramebuffer(7);
+    TMStateCullFace(GL_BACK);
+    TMStateCullFace(GL_FRONT);
+    Check(gCalls.clearColor == 1 && gCalls.viewport == 2 && gCalls.bindFramebuffer == 1 && gCalls.cullFace == 1,
+          "clear color, viewport, framebuffer, cull face");
+    // a blit binds the read and draw framebuffers around the shadow, even back to 0
+    TMStateBindFramebuffer(0);
+    TMStateForgetFramebuffer();
+    TMStateBindFramebuffer(0);
+    TMStateBindFramebuffer(0);
+    Check(gCalls.bindFramebuffer == 3, "framebuffer bound again after a blit");
+
+    TMStateBindVertexArray(BENCH_VAO);
+    TMStateForgetVertexArray(BENCH_VAO);
+    TMStateBindVertexArray(BENCH_VAO);
+    Check(gCalls.bindVertexArray == 2, "vertex array bound again after a delete");
+
+    Check(state.stats.callsIssued == MockGLStateCalls(), "issued counter matches the driver calls");
+    gState = NULL;
+}
+
+struct BenchObject {
+    unsigned int texture;
+    float world[16];
+};
+
+// manuel: what TMRendererShaderUpdate, TMRendererTextureBind and TMRendererDrawBufferElements
+// did before the uniform cache and the state shadow, every call went to the driver
+static void DrawFrameDirect(BenchObject *objects, unsigned int objectsCount, float *proj) {
+    glClearColor(0.1f, 0.5f, 0.1f, 1.0f);
+    glUseProgram(BENCH_PROGRAM);
+    int location = glGetUniformLocation(BENCH_PROGRAM, "uProj");
+    glUseProgram(BENCH_PROGRAM);
+    glUniformMatrix4fv(location, 1, false, proj);
+    for(unsigned int i = 0; i < objectsCount; ++i) {
+        location = glGetUniformLocation(BENCH_PROGRAM, "uWorld");
+        glUseProgram(BENCH_PROGRAM);
+        glUniformMatrix4fv(location, 1, false, objects[i].world);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, objects[i].texture);
+        location = glGetUniformLocation(BENCH_PROGRAM, "uTexture");
+        glUseProgram(BENCH_PROGRAM);
+        glUniform1i(location, 0);
+        glBindVertexArray(BENCH_VAO);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+    }
+    glDisable(GL_DEPTH_TEST);
+}
+
+// the same frame with the uniform locations resolved once and every bind through the shadow
+static void DrawFrameShadowed(BenchObject *objects, unsigned int objectsCount, float *proj,
+                              int uProj, int uWorld, int uTexture) {
+    TMStateClearColor(0.1f, 0.5f, 0.1f, 1.0f);
+    TMStateUseProgram(BENCH_PROGRAM);
+    TMStateUseProgram(BENCH_PROGRAM);
+    glUniformMatrix4fv(uProj, 1, false, proj);
+    for(unsigned int i = 0; i < objectsCount; ++i) {
+        TMStateUseProgram(BENCH_PROGRAM);
+        glUniformMatrix4fv(uWorld, 1, false, objects[i].world);
+        TMStateBindTexture(0, objects[i].texture);
+        TMStateUseProgram(BENCH_PROGRAM);
+        glUniform1i(uTexture, 0);
+        TMStateBindVertexArray(BENCH_VAO);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+    }
+    TMStateEnable(GL_DEPTH_TEST, &gState->depthTest, false);
+}
+
+static void PrintCalls(const char *name) {
+    printf("%-10s %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f\n", name,
+           (double)gCalls.useProgram / BENCH_FRAMES,
+           (double)gCalls.getUniformLocation / BENCH_FRAMES,
+           (double)(gCalls.activeTexture + gCalls.bindTexture) / BENCH_FRAMES,
+           (double)gCalls.bindVertexArray / BENCH_FRAMES,
+           (double)(gCalls.enable + gCalls.disable + gCalls.clearColor) / BENCH_FRAMES,
+           (double)(gCalls.uniform + gCalls.draw) / BENCH_FRAMES,
+           (double)MockGLTotalCalls() / BENCH_FRAMES);
+}
+
+static void Bench(unsigned int bricksCount) {
+    unsigned int objectsCount = 4 + bricksCount;
+    BenchObject *objects = (BenchObject *)malloc(sizeof(BenchObject) * objectsCount);
+    memset(objects, 0, sizeof(BenchObject) * objectsCount);
+    objects[0].texture = BENCH_BACKGROUND_TEXTURE;
+    objects[1].texture = BENCH_PADDLE1_TEXTURE;
+    objects[2].texture = BENCH_PADDLE2_TEXTURE;
+    objects[3].texture = BENCH_BALL_TEXTURE;
+    for(unsigned int i = 4; i < objectsCount; ++i) objects[i].texture = BENCH_BRICK_TEXTURE;
+    float proj[16] = {};
+
+    printf("\n%u draws per frame, driver calls per frame\n", objectsCount);
+    printf("%-10s %8s %8s %8s %8s %8s %8s %8s\n", "", "program", "lookup", "texture", "vao", "enable",
+           "uni+draw", "total");
+
+    MockGLReset();
+    for(int frame = 0; frame < BENCH_FRAMES; ++frame) {
+        DrawFrameDirect(objects, objectsCount, proj);
+    }
+    PrintCalls("before");
+
+    TMRendererState state;
+    StateReset(&state);
+    // manuel: TMRendererShaderCreate does these lookups once, at link time
+    int uProj = glGetUniformLocation(BENCH_PROGRAM, "uProj");
+    int uWorld = glGetUniformLocation(BENCH_PROGRAM, "uWorld");
+    int uTexture = glGetUniformLocation(BENCH_PROGRAM, "uTexture");
+    MockGLReset();
+    for(int frame = 0; frame < BENCH_FRAMES; ++frame) {
+        DrawFrameShadowed(objects, objectsCount, proj, uProj, uWorld, uTexture);
+    }
+    PrintCalls("after");
+    printf("state calls issued %.1f elided %.1f per frame\n",
+           (double)state.stats.callsIssued / BENCH_FRAMES, (double)state.stats.callsElided / BENCH_FRAMES);
+    gState = NULL;
+    free(objects);
+}
+
+int main(int argc, char **argv) {
+    int bricksCount = argc > 1 ? atoi(argv[1]) : 32;
+    if(bricksCount < 0) bricksCount = 0;
+
+    Test();
+    if(ChecksFailed()) return 1;
+    Bench((unsigned int)bricksCount);
+    return 0;
+}
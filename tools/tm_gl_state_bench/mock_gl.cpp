@@ -0,0 +1,90 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "mock_gl.h"
+
+#include <string.h>
+#include <GLES3/gl3.h>
+
+MockGLCalls gCalls;
+unsigned int gMockProgram;
+unsigned int gMockActiveTexture;
+unsigned int gMockTextures[16];
+
+void MockGLReset() {
+    memset(&gCalls, 0, sizeof(MockGLCalls));
+}
+
+unsigned int MockGLStateCalls() {
+    return gCalls.useProgram + gCalls.bindVertexArray + gCalls.activeTexture + gCalls.bindTexture +
+           gCalls.enable + gCalls.disable + gCalls.cullFace + gCalls.clearColor +
+           gCalls.bindFramebuffer + gCalls.viewport;
+}
+
+unsigned int MockGLTotalCalls() {
+    return MockGLStateCalls() + gCalls.getUniformLocation + gCalls.uniform + gCalls.draw;
+}
+
+// manuel: the GLES3 entry points the state shadow and the benchmark frame use,
+// each one only counts itself
+
+void glUseProgram(GLuint program) {
+    gMockProgram = program;
+    gCalls.useProgram++;
+}
+
+void glBindVertexArray(GLuint) {
+    gCalls.bindVertexArray++;
+}
+
+void glActiveTexture(GLenum texture) {
+    gMockActiveTexture = texture - GL_TEXTURE0;
+    gCalls.activeTexture++;
+}
+
+void glBindTexture(GLenum, GLuint texture) {
+    gMockTextures[gMockActiveTexture] = texture;
+    gCalls.bindTexture++;
+}
+
+void glEnable(GLenum) {
+    gCalls.enable++;
+}
+
+void glDisable(GLenum) {
+    gCalls.disable++;
+}
+
+void glCullFace(GLenum) {
+    gCalls.cullFace++;
+}
+
+void glClearColor(GLfloat, GLfloat, GLfloat, GLfloat) {
+    gCalls.clearColor++;
+}
+
+void glBindFramebuffer(GLenum, GLuint) {
+    gCalls.bindFramebuffer++;
+}
+
+void glViewport(GLint, GLint, GLsizei, GLsizei) {
+    gCalls.viewport++;
+}
+
+GLint glGetUniformLocation(GLuint, const GLchar *name) {
+    gCalls.getUniformLocation++;
+    return (GLint)strlen(name);
+}
+
+void glUniform1i(GLint, GLint) {
+    gCalls.uniform++;
+}
+
+void glUniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat *) {
+    gCalls.uniform++;
+}
+
+void glDrawElements(GLenum, GLsizei, GLenum, const void *) {
+    gCalls.draw++;
+}
@@ -0,0 +1,36 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef TM_GL_STATE_BENCH_MOCK_GL_H
+#define TM_GL_STATE_BENCH_MOCK_GL_H
+
+// calls that reached the mock driver since the last MockGLReset
+struct MockGLCalls {
+    unsigned int useProgram;
+    unsigned int bindVertexArray;
+    unsigned int activeTexture;
+    unsigned int bindTexture;
+    unsigned int enable;
+    unsigned int disable;
+    unsigned int cullFace;
+    unsigned int clearColor;
+    unsigned int bindFramebuffer;
+    unsigned int viewport;
+    unsigned int getUniformLocation;
+    unsigned int uniform;
+    unsigned int draw;
+};
+
+extern MockGLCalls gCalls;
+// bound program and texture unit as the driver sees them
+extern unsigned int gMockProgram;
+extern unsigned int gMockActiveTexture;
+extern unsigned int gMockTextures[16];
+
+void MockGLReset();
+// calls TMRendererState filters, the ones counted in its stats
+unsigned int MockGLStateCalls();
+unsigned int MockGLTotalCalls();
+
+#endif //TM_GL_STATE_BENCH_MOCK_GL_H
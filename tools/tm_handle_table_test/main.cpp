@@ -0,0 +1,140 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// TMHandleTable test. Runs random adds and removes against a plain list of the live
+// handles and checks after every one that each live handle reaches its own element
+// after the table grew or the last element moved into a hole, that iterating the
+// dense array visits every live element once, and that removed handles fail. Then
+// checks double removes, zeroed elements and that a slot that used every generation
+// is retired so none of its old handles can come back.
+// usage: tm_handle_table_test
+
+#include "utils/tm_handle_table.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_MAX_LIVE 512
+#define TEST_OPERATIONS 100000
+
+// manuel: bigger than a pointer and not a power of two, every element carries its handle
+struct TestElement {
+    unsigned int handle;
+    unsigned int values[5];
+};
+
+static bool ElementOk(TestElement *element, unsigned int handle) {
+    if(!element || element->handle != handle) return false;
+    for(int i = 0; i < 5; ++i) {
+        if(element->values[i] != handle * 31u + (unsigned int)i) return false;
+    }
+    return true;
+}
+
+static unsigned int Add(TMHandleTable *table) {
+    TestElement *element;
+    unsigned int handle = TMHandleTableAdd(table, (void **)&element);
+    element->handle = handle;
+    for(int i = 0; i < 5; ++i) element->values[i] = handle * 31u + (unsigned int)i;
+    return handle;
+}
+
+static bool Consistent(TMHandleTable *table, unsigned int *live, unsigned int liveCount) {
+    if(TMHandleTableGetCount(table) != liveCount) return false;
+    for(unsigned int i = 0; i < liveCount; ++i) {
+        if(!ElementOk((TestElement *)TMHandleTableGet(table, live[i]), live[i])) return false;
+    }
+    // every dense element is live and knows its own handle
+    for(unsigned int i = 0; i < liveCount; ++i) {
+        unsigned int handle = TMHandleTableGetHandleAt(table, i);
+        if(!ElementOk((TestElement *)TMHandleTableGetAt(table, i), handle)) return false;
+        if(TMHandleTableGet(table, handle) != TMHandleTableGetAt(table, i)) return false;
+    }
+    return true;
+}
+
+static void TestChurn() {
+    TMHandleTable *table = TMHandleTableCreate(sizeof(TestElement), 4);
+    unsigned int live[TEST_MAX_LIVE];
+    unsigned int liveCount = 0;
+    unsigned int dead[TEST_MAX_LIVE];
+    unsigned int deadCount = 0;
+    bool consistent = true;
+    bool deadFail = true;
+    srand(1234);
+    for(int op = 0; op < TEST_OPERATIONS; ++op) {
+        bool add = liveCount == 0 || (liveCount < TEST_MAX_LIVE && rand() % 100 < 55);
+        if(add) {
+            live[liveCount++] = Add(table);
+        } else {
+            unsigned int victim = (unsigned int)rand() % liveCount;
+            unsigned int handle = live[victim];
+            if(!TMHandleTableRemove(table, handle)) consistent = false;
+            live[victim] = live[--liveCount];
+            dead[deadCount++ % TEST_MAX_LIVE] = handle;
+        }
+        consistent = consistent && Consistent(table, live, liveCount);
+    }
+    unsigned int checkedDead = deadCount < TEST_MAX_LIVE ? deadCount : TEST_MAX_LIVE;
+    for(unsigned int i = 0; i < checkedDead; ++i) {
+        if(TMHandleTableIsValid(table, dead[i]) || TMHandleTableGet(table, dead[i]) ||
+           TMHandleTableRemove(table, dead[i])) {
+            deadFail = false;
+        }
+    }
+    Check(consistent, "random churn keeps handles on their elements");
+    Check(table->capacity >= TEST_MAX_LIVE, "the table grew from 4");
+    Check(deadFail, "removed handles fail after the slot is reused");
+    Check(!TMHandleTableIsValid(table, TM_HANDLE_NULL), "TM_HANDLE_NULL is never valid");
+    Check(!TMHandleTableIsValid(table, (1u << TM_HANDLE_INDEX_BITS) | TM_HANDLE_INDEX_MASK),
+          "slot never used is not valid");
+    TMHandleTableDestroy(table);
+}
+
+static void TestElements() {
+    TMHandleTable *table = TMHandleTableCreate(sizeof(TestElement), 8);
+    unsigned int handle = Add(table);
+    Check(TMHandleTableRemove(table, handle) && !TMHandleTableRemove(table, handle), "double remove fails");
+    TestElement *element;
+    unsigned int reused = TMHandleTableAdd(table, (void **)&element);
+    Check(TM_HANDLE_INDEX(reused) == TM_HANDLE_INDEX(handle) && reused != handle,
+          "reused slot gets a new generation");
+    Check(element->handle == 0 && element->values[4] == 0, "new element starts zeroed");
+    Check(TMHandleTableAdd(table, NULL) != TM_HANDLE_NULL, "element pointer is optional");
+    TMHandleTableDestroy(table);
+}
+
+static void TestRetire() {
+    TMHandleTable *table = TMHandleTableCreate(sizeof(TestElement), 8);
+    unsigned int first = Add(table);
+    unsigned int slot = TM_HANDLE_INDEX(first);
+    unsigned int handle = first;
+    unsigned int uses = 1;
+    // manuel: the slot goes back to the free list until its last generation is removed
+    while(TMHandleTableRemove(table, handle)) {
+        handle = Add(table);
+        if(TM_HANDLE_INDEX(handle) != slot) break;
+        uses++;
+    }
+    Check(uses == TM_HANDLE_MAX_GENERATION, "a slot is used once per generation");
+    Check(TM_HANDLE_INDEX(handle) != slot, "then it is retired");
+    bool oldFail = true;
+    for(unsigned int generation = 1; generation <= TM_HANDLE_MAX_GENERATION; ++generation) {
+        if(TMHandleTableIsValid(table, (generation << TM_HANDLE_INDEX_BITS) | slot)) oldFail = false;
+    }
+    Check(oldFail, "no handle of a retired slot is valid");
+    Check(ElementOk((TestElement *)TMHandleTableGet(table, handle), handle) && TMHandleTableGetCount(table) == 1,
+          "the new slot works");
+    TMHandleTableDestroy(table);
+}
+
+int main() {
+    TestChurn();
+    TestElements();
+    TestRetire();
+    if(ChecksFailed()) return 1;
+    return 0;
+}
@@ -0,0 +1,177 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// Job system stress test and benchmark. The stress part checks that every job runs
+// exactly once with many small jobs, jobs that start and wait for jobs, threads
+// without a queue starting jobs, parallel for ranges, and that background jobs only
+// run on the workers, never on a thread that waits. The benchmark times an
+// empty job round trip and a parallel for over some math against a plain loop.
+// usage: tm_job_bench [workers] (0 or nothing picks one per big core minus one)
+
+#include "tm_job_system.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <thread>
+#include <chrono>
+
+#define BENCH_EMPTY_JOBS 1000000
+#define BENCH_TREE_DEPTH 16
+#define BENCH_FOREIGN_THREADS 4
+#define BENCH_FOREIGN_JOBS 100000
+#define BENCH_RANGE_COUNT 10000000
+#define BENCH_BACKGROUND_JOBS 8
+// about a texture decode
+#define BENCH_BACKGROUND_MS 20
+
+static TMJobSystem *gJobSystem;
+static std::atomic<int> gExecuted;
+
+static void EmptyJob(void *) {
+    gExecuted.fetch_add(1, std::memory_order_relaxed);
+}
+
+// every node starts its two children and waits for them, the leaves count
+struct TreeNode {
+    int depth;
+};
+
+static void TreeJob(void *data) {
+    TreeNode *node = (TreeNode *)data;
+    if(node->depth == 0) {
+        gExecuted.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TreeNode children[2] = {{node->depth - 1}, {node->depth - 1}};
+    TMJobCounter counter;
+    counter.pending.store(0);
+    TMJobSystemRun(gJobSystem, TreeJob, children + 0, &counter);
+    TMJobSystemRun(gJobSystem, TreeJob, children + 1, &counter);
+    TMJobSystemWait(gJobSystem, &counter);
+}
+
+static void ForeignThread() {
+    TMJobCounter counter;
+    counter.pending.store(0);
+    for(int i = 0; i < BENCH_FOREIGN_JOBS; ++i) {
+        TMJobSystemRun(gJobSystem, EmptyJob, NULL, &counter);
+    }
+    TMJobSystemWait(gJobSystem, &counter);
+}
+
+static void MarkRange(void *data, unsigned int begin, unsigned int end) {
+    std::atomic<unsigned char> *marks = (std::atomic<unsigned char> *)data;
+    for(unsigned int i = begin; i < end; ++i) {
+        marks[i].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static std::thread::id gMainThread;
+static std::atomic<int> gBackgroundOnMain;
+
+static void BackgroundJob(void *) {
+    if(std::this_thread::get_id() == gMainThread) gBackgroundOnMain.fetch_add(1, std::memory_order_relaxed);
+    std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_BACKGROUND_MS));
+    gExecuted.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void WorkRange(void *data, unsigned int begin, unsigned int end) {
+    float *values = (float *)data;
+    for(unsigned int i = begin; i < end; ++i) {
+        float x = (float)i * 0.001f;
+        values[i] = sqrtf(x) * sinf(x) + cosf(x * 0.5f);
+    }
+}
+
+int main(int argc, char **argv) {
+    int workers = argc > 1 ? atoi(argv[1]) : 0;
+    gJobSystem = TMJobSystemCreate(workers);
+    printf("%d workers + the main thread\n", TMJobSystemGetWorkersCount(gJobSystem));
+
+    // stress
+    TMJobCounter counter;
+    counter.pending.store(0);
+    gExecuted.store(0);
+    double start = GetTime();
+    for(int i = 0; i < BENCH_EMPTY_JOBS; ++i) {
+        TMJobSystemRun(gJobSystem, EmptyJob, NULL, &counter);
+    }
+    TMJobSystemWait(gJobSystem, &counter);
+    double emptyTime = GetTime() - start;
+    Check(gExecuted.load() == BENCH_EMPTY_JOBS && counter.pending.load() == 0, "empty jobs run once");
+
+    gExecuted.store(0);
+    TreeNode root = {BENCH_TREE_DEPTH};
+    counter.pending.store(0);
+    TMJobSystemRun(gJobSystem, TreeJob, &root, &counter);
+    TMJobSystemWait(gJobSystem, &counter);
+    Check(gExecuted.load() == (1 << BENCH_TREE_DEPTH), "jobs waiting for their children");
+
+    gExecuted.store(0);
+    std::thread foreign[BENCH_FOREIGN_THREADS];
+    for(int i = 0; i < BENCH_FOREIGN_THREADS; ++i) {
+        foreign[i] = std::thread(ForeignThread);
+    }
+    for(int i = 0; i < BENCH_FOREIGN_THREADS; ++i) {
+        foreign[i].join();
+    }
+    Check(gExecuted.load() == BENCH_FOREIGN_THREADS * BENCH_FOREIGN_JOBS, "jobs from threads without a queue");
+
+    unsigned int marksCount = 1000003;
+    std::atomic<unsigned char> *marks = new std::atomic<unsigned char>[marksCount];
+    bool marksOk = true;
+    for(unsigned int batch = 1; batch <= 4096; batch *= 8) {
+        for(unsigned int i = 0; i < marksCount; ++i) marks[i].store(0);
+        TMJobSystemParallelFor(gJobSystem, marksCount, batch, MarkRange, marks);
+        for(unsigned int i = 0; i < marksCount; ++i) {
+            if(marks[i].load() != 1) marksOk = false;
+        }
+    }
+    delete[] marks;
+    Check(marksOk, "parallel for visits every item once");
+
+    // manuel: what the game does, decodes queued while the main thread waits for a parallel for
+    gExecuted.store(0);
+    gMainThread = std::this_thread::get_id();
+    gBackgroundOnMain.store(0);
+    TMJobCounter background;
+    background.pending.store(0);
+    for(int i = 0; i < BENCH_BACKGROUND_JOBS; ++i) {
+        TMJobSystemRunBackground(gJobSystem, BackgroundJob, NULL, &background);
+    }
+    float *small = (float *)malloc(sizeof(float) * 100000);
+    for(int i = 0; i < 100; ++i) {
+        TMJobSystemParallelFor(gJobSystem, 100000, 1024, WorkRange, small);
+    }
+    free(small);
+    TMJobSystemWait(gJobSystem, &background);
+    Check(gExecuted.load() == BENCH_BACKGROUND_JOBS, "background jobs run once");
+    Check(gBackgroundOnMain.load() == 0, "waiting thread runs no background job");
+
+    // benchmark
+    float *values = (float *)malloc(sizeof(float) * BENCH_RANGE_COUNT);
+    double serialTime = 1e9, parallelTime = 1e9;
+    for(int run = 0; run < 5; ++run) {
+        start = GetTime();
+        WorkRange(values, 0, BENCH_RANGE_COUNT);
+        double time = GetTime() - start;
+        if(time < serialTime) serialTime = time;
+        start = GetTime();
+        TMJobSystemParallelFor(gJobSystem, BENCH_RANGE_COUNT, 16384, WorkRange, values);
+        time = GetTime() - start;
+        if(time < parallelTime) parallelTime = time;
+    }
+    free(values);
+
+    printf("\n%d empty jobs: %.1f ms, %.0f ns per job\n", BENCH_EMPTY_JOBS, emptyTime * 1000.0,
+           emptyTime * 1e9 / BENCH_EMPTY_JOBS);
+    printf("parallel for of %d items: serial %.2f ms, jobs %.2f ms, %.2fx\n", BENCH_RANGE_COUNT,
+           serialTime * 1000.0, parallelTime * 1000.0, serialTime / parallelTime);
+
+    TMJobSystemDestroy(gJobSystem);
+    return ChecksFailed() ? 1 : 0;
+}
@@ -0,0 +1,337 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// TMKtx2 and ETC2 encoder test. Writes KTX2 files of every supported format with
+// full mip chains and odd sizes and checks that TMKtx2Parse gives back the same
+// header and level data, that it rejects every truncation and a few corruptions of
+// a valid file, and that the level data sits on block boundaries. Then checks the
+// ETC2 / EAC decoder against blocks built by hand from the specification, and the
+// encoder by encoding and decoding images with a known error bound, through a
+// KTX2 file like tm_texconv writes them.
+// usage: tm_ktx2_test
+
+#include "utils/tm_ktx2.h"
+#include "tm_etc2.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static unsigned int gRandom = 0x12345678u;
+
+static unsigned int Random() {
+    gRandom ^= gRandom << 13;
+    gRandom ^= gRandom >> 17;
+    gRandom ^= gRandom << 5;
+    return gRandom;
+}
+
+static unsigned int LevelSize(unsigned int size, unsigned int level) {
+    size >>= level;
+    return size > 0 ? size : 1;
+}
+
+// a ktx2 with random level data, the levels are malloced
+static void MakeKtx2(unsigned int vkFormat, unsigned int width, unsigned int height, TMKtx2 *ktx2) {
+    unsigned int blockBytes, blockWidth, blockHeight;
+    TMKtx2FormatBlock(vkFormat, &blockBytes, &blockWidth, &blockHeight);
+    memset(ktx2, 0, sizeof(TMKtx2));
+    ktx2->vkFormat = vkFormat;
+    ktx2->width = width;
+    ktx2->height = height;
+    unsigned int size = width > height ? width : height;
+    ktx2->levelCount = 1;
+    while(size > 1) {
+        size >>= 1;
+        ktx2->levelCount++;
+    }
+    for(unsigned int i = 0; i < ktx2->levelCount; ++i) {
+        TMKtx2Level *level = ktx2->levels + i;
+        level->width = LevelSize(width, i);
+        level->height = LevelSize(height, i);
+        level->size = (size_t)((level->width + blockWidth - 1) / blockWidth) *
+                      ((level->height + blockHeight - 1) / blockHeight) * blockBytes;
+        unsigned char *data = (unsigned char *)malloc(level->size);
+        for(size_t b = 0; b < level->size; ++b) data[b] = (unsigned char)Random();
+        level->data = data;
+    }
+}
+
+static void FreeKtx2(TMKtx2 *ktx2) {
+    for(unsigned int i = 0; i < ktx2->levelCount; ++i) {
+        free((void *)ktx2->levels[i].data);
+    }
+}
+
+static bool SameKtx2(TMKtx2 *a, TMKtx2 *b, const unsigned char *file, unsigned int blockBytes) {
+    if(a->vkFormat != b->vkFormat || a->width != b->width || a->height != b->height ||
+       a->levelCount != b->levelCount) {
+        return false;
+    }
+    for(unsigned int i = 0; i < a->levelCount; ++i) {
+        TMKtx2Level *levelA = a->levels + i;
+        TMKtx2Level *levelB = b->levels + i;
+        if(levelA->width != levelB->width || levelA->height != levelB->height || levelA->size != levelB->size ||
+           memcmp(levelA->data, levelB->data, levelA->size) != 0) {
+            return false;
+        }
+        if((size_t)(levelB->data - file) % blockBytes != 0) return false;
+    }
+    return true;
+}
+
+static void TestKtx2(unsigned int vkFormat, const char *name) {
+    unsigned int blockBytes, blockWidth, blockHeight;
+    TMKtx2FormatBlock(vkFormat, &blockBytes, &blockWidth, &blockHeight);
+    char what[128];
+
+    bool roundTrip = true;
+    bool truncations = true;
+    const unsigned int sizes[][2] = {{1, 1}, {4, 4}, {13, 7}, {64, 256}, {300, 17}};
+    for(unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        TMKtx2 ktx2;
+        MakeKtx2(vkFormat, sizes[s][0], sizes[s][1], &ktx2);
+        size_t size = TMKtx2Write(&ktx2, NULL, 0);
+        unsigned char *file = (unsigned char *)malloc(size);
+        if(TMKtx2Write(&ktx2, file, size - 1) != 0) roundTrip = false;
+        if(TMKtx2Write(&ktx2, file, size) != size) roundTrip = false;
+
+        TMKtx2 parsed;
+        if(!TMKtx2Parse(file, size, &parsed) || !SameKtx2(&ktx2, &parsed, file, blockBytes)) {
+            roundTrip = false;
+        }
+        // manuel: every prefix of the file must fail to parse, not read past the end.
+        // The buffer is exactly that long so ASan catches any read past it
+        for(size_t length = 0; length < size; ++length) {
+            unsigned char *prefix = (unsigned char *)malloc(length ? length : 1);
+            memcpy(prefix, file, length);
+            if(TMKtx2Parse(prefix, length, &parsed)) truncations = false;
+            free(prefix);
+        }
+        free(file);
+        FreeKtx2(&ktx2);
+    }
+    snprintf(what, sizeof(what), "%s write / parse round trip", name);
+    Check(roundTrip, what);
+    snprintf(what, sizeof(what), "%s truncated files rejected", name);
+    Check(truncations, what);
+}
+
+static void WriteU32(unsigned char *dst, unsigned int value) {
+    dst[0] = (unsigned char)(value);
+    dst[1] = (unsigned char)(value >> 8);
+    dst[2] = (unsigned char)(value >> 16);
+    dst[3] = (unsigned char)(value >> 24);
+}
+
+// a valid file with one field changed
+static bool ParseCorrupted(unsigned int offset, unsigned int value) {
+    TMKtx2 ktx2;
+    MakeKtx2(TM_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, 64, 64, &ktx2);
+    size_t size = TMKtx2Write(&ktx2, NULL, 0);
+    unsigned char *file = (unsigned char *)malloc(size);
+    TMKtx2Write(&ktx2, file, size);
+    WriteU32(file + offset, value);
+    TMKtx2 parsed;
+    bool result = TMKtx2Parse(file, size, &parsed);
+    free(file);
+    FreeKtx2(&ktx2);
+    return result;
+}
+
+static void TestKtx2Corrupted() {
+    Check(!ParseCorrupted(0, 0x12345678), "bad identifier rejected");
+    Check(!ParseCorrupted(20, 65), "width that does not match the levels rejected");
+    Check(!ParseCorrupted(28, 2), "3D texture rejected");
+    Check(!ParseCorrupted(36, 6), "cube map rejected");
+    Check(!ParseCorrupted(40, TM_KTX2_MAX_LEVELS + 1), "too many levels rejected");
+    Check(!ParseCorrupted(44, 1), "supercompressed file rejected");
+    // level 0 offset past the end of the file
+    Check(!ParseCorrupted(80, 0x7FFFFFFF), "level out of the file rejected");
+    // level 0 length overflowing offset + length
+    Check(!ParseCorrupted(88, 0xFFFFFFFF), "level length overflow rejected");
+}
+
+// manuel: decoder checks against blocks built from the spec, so an encoder and
+// a decoder that agree on the same mistake still fail here
+static void TestEtc2Decode() {
+    unsigned char pixels[64];
+
+    // individual mode, base 0x8 (136) in both subblocks, table 0, every index 00 (+2)
+    unsigned char individual[8] = {0x88, 0x88, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00};
+    // texel (0, 0) is bit 0 of both index halves, 11 is -8
+    individual[5] = 0x01;
+    individual[7] = 0x01;
+    TMEtc2DecodeRGB(individual, pixels);
+    bool ok = pixels[0] == 128 && pixels[1] == 128 && pixels[2] == 128 && pixels[3] == 255;
+    for(int i = 1; i < 16; ++i) {
+        if(pixels[i * 4] != 138 || pixels[i * 4 + 1] != 138 || pixels[i * 4 + 2] != 138) ok = false;
+    }
+    Check(ok, "ETC1 individual block decoded");
+
+    // differential mode, base 16 (132) and delta -1 (15 -> 123) for red only,
+    // not flipped so the left two columns are the first subblock
+    unsigned char differential[8] = {(16 << 3) | 7, 16 << 3, 16 << 3, 0x02, 0x00, 0x00, 0x00, 0x00};
+    TMEtc2DecodeRGB(differential, pixels);
+    ok = true;
+    for(int y = 0; y < 4; ++y) {
+        for(int x = 0; x < 4; ++x) {
+            unsigned char *texel = pixels + (y * 4 + x) * 4;
+            int red = x < 2 ? 134 : 125;
+            if(texel[0] != red || texel[1] != 134 || texel[2] != 134) ok = false;
+        }
+    }
+    Check(ok, "ETC1 differential block decoded");
+
+    // same block flipped, the top two rows are the first subblock
+    differential[3] |= 0x01;
+    TMEtc2DecodeRGB(differential, pixels);
+    ok = true;
+    for(int y = 0; y < 4; ++y) {
+        for(int x = 0; x < 4; ++x) {
+            if(pixels[(y * 4 + x) * 4] != (y < 2 ? 134 : 125)) ok = false;
+        }
+    }
+    Check(ok, "ETC1 flipped differential block decoded");
+
+    // EAC alpha: base 128, multiplier 2, table 0, texel (0, 0) index 7 (+14), the rest 0 (-3)
+    unsigned char alpha[16] = {128, (2 << 4) | 0, 7 << 5, 0, 0, 0, 0, 0,
+                               0x88, 0x88, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00};
+    TMEtc2DecodeRGBA(alpha, pixels);
+    ok = pixels[3] == 156 && pixels[0] == 138;
+    for(int i = 1; i < 16; ++i) {
+        if(pixels[i * 4 + 3] != 122) ok = false;
+    }
+    Check(ok, "EAC alpha block decoded");
+}
+
+// encodes a width x height RGBA8 image block by block into a one level KTX2 file,
+// parses it back, decodes it and returns the PSNR of the chosen channels
+static double EncodeRoundTrip(const unsigned char *image, int width, int height, bool alpha, bool *parsed) {
+    int blocksX = (width + 3) / 4;
+    int blocksY = (height + 3) / 4;
+    unsigned int blockBytes = alpha ? 16 : 8;
+    unsigned char *blocks = (unsigned char *)malloc((size_t)blocksX * blocksY * blockBytes);
+    for(int by = 0; by < blocksY; ++by) {
+        for(int bx = 0; bx < blocksX; ++bx) {
+            // manuel: edge blocks repeat the last row / column, like tm_texconv
+            unsigned char texels[64];
+            for(int y = 0; y < 4; ++y) {
+                for(int x = 0; x < 4; ++x) {
+                    int sx = bx * 4 + x < width ? bx * 4 + x : width - 1;
+                    int sy = by * 4 + y < height ? by * 4 + y : height - 1;
+                    memcpy(texels + (y * 4 + x) * 4, image + ((size_t)sy * width + sx) * 4, 4);
+                }
+            }
+            unsigned char *block = blocks + ((size_t)by * blocksX + bx) * blockBytes;
+            if(alpha) TMEtc2EncodeRGBA(texels, block);
+            else TMEtc2EncodeRGB(texels, block);
+        }
+    }
+
+    TMKtx2 ktx2;
+    memset(&ktx2, 0, sizeof(TMKtx2));
+    ktx2.vkFormat = alpha ? TM_VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK : TM_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+    ktx2.width = width;
+    ktx2.height = height;
+    ktx2.levelCount = 1;
+    ktx2.levels[0].data = blocks;
+    ktx2.levels[0].size = (size_t)blocksX * blocksY * blockBytes;
+    ktx2.levels[0].width = width;
+    ktx2.levels[0].height = height;
+    size_t size = TMKtx2Write(&ktx2, NULL, 0);
+    unsigned char *file = (unsigned char *)malloc(size);
+    TMKtx2Write(&ktx2, file, size);
+    free(blocks);
+
+    TMKtx2 result;
+    *parsed = TMKtx2Parse(file, size, &result) && result.vkFormat == ktx2.vkFormat &&
+              result.levels[0].size == ktx2.levels[0].size;
+    double squaredError = 0.0;
+    if(*parsed) {
+        for(int by = 0; by < blocksY; ++by) {
+            for(int bx = 0; bx < blocksX; ++bx) {
+                unsigned char decoded[64];
+                const unsigned char *block = result.levels[0].data + ((size_t)by * blocksX + bx) * blockBytes;
+                if(alpha) TMEtc2DecodeRGBA(block, decoded);
+                else TMEtc2DecodeRGB(block, decoded);
+                for(int y = 0; y < 4 && by * 4 + y < height; ++y) {
+                    for(int x = 0; x < 4 && bx * 4 + x < width; ++x) {
+                        const unsigned char *src = image + ((size_t)(by * 4 + y) * width + bx * 4 + x) * 4;
+                        const unsigned char *dst = decoded + (y * 4 + x) * 4;
+                        for(int c = 0; c < (alpha ? 4 : 3); ++c) {
+                            double d = (double)src[c] - (double)dst[c];
+                            squaredError += d * d;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    free(file);
+    double mse = squaredError / ((double)width * height * (alpha ? 4 : 3));
+    return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+static void TestEtc2Encode() {
+    const int width = 61;
+    const int height = 35;
+    unsigned char *image = (unsigned char *)malloc((size_t)width * height * 4);
+    char what[128];
+    bool parsed;
+
+    // solid colors only lose the 4 / 5 bit quantization, the modifiers close most of it
+    // but the three channels share one modifier
+    bool solid = true;
+    for(int i = 0; i < 4096; ++i) {
+        unsigned char color[4] = {(unsigned char)Random(), (unsigned char)Random(), (unsigned char)Random(), 255};
+        unsigned char texels[64], block[8], decoded[64];
+        for(int t = 0; t < 16; ++t) memcpy(texels + t * 4, color, 4);
+        TMEtc2EncodeRGB(texels, block);
+        TMEtc2DecodeRGB(block, decoded);
+        for(int t = 0; t < 16; ++t) {
+            for(int c = 0; c < 3; ++c) {
+                if(abs((int)decoded[t * 4 + c] - (int)color[c]) > 8) solid = false;
+            }
+        }
+    }
+    Check(solid, "solid blocks within 8 levels");
+
+    for(int y = 0; y < height; ++y) {
+        for(int x = 0; x < width; ++x) {
+            unsigned char *texel = image + ((size_t)y * width + x) * 4;
+            texel[0] = (unsigned char)(x * 255 / (width - 1));
+            texel[1] = (unsigned char)(y * 255 / (height - 1));
+            texel[2] = (unsigned char)((x + y) * 255 / (width + height - 2));
+            texel[3] = (unsigned char)(255 - x * 255 / (width - 1));
+        }
+    }
+    double psnr = EncodeRoundTrip(image, width, height, false, &parsed);
+    snprintf(what, sizeof(what), "RGB gradient through KTX2, PSNR %.1f dB", psnr);
+    Check(parsed && psnr > 35.0, what);
+    psnr = EncodeRoundTrip(image, width, height, true, &parsed);
+    snprintf(what, sizeof(what), "RGBA gradient through KTX2, PSNR %.1f dB", psnr);
+    Check(parsed && psnr > 35.0, what);
+
+    // manuel: noise is the worst case for a block codec, it only has to stay sane
+    for(int i = 0; i < width * height * 4; ++i) image[i] = (unsigned char)Random();
+    psnr = EncodeRoundTrip(image, width, height, true, &parsed);
+    snprintf(what, sizeof(what), "RGBA noise through KTX2, PSNR %.1f dB", psnr);
+    Check(parsed && psnr > 10.0, what);
+    free(image);
+}
+
+int main() {
+    TestKtx2(TM_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, "ETC2 RGB8");
+    TestKtx2(TM_VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, "ETC2 RGBA8");
+    TestKtx2(TM_VK_FORMAT_ASTC_4x4_UNORM_BLOCK, "ASTC 4x4");
+    TestKtx2(TM_VK_FORMAT_ASTC_8x8_UNORM_BLOCK, "ASTC 8x8");
+    TestKtx2Corrupted();
+    TestEtc2Decode();
+    TestEtc2Encode();
+    if(ChecksFailed()) return 1;
+    return 0;
+}
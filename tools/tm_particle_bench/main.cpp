@@ -0,0 +1,176 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// Particle system benchmark with the effects of the game: a trail emitter on each of
+// a few moving balls and a shower of sparks on every hit, enough hits to keep the
+// system near full. Times the update and the instance packing of every frame and
+// checks that the count never passes the capacity, that every packed instance is
+// finite with a size >= 0, and that everything dies once the emitters are gone.
+// The checksum of the packed instances is the same with and without TM_PARTICLE_NO_SIMD.
+// usage: tm_particle_bench [hits_per_frame]
+
+#include "tm_particle_system.h"
+#include "tm_renderer.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+// same as GAME_MAX_PARTICLES and GAME_MAX_TRAILS
+#define BENCH_MAX_PARTICLES 32768
+#define BENCH_TRAILS 8
+#define BENCH_FRAMES 600
+#define BENCH_DT (1.0f / 60.0f)
+
+// manuel: copies of gSparksDesc and gTrailDesc in game.cpp
+static const TMParticleEmitterDesc gSparksDesc = {
+        2000.0f, 150, 0.08f,
+        0.0f, 3.14159265f,
+        400.0f, 1400.0f,
+        0.3f, 0.8f,
+        12.0f, 28.0f, 0.3f,
+        TMVec2{0, -1500},
+        TMVec4{1.0f, 0.9f, 0.5f, 1.0f},
+        TMVec4{1.0f, 0.3f, 0.0f, 0.0f}
+};
+
+static const TMParticleEmitterDesc gTrailDesc = {
+        600.0f, 0, 0.0f,
+        0.0f, 3.14159265f,
+        20.0f, 60.0f,
+        0.4f, 0.7f,
+        40.0f, 80.0f, 0.1f,
+        TMVec2{0, 0},
+        TMVec4{1.0f, 1.0f, 0.8f, 0.6f},
+        TMVec4{1.0f, 0.5f, 0.1f, 0.0f}
+};
+
+// manuel: the renderer side the particle system talks to, it keeps what would be
+// uploaded so the frame can check and hash it outside of the timing
+struct TMInstanceBuffer {
+    unsigned int maxInstances;
+    TMInstance *instances;
+    unsigned int instancesCount;
+};
+
+static uint64_t gChecksum = 14695981039346656037ull;
+static bool gInstancesValid = true;
+static unsigned int gDrawnCount;
+
+// the one the particle system created
+static TMInstanceBuffer *gLastInstanceBuffer;
+
+TMInstanceBuffer *TMRendererInstanceBufferCreate(TMRenderer *, unsigned int maxInstances) {
+    TMInstanceBuffer *instanceBuffer = (TMInstanceBuffer *)malloc(sizeof(TMInstanceBuffer));
+    gLastInstanceBuffer = instanceBuffer;
+    instanceBuffer->maxInstances = maxInstances;
+    instanceBuffer->instances = NULL;
+    instanceBuffer->instancesCount = 0;
+    return instanceBuffer;
+}
+
+void TMRendererInstanceBufferDestroy(TMRenderer *, TMInstanceBuffer *instanceBuffer) {
+    free(instanceBuffer);
+}
+
+void TMRendererInstanceBufferUpdate(TMInstanceBuffer *instanceBuffer, TMInstance *instances,
+                                    unsigned int instancesCount) {
+    if(instancesCount > instanceBuffer->maxInstances) gInstancesValid = false;
+    instanceBuffer->instances = instances;
+    instanceBuffer->instancesCount = instancesCount;
+}
+
+void TMRendererDrawBufferInstanced(TMBuffer, TMInstanceBuffer *, unsigned int instancesCount) {
+    gDrawnCount = instancesCount;
+}
+
+static void HashInstances(TMInstanceBuffer *instanceBuffer) {
+    for(unsigned int i = 0; i < instanceBuffer->instancesCount; ++i) {
+        TMInstance *instance = instanceBuffer->instances + i;
+        if(!isfinite(instance->position.x) || !isfinite(instance->position.y) || !(instance->scale.x >= 0.0f)) {
+            gInstancesValid = false;
+        }
+        const unsigned char *bytes = (const unsigned char *)instance;
+        for(unsigned int b = 0; b < sizeof(TMInstance); ++b) {
+            gChecksum = (gChecksum ^ bytes[b]) * 1099511628211ull;
+        }
+    }
+    instanceBuffer->instancesCount = 0;
+}
+
+static unsigned int gRandom = 1234567u;
+
+static float RandomFloat(float min, float max) {
+    gRandom ^= gRandom << 13;
+    gRandom ^= gRandom >> 17;
+    gRandom ^= gRandom << 5;
+    return min + (max - min) * (float)(gRandom >> 8) * (1.0f / 16777216.0f);
+}
+
+int main(int argc, char **argv) {
+    int hitsPerFrame = argc > 1 ? atoi(argv[1]) : 4;
+    if(hitsPerFrame < 0) hitsPerFrame = 0;
+#if defined(TM_PARTICLE_NO_SIMD)
+    printf("scalar, %d hits per frame\n", hitsPerFrame);
+#else
+    printf("simd, %d hits per frame\n", hitsPerFrame);
+#endif
+
+    TMParticleSystem *system = TMParticleSystemCreate(NULL, BENCH_MAX_PARTICLES);
+    TMInstanceBuffer *instanceBuffer = gLastInstanceBuffer;
+    TMParticleEmitter *trails[BENCH_TRAILS];
+    for(int i = 0; i < BENCH_TRAILS; ++i) {
+        trails[i] = TMParticleEmitterCreate(system, &gTrailDesc, TMVec2{0, 0});
+    }
+    TMBuffer quad{1};
+
+    double updateTime = 0.0;
+    double drawTime = 0.0;
+    unsigned int peakCount = 0;
+    bool underCapacity = true;
+    for(int frame = 0; frame < BENCH_FRAMES; ++frame) {
+        float t = (float)frame * BENCH_DT;
+        for(int i = 0; i < BENCH_TRAILS; ++i) {
+            TMParticleEmitterSetPosition(trails[i], TMVec2{cosf(t * 2.0f + (float)i) * 500.0f,
+                                                          sinf(t * 3.0f + (float)i) * 800.0f});
+        }
+        for(int i = 0; i < hitsPerFrame; ++i) {
+            TMParticleEmitterCreate(system, &gSparksDesc, TMVec2{RandomFloat(-500, 500), RandomFloat(-800, 800)});
+        }
+        double start = GetTime();
+        TMParticleSystemUpdate(system, BENCH_DT);
+        double middle = GetTime();
+        TMParticleSystemDraw(system, quad);
+        double end = GetTime();
+        updateTime += middle - start;
+        drawTime += end - middle;
+        HashInstances(instanceBuffer);
+
+        unsigned int count = TMParticleSystemGetCount(system);
+        if(count > BENCH_MAX_PARTICLES || gDrawnCount != count) underCapacity = false;
+        if(count > peakCount) peakCount = count;
+    }
+
+    printf("peak %u particles, update %.3f ms, pack %.3f ms per frame\n", peakCount,
+           updateTime * 1000.0 / BENCH_FRAMES, drawTime * 1000.0 / BENCH_FRAMES);
+    printf("checksum %016llx\n", (unsigned long long)gChecksum);
+    Check(underCapacity, "count stays within the capacity");
+    Check(gInstancesValid, "packed instances are finite");
+
+    // the sparks stop on their own, the trails go with their emitter. Nothing lives past 0.8 s
+    for(int i = 0; i < BENCH_TRAILS; ++i) {
+        TMParticleEmitterDestroy(system, trails[i]);
+    }
+    for(int frame = 0; frame < 60; ++frame) {
+        TMParticleSystemUpdate(system, BENCH_DT);
+    }
+    Check(TMParticleSystemGetCount(system) == 0, "everything dies without emitters");
+
+    TMParticleSystemDestroy(NULL, system);
+    if(ChecksFailed()) return 1;
+    return 0;
+}
@@ -0,0 +1,396 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// TMMemoryPool and TMConcurrentPool test and benchmark. The test checks that chunks
+// are aligned and never overlap through growth, reserve, bulk alloc / free and reset,
+// that a virtual pool gives empty blocks back and maps them again, and that the
+// concurrent pool hands every chunk to one thread at a time with chunks freed by other
+// threads. The benchmark times the pool against malloc / free with a stack like pattern,
+// a random pattern and bulk operations, then the concurrent pool against a locked
+// TMMemoryPool and malloc from 1 to maxThreads threads.
+// usage: tm_pool_bench [chunkSize] [maxThreads]
+
+#include "utils/tm_memory_pool.h"
+#include "utils/tm_concurrent_pool.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#define BENCH_CHUNKS 100000
+#define BENCH_ROUNDS 50
+#define BENCH_RANDOM_OPS 10000000
+#define BENCH_MAX_THREADS 64
+// chunks each thread holds at once in the threaded tests
+#define BENCH_THREAD_CHUNKS 256
+#define BENCH_THREAD_ROUNDS 200
+#define BENCH_THREAD_OPS 2000000
+
+static unsigned int gRandom = 0x12345678u;
+
+static unsigned int Random() {
+    gRandom ^= gRandom << 13;
+    gRandom ^= gRandom >> 17;
+    gRandom ^= gRandom << 5;
+    return gRandom;
+}
+
+// every live chunk holds its own index, a chunk handed out twice gets overwritten
+static bool ChunksIntact(void **chunks, unsigned int count, unsigned int chunkSize) {
+    for(unsigned int i = 0; i < count; ++i) {
+        if(chunks[i] && memcmp(chunks[i], &i, sizeof(unsigned int)) != 0) return false;
+        for(unsigned int b = sizeof(unsigned int); b < chunkSize; ++b) {
+            if(chunks[i] && ((unsigned char *)chunks[i])[b] != (unsigned char)i) return false;
+        }
+    }
+    return true;
+}
+
+static void Fill(void *chunk, unsigned int i, unsigned int chunkSize) {
+    memset(chunk, (unsigned char)i, chunkSize);
+    memcpy(chunk, &i, sizeof(unsigned int));
+}
+
+static bool ChunksAligned(void **chunks, unsigned int count, unsigned int alignment) {
+    for(unsigned int i = 0; i < count; ++i) {
+        if(chunks[i] && ((uintptr_t)chunks[i] & (alignment - 1)) != 0) return false;
+    }
+    return true;
+}
+
+static void Test(unsigned int chunkSize) {
+    void **chunks = (void **)calloc(BENCH_CHUNKS, sizeof(void *));
+    TMMemoryPool *pool = TMMemoryPoolCreate(chunkSize, 16);
+
+    for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) {
+        chunks[i] = TMMemoryPoolAlloc(pool);
+        Fill(chunks[i], i, chunkSize);
+    }
+    Check(ChunksIntact(chunks, BENCH_CHUNKS, chunkSize), "grow");
+    Check(ChunksAligned(chunks, BENCH_CHUNKS, TM_MEMORY_POOL_DEFAULT_ALIGNMENT), "default alignment");
+    Check(pool->blockCount < 32, "few blocks after growth");
+    Check(pool->chunkCount - pool->freeCount == BENCH_CHUNKS, "counts after growth");
+
+    for(unsigned int op = 0; op < 1000000; ++op) {
+        unsigned int i = Random() % BENCH_CHUNKS;
+        if(chunks[i]) {
+            TMMemoryPoolFree(pool, chunks[i]);
+            chunks[i] = NULL;
+        } else {
+            chunks[i] = TMMemoryPoolAlloc(pool);
+            Fill(chunks[i], i, chunkSize);
+        }
+    }
+    Check(ChunksIntact(chunks, BENCH_CHUNKS, chunkSize), "random alloc / free");
+
+    // free the live ones in bulk and take them back in bulk
+    unsigned int liveCount = 0;
+    void **live = (void **)malloc(sizeof(void *) * BENCH_CHUNKS);
+    for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) {
+        if(chunks[i]) live[liveCount++] = chunks[i];
+    }
+    TMMemoryPoolFreeBulk(pool, live, liveCount);
+    Check(pool->freeCount == pool->chunkCount, "free bulk");
+    unsigned int blocks = pool->blockCount;
+    bool allocated = TMMemoryPoolAllocBulk(pool, chunks, BENCH_CHUNKS);
+    for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) Fill(chunks[i], i, chunkSize);
+    Check(allocated && ChunksIntact(chunks, BENCH_CHUNKS, chunkSize) && pool->blockCount == blocks, "alloc bulk");
+
+    TMMemoryPoolReset(pool);
+    Check(pool->freeCount == pool->chunkCount, "reset");
+    TMMemoryPoolReserve(pool, pool->chunkCount + 1000);
+    blocks = pool->blockCount;
+    unsigned int reserved = pool->freeCount;
+    for(unsigned int i = 0; i < reserved; ++i) TMMemoryPoolAlloc(pool);
+    Check(pool->blockCount == blocks && pool->freeCount == 0, "reserve");
+
+    free(live);
+    TMMemoryPoolDestroy(pool);
+    free(chunks);
+}
+
+static void TestVirtual(unsigned int chunkSize) {
+    void **chunks = (void **)calloc(BENCH_CHUNKS, sizeof(void *));
+    TMMemoryPool *pool = TMMemoryPoolCreateVirtual(chunkSize, 64, TM_MEMORY_POOL_MAX_ALIGNMENT, (size_t)1 << 30);
+
+    for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) {
+        chunks[i] = TMMemoryPoolAlloc(pool);
+        Fill(chunks[i], i, chunkSize);
+    }
+    Check(ChunksIntact(chunks, BENCH_CHUNKS, chunkSize), "virtual grow");
+    Check(ChunksAligned(chunks, BENCH_CHUNKS, TM_MEMORY_POOL_MAX_ALIGNMENT), "virtual cache line alignment");
+    unsigned int peakChunks = pool->chunkCount;
+    unsigned int peakBlocks = pool->blockCount;
+
+    // random frees leave every block partly used, nothing can go back
+    for(unsigned int i = 0; i < BENCH_CHUNKS; i += 2) {
+        TMMemoryPoolFree(pool, chunks[i]);
+        chunks[i] = NULL;
+    }
+    Check(pool->chunkCount == peakChunks && ChunksIntact(chunks, BENCH_CHUNKS, chunkSize), "virtual partly used blocks stay");
+
+    // in order frees empty whole blocks, they are given back keeping a block of slack
+    for(unsigned int i = 1; i < BENCH_CHUNKS; i += 2) {
+        TMMemoryPoolFree(pool, chunks[i]);
+        chunks[i] = NULL;
+    }
+    Check(pool->chunkCount <= 2 * pool->chunksPerBlock && pool->freeCount == pool->chunkCount, "virtual trim on free");
+
+    // mapped again, no new address space
+    for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) {
+        chunks[i] = TMMemoryPoolAlloc(pool);
+        Fill(chunks[i], i, chunkSize);
+    }
+    Check(ChunksIntact(chunks, BENCH_CHUNKS, chunkSize) && pool->blockCount == peakBlocks, "virtual regrow");
+
+    TMMemoryPoolFreeBulk(pool, chunks, BENCH_CHUNKS);
+    bool allocated = TMMemoryPoolAllocBulk(pool, chunks, BENCH_CHUNKS);
+    for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) Fill(chunks[i], i, chunkSize);
+    Check(allocated && ChunksIntact(chunks, BENCH_CHUNKS, chunkSize), "virtual bulk");
+
+    TMMemoryPoolReset(pool);
+    TMMemoryPoolTrim(pool);
+    Check(pool->chunkCount == 0 && pool->freeCount == 0, "virtual reset and trim");
+    Check(TMMemoryPoolAlloc(pool) != NULL, "virtual alloc after trim");
+    TMMemoryPoolDestroy(pool);
+
+    // a reservation of one block runs out
+    pool = TMMemoryPoolCreateVirtual(chunkSize, 1, TM_MEMORY_POOL_DEFAULT_ALIGNMENT, 1);
+    unsigned int count = 0;
+    while((chunks[count] = TMMemoryPoolAlloc(pool)) != NULL) count++;
+    Check(count == pool->chunksPerBlock, "virtual reservation full");
+    void *extra[2];
+    Check(!TMMemoryPoolAllocBulk(pool, extra, 1) && pool->freeCount == 0, "virtual alloc bulk on a full reservation");
+    TMMemoryPoolFree(pool, chunks[0]);
+    Check(!TMMemoryPoolAllocBulk(pool, extra, 2) && pool->freeCount == 1 &&
+          TMMemoryPoolAllocBulk(pool, extra, 1) && extra[0] == chunks[0], "virtual alloc bulk takes all or nothing");
+    TMMemoryPoolDestroy(pool);
+
+    free(chunks);
+}
+
+static void Bench(unsigned int chunkSize) {
+    void **chunks = (void **)malloc(sizeof(void *) * BENCH_CHUNKS);
+    unsigned int *order = (unsigned int *)malloc(sizeof(unsigned int) * BENCH_RANDOM_OPS);
+    for(unsigned int i = 0; i < BENCH_RANDOM_OPS; ++i) order[i] = Random() % BENCH_CHUNKS;
+    double ops = (double)BENCH_CHUNKS * BENCH_ROUNDS * 2;
+    printf("\n%u byte chunks, ns per alloc or free\n", chunkSize);
+
+    // fill and empty, the first round of the pool includes its growth
+    TMMemoryPool *pool = TMMemoryPoolCreate(chunkSize, 64);
+    double start = GetTime();
+    for(int r = 0; r < BENCH_ROUNDS; ++r) {
+        for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) chunks[i] = TMMemoryPoolAlloc(pool);
+        for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) TMMemoryPoolFree(pool, chunks[i]);
+    }
+    double poolTime = GetTime() - start;
+    start = GetTime();
+    for(int r = 0; r < BENCH_ROUNDS; ++r) {
+        TMMemoryPoolAllocBulk(pool, chunks, BENCH_CHUNKS);
+        TMMemoryPoolFreeBulk(pool, chunks, BENCH_CHUNKS);
+    }
+    double bulkTime = GetTime() - start;
+    // manuel: empty blocks are given back on every round and mapped again on the next
+    TMMemoryPool *virtualPool = TMMemoryPoolCreateVirtual(chunkSize, 64, TM_MEMORY_POOL_DEFAULT_ALIGNMENT,
+                                                          (size_t)1 << 30);
+    start = GetTime();
+    for(int r = 0; r < BENCH_ROUNDS; ++r) {
+        for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) chunks[i] = TMMemoryPoolAlloc(virtualPool);
+        for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) TMMemoryPoolFree(virtualPool, chunks[i]);
+    }
+    double virtualTime = GetTime() - start;
+    start = GetTime();
+    for(int r = 0; r < BENCH_ROUNDS; ++r) {
+        for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) chunks[i] = malloc(chunkSize);
+        for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) free(chunks[i]);
+    }
+    double mallocTime = GetTime() - start;
+    printf("%-20s pool %6.2f  bulk %6.2f  virtual %6.2f  malloc %6.2f\n", "fill and empty",
+           poolTime / ops * 1e9, bulkTime / ops * 1e9, virtualTime / ops * 1e9, mallocTime / ops * 1e9);
+
+    // random frees and allocs over a half full set
+    memset(chunks, 0, sizeof(void *) * BENCH_CHUNKS);
+    start = GetTime();
+    for(unsigned int op = 0; op < BENCH_RANDOM_OPS; ++op) {
+        unsigned int i = order[op];
+        if(chunks[i]) {
+            TMMemoryPoolFree(pool, chunks[i]);
+            chunks[i] = NULL;
+        } else {
+            chunks[i] = TMMemoryPoolAlloc(pool);
+        }
+    }
+    poolTime = GetTime() - start;
+    TMMemoryPoolReset(pool);
+    memset(chunks, 0, sizeof(void *) * BENCH_CHUNKS);
+    start = GetTime();
+    for(unsigned int op = 0; op < BENCH_RANDOM_OPS; ++op) {
+        unsigned int i = order[op];
+        if(chunks[i]) {
+            TMMemoryPoolFree(virtualPool, chunks[i]);
+            chunks[i] = NULL;
+        } else {
+            chunks[i] = TMMemoryPoolAlloc(virtualPool);
+        }
+    }
+    virtualTime = GetTime() - start;
+    TMMemoryPoolDestroy(virtualPool);
+    memset(chunks, 0, sizeof(void *) * BENCH_CHUNKS);
+    start = GetTime();
+    for(unsigned int op = 0; op < BENCH_RANDOM_OPS; ++op) {
+        unsigned int i = order[op];
+        if(chunks[i]) {
+            free(chunks[i]);
+            chunks[i] = NULL;
+        } else {
+            chunks[i] = malloc(chunkSize);
+        }
+    }
+    mallocTime = GetTime() - start;
+    for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) free(chunks[i]);
+    printf("%-20s pool %6.2f  bulk %6s  virtual %6.2f  malloc %6.2f\n", "random",
+           poolTime / BENCH_RANDOM_OPS * 1e9, "-", virtualTime / BENCH_RANDOM_OPS * 1e9,
+           mallocTime / BENCH_RANDOM_OPS * 1e9);
+
+    // manuel: every other chunk first, then the rest empty a block on almost every
+    // free while the free chunks of all the other blocks stay around
+    virtualPool = TMMemoryPoolCreateVirtual(chunkSize, 64, TM_MEMORY_POOL_DEFAULT_ALIGNMENT, (size_t)1 << 30);
+    for(unsigned int i = 0; i < BENCH_CHUNKS; ++i) chunks[i] = TMMemoryPoolAlloc(virtualPool);
+    for(unsigned int i = 0; i < BENCH_CHUNKS; i += 2) TMMemoryPoolFree(virtualPool, chunks[i]);
+    start = GetTime();
+    for(unsigned int i = 1; i < BENCH_CHUNKS; i += 2) TMMemoryPoolFree(virtualPool, chunks[i]);
+    virtualTime = GetTime() - start;
+    TMMemoryPoolDestroy(virtualPool);
+    printf("%-20s pool %6s  bulk %6s  virtual %6.2f  malloc %6s\n", "fragmented free", "-", "-",
+           virtualTime / (BENCH_CHUNKS / 2) * 1e9, "-");
+
+    TMMemoryPoolDestroy(pool);
+    free(order);
+    free(chunks);
+}
+
+static unsigned int ThreadStamp(int round, int thread, int i) {
+    return ((unsigned int)round * BENCH_MAX_THREADS + (unsigned int)thread) * BENCH_THREAD_CHUNKS + (unsigned int)i;
+}
+
+// Every round each thread frees the chunks the thread before it allocated in the last
+// round, after checking they still hold that thread's stamp, and allocates new ones.
+// The chunks of a round and of the round before live in different arrays
+static void TestConcurrent(unsigned int chunkSize, int threadsCount) {
+    TMConcurrentPool *pool = TMConcurrentPoolCreate(chunkSize, 64);
+    size_t roundSize = (size_t)threadsCount * BENCH_THREAD_CHUNKS;
+    void **chunks[2];
+    chunks[0] = (void **)calloc(roundSize, sizeof(void *));
+    chunks[1] = (void **)calloc(roundSize, sizeof(void *));
+    std::atomic<int> corrupted(0);
+    std::thread threads[BENCH_MAX_THREADS];
+    for(int round = 0; round <= BENCH_THREAD_ROUNDS; ++round) {
+        for(int t = 0; t < threadsCount; ++t) {
+            threads[t] = std::thread([&, t, round] {
+                int before = (t + threadsCount - 1) % threadsCount;
+                void **previous = chunks[(round + 1) & 1] + (size_t)before * BENCH_THREAD_CHUNKS;
+                void **current = chunks[round & 1] + (size_t)t * BENCH_THREAD_CHUNKS;
+                for(int i = 0; round > 0 && i < BENCH_THREAD_CHUNKS; ++i) {
+                    unsigned int stamp = ThreadStamp(round - 1, before, i);
+                    if(memcmp(previous[i], &stamp, sizeof(unsigned int)) != 0) corrupted++;
+                    TMConcurrentPoolFree(pool, previous[i]);
+                }
+                if(round == BENCH_THREAD_ROUNDS) return;
+                for(int i = 0; i < BENCH_THREAD_CHUNKS; ++i) {
+                    current[i] = TMConcurrentPoolAlloc(pool);
+                    unsigned int stamp = ThreadStamp(round, t, i);
+                    memset(current[i], 0, chunkSize);
+                    memcpy(current[i], &stamp, sizeof(unsigned int));
+                }
+            });
+        }
+        for(int t = 0; t < threadsCount; ++t) threads[t].join();
+    }
+    char what[64];
+    snprintf(what, sizeof(what), "concurrent pool, %d threads", threadsCount);
+    Check(corrupted.load() == 0 && TMConcurrentPoolGetCapacity(pool) < 4 * roundSize + 1024, what);
+    free(chunks[0]);
+    free(chunks[1]);
+    TMConcurrentPoolDestroy(pool);
+}
+
+// every thread keeps a window of live chunks, frees the oldest and allocates a new one
+template<typename Alloc, typename Free>
+static double BenchThreads(int threadsCount, Alloc alloc, Free free) {
+    std::thread threads[BENCH_MAX_THREADS];
+    double start = GetTime();
+    for(int t = 0; t < threadsCount; ++t) {
+        threads[t] = std::thread([&] {
+            void *window[BENCH_THREAD_CHUNKS];
+            for(int i = 0; i < BENCH_THREAD_CHUNKS; ++i) window[i] = alloc();
+            for(int op = 0; op < BENCH_THREAD_OPS; ++op) {
+                int i = op % BENCH_THREAD_CHUNKS;
+                free(window[i]);
+                window[i] = alloc();
+            }
+            for(int i = 0; i < BENCH_THREAD_CHUNKS; ++i) free(window[i]);
+        });
+    }
+    for(int t = 0; t < threadsCount; ++t) threads[t].join();
+    double ops = (double)threadsCount * (BENCH_THREAD_OPS + BENCH_THREAD_CHUNKS) * 2;
+    return (GetTime() - start) / ops * 1e9;
+}
+
+static void BenchConcurrent(unsigned int chunkSize, int threadsCount) {
+    if(threadsCount == 1) {
+        printf("\n%u byte chunks, ns per alloc or free over all threads\n", chunkSize);
+        TMMemoryPool *pool = TMMemoryPoolCreate(chunkSize, 64);
+        double single = BenchThreads(1, [pool] { return TMMemoryPoolAlloc(pool); },
+                                     [pool](void *mem) { TMMemoryPoolFree(pool, mem); });
+        TMMemoryPoolDestroy(pool);
+        printf("%-12s %8.2f\n", "pool 1 thread", single);
+    }
+
+    TMConcurrentPool *concurrent = TMConcurrentPoolCreate(chunkSize, 64);
+    double concurrentTime = BenchThreads(threadsCount, [concurrent] { return TMConcurrentPoolAlloc(concurrent); },
+                                         [concurrent](void *mem) { TMConcurrentPoolFree(concurrent, mem); });
+    TMConcurrentPoolDestroy(concurrent);
+
+    TMMemoryPool *pool = TMMemoryPoolCreate(chunkSize, 64);
+    std::mutex mutex;
+    double lockedTime = BenchThreads(threadsCount, [pool, &mutex] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return TMMemoryPoolAlloc(pool);
+    }, [pool, &mutex](void *mem) {
+        std::lock_guard<std::mutex> lock(mutex);
+        TMMemoryPoolFree(pool, mem);
+    });
+    TMMemoryPoolDestroy(pool);
+
+    double mallocTime = BenchThreads(threadsCount, [chunkSize] { return malloc(chunkSize); },
+                                     [](void *mem) { free(mem); });
+    printf("%2d threads   concurrent %6.2f  locked pool %6.2f  malloc %6.2f\n",
+           threadsCount, concurrentTime, lockedTime, mallocTime);
+}
+
+int main(int argc, char **argv) {
+    unsigned int chunkSize = argc > 1 ? (unsigned int)atoi(argv[1]) : 64;
+    if(chunkSize < sizeof(unsigned int)) chunkSize = sizeof(unsigned int);
+    int maxThreads = argc > 2 ? atoi(argv[2]) : 16;
+    if(maxThreads < 1) maxThreads = 1;
+    if(maxThreads > BENCH_MAX_THREADS) maxThreads = BENCH_MAX_THREADS;
+
+    Test(chunkSize);
+    TestVirtual(chunkSize);
+    for(int threadsCount = 1; threadsCount <= maxThreads; threadsCount *= 2) {
+        TestConcurrent(chunkSize, threadsCount);
+    }
+    if(ChecksFailed()) return 1;
+    Bench(chunkSize);
+    for(int threadsCount = 1; threadsCount <= maxThreads; threadsCount *= 2) {
+        BenchConcurrent(chunkSize, threadsCount);
+    }
+    return 0;
+}
@@ -0,0 +1,295 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// TMRunLoop test with a fake looper. The looper holds a queue of scripted events,
+// lifecycle changes like the Android glue reports them or plain input, and records
+// the timeout of every poll. Checks that an app without a window or paused blocks
+// for the idle timeout and runs no frame, that an active app never blocks and runs
+// one frame per step, that one pump stops at TM_RUN_LOOP_MAX_EVENTS_PER_PUMP events,
+// and that windowCreated / windowDestroyed and resumed / paused stay balanced through
+// repeated, missing and random lifecycle events and a destroy from any state.
+// usage: tm_run_loop_test
+
+#include "tm_run_loop.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define FAKE_MAX_EVENTS 4096
+#define FAKE_MAX_POLLS 4096
+
+enum FakeEvent {
+    FAKE_EVENT_INPUT,
+    FAKE_EVENT_WINDOW_CREATED,
+    FAKE_EVENT_WINDOW_DESTROYED,
+    FAKE_EVENT_RESUME,
+    FAKE_EVENT_PAUSE,
+    FAKE_EVENT_DESTROY,
+    FAKE_EVENT_COUNT
+};
+
+struct FakeLooper {
+    TMRunLoop *loop;
+    FakeEvent events[FAKE_MAX_EVENTS];
+    unsigned int head;
+    unsigned int count;
+    // timeouts passed to poll since the last reset
+    int timeouts[FAKE_MAX_POLLS];
+    unsigned int pollsCount;
+    // time a real looper would have slept waiting for an event that never came
+    long long blockedMs;
+};
+
+struct FakeHooks {
+    int windowCreated;
+    int windowDestroyed;
+    int resumed;
+    int paused;
+    int destroyed;
+    int frames;
+    // a frame while not active or a hook in the wrong order
+    int errors;
+    bool hasWindow;
+    bool resumedState;
+};
+
+static bool FakePoll(void *userData, int timeoutMs) {
+    FakeLooper *looper = (FakeLooper *)userData;
+    if(looper->pollsCount < FAKE_MAX_POLLS) looper->timeouts[looper->pollsCount] = timeoutMs;
+    looper->pollsCount++;
+    if(looper->count == 0) {
+        if(timeoutMs > 0) looper->blockedMs += timeoutMs;
+        return false;
+    }
+    FakeEvent event = looper->events[looper->head];
+    looper->head = (looper->head + 1) % FAKE_MAX_EVENTS;
+    looper->count--;
+    // manuel: the Android glue calls these from inside the poll, do the same
+    switch(event) {
+        case FAKE_EVENT_WINDOW_CREATED: TMRunLoopOnWindowCreated(looper->loop); break;
+        case FAKE_EVENT_WINDOW_DESTROYED: TMRunLoopOnWindowDestroyed(looper->loop); break;
+        case FAKE_EVENT_RESUME: TMRunLoopOnResume(looper->loop); break;
+        case FAKE_EVENT_PAUSE: TMRunLoopOnPause(looper->loop); break;
+        case FAKE_EVENT_DESTROY: TMRunLoopOnDestroy(looper->loop); break;
+        default: break;
+    }
+    return true;
+}
+
+static void Push(FakeLooper *looper, FakeEvent event) {
+    looper->events[(looper->head + looper->count) % FAKE_MAX_EVENTS] = event;
+    looper->count++;
+}
+
+static void ResetPolls(FakeLooper *looper) {
+    looper->pollsCount = 0;
+    looper->blockedMs = 0;
+}
+
+static void OnWindowCreated(void *userData) {
+    FakeHooks *hooks = (FakeHooks *)userData;
+    if(hooks->hasWindow) hooks->errors++;
+    hooks->hasWindow = true;
+    hooks->windowCreated++;
+}
+
+static void OnWindowDestroyed(void *userData) {
+    FakeHooks *hooks = (FakeHooks *)userData;
+    if(!hooks->hasWindow) hooks->errors++;
+    hooks->hasWindow = false;
+    hooks->windowDestroyed++;
+}
+
+static void OnResumed(void *userData) {
+    FakeHooks *hooks = (FakeHooks *)userData;
+    if(hooks->resumedState) hooks->errors++;
+    hooks->resumedState = true;
+    hooks->resumed++;
+}
+
+static void OnPaused(void *userData) {
+    FakeHooks *hooks = (FakeHooks *)userData;
+    if(!hooks->resumedState) hooks->errors++;
+    hooks->resumedState = false;
+    hooks->paused++;
+}
+
+static void OnDestroyed(void *userData) {
+    FakeHooks *hooks = (FakeHooks *)userData;
+    hooks->destroyed++;
+}
+
+static void OnFrame(void *userData) {
+    FakeHooks *hooks = (FakeHooks *)userData;
+    if(!hooks->hasWindow || !hooks->resumedState) hooks->errors++;
+    hooks->frames++;
+}
+
+static void Setup(TMRunLoop *loop, FakeLooper *looper, FakeHooks *hooks) {
+    memset(looper, 0, sizeof(FakeLooper));
+    memset(hooks, 0, sizeof(FakeHooks));
+    looper->loop = loop;
+    TMRunLoopLooper fakeLooper{};
+    fakeLooper.userData = looper;
+    fakeLooper.poll = FakePoll;
+    TMRunLoopHooks fakeHooks{};
+    fakeHooks.userData = hooks;
+    fakeHooks.windowCreated = OnWindowCreated;
+    fakeHooks.windowDestroyed = OnWindowDestroyed;
+    fakeHooks.resumed = OnResumed;
+    fakeHooks.paused = OnPaused;
+    fakeHooks.destroyed = OnDestroyed;
+    fakeHooks.frame = OnFrame;
+    TMRunLoopInitialize(loop, fakeLooper, fakeHooks, TM_RUN_LOOP_DEFAULT_IDLE_TIMEOUT_MS);
+}
+
+static bool Balanced(FakeHooks *hooks) {
+    return hooks->windowCreated == hooks->windowDestroyed && hooks->resumed == hooks->paused &&
+           hooks->destroyed == 1 && hooks->errors == 0;
+}
+
+static void TestScheduling() {
+    TMRunLoop loop;
+    FakeLooper looper;
+    FakeHooks hooks;
+    Setup(&loop, &looper, &hooks);
+
+    // no window yet: one blocking poll of the idle timeout per step and no frame
+    for(int i = 0; i < 4; ++i) TMRunLoopStep(&loop);
+    Check(TM_RUN_LOOP_DEFAULT_IDLE_TIMEOUT_MS == 500, "idle timeout is 500 ms");
+    Check(looper.pollsCount == 4 && looper.timeouts[0] == 500 && looper.timeouts[3] == 500 &&
+          looper.blockedMs == 2000 && hooks.frames == 0, "no window blocks 500 ms per step");
+
+    // the first poll may block, the rest of the drain does not
+    ResetPolls(&looper);
+    Push(&looper, FAKE_EVENT_WINDOW_CREATED);
+    Push(&looper, FAKE_EVENT_RESUME);
+    TMRunLoopStep(&loop);
+    Check(looper.pollsCount == 3 && looper.timeouts[0] == 500 && looper.timeouts[1] == 0 &&
+          looper.timeouts[2] == 0, "only the first poll of a pump blocks");
+    Check(TMRunLoopIsActive(&loop) && hooks.frames == 1, "frame runs once window and resume arrive");
+
+    // active: never blocks, one frame per step
+    ResetPolls(&looper);
+    for(int i = 0; i < 100; ++i) TMRunLoopStep(&loop);
+    Check(looper.pollsCount == 100 && looper.blockedMs == 0 && hooks.frames == 101,
+          "active never blocks and runs a frame per step");
+
+    // paused with the window still there: blocks again and stops drawing
+    Push(&looper, FAKE_EVENT_PAUSE);
+    TMRunLoopStep(&loop);
+    int frames = hooks.frames;
+    ResetPolls(&looper);
+    for(int i = 0; i < 10; ++i) TMRunLoopStep(&loop);
+    Check(!TMRunLoopIsActive(&loop) && hooks.frames == frames, "paused runs no frame");
+    Check(looper.pollsCount == 10 && looper.timeouts[9] == 500 && looper.blockedMs == 5000,
+          "paused blocks 500 ms per step");
+
+    // input while paused wakes the loop up without running a frame
+    ResetPolls(&looper);
+    Push(&looper, FAKE_EVENT_INPUT);
+    TMRunLoopStep(&loop);
+    Check(looper.pollsCount == 2 && looper.timeouts[0] == 500 && looper.timeouts[1] == 0 &&
+          hooks.frames == frames, "input while paused is drained without a frame");
+
+    Push(&looper, FAKE_EVENT_RESUME);
+    TMRunLoopStep(&loop);
+    Check(hooks.frames == frames + 1, "resume draws again");
+
+    Push(&looper, FAKE_EVENT_DESTROY);
+    Check(!TMRunLoopStep(&loop), "step returns false once destroyed");
+    Check(Balanced(&hooks), "destroy while active balances the hooks");
+}
+
+static void TestDrainCap() {
+    TMRunLoop loop;
+    FakeLooper looper;
+    FakeHooks hooks;
+    Setup(&loop, &looper, &hooks);
+    Push(&looper, FAKE_EVENT_WINDOW_CREATED);
+    Push(&looper, FAKE_EVENT_RESUME);
+    TMRunLoopStep(&loop);
+
+    const unsigned int flood = 1000;
+    for(unsigned int i = 0; i < flood; ++i) Push(&looper, FAKE_EVENT_INPUT);
+    int frames = hooks.frames;
+    unsigned int drained = (unsigned int)TMRunLoopPumpEvents(&loop);
+    Check(drained == TM_RUN_LOOP_MAX_EVENTS_PER_PUMP && looper.count == flood - drained,
+          "one pump stops at 256 events");
+
+    // manuel: the flood is spread over frames instead of holding the next one back
+    unsigned int steps = 0;
+    while(looper.count > 0) {
+        TMRunLoopStep(&loop);
+        steps++;
+    }
+    Check(steps == (flood - drained + TM_RUN_LOOP_MAX_EVENTS_PER_PUMP - 1) / TM_RUN_LOOP_MAX_EVENTS_PER_PUMP &&
+          hooks.frames == frames + (int)steps, "a frame runs after every capped pump");
+
+    // events after the destroy are not dispatched
+    Push(&looper, FAKE_EVENT_DESTROY);
+    Push(&looper, FAKE_EVENT_INPUT);
+    Push(&looper, FAKE_EVENT_WINDOW_CREATED);
+    TMRunLoopPumpEvents(&loop);
+    Check(looper.count == 2u && Balanced(&hooks), "pump stops at the destroy");
+}
+
+static void TestHooksBalanced() {
+    TMRunLoop loop;
+    FakeLooper looper;
+    FakeHooks hooks;
+
+    // repeated and unmatched events from the platform
+    Setup(&loop, &looper, &hooks);
+    Push(&looper, FAKE_EVENT_WINDOW_DESTROYED);
+    Push(&looper, FAKE_EVENT_PAUSE);
+    Push(&looper, FAKE_EVENT_WINDOW_CREATED);
+    Push(&looper, FAKE_EVENT_WINDOW_CREATED);
+    Push(&looper, FAKE_EVENT_RESUME);
+    Push(&looper, FAKE_EVENT_RESUME);
+    TMRunLoopStep(&loop);
+    Check(hooks.windowCreated == 1 && hooks.resumed == 1 && hooks.windowDestroyed == 0 && hooks.paused == 0 &&
+          hooks.errors == 0, "repeated and unmatched events ignored");
+    Push(&looper, FAKE_EVENT_WINDOW_DESTROYED);
+    Push(&looper, FAKE_EVENT_WINDOW_CREATED);
+    TMRunLoopStep(&loop);
+    Check(hooks.windowCreated == 2 && hooks.windowDestroyed == 1 && hooks.errors == 0, "window recreated");
+    TMRunLoopOnDestroy(&loop);
+    TMRunLoopOnDestroy(&loop);
+    Check(Balanced(&hooks), "destroy twice calls destroyed once");
+
+    // manuel: random lifecycle sequences, the platform can skip or repeat any step
+    unsigned int random = 0x2545F491u;
+    bool balanced = true;
+    bool framesWhileActive = true;
+    for(int run = 0; run < 1000; ++run) {
+        Setup(&loop, &looper, &hooks);
+        int steps = 1 + run % 50;
+        for(int i = 0; i < steps; ++i) {
+            for(int e = 0; e < 3; ++e) {
+                random ^= random << 13;
+                random ^= random >> 17;
+                random ^= random << 5;
+                FakeEvent event = (FakeEvent)(random % (FAKE_EVENT_COUNT - 1));
+                Push(&looper, event);
+            }
+            int frames = hooks.frames;
+            TMRunLoopStep(&loop);
+            if(hooks.frames != frames + (TMRunLoopIsActive(&loop) ? 1 : 0)) framesWhileActive = false;
+        }
+        TMRunLoopOnDestroy(&loop);
+        if(!Balanced(&hooks) || TMRunLoopIsActive(&loop)) balanced = false;
+    }
+    Check(framesWhileActive, "random lifecycles draw only while active");
+    Check(balanced, "random lifecycles end balanced");
+}
+
+int main() {
+    TestScheduling();
+    TestDrainCap();
+    TestHooksBalanced();
+    if(ChecksFailed()) return 1;
+    return 0;
+}
@@ -0,0 +1,169 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// TMShaderCache test. Runs in a fresh temporary directory and checks that the key
+// changes with either source and the driver, that a stored binary loads back, that
+// a different key, a truncated file, a flipped byte or trailing data is a miss, that
+// a program whose sources or driver changed overwrites its one file instead of adding
+// another, and that a failed store leaves the previous binary in place.
+// usage: tm_shader_cache_test
+
+#include "utils/tm_shader_cache.h"
+#include "utils/tm_arena.h"
+#include "tm_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#define TEST_BINARY_SIZE 4000
+
+static unsigned int FilesCount(const char *directory) {
+    DIR *dir = opendir(directory);
+    if(!dir) return 0;
+    unsigned int count = 0;
+    dirent *entry;
+    while((entry = readdir(dir)) != NULL) {
+        if(strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+static bool FileExists(const char *directory, const char *name) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    return access(path, F_OK) == 0;
+}
+
+static void WriteFile(const char *directory, const char *name, const void *data, size_t size) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    FILE *file = fopen(path, "wb");
+    fwrite(data, 1, size, file);
+    fclose(file);
+}
+
+static unsigned char *ReadFile(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char *data = (unsigned char *)malloc(*size + 1);
+    *size = fread(data, 1, *size, file);
+    fclose(file);
+    return data;
+}
+
+static void OverwriteFile(const char *path, const void *data, size_t size) {
+    FILE *file = fopen(path, "wb");
+    fwrite(data, 1, size, file);
+    fclose(file);
+}
+
+static bool Load(const char *path, uint64_t key, TMArena *arena, const unsigned char *expected) {
+    unsigned int binaryFormat = 0;
+    void *binary = NULL;
+    size_t binarySize = 0;
+    TMArenaSavepoint savepoint = TMArenaSave(arena);
+    bool loaded = TMShaderCacheLoad(path, key, arena, &binaryFormat, &binary, &binarySize);
+    bool result = loaded && binaryFormat == 0x8741 && binarySize == TEST_BINARY_SIZE &&
+                  memcmp(binary, expected, TEST_BINARY_SIZE) == 0;
+    TMArenaRollback(savepoint);
+    return result;
+}
+
+static void TestKey() {
+    uint64_t key = TMShaderCacheKey("vert", "frag", "driver");
+    Check(key == TMShaderCacheKey("vert", "frag", "driver"), "same sources, same key");
+    Check(key != TMShaderCacheKey("vert2", "frag", "driver"), "vertex source changes the key");
+    Check(key != TMShaderCacheKey("vert", "frag2", "driver"), "fragment source changes the key");
+    Check(key != TMShaderCacheKey("vert", "frag", "driver 2"), "driver changes the key");
+    Check(key != TMShaderCacheKey("ver", "tfrag", "driver"), "text moved between sources changes the key");
+}
+
+static void TestFiles(const char *directory) {
+    TMArena *arena = TMArenaCreate(64 * 1024);
+    unsigned char binary[TEST_BINARY_SIZE];
+    for(int i = 0; i < TEST_BINARY_SIZE; ++i) binary[i] = (unsigned char)(i * 7 + 3);
+
+    char path[512];
+    TMShaderCachePath(directory, "shaders/vert.glsl", "shaders/frag.glsl", path, sizeof(path));
+    char otherPath[512];
+    TMShaderCachePath(directory, "shaders/vert_instanced.glsl", "shaders/frag_instanced.glsl",
+                      otherPath, sizeof(otherPath));
+    Check(strcmp(path, otherPath) != 0, "programs get different files");
+
+    uint64_t key = TMShaderCacheKey("vert", "frag", "driver");
+    Check(!Load(path, key, arena, binary), "missing file is a miss");
+    Check(TMShaderCacheStore(path, key, 0x8741, binary, TEST_BINARY_SIZE), "store");
+    Check(Load(path, key, arena, binary), "stored binary loads back");
+    Check(!Load(path, TMShaderCacheKey("vert", "frag", "driver 2"), arena, binary), "other key is a miss");
+
+    size_t size;
+    unsigned char *file = ReadFile(path, &size);
+    OverwriteFile(path, file, size - 1);
+    Check(!Load(path, key, arena, binary), "truncated file is a miss");
+    file[size - 100] ^= 0x10;
+    OverwriteFile(path, file, size);
+    Check(!Load(path, key, arena, binary), "flipped byte is a miss");
+    file[size - 100] ^= 0x10;
+    file[size] = 0;
+    OverwriteFile(path, file, size + 1);
+    Check(!Load(path, key, arena, binary), "trailing data is a miss");
+    OverwriteFile(path, file, size);
+    Check(Load(path, key, arena, binary), "restored file loads");
+    free(file);
+
+    // manuel: what the renderer does after an edit or a driver update, miss then store
+    unsigned int filesCount = FilesCount(directory);
+    uint64_t editedKey = TMShaderCacheKey("vert edited", "frag", "driver");
+    Check(!Load(path, editedKey, arena, binary), "edited source is a miss");
+    Check(TMShaderCacheStore(path, editedKey, 0x8741, binary, TEST_BINARY_SIZE), "store after the edit");
+    uint64_t updatedKey = TMShaderCacheKey("vert edited", "frag", "driver 2");
+    Check(TMShaderCacheStore(path, updatedKey, 0x8741, binary, TEST_BINARY_SIZE), "store after a driver update");
+    Check(FilesCount(directory) == filesCount, "stale binaries replaced, not added");
+    Check(Load(path, updatedKey, arena, binary) && !Load(path, editedKey, arena, binary),
+          "only the newest binary loads");
+
+    // a crash during a write leaves the .tmp behind, the next store reuses it
+    char tempName[512];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", strrchr(path, '/') + 1);
+    WriteFile(directory, tempName, binary, 16);
+    Check(TMShaderCacheStore(path, updatedKey, 0x8741, binary, TEST_BINARY_SIZE) &&
+          !FileExists(directory, tempName), "temporary file left by a crash reused");
+    Check(!TMShaderCacheStore(path, editedKey, 0x8741, binary, 0), "empty binary not stored");
+    Check(Load(path, updatedKey, arena, binary), "failed store keeps the previous binary");
+
+    TMArenaDestroy(arena);
+}
+
+static void RemoveDirectory(const char *directory) {
+    DIR *dir = opendir(directory);
+    if(!dir) return;
+    dirent *entry;
+    while((entry = readdir(dir)) != NULL) {
+        if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        remove(path);
+    }
+    closedir(dir);
+    rmdir(directory);
+}
+
+int main() {
+    char directory[] = "/tmp/tm_shader_cache_XXXXXX";
+    if(!mkdtemp(directory)) {
+        printf("can't create a temporary directory\n");
+        return 1;
+    }
+    TestKey();
+    TestFiles(directory);
+    RemoveDirectory(directory);
+    if(ChecksFailed()) return 1;
+    return 0;
+}
@@ -0,0 +1,35 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef TM_TOOLS_TM_TEST_H
+#define TM_TOOLS_TM_TEST_H
+
+// Checks shared by the host tests and benchmarks in tools/. Every tool is a single
+// main.cpp that includes this once, so the counter and the helpers are static here.
+// Check prints one line per check, ChecksFailed prints the failed count at the end:
+//   if(ChecksFailed()) return 1;
+
+#include <stdio.h>
+#include <time.h>
+
+static int gFailed;
+
+static inline void Check(bool condition, const char *what) {
+    printf("%-56s %s\n", what, condition ? "ok" : "FAILED");
+    if(!condition) gFailed++;
+}
+
+static inline bool ChecksFailed() {
+    if(gFailed) printf("%d checks FAILED\n", gFailed);
+    return gFailed != 0;
+}
+
+// monotonic seconds for the benchmarks
+static inline double GetTime() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1000000000.0;
+}
+
+#endif //TM_TOOLS_TM_TEST_H
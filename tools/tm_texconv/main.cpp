@@ -0,0 +1,216 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+// Offline texture converter: PNG -> ETC2 KTX2 with a pre-built mip chain.
+// usage: tm_texconv [--no-mips] [-o output_dir] image.png...
+// Images without transparency are written as ETC2 RGB8 (4 bits per texel),
+// the rest as ETC2 RGBA8 EAC (8 bits per texel).
+
+#include "tm_etc2.h"
+#include "utils/tm_ktx2.h"
+
+#include <png.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+struct TMConvImage {
+    unsigned char *pixels;
+    unsigned int width;
+    unsigned int height;
+};
+
+static bool LoadPng(const char *path, TMConvImage *image) {
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    if(!png_image_begin_read_from_file(&png, path)) {
+        fprintf(stderr, "%s: %s\n", path, png.message);
+        return false;
+    }
+    png.format = PNG_FORMAT_RGBA;
+    image->width = png.width;
+    image->height = png.height;
+    image->pixels = (unsigned char *)malloc(PNG_IMAGE_SIZE(png));
+    if(!png_image_finish_read(&png, NULL, image->pixels, 0, NULL)) {
+        fprintf(stderr, "%s: %s\n", path, png.message);
+        free(image->pixels);
+        return false;
+    }
+    return true;
+}
+
+// 2x2 box filter, odd sizes repeat the last row / column
+static TMConvImage Downsample(TMConvImage *src) {
+    TMConvImage dst;
+    dst.width = src->width > 1 ? src->width / 2 : 1;
+    dst.height = src->height > 1 ? src->height / 2 : 1;
+    dst.pixels = (unsigned char *)malloc(dst.width * dst.height * 4);
+    for(unsigned int y = 0; y < dst.height; ++y) {
+        unsigned int y0 = y * 2 < src->height ? y * 2 : src->height - 1;
+        unsigned int y1 = y0 + 1 < src->height ? y0 + 1 : y0;
+        for(unsigned int x = 0; x < dst.width; ++x) {
+            unsigned int x0 = x * 2 < src->width ? x * 2 : src->width - 1;
+            unsigned int x1 = x0 + 1 < src->width ? x0 + 1 : x0;
+            for(unsigned int c = 0; c < 4; ++c) {
+                unsigned int sum = src->pixels[(y0 * src->width + x0) * 4 + c] +
+                                   src->pixels[(y0 * src->width + x1) * 4 + c] +
+                                   src->pixels[(y1 * src->width + x0) * 4 + c] +
+                                   src->pixels[(y1 * src->width + x1) * 4 + c];
+                dst.pixels[(y * dst.width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+    return dst;
+}
+
+static bool HasAlpha(TMConvImage *image) {
+    for(unsigned int i = 0; i < image->width * image->height; ++i) {
+        if(image->pixels[i * 4 + 3] != 255) return true;
+    }
+    return false;
+}
+
+// encodes one level, blocks on the border repeat the edge texels.
+// Accumulates the squared error of the decoded result for the report
+static unsigned char *EncodeLevel(TMConvImage *image, bool alpha, size_t *size, double *squaredError) {
+    unsigned int blockBytes = alpha ? 16 : 8;
+    unsigned int blocksX = (image->width + 3) / 4;
+    unsigned int blocksY = (image->height + 3) / 4;
+    *size = (size_t)blocksX * blocksY * blockBytes;
+    unsigned char *data = (unsigned char *)malloc(*size);
+
+    unsigned char texels[64];
+    unsigned char decoded[64];
+    for(unsigned int by = 0; by < blocksY; ++by) {
+        for(unsigned int bx = 0; bx < blocksX; ++bx) {
+            for(unsigned int y = 0; y < 4; ++y) {
+                unsigned int sy = by * 4 + y < image->height ? by * 4 + y : image->height - 1;
+                for(unsigned int x = 0; x < 4; ++x) {
+                    unsigned int sx = bx * 4 + x < image->width ? bx * 4 + x : image->width - 1;
+                    memcpy(texels + (y * 4 + x) * 4, image->pixels + (sy * image->width + sx) * 4, 4);
+                }
+            }
+            unsigned char *block = data + (by * blocksX + bx) * blockBytes;
+            if(alpha) {
+                TMEtc2EncodeRGBA(texels, block);
+                TMEtc2DecodeRGBA(block, decoded);
+            } else {
+                TMEtc2EncodeRGB(texels, block);
+                TMEtc2DecodeRGB(block, decoded);
+            }
+            for(unsigned int i = 0; i < 64; ++i) {
+                if(!alpha && (i & 3) == 3) continue;
+                double delta = (double)texels[i] - (double)decoded[i];
+                *squaredError += delta * delta;
+            }
+        }
+    }
+    return data;
+}
+
+static bool WriteFile(const char *path, const unsigned char *data, size_t size) {
+    FILE *file = fopen(path, "wb");
+    if(!file) {
+        fprintf(stderr, "%s: can't open for writing\n", path);
+        return false;
+    }
+    bool result = fwrite(data, 1, size, file) == size;
+    fclose(file);
+    return result;
+}
+
+static void OutputPath(const char *input, const char *outputDir, char *output, size_t outputSize) {
+    const char *name = input;
+    if(outputDir) {
+        const char *slash = strrchr(input, '/');
+        if(slash) name = slash + 1;
+        snprintf(output, outputSize, "%s/%s", outputDir, name);
+    } else {
+        snprintf(output, outputSize, "%s", input);
+    }
+    char *dot = strrchr(output, '.');
+    char *slash = strrchr(output, '/');
+    if(dot && (!slash || dot > slash)) *dot = 0;
+    strncat(output, ".ktx2", outputSize - strlen(output) - 1);
+}
+
+static bool Convert(const char *input, const char *output, bool mips) {
+    TMConvImage image;
+    if(!LoadPng(input, &image)) return false;
+
+    bool alpha = HasAlpha(&image);
+    TMKtx2 ktx2;
+    memset(&ktx2, 0, sizeof(ktx2));
+    ktx2.vkFormat = alpha ? TM_VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK : TM_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+    ktx2.width = image.width;
+    ktx2.height = image.height;
+
+    double squaredError = 0.0;
+    size_t samples = (size_t)image.width * image.height * (alpha ? 4 : 3);
+    TMConvImage level = image;
+    for(;;) {
+        TMKtx2Level *dst = ktx2.levels + ktx2.levelCount;
+        dst->width = level.width;
+        dst->height = level.height;
+        double levelError = 0.0;
+        dst->data = EncodeLevel(&level, alpha, &dst->size, &levelError);
+        if(ktx2.levelCount == 0) squaredError = levelError;
+        ktx2.levelCount++;
+
+        if(!mips || (level.width == 1 && level.height == 1) || ktx2.levelCount == TM_KTX2_MAX_LEVELS) break;
+        TMConvImage next = Downsample(&level);
+        free(level.pixels);
+        level = next;
+    }
+    free(level.pixels);
+
+    size_t size = TMKtx2Write(&ktx2, NULL, 0);
+    unsigned char *file = (unsigned char *)malloc(size);
+    TMKtx2Write(&ktx2, file, size);
+    bool result = WriteFile(output, file, size);
+
+    double mse = squaredError / (double)samples;
+    double psnr = mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+    printf("%s -> %s: %ux%u %s, %u levels, %zu bytes (RGBA8 with mips %zu), PSNR %.2f dB\n",
+           input, output, ktx2.width, ktx2.height, alpha ? "ETC2 RGBA8" : "ETC2 RGB8",
+           ktx2.levelCount, size, (size_t)image.width * image.height * 4 * 4 / 3, psnr);
+
+    for(unsigned int i = 0; i < ktx2.levelCount; ++i) {
+        free((void *)ktx2.levels[i].data);
+    }
+    free(file);
+    return result;
+}
+
+int main(int argc, char **argv) {
+    bool mips = true;
+    const char *outputDir = NULL;
+    int inputsCount = 0;
+    for(int i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "--no-mips") == 0) {
+            mips = false;
+        } else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outputDir = argv[++i];
+        } else {
+            inputsCount++;
+        }
+    }
+    if(inputsCount == 0) {
+        fprintf(stderr, "usage: %s [--no-mips] [-o output_dir] image.png...\n", argv[0]);
+        return 1;
+    }
+
+    int failed = 0;
+    for(int i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "--no-mips") == 0) continue;
+        if(strcmp(argv[i], "-o") == 0) { ++i; continue; }
+        char output[1024];
+        OutputPath(argv[i], outputDir, output, sizeof(output));
+        if(!Convert(argv[i], output, mips)) failed++;
+    }
+    return failed == 0 ? 0 : 1;
+}
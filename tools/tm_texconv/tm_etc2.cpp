@@ -0,0 +1,316 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#include "tm_etc2.h"
+
+#include <stdint.h>
+#include <limits.h>
+
+// Block layout reference: Khronos Data Format Specification, ETC2 and EAC.
+// Texels inside a block are indexed column by column: p = x * 4 + y.
+
+static const int gEtcModifiers[8][2] = {
+    {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}
+};
+
+static const int gEacModifiers[16][8] = {
+    {-3, -6, -9, -15, 2, 5, 8, 14},
+    {-3, -7, -10, -13, 2, 6, 9, 12},
+    {-2, -5, -8, -13, 1, 4, 7, 12},
+    {-2, -4, -6, -13, 1, 3, 5, 12},
+    {-3, -6, -8, -12, 2, 5, 7, 11},
+    {-3, -7, -9, -11, 2, 6, 8, 10},
+    {-4, -7, -8, -11, 3, 6, 7, 10},
+    {-3, -5, -8, -11, 2, 4, 7, 10},
+    {-2, -6, -8, -10, 1, 5, 7, 9},
+    {-2, -5, -8, -10, 1, 4, 7, 9},
+    {-2, -4, -8, -10, 1, 3, 7, 9},
+    {-2, -5, -7, -10, 1, 4, 6, 9},
+    {-3, -4, -7, -10, 2, 3, 6, 9},
+    {-1, -2, -3, -10, 0, 1, 2, 9},
+    {-4, -6, -8, -9, 3, 5, 7, 8},
+    {-3, -5, -7, -9, 2, 4, 6, 8}
+};
+
+static int Clamp255(int value) {
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+// pixel index value (msb lsb) -> modifier: 00 +a, 01 +b, 10 -a, 11 -b
+static int EtcModifier(int table, int index) {
+    int modifier = gEtcModifiers[table][index & 1];
+    return (index & 2) ? -modifier : modifier;
+}
+
+static int Expand4(int value) { return (value << 4) | value; }
+static int Expand5(int value) { return (value << 3) | (value >> 2); }
+
+static bool InSubblock(int x, int y, bool flip, int subblock) {
+    int coord = flip ? y : x;
+    return (coord >= 2) == (subblock == 1);
+}
+
+struct EtcSubblockFit {
+    int table;
+    int indices[16];
+    int64_t error;
+};
+
+// picks the best modifier table and per texel modifier for a fixed base color
+static void FitSubblock(const unsigned char *pixels, bool flip, int subblock,
+                        const int *base, EtcSubblockFit *fit) {
+    fit->error = INT64_MAX;
+    for(int table = 0; table < 8; ++table) {
+        int indices[16];
+        int64_t tableError = 0;
+        for(int y = 0; y < 4; ++y) {
+            for(int x = 0; x < 4; ++x) {
+                if(!InSubblock(x, y, flip, subblock)) continue;
+                const unsigned char *texel = pixels + (y * 4 + x) * 4;
+                int bestError = INT_MAX;
+                int bestIndex = 0;
+                for(int index = 0; index < 4; ++index) {
+                    int modifier = EtcModifier(table, index);
+                    int dr = Clamp255(base[0] + modifier) - texel[0];
+                    int dg = Clamp255(base[1] + modifier) - texel[1];
+                    int db = Clamp255(base[2] + modifier) - texel[2];
+                    int error = dr * dr + dg * dg + db * db;
+                    if(error < bestError) {
+                        bestError = error;
+                        bestIndex = index;
+                    }
+                }
+                indices[x * 4 + y] = bestIndex;
+                tableError += bestError;
+            }
+        }
+        if(tableError < fit->error) {
+            fit->error = tableError;
+            fit->table = table;
+            for(int i = 0; i < 16; ++i) fit->indices[i] = indices[i];
+        }
+    }
+}
+
+static void SubblockAverage(const unsigned char *pixels, bool flip, int subblock, float *average) {
+    int sum[3] = {0, 0, 0};
+    for(int y = 0; y < 4; ++y) {
+        for(int x = 0; x < 4; ++x) {
+            if(!InSubblock(x, y, flip, subblock)) continue;
+            const unsigned char *texel = pixels + (y * 4 + x) * 4;
+            sum[0] += texel[0];
+            sum[1] += texel[1];
+            sum[2] += texel[2];
+        }
+    }
+    for(int i = 0; i < 3; ++i) average[i] = sum[i] / 8.0f;
+}
+
+static int Quantize(float value, int maxValue) {
+    int result = (int)(value * maxValue / 255.0f + 0.5f);
+    return result < 0 ? 0 : (result > maxValue ? maxValue : result);
+}
+
+static void WriteIndices(const EtcSubblockFit *fits, bool flip, unsigned char *block) {
+    unsigned int msb = 0;
+    unsigned int lsb = 0;
+    for(int y = 0; y < 4; ++y) {
+        for(int x = 0; x < 4; ++x) {
+            int p = x * 4 + y;
+            int subblock = InSubblock(x, y, flip, 1) ? 1 : 0;
+            int index = fits[subblock].indices[p];
+            msb |= (unsigned int)(index >> 1) << p;
+            lsb |= (unsigned int)(index & 1) << p;
+        }
+    }
+    block[4] = (unsigned char)(msb >> 8);
+    block[5] = (unsigned char)(msb);
+    block[6] = (unsigned char)(lsb >> 8);
+    block[7] = (unsigned char)(lsb);
+}
+
+void TMEtc2EncodeRGB(const unsigned char *pixels, unsigned char *block) {
+    int64_t bestError = INT64_MAX;
+
+    for(int flipIndex = 0; flipIndex < 2; ++flipIndex) {
+        bool flip = flipIndex == 1;
+        float averages[2][3];
+        SubblockAverage(pixels, flip, 0, averages[0]);
+        SubblockAverage(pixels, flip, 1, averages[1]);
+
+        // differential mode: 5 bit base plus a 3 bit signed delta. A delta out of
+        // range would be read as one of the ETC2 T / H / planar modes, so skip it
+        int base5[2][3];
+        bool differential = true;
+        for(int c = 0; c < 3; ++c) {
+            base5[0][c] = Quantize(averages[0][c], 31);
+            base5[1][c] = Quantize(averages[1][c], 31);
+            int delta = base5[1][c] - base5[0][c];
+            if(delta < -4 || delta > 3) differential = false;
+        }
+        if(differential) {
+            EtcSubblockFit fits[2];
+            for(int s = 0; s < 2; ++s) {
+                int base[3] = {Expand5(base5[s][0]), Expand5(base5[s][1]), Expand5(base5[s][2])};
+                FitSubblock(pixels, flip, s, base, fits + s);
+            }
+            int64_t error = fits[0].error + fits[1].error;
+            if(error < bestError) {
+                bestError = error;
+                for(int c = 0; c < 3; ++c) {
+                    block[c] = (unsigned char)((base5[0][c] << 3) | ((base5[1][c] - base5[0][c]) & 7));
+                }
+                block[3] = (unsigned char)((fits[0].table << 5) | (fits[1].table << 2) | 2 | flipIndex);
+                WriteIndices(fits, flip, block);
+            }
+        }
+
+        // individual mode: two independent 4 bit base colors
+        int base4[2][3];
+        for(int c = 0; c < 3; ++c) {
+            base4[0][c] = Quantize(averages[0][c], 15);
+            base4[1][c] = Quantize(averages[1][c], 15);
+        }
+        EtcSubblockFit fits[2];
+        for(int s = 0; s < 2; ++s) {
+            int base[3] = {Expand4(base4[s][0]), Expand4(base4[s][1]), Expand4(base4[s][2])};
+            FitSubblock(pixels, flip, s, base, fits + s);
+        }
+        int64_t error = fits[0].error + fits[1].error;
+        if(error < bestError) {
+            bestError = error;
+            for(int c = 0; c < 3; ++c) {
+                block[c] = (unsigned char)((base4[0][c] << 4) | base4[1][c]);
+            }
+            block[3] = (unsigned char)((fits[0].table << 5) | (fits[1].table << 2) | flipIndex);
+            WriteIndices(fits, flip, block);
+        }
+    }
+}
+
+static int64_t FitAlpha(const unsigned char *pixels, int base, int multiplier, int table, int *indices) {
+    int64_t error = 0;
+    for(int y = 0; y < 4; ++y) {
+        for(int x = 0; x < 4; ++x) {
+            int alpha = pixels[(y * 4 + x) * 4 + 3];
+            int bestError = INT_MAX;
+            int bestIndex = 0;
+            for(int index = 0; index < 8; ++index) {
+                int delta = Clamp255(base + gEacModifiers[table][index] * multiplier) - alpha;
+                if(delta * delta < bestError) {
+                    bestError = delta * delta;
+                    bestIndex = index;
+                }
+            }
+            indices[x * 4 + y] = bestIndex;
+            error += bestError;
+        }
+    }
+    return error;
+}
+
+static void EncodeAlpha(const unsigned char *pixels, unsigned char *block) {
+    int minAlpha = 255;
+    int maxAlpha = 0;
+    for(int i = 0; i < 16; ++i) {
+        int alpha = pixels[i * 4 + 3];
+        if(alpha < minAlpha) minAlpha = alpha;
+        if(alpha > maxAlpha) maxAlpha = alpha;
+    }
+
+    int bestBase = minAlpha;
+    int bestMultiplier = 1;
+    int bestTable = 13; // has a zero modifier, exact for constant blocks
+    int bestIndices[16];
+    int64_t bestError = FitAlpha(pixels, bestBase, bestMultiplier, bestTable, bestIndices);
+
+    // search around the multiplier and base that map each table range onto [min, max]
+    for(int table = 0; table < 16 && bestError > 0; ++table) {
+        int low = gEacModifiers[table][3];
+        int high = gEacModifiers[table][7];
+        int center = (int)((float)(maxAlpha - minAlpha) / (float)(high - low) + 0.5f);
+        for(int multiplier = center - 1; multiplier <= center + 1; ++multiplier) {
+            if(multiplier < 1 || multiplier > 15) continue;
+            int baseCenter = (minAlpha + maxAlpha - (low + high) * multiplier) / 2;
+            for(int base = baseCenter - 2; base <= baseCenter + 2; ++base) {
+                if(base < 0 || base > 255) continue;
+                int indices[16];
+                int64_t error = FitAlpha(pixels, base, multiplier, table, indices);
+                if(error < bestError) {
+                    bestError = error;
+                    bestBase = base;
+                    bestMultiplier = multiplier;
+                    bestTable = table;
+                    for(int i = 0; i < 16; ++i) bestIndices[i] = indices[i];
+                }
+            }
+        }
+    }
+
+    uint64_t bits = 0;
+    for(int p = 0; p < 16; ++p) {
+        bits |= (uint64_t)bestIndices[p] << (45 - p * 3);
+    }
+    block[0] = (unsigned char)bestBase;
+    block[1] = (unsigned char)((bestMultiplier << 4) | bestTable);
+    for(int i = 0; i < 6; ++i) {
+        block[2 + i] = (unsigned char)(bits >> (40 - i * 8));
+    }
+}
+
+void TMEtc2EncodeRGBA(const unsigned char *pixels, unsigned char *block) {
+    EncodeAlpha(pixels, block);
+    TMEtc2EncodeRGB(pixels, block + 8);
+}
+
+void TMEtc2DecodeRGB(const unsigned char *block, unsigned char *pixels) {
+    bool differential = (block[3] & 2) != 0;
+    bool flip = (block[3] & 1) != 0;
+    int tables[2] = {block[3] >> 5, (block[3] >> 2) & 7};
+    int bases[2][3];
+    for(int c = 0; c < 3; ++c) {
+        if(differential) {
+            int base = block[c] >> 3;
+            int delta = (block[c] & 7) >= 4 ? (block[c] & 7) - 8 : (block[c] & 7);
+            bases[0][c] = Expand5(base);
+            bases[1][c] = Expand5(base + delta);
+        } else {
+            bases[0][c] = Expand4(block[c] >> 4);
+            bases[1][c] = Expand4(block[c] & 15);
+        }
+    }
+    unsigned int msb = ((unsigned int)block[4] << 8) | block[5];
+    unsigned int lsb = ((unsigned int)block[6] << 8) | block[7];
+    for(int y = 0; y < 4; ++y) {
+        for(int x = 0; x < 4; ++x) {
+            int p = x * 4 + y;
+            int subblock = InSubblock(x, y, flip, 1) ? 1 : 0;
+            int index = (((msb >> p) & 1) << 1) | ((lsb >> p) & 1);
+            int modifier = EtcModifier(tables[subblock], index);
+            unsigned char *texel = pixels + (y * 4 + x) * 4;
+            texel[0] = (unsigned char)Clamp255(bases[subblock][0] + modifier);
+            texel[1] = (unsigned char)Clamp255(bases[subblock][1] + modifier);
+            texel[2] = (unsigned char)Clamp255(bases[subblock][2] + modifier);
+            texel[3] = 255;
+        }
+    }
+}
+
+void TMEtc2DecodeRGBA(const unsigned char *block, unsigned char *pixels) {
+    TMEtc2DecodeRGB(block + 8, pixels);
+    int base = block[0];
+    int multiplier = block[1] >> 4;
+    int table = block[1] & 15;
+    uint64_t bits = 0;
+    for(int i = 0; i < 6; ++i) {
+        bits = (bits << 8) | block[2 + i];
+    }
+    for(int y = 0; y < 4; ++y) {
+        for(int x = 0; x < 4; ++x) {
+            int p = x * 4 + y;
+            int index = (int)((bits >> (45 - p * 3)) & 7);
+            pixels[(y * 4 + x) * 4 + 3] = (unsigned char)Clamp255(base + gEacModifiers[table][index] * multiplier);
+        }
+    }
+}
@@ -0,0 +1,22 @@
+//
+// Created by Manuel Cabrerizo on 17/10/2026.
+//
+
+#ifndef MY_APPLICATION_TM_ETC2_H
+#define MY_APPLICATION_TM_ETC2_H
+
+// ETC2 block encoder used by the offline texture converter. The color part only
+// emits the ETC1 compatible individual / differential modes, every GLES3 device
+// decodes them and they are cheap to search exhaustively.
+
+// pixels is a 4x4 block of RGBA8 texels, row by row. Writes 8 bytes
+void TMEtc2EncodeRGB(const unsigned char *pixels, unsigned char *block);
+// writes 16 bytes, the EAC alpha block followed by the color block
+void TMEtc2EncodeRGBA(const unsigned char *pixels, unsigned char *block);
+
+// decoders for the blocks written above (individual / differential modes only),
+// used to measure the error of the encoder
+void TMEtc2DecodeRGB(const unsigned char *block, unsigned char *pixels);
+void TMEtc2DecodeRGBA(const unsigned char *block, unsigned char *pixels);
+
+#endif //MY_APPLICATION_TM_ETC2_H